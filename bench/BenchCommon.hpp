@@ -0,0 +1,88 @@
+#pragma once
+
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace notascore::bench {
+
+class Stopwatch {
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+    [[nodiscard]] double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Deterministic xorshift so that runs are comparable.
+class Rng {
+public:
+    explicit Rng(std::uint32_t seed = 0x9E3779B9u) : m_state(seed) {}
+
+    std::uint32_t next() noexcept {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    int range(int lo, int hi) noexcept { return lo + static_cast<int>(next() % static_cast<std::uint32_t>(hi - lo + 1)); }
+
+private:
+    std::uint32_t m_state;
+};
+
+// Tick-ordered synthetic score mixing quarters, eighths, sixteenths and chords in 4/4 at 480 PPQ.
+inline std::vector<notation::NoteEvent> makeSyntheticScore(std::size_t noteCount, std::uint32_t seed = 1) {
+    static constexpr int kDurations[] {480, 240, 120, 960, 240, 480};
+    Rng rng(seed);
+    std::vector<notation::NoteEvent> notes;
+    notes.reserve(noteCount);
+    int tick = 0;
+    while (notes.size() < noteCount) {
+        int duration = kDurations[rng.next() % 6];
+        const int measureEnd = (tick / 1920 + 1) * 1920;
+        if (tick + duration > measureEnd) {
+            duration = measureEnd - tick;
+        }
+        const int chordSize = rng.range(1, 3);
+        for (int c = 0; c < chordSize && notes.size() < noteCount; ++c) {
+            notes.push_back({.tick = tick, .duration = duration, .midiPitch = rng.range(55, 84)});
+        }
+        tick += duration;
+    }
+    return notes;
+}
+
+inline void report(const char* name, double ms, double targetMs) {
+    std::printf("%-44s %10.3f ms  (target %8.3f ms) %s\n", name, ms, targetMs, ms <= targetMs ? "ok" : "MISSED");
+}
+
+// Best effort: drops the file's clean pages so the next read goes to disk.
+inline void evictFromPageCache(const std::filesystem::path& path) {
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+} // namespace notascore::bench
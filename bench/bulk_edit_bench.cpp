@@ -0,0 +1,66 @@
+#include "BenchCommon.hpp"
+
+#include <cstdio>
+
+// Bulk edits over a 1M-note score: transposing every note, then a velocity
+// change on half of them, each as one undo step with the layout kept
+// incremental. Compared with the same transpose done note by note through
+// modifyNote().
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 1'000'000;
+
+} // namespace
+
+int main() {
+    const auto notes = bench::makeSyntheticScore(kNotes);
+    const auto count = static_cast<std::uint32_t>(notes.size());
+    const std::vector<notation::NoteRange> all {{0, count}};
+
+    notation::NotationEngine engine;
+    engine.addNotes(notes);
+    engine.recomputeLayoutIfNeeded();
+    engine.clearUndoHistory();
+
+    bench::Stopwatch transpose;
+    engine.applyBulkEdit({.kind = notation::BulkEditKind::Transpose, .amount = 2}, all);
+    const double transposeMs = transpose.elapsedMs();
+    bench::report("bulk transpose 1M notes (edit + undo step)", transposeMs, 50.0);
+
+    std::vector<notation::NoteRange> everyOtherMeasure;
+    for (std::uint32_t m = 0; m + 1 < engine.layout().measureFirstNote.size(); m += 2) {
+        everyOtherMeasure.push_back({engine.layout().measureFirstNote[m], engine.layout().measureFirstNote[m + 1]});
+    }
+    bench::Stopwatch velocity;
+    engine.applyBulkEdit({.kind = notation::BulkEditKind::ScaleVelocities, .amount = 9, .divisor = 10}, everyOtherMeasure);
+    bench::report("bulk velocity scale, every other measure", velocity.elapsedMs(), 50.0);
+
+    bench::Stopwatch relayout;
+    engine.recomputeLayoutIfNeeded();
+    bench::report("relayout after bulk edits", relayout.elapsedMs(), 1000.0);
+
+    bench::Stopwatch undo;
+    engine.undo();
+    engine.undo();
+    bench::report("undo both bulk edits", undo.elapsedMs(), 100.0);
+
+    // Baseline: the same transpose as individual edits, on the first 1000 notes;
+    // each one moves the storage tail, so it is extrapolated.
+    notation::NotationEngine perNote;
+    perNote.addNotes(notes);
+    perNote.recomputeLayoutIfNeeded();
+    bench::Stopwatch modify;
+    constexpr std::size_t kSampled = 1000;
+    for (std::size_t i = 0; i < kSampled; ++i) {
+        auto note = perNote.notes()[i];
+        note.midiPitch += 2;
+        perNote.modifyNote(i, note);
+    }
+    perNote.commitUndoStep();
+    const double perNoteMs = modify.elapsedMs() * (kNotes / kSampled);
+    std::printf("per-note transpose of 1M notes, extrapolated: %.0f ms (bulk is %.0fx faster)\n", perNoteMs,
+        perNoteMs / transposeMs);
+    return engine.notes()[0] == notes[0] ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include "BenchCommon.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+// Importing 1M notes through addNotes() versus repeated addNote() calls, for
+// tick-ordered input (MIDI tracks) and shuffled input (multi-track merges).
+int main() {
+    using namespace notascore;
+
+    const auto ordered = bench::makeSyntheticScore(1'000'000);
+    auto shuffled = ordered;
+    bench::Rng rng(11);
+    for (std::size_t i = shuffled.size() - 1; i > 0; --i) {
+        std::swap(shuffled[i], shuffled[rng.next() % (i + 1)]);
+    }
+
+    const auto timeSingle = [](std::span<const notation::NoteEvent> notes) {
+        notation::NotationEngine engine;
+        bench::Stopwatch watch;
+        for (const auto& note : notes) {
+            engine.addNote(note);
+        }
+        return watch.elapsedMs();
+    };
+    const auto timeBulk = [](std::span<const notation::NoteEvent> notes) {
+        notation::NotationEngine engine;
+        bench::Stopwatch watch;
+        engine.addNotes(notes);
+        return watch.elapsedMs();
+    };
+
+    std::printf("1M ordered:   addNote x N %9.3f ms, addNotes %9.3f ms\n", timeSingle(ordered), timeBulk(ordered));
+    std::printf("1M shuffled:  addNotes %9.3f ms (repeated addNote is quadratic here)\n", timeBulk(shuffled));
+
+    const std::span<const notation::NoteEvent> sample(shuffled.data(), 50'000);
+    std::printf("50k shuffled: addNote x N %9.3f ms, addNotes %9.3f ms\n", timeSingle(sample), timeBulk(sample));
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/Collision.hpp"
+
+#include <cstdio>
+
+// Collision pass on dense orchestral-style pages: four-note chords on every
+// sixteenth with chromatic pitches, an articulation and a lyric per onset and
+// two dynamics per measure. Compares the grid broadphase with all-pairs checks.
+namespace {
+
+using namespace notascore;
+
+notation::NotationEngine makeDenseScore(int measures) {
+    notation::NotationEngine engine;
+    bench::Rng rng(5);
+    auto batch = engine.beginBatch(static_cast<std::size_t>(measures) * 64);
+    for (int m = 0; m < measures; ++m) {
+        for (int tick = m * 1920; tick < (m + 1) * 1920; tick += 120) {
+            for (int voice = 0; voice < 4; ++voice) {
+                batch.add({.tick = tick, .duration = 120, .midiPitch = rng.range(48, 88)});
+            }
+            engine.addMarking({.tick = tick, .kind = notation::MarkingKind::Articulation, .width = 0.8f});
+            engine.addMarking({.tick = tick, .kind = notation::MarkingKind::Lyric, .width = 2.2f});
+        }
+        engine.addMarking({.tick = m * 1920, .kind = notation::MarkingKind::Dynamic, .width = 2.0f});
+        engine.addMarking({.tick = m * 1920 + 960, .kind = notation::MarkingKind::Dynamic, .width = 2.0f});
+    }
+    batch.commit();
+    return engine;
+}
+
+// Replays the collision pass's broadphase work on the final boxes of every
+// system (noteheads inserted, then each glyph queried and inserted), through
+// the grid or against every previous box.
+struct Broadphase {
+    double gridMs {0.0};
+    double allPairsMs {0.0};
+    std::size_t overlaps {0};
+};
+
+Broadphase compareBroadphase(const notation::NotationEngine& engine) {
+    const auto& layout = engine.layout();
+    const auto& options = engine.layoutOptions();
+    Broadphase result;
+    notation::SpatialGrid grid;
+    std::vector<notation::Box> boxes;
+    std::vector<notation::Box> placed;
+    std::size_t gridHits = 0;
+    for (std::size_t s = 0; s < layout.systemCount(); ++s) {
+        boxes.clear();
+        const auto nFirst = layout.measureFirstNote[layout.systemFirstMeasure[s]];
+        const auto fixed = layout.measureFirstNote[layout.systemFirstMeasure[s + 1]] - nFirst;
+        for (auto n = layout.measureFirstNote[layout.systemFirstMeasure[s]];
+             n < layout.measureFirstNote[layout.systemFirstMeasure[s + 1]]; ++n) {
+            boxes.push_back({.x0 = layout.noteX[n], .y0 = layout.noteY[n] - 0.5f, .x1 = layout.noteX[n] + 1.18f,
+                .y1 = layout.noteY[n] + 0.5f});
+        }
+        for (const auto& item : layout.systemItems[s]) {
+            boxes.push_back({.x0 = item.x, .y0 = item.y, .x1 = item.x + item.width, .y1 = item.y + item.height});
+        }
+
+        bench::Stopwatch gridWatch;
+        grid.reset(options.marginX - 16.0f, -1.5f * options.systemHeight, options.lineWidth() + 32.0f,
+            3.0f * options.systemHeight, 2.0f);
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            gridHits += i >= fixed && grid.overlaps(boxes[i]) ? 1 : 0;
+            grid.insert(boxes[i]);
+        }
+        result.gridMs += gridWatch.elapsedMs();
+
+        bench::Stopwatch pairWatch;
+        placed.clear();
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            for (std::size_t j = 0; i >= fixed && j < placed.size(); ++j) {
+                if (boxes[i].intersects(placed[j])) {
+                    ++result.overlaps;
+                    break;
+                }
+            }
+            placed.push_back(boxes[i]);
+        }
+        result.allPairsMs += pairWatch.elapsedMs();
+    }
+    result.overlaps += gridHits == result.overlaps ? 0 : 1'000'000;
+    return result;
+}
+
+// One orchestral system of `staves` stacked staves filled with glyphs: the case
+// where per-system box counts get large and all-pairs checks turn quadratic.
+void orchestralSystem(int staves) {
+    bench::Rng rng(static_cast<std::uint32_t>(staves));
+    std::vector<notation::Box> boxes;
+    const float height = static_cast<float>(staves) * 12.0f;
+    for (int staff = 0; staff < staves; ++staff) {
+        for (int glyph = 0; glyph < 400; ++glyph) {
+            const float x = static_cast<float>(rng.range(0, 1040)) * 0.1f;
+            const float y = static_cast<float>(staff) * 12.0f + static_cast<float>(rng.range(0, 100)) * 0.1f;
+            boxes.push_back({.x0 = x, .y0 = y, .x1 = x + 1.0f, .y1 = y + 1.0f});
+        }
+    }
+
+    std::size_t gridHits = 0;
+    bench::Stopwatch gridWatch;
+    notation::SpatialGrid grid;
+    grid.reset(0.0f, 0.0f, 106.0f, height, 2.0f);
+    for (const auto& box : boxes) {
+        gridHits += grid.overlaps(box) ? 1 : 0;
+        grid.insert(box);
+    }
+    const double gridMs = gridWatch.elapsedMs();
+
+    std::size_t pairHits = 0;
+    bench::Stopwatch pairWatch;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            if (boxes[i].intersects(boxes[j])) {
+                ++pairHits;
+                break;
+            }
+        }
+    }
+    const double pairMs = pairWatch.elapsedMs();
+    std::printf("orchestral system, %2d staves (%5zu glyphs): grid %7.3f ms, all pairs %8.3f ms%s\n", staves,
+        boxes.size(), gridMs, pairMs, gridHits == pairHits ? "" : "  MISMATCH");
+}
+
+} // namespace
+
+int main() {
+    auto engine = makeDenseScore(2'000);
+    engine.recomputeLayoutIfNeeded();
+
+    const auto& layout = engine.layout();
+    std::size_t items = 0;
+    for (const auto& system : layout.systemItems) {
+        items += system.size();
+    }
+    std::printf("dense score: %zu notes, %zu placed glyphs, %zu systems, %zu pages\n", engine.noteCount(), items,
+        layout.systemCount(), layout.pageCount());
+
+    double bestMs = 1e9;
+    for (int run = 0; run < 5; ++run) {
+        engine.setDirty();
+        bench::Stopwatch watch;
+        engine.recomputeLayoutIfNeeded();
+        bestMs = std::min(bestMs, watch.elapsedMs());
+    }
+    const double perPage = bestMs / static_cast<double>(layout.pageCount());
+    bench::report("full layout incl. collisions, per page", perPage, 1.0);
+
+    const auto pages = static_cast<double>(layout.pageCount());
+    const auto broadphase = compareBroadphase(engine);
+    std::printf("broadphase per page: grid %.3f ms, all pairs %.3f ms (%zu overlaps left)\n", broadphase.gridMs / pages,
+        broadphase.allPairsMs / pages, broadphase.overlaps);
+    for (const int staves : {4, 16, 32}) {
+        orchestralSystem(staves);
+    }
+    return broadphase.overlaps == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "BenchCommon.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Single-note edits in a ~500-page score. Target: < 2 ms per edit including the
+// relayout pass, mean, 99th percentile and worst, versus a full relayout of the
+// same score; the same for edits in the first measure, and with layout
+// publishing on, where each pass also publishes a version for reader threads.
+int main() {
+    using namespace notascore;
+
+    const auto notes = bench::makeSyntheticScore(220'000);
+    notation::NotationEngine engine;
+    for (const auto& note : notes) {
+        engine.addNote(note);
+    }
+
+    bench::Stopwatch fullWatch;
+    engine.recomputeLayoutIfNeeded();
+    const double fullMs = fullWatch.elapsedMs();
+    std::printf("score: %zu notes, %zu measures, %zu systems, %zu pages\n", engine.noteCount(),
+        engine.layout().measureCount(), engine.layout().systemCount(), engine.layout().pageCount());
+    bench::report("full relayout", fullMs, 0.15 * static_cast<double>(engine.noteCount()) / 1000.0);
+
+    constexpr int kEdits = 200;
+    bench::Rng rng(7);
+    std::size_t measures = 0;
+    std::size_t systems = 0;
+    std::size_t pages = 0;
+    struct EditTimes {
+        double meanMs {0.0};
+        double p99Ms {0.0};
+        double worstMs {0.0};
+    };
+    // Edits in random measures, or all in the first one, where every later break
+    // could move.
+    const auto edits = [&](bool firstMeasure) {
+        std::vector<double> times;
+        for (int i = 0; i < kEdits; ++i) {
+            const int measure = firstMeasure ? 0 : rng.range(0, static_cast<int>(engine.layout().measureCount()) - 2);
+            bench::Stopwatch one;
+            engine.addNote({.tick = measure * 1920 + rng.range(0, 15) * 120, .duration = 120, .midiPitch = rng.range(55, 84)});
+            engine.recomputeLayoutIfNeeded();
+            times.push_back(one.elapsedMs());
+            measures += engine.lastPassStats().measuresRespaced;
+            systems += engine.lastPassStats().systemsJustified;
+            pages += engine.lastPassStats().pagesStacked;
+        }
+        std::ranges::sort(times);
+        double total = 0.0;
+        for (const double ms : times) {
+            total += ms;
+        }
+        return EditTimes {.meanMs = total / kEdits, .p99Ms = times[kEdits * 99 / 100], .worstMs = times.back()};
+    };
+    const auto report = [](const char* name, const EditTimes& times) {
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s (mean)", name);
+        bench::report(label, times.meanMs, 2.0);
+        std::snprintf(label, sizeof(label), "%s (p99)", name);
+        bench::report(label, times.p99Ms, 2.0);
+        std::snprintf(label, sizeof(label), "%s (worst)", name);
+        bench::report(label, times.worstMs, 2.0);
+    };
+    report("single-note edit + relayout", edits(false));
+    std::printf("per edit: %.2f measures respaced, %.2f systems justified, %.2f pages stacked\n",
+        static_cast<double>(measures) / kEdits, static_cast<double>(systems) / kEdits, static_cast<double>(pages) / kEdits);
+    report("edit in the first measure", edits(true));
+
+    // A reader keeps the first version pinned throughout, as a slow render would.
+    engine.enableLayoutPublishing();
+    const auto pinned = engine.pinLayout();
+    report("edit + relayout + publish", edits(false));
+    const auto latest = engine.pinLayout();
+    std::vector<const notation::PublishedSystem*> first;
+    for (const auto& system : pinned->layout.systems) {
+        first.push_back(system.get());
+    }
+    std::ranges::sort(first);
+    std::size_t shared = 0;
+    for (const auto& system : latest->layout.systems) {
+        shared += std::ranges::binary_search(first, system.get()) ? 1 : 0;
+    }
+    std::printf("after %d published edits, %zu of %zu systems still shared with the first version\n", kEdits, shared,
+        latest->layout.systemCount());
+    return 0;
+}
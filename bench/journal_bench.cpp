@@ -0,0 +1,70 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/io/EditJournal.hpp"
+
+#include <cstdio>
+#include <filesystem>
+
+// Edit journal: append throughput and size of 1M single-note edits, replay of
+// those edits, and rebuilding a 220k-note document from its journal versus
+// inserting the raw notes (the work a full load does after parsing).
+int main() {
+    using namespace notascore;
+    const auto path = std::filesystem::temp_directory_path() / "notascore_journal_bench.nsxj";
+    std::filesystem::remove(path);
+
+    constexpr std::size_t kEdits = 1'000'000;
+    const auto notes = bench::makeSyntheticScore(kEdits);
+
+    double appendMs = 0.0;
+    std::uint64_t bytes = 0;
+    {
+        io::EditJournal journal;
+        journal.open(path);
+        bench::Stopwatch watch;
+        for (std::size_t i = 0; i < notes.size(); ++i) {
+            journal.append({.kind = notation::EditKind::AddNotes, .notes = std::span(&notes[i], 1)});
+        }
+        journal.sync();
+        appendMs = watch.elapsedMs();
+        bytes = journal.bytesWritten();
+    }
+    bench::Stopwatch replayWatch;
+    notation::NotationEngine replayed;
+    io::EditJournal::replay(path, replayed);
+    const double replayMs = replayWatch.elapsedMs();
+
+    std::printf("1M note inserts: %.2f bytes/edit (raw note %zu bytes)\n", static_cast<double>(bytes) / kEdits,
+        sizeof(notation::NoteEvent));
+    bench::report("append 1M edits + fsync", appendMs, 100.0);
+    bench::report("replay 1M edits", replayMs, 200.0);
+
+    // Whole-document journal (one bulk import) versus inserting the notes directly.
+    const auto score = bench::makeSyntheticScore(220'000, 3);
+    {
+        io::EditJournal journal;
+        journal.open(path);
+        journal.reset();
+        notation::NotationEngine engine;
+        journal.attach(engine);
+        engine.addNotes(score);
+        for (int i = 0; i < 10'000; ++i) {
+            engine.addNote({.tick = (i * 613) % 1'000'000, .duration = 120, .midiPitch = 60 + i % 12});
+        }
+    }
+    bench::Stopwatch rebuildWatch;
+    notation::NotationEngine rebuilt;
+    io::EditJournal::replay(path, rebuilt);
+    const double rebuildMs = rebuildWatch.elapsedMs();
+    bench::Stopwatch directWatch;
+    notation::NotationEngine direct;
+    direct.addNotes(score);
+    const double directMs = directWatch.elapsedMs();
+    std::printf("220k-note document + 10k edits: journal %.1f KiB\n",
+        static_cast<double>(std::filesystem::file_size(path)) / 1024.0);
+    bench::report("rebuild from journal", rebuildMs, 60.0);
+    bench::report("insert raw notes (no edits)", directMs, 60.0);
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#include "BenchCommon.hpp"
+
+#include <cstdio>
+
+// Full layout (measures, spacing, breaking, justification, pages) of synthetic
+// scores, including the collision pass. Target: 0.15 us/note single-threaded,
+// i.e. 150 ms for 1M notes.
+int main() {
+    using namespace notascore;
+
+    constexpr double kTargetUsPerNote = 0.15;
+    for (const std::size_t count : {std::size_t {10'000}, std::size_t {100'000}, std::size_t {1'000'000}}) {
+        const auto notes = bench::makeSyntheticScore(count);
+
+        notation::NotationEngine engine;
+        for (const auto& note : notes) {
+            engine.addNote(note);
+        }
+
+        bench::Stopwatch watch;
+        engine.recomputeLayoutIfNeeded();
+        const double ms = watch.elapsedMs();
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "layout %zu notes (%zu pages)", count, engine.layout().pageCount());
+        bench::report(name, ms, kTargetUsPerNote * static_cast<double>(count) / 1000.0);
+    }
+    return 0;
+}
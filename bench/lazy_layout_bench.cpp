@@ -0,0 +1,64 @@
+#include "BenchCommon.hpp"
+
+#include <cstdio>
+
+// Time to first page when opening an 800-page score: the full layout against
+// lazy pages (measure widths, breaks and pages for the whole score, notes and
+// collisions for the first pages only). Then a jump to the middle of the score
+// and, in low-memory mode, a scroll through every page with eviction.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 270'000;
+
+double openMs(const std::vector<notation::NoteEvent>& notes, const notation::LayoutOptions& options,
+    notation::NotationEngine& engine) {
+    bench::Stopwatch watch;
+    engine.setLayoutOptions(options);
+    engine.addNotes(notes);
+    engine.recomputeLayoutIfNeeded();
+    return watch.elapsedMs();
+}
+
+std::size_t itemCount(const notation::LayoutResult& layout) {
+    std::size_t count = 0;
+    for (const auto& items : layout.systemItems) {
+        count += items.capacity();
+    }
+    return count;
+}
+
+} // namespace
+
+int main() {
+    const auto notes = bench::makeSyntheticScore(kNotes);
+
+    notation::NotationEngine eager;
+    const double eagerMs = openMs(notes, {}, eager);
+    char name[64];
+    std::snprintf(name, sizeof(name), "open %zu pages, full layout", eager.layout().pageCount());
+    bench::report(name, eagerMs, 60.0);
+
+    notation::NotationEngine lazy;
+    const double lazyMs = openMs(notes, {.lazyPages = true}, lazy);
+    bench::report("open, lazy pages (time to first page)", lazyMs, 30.0);
+
+    bench::Stopwatch jump;
+    lazy.setViewport(lazy.layout().pageCount() / 2, lazy.layout().pageCount() / 2 + 1);
+    bench::report("jump to middle page", jump.elapsedMs(), 1.0);
+
+    notation::NotationEngine lowMemory;
+    openMs(notes, {.lowMemoryMode = true, .lazyPages = true}, lowMemory);
+    bench::Stopwatch scroll;
+    std::size_t peakItems = 0;
+    for (std::size_t page = 0; page < lowMemory.layout().pageCount(); ++page) {
+        lowMemory.setViewport(page, page + 1);
+        peakItems = std::max(peakItems, itemCount(lowMemory.layout()));
+    }
+    bench::report("scroll every page, low memory", scroll.elapsedMs(), 100.0);
+
+    std::printf("time to first page %.1fx faster; collision items held while scrolling: %zu (full layout: %zu)\n",
+        eagerMs / lazyMs, peakItems, itemCount(eager.layout()));
+    return 0;
+}
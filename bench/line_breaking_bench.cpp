@@ -0,0 +1,98 @@
+#include "BenchCommon.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+// System breaking of a 5,000-measure document: greedy versus optimal (full and
+// after a single-measure edit), and the raggedness each leaves behind.
+namespace {
+
+using namespace notascore;
+
+struct Raggedness {
+    double worstStretch {1.0};
+    double meanStretch {1.0};
+};
+
+// Justification stretch of every system but the last.
+Raggedness measure(std::span<const float> widths, std::span<const std::uint32_t> breaks, float lineWidth) {
+    Raggedness result {.worstStretch = 1.0, .meanStretch = 0.0};
+    const std::size_t systems = breaks.size() - 1;
+    for (std::size_t s = 0; s + 1 < systems; ++s) {
+        double natural = 0.0;
+        for (std::size_t m = breaks[s]; m < breaks[s + 1]; ++m) {
+            natural += widths[m];
+        }
+        const double stretch = lineWidth / natural;
+        result.worstStretch = std::max(result.worstStretch, stretch);
+        result.meanStretch += stretch;
+    }
+    result.meanStretch /= static_cast<double>(std::max<std::size_t>(systems - 1, 1));
+    return result;
+}
+
+} // namespace
+
+int main() {
+    constexpr std::size_t kMeasures = 5000;
+    constexpr int kRuns = 20;
+
+    notation::LayoutOptions options;
+    auto notes = bench::makeSyntheticScore(kMeasures * 11);
+    notes.erase(std::remove_if(notes.begin(), notes.end(),
+                    [&](const notation::NoteEvent& note) {
+                        return note.tick >= static_cast<int>(kMeasures) * options.measureTicks;
+                    }),
+        notes.end());
+
+    const std::size_t measureCount = notation::layout::measureCountFor(notes, options);
+    notation::LayoutResult result;
+    result.noteMeasure.resize(notes.size());
+    result.noteY.resize(notes.size());
+    result.measureFirstNote.resize(measureCount + 1);
+    result.measureFirstNote[measureCount] = static_cast<std::uint32_t>(notes.size());
+    notation::layout::indexMeasures(notes, options, 0, measureCount, result);
+    notation::MeasureSpacing spacing;
+    spacing.naturalWidth.resize(measureCount);
+    spacing.noteOffset.resize(notes.size());
+    notation::layout::spaceMeasures(notes, options, 0, measureCount, result, spacing);
+    auto& widths = spacing.naturalWidth;
+    const float lineWidth = options.lineWidth();
+
+    std::vector<std::uint32_t> greedy;
+    bench::Stopwatch greedyWatch;
+    for (int run = 0; run < kRuns; ++run) {
+        greedy = notation::layout::breakSystemsGreedy(widths, lineWidth);
+    }
+    const double greedyMs = greedyWatch.elapsedMs() / kRuns;
+
+    std::vector<std::uint32_t> optimal;
+    notation::LineBreakState state;
+    bench::Stopwatch optimalWatch;
+    for (int run = 0; run < kRuns; ++run) {
+        optimal = notation::layout::breakSystemsOptimal(widths, lineWidth, 0, state);
+    }
+    const double optimalMs = optimalWatch.elapsedMs() / kRuns;
+
+    // A widened measure in the middle only recomputes the DP from there until the
+    // breaks settle back onto the old ones.
+    bench::Stopwatch editWatch;
+    for (int run = 0; run < kRuns; ++run) {
+        widths[kMeasures / 2] += run % 2 == 0 ? 6.0f : -6.0f;
+        optimal = notation::layout::breakSystemsOptimal(widths, lineWidth, kMeasures / 2, state, kMeasures / 2 + 1);
+    }
+    const double editMs = editWatch.elapsedMs() / kRuns;
+
+    std::printf("%zu measures, %zu notes\n", measureCount, notes.size());
+    bench::report("greedy breaking", greedyMs, 1.0);
+    bench::report("optimal breaking (full)", optimalMs, 5.0);
+    bench::report("optimal breaking (edit at middle)", editMs, 2.5);
+
+    const auto greedyShape = measure(widths, greedy, lineWidth);
+    const auto optimalShape = measure(widths, optimal, lineWidth);
+    std::printf("greedy:  %zu systems, mean stretch %.3f, worst %.3f\n", greedy.size() - 1, greedyShape.meanStretch,
+        greedyShape.worstStretch);
+    std::printf("optimal: %zu systems, mean stretch %.3f, worst %.3f\n", optimal.size() - 1, optimalShape.meanStretch,
+        optimalShape.worstStretch);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/MeasureCache.hpp"
+#include "notascore/notation/Score.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Memoized measure spacing: hit rate and time saved on a 24-part orchestral
+// score (doublings, ostinatos, tacet passages) and on a synthetic score that
+// repeats one 8-bar phrase, versus spacing every measure from scratch; and the
+// warm spacing pass with the parts split over 4 threads sharing the cache,
+// whose shards keep them from queueing on one lock.
+namespace {
+
+using namespace notascore;
+
+constexpr int kMeasures = 800;
+constexpr int kMeasureTicks = 1920;
+
+std::vector<notation::NoteEvent> firstMeasures(std::vector<notation::NoteEvent> notes, int measures) {
+    std::erase_if(notes, [&](const notation::NoteEvent& note) { return note.tick >= measures * kMeasureTicks; });
+    return notes;
+}
+
+// Repeats the first `period` measures of `source` across the whole score.
+std::vector<notation::NoteEvent> repeated(const std::vector<notation::NoteEvent>& source, int period) {
+    const auto phrase = firstMeasures(source, period);
+    std::vector<notation::NoteEvent> notes;
+    for (int start = 0; start < kMeasures; start += period) {
+        for (auto note : phrase) {
+            note.tick += start * kMeasureTicks;
+            notes.push_back(note);
+        }
+    }
+    return notes;
+}
+
+void fillOrchestra(notation::Score& score) {
+    std::vector<notation::NoteEvent> previous;
+    for (int p = 0; p < 24; ++p) {
+        auto& part = score.addPart("Part " + std::to_string(p), "C2-C7");
+        const auto fresh = firstMeasures(bench::makeSyntheticScore(kMeasures * 12, static_cast<std::uint32_t>(p + 1)), kMeasures);
+        std::vector<notation::NoteEvent> notes;
+        switch (p % 4) {
+        case 0: // independent line
+            notes = fresh;
+            break;
+        case 1: // doubles the previous part
+            notes = previous;
+            break;
+        case 2: // two-bar ostinato
+            notes = repeated(fresh, 2);
+            break;
+        default: // plays every other 16-bar phrase, tacet otherwise
+            for (const auto& note : fresh) {
+                if (note.tick / kMeasureTicks / 16 % 2 == 0) {
+                    notes.push_back(note);
+                }
+            }
+            break;
+        }
+        part.voice(0, 0)->addNotes(notes);
+        previous = notes;
+    }
+}
+
+void fillRepetitive(notation::Score& score) {
+    const auto phrase = repeated(bench::makeSyntheticScore(8 * 12, 7), 8);
+    for (int p = 0; p < 4; ++p) {
+        score.addPart("Part " + std::to_string(p), "C2-C7").voice(0, 0)->addNotes(phrase);
+    }
+}
+
+void run(const char* name, void (*fill)(notation::Score&)) {
+    notation::Score uncached;
+    fill(uncached);
+    for (std::size_t p = 0; p < uncached.partCount(); ++p) {
+        uncached.part(p).setMeasureCache(nullptr);
+    }
+    notation::Score cached;
+    fill(cached);
+
+    bench::Stopwatch uncachedWatch;
+    uncached.recomputeLayoutIfNeeded();
+    const double uncachedMs = uncachedWatch.elapsedMs();
+    bench::Stopwatch cachedWatch;
+    cached.recomputeLayoutIfNeeded();
+    const double cachedMs = cachedWatch.elapsedMs();
+    const double hitRate = cached.measureCache().hitRate();
+
+    // Spacing pass alone, where the cache applies; best of several runs.
+    const auto spacingMs = [](notation::Score& score, notation::MeasureCache* cache, std::size_t threads) {
+        // Buffers are set up outside the timed part.
+        std::vector<notation::LayoutResult> results;
+        std::vector<notation::MeasureSpacing> spacings;
+        for (std::size_t p = 0; p < score.partCount(); ++p) {
+            const auto* engine = score.part(p).voice(0, 0);
+            results.push_back(engine->layout());
+            spacings.push_back({.naturalWidth = std::vector<float>(results.back().measureCount()),
+                .noteOffset = std::vector<float>(engine->noteCount())});
+        }
+        const auto space = [&](std::size_t t) {
+            for (std::size_t p = t; p < score.partCount(); p += threads) {
+                const auto* engine = score.part(p).voice(0, 0);
+                notation::layout::spaceMeasures(engine->notes(), engine->layoutOptions(), 0, results[p].measureCount(),
+                    results[p], spacings[p], cache);
+            }
+        };
+        double best = 1e9;
+        for (int run = 0; run < 10; ++run) {
+            bench::Stopwatch watch;
+            std::vector<std::thread> workers;
+            for (std::size_t t = 1; t < threads; ++t) {
+                workers.emplace_back(space, t);
+            }
+            space(0);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            best = std::min(best, watch.elapsedMs());
+        }
+        return best;
+    };
+    const double spaceUncachedMs = spacingMs(uncached, nullptr, 1);
+    const double spaceCachedMs = spacingMs(cached, &cached.measureCache(), 1);
+    const double parallelUncachedMs = spacingMs(uncached, nullptr, 4);
+    const double parallelCachedMs = spacingMs(cached, &cached.measureCache(), 4);
+
+    std::printf("%s: %zu parts, %zu notes, hit rate %.1f%% (%zu entries)\n", name, cached.partCount(),
+        cached.noteCount(), hitRate * 100.0, cached.measureCache().size());
+    std::printf("  full layout  %9.3f ms -> %9.3f ms\n", uncachedMs, cachedMs);
+    std::printf("  spacing pass %9.3f ms -> %9.3f ms (warm cache)\n", spaceUncachedMs, spaceCachedMs);
+    std::printf("  on 4 threads %9.3f ms -> %9.3f ms (warm cache, %u hardware threads)\n", parallelUncachedMs,
+        parallelCachedMs, std::thread::hardware_concurrency());
+}
+
+} // namespace
+
+int main() {
+    run("orchestral (24 parts x 800 measures)", fillOrchestra);
+    run("repetitive (8-bar phrase x 100)", fillRepetitive);
+    return 0;
+}
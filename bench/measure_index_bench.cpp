@@ -0,0 +1,64 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/Score.hpp"
+
+#include <cstdio>
+
+// Bar lookups on a 1M-note score with a pickup and 1000 meter changes: 1M
+// tick -> bar and bar -> tick lookups, 100k "notes in bar N" queries, and meter
+// edits in the middle of the score.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 1'000'000;
+constexpr std::size_t kLookups = 1'000'000;
+
+} // namespace
+
+int main() {
+    static constexpr notation::Meter kMeters[] {{4, 4}, {3, 4}, {6, 8}, {5, 8}, {2, 2}, {7, 16}};
+    bench::Rng rng(5);
+    notation::Score score;
+    auto& engine = *score.addPart("Piano", "A0-C8").voice(0, 0);
+    engine.addNotes(bench::makeSyntheticScore(kNotes));
+    score.setPickup(480);
+    for (std::uint32_t bar = 40; bar < 40'000; bar += 40) {
+        score.setMeter(bar, kMeters[rng.next() % 6]);
+    }
+    const auto& index = engine.measureIndex();
+    const auto lastTick = engine.notes().back().tick;
+    const auto barCount = index.barAt(lastTick) + 1;
+
+    bench::Stopwatch toBar;
+    std::uint64_t checksum = 0;
+    for (std::size_t i = 0; i < kLookups; ++i) {
+        checksum += index.barAt(static_cast<notation::Tick>(rng.next() % static_cast<std::uint32_t>(lastTick)));
+    }
+    bench::report("1M tick->bar lookups", toBar.elapsedMs(), 50.0);
+
+    bench::Stopwatch toTick;
+    for (std::size_t i = 0; i < kLookups; ++i) {
+        checksum += static_cast<std::uint64_t>(index.barStart(rng.next() % barCount));
+    }
+    bench::report("1M bar->tick lookups", toTick.elapsedMs(), 50.0);
+
+    bench::Stopwatch inBar;
+    std::uint64_t found = 0;
+    for (std::size_t i = 0; i < kLookups / 10; ++i) {
+        const auto range = engine.notesInBar(rng.next() % barCount);
+        found += range.last - range.first;
+    }
+    bench::report("100k notes-in-bar queries", inBar.elapsedMs(), 100.0);
+
+    bench::Stopwatch edits;
+    for (int i = 0; i < 1000; ++i) {
+        score.setMeter(20'000 + static_cast<std::uint32_t>(i % 37), kMeters[i % 6]);
+    }
+    const double editMs = edits.elapsedMs();
+    bench::report("1000 meter edits mid-score", editMs, 5.0);
+
+    std::printf("%u bars, %zu meter changes; %.1f notes per queried bar; %.2f us per meter edit\n", barCount,
+        index.meterChangeCount(), static_cast<double>(found) / (kLookups / 10), editMs * 1000.0 / 1000);
+    return checksum != 0 ? 0 : 1;
+}
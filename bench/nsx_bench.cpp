@@ -0,0 +1,56 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/io/NsxDocument.hpp"
+#include "notascore/notation/Score.hpp"
+
+#include <cstdio>
+#include <filesystem>
+
+// NSX v2 throughput on a 1M-note score of 16 parts: save, full load into a
+// Score (decode plus bulk insert into every voice), and reading only the chunk
+// table, as a loader planning its reads does.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kParts = 16;
+constexpr std::size_t kNotesPerPart = 1'000'000 / kParts;
+
+} // namespace
+
+int main() {
+    notation::Score score;
+    for (std::size_t p = 0; p < kParts; ++p) {
+        auto& part = score.addPart("Part " + std::to_string(p), "C2-C7");
+        part.voice(0, 0)->addNotes(bench::makeSyntheticScore(kNotesPerPart, static_cast<std::uint32_t>(p + 1)));
+        part.voice(0, 0)->addMarking({.tick = 0, .kind = notation::MarkingKind::Dynamic, .width = 2.0f});
+    }
+    score.part(0).recomputeLayoutIfNeeded();
+    const std::vector<io::NsxMetadataEntry> metadata {{"title", "Throughput"}, {"composer", "Bench"}};
+
+    io::NsxDocument document;
+    const auto path = std::filesystem::temp_directory_path() / "notascore_nsx_bench.nsx";
+    bench::Stopwatch save;
+    const bool saved = document.save(path, score, metadata);
+    const double saveMs = save.elapsedMs();
+    const double fileMiB = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    bench::report("save 1M notes, 16 parts", saveMs, 100.0);
+
+    notation::Score loaded;
+    io::NsxContents contents;
+    bench::Stopwatch load;
+    const bool read = document.load(path, loaded, &contents);
+    const double loadMs = load.elapsedMs();
+    bench::report("load 1M notes into a Score", loadMs, 150.0);
+
+    bench::Stopwatch table;
+    io::NsxReader reader;
+    const bool opened = reader.open(path);
+    bench::report("open + chunk table", table.elapsedMs(), 1.0);
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::printf("%.1f MiB file (%.1f bytes per note), %zu chunks; save %.0f MiB/s, load %.0f MiB/s\n", fileMiB,
+        fileMiB * 1024.0 * 1024.0 / 1e6, reader.chunks().size(), fileMiB / (saveMs / 1000.0), fileMiB / (loadMs / 1000.0));
+    return saved && read && opened && loaded.noteCount() == score.noteCount() && contents.metadata == metadata ? 0 : 1;
+}
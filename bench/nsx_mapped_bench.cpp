@@ -0,0 +1,139 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/io/MappedFile.hpp"
+#include "notascore/io/NsxDocument.hpp"
+#include "notascore/notation/Score.hpp"
+
+#include <cstdio>
+#include <filesystem>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Opening a 1M-note, 16-part NSX file mapped versus loading it through the
+// stream loader, cold (file evicted from the page cache) and warm: the mapped
+// open itself, reading the first page of music (the first 8 measures of every
+// part), a scan of every tick column (first reading the rest of the file, then
+// warm), the copy of one voice on its first edit, and promotion of the whole
+// document to a Score. Also reports how much of the file is resident after a
+// cold open plus first page, which is what the mapping read from disk.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kParts = 16;
+constexpr std::size_t kNotesPerPart = 1'000'000 / kParts;
+constexpr std::int64_t kFirstPageTicks = 8 * 1920;
+
+// Fraction of the file in the page cache.
+double resident(const std::filesystem::path& path) {
+#if !defined(_WIN32)
+    io::MappedFile file;
+    if (!file.open(path)) {
+        return 0.0;
+    }
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> pages((file.bytes().size() + page - 1) / page);
+    if (::mincore(const_cast<std::byte*>(file.bytes().data()), file.bytes().size(), pages.data()) != 0) {
+        return 0.0;
+    }
+    std::size_t count = 0;
+    for (const auto flags : pages) {
+        count += flags & 1u;
+    }
+    return static_cast<double>(count) / static_cast<double>(pages.size());
+#else
+    (void)path;
+    return 1.0;
+#endif
+}
+
+std::int64_t firstPage(const io::NsxMappedDocument& document) {
+    std::int64_t checksum = 0;
+    for (std::size_t p = 0; p < document.partCount(); ++p) {
+        const auto notes = document.notes(p, 0, 0);
+        const std::size_t end = notes.lowerBound(kFirstPageTicks);
+        for (std::size_t i = 0; i < end; ++i) {
+            checksum += notes.ticks[i] + notes.durations[i] + notes.pitches[i];
+        }
+    }
+    return checksum;
+}
+
+} // namespace
+
+int main() {
+    notation::Score score;
+    for (std::size_t p = 0; p < kParts; ++p) {
+        auto& part = score.addPart("Part " + std::to_string(p), "C2-C7");
+        part.voice(0, 0)->addNotes(bench::makeSyntheticScore(kNotesPerPart, static_cast<std::uint32_t>(p + 1)));
+    }
+    io::NsxDocument document;
+    const auto path = std::filesystem::temp_directory_path() / "notascore_nsx_mapped_bench.nsx";
+    if (!document.save(path, score)) {
+        return 1;
+    }
+
+    notation::Score loaded;
+    bench::evictFromPageCache(path);
+    bench::Stopwatch streamCold;
+    bool ok = document.load(path, loaded);
+    bench::report("stream load, cold", streamCold.elapsedMs(), 500.0);
+    bench::Stopwatch streamWarm;
+    ok = document.load(path, loaded) && ok;
+    bench::report("stream load, warm", streamWarm.elapsedMs(), 150.0);
+
+    io::NsxMappedDocument mapped;
+    bench::evictFromPageCache(path);
+    bench::Stopwatch mappedCold;
+    ok = mapped.open(path) && ok;
+    bench::report("mapped open, cold", mappedCold.elapsedMs(), 5.0);
+    bench::Stopwatch pageCold;
+    std::int64_t checksum = firstPage(mapped);
+    bench::report("first page of 16 parts, cold", pageCold.elapsedMs(), 20.0);
+    const double residentAfterPage = resident(path);
+
+    bench::Stopwatch mappedWarm;
+    ok = mapped.open(path) && ok;
+    bench::report("mapped open, warm", mappedWarm.elapsedMs(), 1.0);
+    bench::Stopwatch pageWarm;
+    checksum += firstPage(mapped);
+    bench::report("first page of 16 parts, warm", pageWarm.elapsedMs(), 1.0);
+
+    // The first scan reads the rest of the file, prefetched a voice at a time.
+    const auto scanTicks = [&](bool prefetch) {
+        for (std::size_t p = 0; p < mapped.partCount(); ++p) {
+            if (prefetch) {
+                mapped.prefetch(p, 0, 0);
+            }
+            for (const auto tick : mapped.notes(p, 0, 0).ticks) {
+                checksum += tick;
+            }
+        }
+    };
+    bench::Stopwatch scanCold;
+    scanTicks(true);
+    bench::report("prefetch + scan every tick column", scanCold.elapsedMs(), 50.0);
+    bench::Stopwatch scanWarm;
+    scanTicks(false);
+    bench::report("scan every tick column, warm", scanWarm.elapsedMs(), 5.0);
+
+    bench::Stopwatch edit;
+    auto* voice = mapped.edit(3, 0, 0);
+    bench::report("first edit copies one voice", edit.elapsedMs(), 10.0);
+    if (voice != nullptr) {
+        voice->addNote({.tick = 0, .duration = 480, .midiPitch = 60});
+    }
+    notation::Score promoted;
+    bench::Stopwatch promote;
+    ok = mapped.promote(promoted) && ok;
+    bench::report("promote to a Score", promote.elapsedMs(), 150.0);
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::printf("%.1f MiB mapped; %.1f%% resident after a cold open and first page\n",
+        static_cast<double>(mapped.mappedBytes()) / (1024.0 * 1024.0), 100.0 * residentAfterPage);
+    return ok && voice != nullptr && checksum != 0 && promoted.noteCount() == score.noteCount() + 1 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/core/TaskScheduler.hpp"
+#include "notascore/io/NsxDocument.hpp"
+#include "notascore/io/NsxStreamLoader.hpp"
+#include "notascore/notation/Score.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+// Time to first paint and total load time of a 1M-note, 16-part score, cold
+// (file evicted from the page cache) and warm: a full NsxDocument::load followed
+// by a layout pass, against NsxStreamLoader, which lays out as soon as start()
+// has published the first page and finishes in background tasks. First paint is
+// open plus the first layout pass; totals run until the whole score is laid
+// out.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kParts = 16;
+constexpr std::size_t kNotesPerPart = 1'000'000 / kParts;
+
+struct Timing {
+    double firstPaintMs {0.0};
+    double totalMs {0.0};
+};
+
+Timing fullLoad(const std::filesystem::path& path, bool& ok) {
+    notation::Score score;
+    bench::Stopwatch watch;
+    ok = io::NsxDocument {}.load(path, score) && ok;
+    score.recomputeLayoutIfNeeded();
+    const double ms = watch.elapsedMs();
+    return {ms, ms};
+}
+
+Timing streamingLoad(const std::filesystem::path& path, core::TaskScheduler& scheduler, std::size_t& reports, bool& ok) {
+    notation::Score score;
+    io::NsxStreamLoader loader;
+    loader.setProgressCallback([&](const io::NsxLoadProgress&) { ++reports; });
+    Timing timing;
+    bench::Stopwatch watch;
+    ok = loader.start(path, score, scheduler) && ok;
+    score.recomputeLayoutIfNeeded();
+    timing.firstPaintMs = watch.elapsedMs();
+    loader.finish();
+    score.recomputeLayoutIfNeeded();
+    timing.totalMs = watch.elapsedMs();
+    ok = ok && loader.progress().done() && !loader.progress().failed && score.noteCount() == kParts * kNotesPerPart;
+    return timing;
+}
+
+} // namespace
+
+int main() {
+    notation::Score score;
+    for (std::size_t p = 0; p < kParts; ++p) {
+        auto& part = score.addPart("Part " + std::to_string(p), "C2-C7");
+        part.voice(0, 0)->addNotes(bench::makeSyntheticScore(kNotesPerPart, static_cast<std::uint32_t>(p + 1)));
+    }
+    // Saved with page breaks, as an edited score would be.
+    score.part(0).recomputeLayoutIfNeeded();
+    const std::size_t pages = score.part(0).voice(0, 0)->layout().pageFirstSystem.size();
+    const auto path = std::filesystem::temp_directory_path() / "notascore_nsx_stream_bench.nsx";
+    if (!io::NsxDocument {}.save(path, score)) {
+        return 1;
+    }
+
+    core::TaskScheduler scheduler(std::max(2u, std::thread::hardware_concurrency()));
+    bool ok = true;
+    std::size_t reports = 0;
+    bench::evictFromPageCache(path);
+    const Timing fullCold = fullLoad(path, ok);
+    const Timing fullWarm = fullLoad(path, ok);
+    bench::evictFromPageCache(path);
+    const Timing streamCold = streamingLoad(path, scheduler, reports, ok);
+    const Timing streamWarm = streamingLoad(path, scheduler, reports, ok);
+
+    bench::report("full load + layout, cold", fullCold.totalMs, 300.0);
+    bench::report("full load + layout, warm", fullWarm.totalMs, 300.0);
+    bench::report("streaming first paint, cold", streamCold.firstPaintMs, 50.0);
+    bench::report("streaming first paint, warm", streamWarm.firstPaintMs, 16.0);
+    bench::report("streaming total, cold", streamCold.totalMs, 300.0);
+    bench::report("streaming total, warm", streamWarm.totalMs, 300.0);
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::printf("%zu pages in the first part; %zu progress reports over two streaming loads\n", pages, reports);
+    return ok ? 0 : 1;
+}
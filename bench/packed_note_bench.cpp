@@ -0,0 +1,97 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/io/NsxDocument.hpp"
+#include "notascore/notation/PackedNote.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+// Note records on a 1M-note document: memory of NoteEvent (32-bit tick),
+// PackedNote (48-bit tick, voice, flags) and a plain struct widened to a 64-bit
+// tick with the same fields; the speed of a full scan (latest end tick and
+// pitch histogram, as range checks and the overlap index do) over each; and an
+// NSX save and load of the first voice as PackedNote records.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 1'000'000;
+constexpr int kScans = 20;
+
+// What NoteEvent would become by widening the tick and adding voice and flags.
+struct WideNote {
+    std::int64_t tick {0};
+    int duration {0};
+    int midiPitch {60};
+    int velocity {80};
+    std::uint8_t voice {0};
+    std::uint8_t flags {0};
+};
+
+template <typename Notes, typename Tick, typename Duration, typename Pitch>
+double scan(const Notes& notes, Tick tick, Duration duration, Pitch pitch, std::int64_t& checksum) {
+    bench::Stopwatch watch;
+    for (int pass = 0; pass < kScans; ++pass) {
+        std::int64_t latestEnd = 0;
+        std::uint32_t histogram[128] {};
+        for (const auto& note : notes) {
+            latestEnd = std::max<std::int64_t>(latestEnd, static_cast<std::int64_t>(tick(note)) + duration(note));
+            ++histogram[pitch(note) & 0x7F];
+        }
+        checksum += latestEnd + histogram[60];
+    }
+    return watch.elapsedMs() / kScans;
+}
+
+} // namespace
+
+int main() {
+    const auto events = bench::makeSyntheticScore(kNotes);
+    std::vector<notation::PackedNote> packed;
+    std::vector<WideNote> wide;
+    packed.reserve(kNotes);
+    wide.reserve(kNotes);
+    for (const auto& note : events) {
+        packed.push_back(notation::PackedNote::pack(note));
+        wide.push_back({.tick = note.tick, .duration = note.duration, .midiPitch = note.midiPitch, .velocity = note.velocity});
+    }
+
+    std::int64_t checksum = 0;
+    const double eventMs = scan(
+        events, [](const auto& n) { return n.tick; }, [](const auto& n) { return n.duration; },
+        [](const auto& n) { return n.midiPitch; }, checksum);
+    const double wideMs = scan(
+        wide, [](const auto& n) { return n.tick; }, [](const auto& n) { return n.duration; },
+        [](const auto& n) { return n.midiPitch; }, checksum);
+    const double packedMs = scan(
+        packed, [](const auto& n) { return n.tick(); }, [](const auto& n) { return n.duration(); },
+        [](const auto& n) { return n.pitch(); }, checksum);
+    bench::report("scan 1M NoteEvent (32-bit tick)", eventMs, 5.0);
+    bench::report("scan 1M wide records (64-bit tick)", wideMs, 5.0);
+    bench::report("scan 1M PackedNote (48-bit tick)", packedMs, 5.0);
+
+    notation::NotationEngine engine;
+    engine.addNotes(events);
+    io::NsxDocument document;
+    const auto path = std::filesystem::temp_directory_path() / "notascore_packed_note_bench.nsx";
+    bench::Stopwatch save;
+    const bool saved = document.save(path, engine);
+    const double saveMs = save.elapsedMs();
+    bench::report("NSX save, 1M notes", saveMs, 100.0);
+    std::vector<notation::PackedNote> loaded;
+    bench::Stopwatch load;
+    const bool read = document.load(path, loaded);
+    const double loadMs = load.elapsedMs();
+    bench::report("NSX load to PackedNote, 1M notes", loadMs, 100.0);
+    std::error_code error;
+    const auto fileBytes = std::filesystem::file_size(path, error);
+    std::filesystem::remove(path, error);
+
+    constexpr double kMiB = 1024.0 * 1024.0;
+    std::printf("memory: NoteEvent %.1f MiB, wide %.1f MiB, packed %.1f MiB (%.0f%% of wide); file %.1f MiB\n",
+        static_cast<double>(kNotes * sizeof(notation::NoteEvent)) / kMiB, static_cast<double>(kNotes * sizeof(WideNote)) / kMiB,
+        static_cast<double>(kNotes * sizeof(notation::PackedNote)) / kMiB,
+        100.0 * sizeof(notation::PackedNote) / sizeof(WideNote), static_cast<double>(fileBytes) / kMiB);
+    return saved && read && loaded == packed && checksum != 0 ? 0 : 1;
+}
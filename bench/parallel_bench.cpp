@@ -0,0 +1,39 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/core/ThreadPool.hpp"
+
+#include <cstdio>
+#include <memory>
+
+// Full layout of a 1M-note score on 1, 2, 4 and 8 threads (the caller plus
+// N-1 pool workers). Reports speedup over the single-threaded pass.
+int main() {
+    using namespace notascore;
+
+    const auto notes = bench::makeSyntheticScore(1'000'000);
+    double baselineMs = 0.0;
+    for (const std::size_t threads : {std::size_t {1}, std::size_t {2}, std::size_t {4}, std::size_t {8}}) {
+        std::unique_ptr<core::ThreadPool> pool;
+        notation::NotationEngine engine;
+        if (threads > 1) {
+            pool = std::make_unique<core::ThreadPool>(threads - 1);
+            engine.setThreadPool(pool.get());
+        }
+        for (const auto& note : notes) {
+            engine.addNote(note);
+        }
+
+        double bestMs = 1e9;
+        for (int run = 0; run < 5; ++run) {
+            engine.setDirty();
+            bench::Stopwatch watch;
+            engine.recomputeLayoutIfNeeded();
+            bestMs = std::min(bestMs, watch.elapsedMs());
+        }
+        if (threads == 1) {
+            baselineMs = bestMs;
+        }
+        std::printf("layout 1M notes, %zu thread(s): %8.3f ms  speedup %.2fx\n", threads, bestMs, baselineMs / bestMs);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/core/ThreadPool.hpp"
+#include "notascore/notation/Quantizer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <span>
+#include <thread>
+
+// Quantizing 1M-event MIDI performances (960 PPQ, human timing jitter, one beat
+// in four played as triplets or quintuplets) to 480 PPQ: one part with a
+// million events, and sixteen parts quantized in parallel.
+namespace {
+
+using namespace notascore;
+
+std::vector<notation::PerformanceNote> makePerformance(std::size_t noteCount, std::uint32_t seed) {
+    static constexpr int kDivisions[] {4, 2, 4, 3, 1, 4, 5, 2};
+    bench::Rng rng(seed);
+    std::vector<notation::PerformanceNote> notes;
+    notes.reserve(noteCount);
+    for (notation::Tick beat = 0; notes.size() < noteCount; ++beat) {
+        const int division = kDivisions[rng.next() % 8];
+        const notation::Tick step = 960 / division;
+        for (int i = 0; i < division && notes.size() < noteCount; ++i) {
+            const notation::Tick onset = beat * 960 + i * step + rng.range(-24, 24);
+            notes.push_back({.onset = std::max<notation::Tick>(onset, 0), .duration = step - rng.range(10, 60),
+                .midiPitch = rng.range(40, 90)});
+        }
+    }
+    return notes;
+}
+
+} // namespace
+
+int main() {
+    constexpr std::size_t kEvents = 1'000'000;
+    const notation::QuantizeOptions options {.sourceTicksPerQuarter = 960};
+
+    const auto performance = makePerformance(kEvents, 7);
+    notation::QuantizedTrack track;
+    bench::Stopwatch single;
+    const bool ok = notation::quantize(performance, options, track);
+    bench::report("quantize 1M events, one part", single.elapsedMs(), 250.0);
+
+    std::vector<std::vector<notation::PerformanceNote>> parts;
+    for (std::uint32_t p = 0; p < 16; ++p) {
+        parts.push_back(makePerformance(kEvents / 16, p + 1));
+    }
+    const std::vector<std::span<const notation::PerformanceNote>> views(parts.begin(), parts.end());
+    std::vector<notation::QuantizedTrack> tracks;
+    bench::Stopwatch serial;
+    const bool serialOk = notation::quantizeParts(views, options, tracks);
+    bench::report("quantize 1M events, 16 parts, serial", serial.elapsedMs(), 250.0);
+
+    core::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    bench::Stopwatch parallel;
+    const bool parallelOk = notation::quantizeParts(views, options, tracks, &pool);
+    bench::report("quantize 1M events, 16 parts, parallel", parallel.elapsedMs(), 250.0);
+
+    std::printf("%zu notes, %zu tuplet beats detected\n", track.notes.size(), track.tuplets.size());
+    return ok && serialOk && parallelOk ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/RangeValidator.hpp"
+
+#include <cstdio>
+
+// Instrument range checks on a 1M-note voice: the first full check of a clean
+// score and of one with a note out of range every few measures, then one pitch
+// edit re-checked incrementally after its layout pass, and the highlight
+// overlays for the first visible pages.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 1'000'000;
+
+} // namespace
+
+int main() {
+    const auto notes = bench::makeSyntheticScore(kNotes);
+    const auto range = notation::parsePitchRange("G3-C6");
+
+    notation::NotationEngine engine;
+    engine.addNotes(notes);
+    engine.recomputeLayoutIfNeeded();
+
+    notation::RangeValidator validator(*range);
+    bench::Stopwatch full;
+    validator.update(engine);
+    bench::report("full-score range check, 1M notes", full.elapsedMs(), 5.0);
+
+    for (std::size_t i = 0; i < kNotes; i += 97) {
+        auto note = engine.notes()[i];
+        note.midiPitch = 40;
+        engine.modifyNote(i, note);
+    }
+    engine.recomputeLayoutIfNeeded();
+    validator.invalidate();
+    bench::Stopwatch flagged;
+    validator.update(engine);
+    bench::report("full-score range check, 1% out of range", flagged.elapsedMs(), 10.0);
+    const auto flaggedBefore = validator.outOfRangeCount();
+
+    auto note = engine.notes()[kNotes / 2];
+    note.midiPitch = 20;
+    engine.modifyNote(kNotes / 2, note);
+    engine.recomputeLayoutIfNeeded();
+    bench::Stopwatch single;
+    validator.update(engine);
+    bench::report("range re-check after one edit", single.elapsedMs(), 0.05);
+
+    std::vector<notation::SelectionHighlight> highlights;
+    bench::Stopwatch overlay;
+    validator.highlights(engine, 0, 2, highlights);
+    bench::report("range highlights for 2 visible pages", overlay.elapsedMs(), 1.0);
+
+    std::printf("%llu notes out of range, %zu measures re-checked after the edit, %zu highlight boxes\n",
+        static_cast<unsigned long long>(validator.outOfRangeCount()), validator.lastMeasuresChecked(),
+        highlights.size());
+    return validator.outOfRangeCount() == flaggedBefore + 1 ? 0 : 1;
+}
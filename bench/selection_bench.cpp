@@ -0,0 +1,83 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/Selection.hpp"
+
+#include <cstdio>
+
+// Selections over a 1M-note score: select-all, a pitch filter (the notes of
+// one register, scattered through the score) and a strided pick, with their
+// memory against a vector of indices; union, intersection and iteration; a bulk
+// transpose driven by a selection; and highlights for the first visible pages.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNotes = 1'000'000;
+
+} // namespace
+
+int main() {
+    const auto notes = bench::makeSyntheticScore(kNotes);
+    const auto count = static_cast<std::uint32_t>(notes.size());
+
+    bench::Stopwatch selectAll;
+    notation::NoteSelection all;
+    all.addRange(0, count);
+    bench::report("select all 1M notes", selectAll.elapsedMs(), 1.0);
+
+    bench::Stopwatch filter;
+    notation::NoteSelection low;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (notes[i].midiPitch < 60) {
+            low.add(i);
+        }
+    }
+    bench::report("select by pitch filter (add per note)", filter.elapsedMs(), 20.0);
+
+    notation::NoteSelection strided;
+    for (std::uint32_t i = 0; i < count; i += 4) {
+        strided.add(i);
+    }
+
+    const auto kib = [](std::size_t bytes) { return static_cast<double>(bytes) / 1024.0; };
+    std::printf("memory: select-all %.1f KiB, filter (%llu notes) %.1f KiB, every 4th %.1f KiB; "
+                "index vector for all %.1f KiB\n",
+        kib(all.memoryBytes()), static_cast<unsigned long long>(low.size()), kib(low.memoryBytes()),
+        kib(strided.memoryBytes()), kib(count * sizeof(std::uint32_t)));
+
+    bench::Stopwatch unite;
+    const auto either = low | strided;
+    bench::report("union (filter | every 4th)", unite.elapsedMs(), 5.0);
+
+    bench::Stopwatch intersect;
+    const auto both = low & strided;
+    bench::report("intersection (filter & every 4th)", intersect.elapsedMs(), 5.0);
+
+    bench::Stopwatch iterate;
+    std::uint64_t sum = 0;
+    either.forEachIndex([&](std::uint32_t index) { sum += index; });
+    bench::report("iterate union by index", iterate.elapsedMs(), 10.0);
+
+    notation::NotationEngine engine;
+    engine.addNotes(notes);
+    engine.recomputeLayoutIfNeeded();
+    engine.clearUndoHistory();
+
+    bench::Stopwatch transposeAll;
+    engine.applyBulkEdit({.kind = notation::BulkEditKind::Transpose, .amount = 2}, all);
+    bench::report("bulk transpose via select-all", transposeAll.elapsedMs(), 50.0);
+
+    bench::Stopwatch transposeLow;
+    engine.applyBulkEdit({.kind = notation::BulkEditKind::Transpose, .amount = 12}, low);
+    bench::report("bulk transpose via pitch filter", transposeLow.elapsedMs(), 50.0);
+    engine.recomputeLayoutIfNeeded();
+
+    std::vector<notation::SelectionHighlight> highlights;
+    bench::Stopwatch highlight;
+    notation::selectionHighlights(low, engine.layout(), 0, 2, highlights);
+    bench::report("highlights for 2 visible pages", highlight.elapsedMs(), 1.0);
+
+    std::printf("%llu notes in both, %zu highlight boxes\n", static_cast<unsigned long long>(both.size()),
+        highlights.size());
+    return sum != 0 && !highlights.empty() ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/Glyphs.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Glyph metrics at startup: the generated constexpr tables versus reading and
+// parsing SMuFL metadata at runtime, for the bundled subset and for a document
+// the size of a full font's metadata (~3,900 glyphs, ~1 MB). Also compares a
+// table lookup with a by-name hash lookup.
+namespace {
+
+using namespace notascore;
+
+// Minimal JSON DOM, about what a runtime metadata loader would build.
+struct Json {
+    enum class Kind { Null, Bool, Number, String, Array, Object } kind {Kind::Null};
+    double number {0.0};
+    std::string text;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    [[nodiscard]] const Json* find(std::string_view key) const {
+        for (const auto& [name, value] : members) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class Parser {
+public:
+    explicit Parser(std::string_view input) : m_input(input) {}
+
+    bool parse(Json& out) {
+        skipSpace();
+        return value(out);
+    }
+
+private:
+    void skipSpace() {
+        while (m_pos < m_input.size() && std::isspace(static_cast<unsigned char>(m_input[m_pos])) != 0) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (m_pos < m_input.size() && m_input[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (m_pos < m_input.size() && m_input[m_pos] != '"') {
+            if (m_input[m_pos] == '\\') {
+                ++m_pos;
+            }
+            out.push_back(m_input[m_pos++]);
+        }
+        return consume('"');
+    }
+
+    bool value(Json& out) {
+        skipSpace();
+        if (m_pos >= m_input.size()) {
+            return false;
+        }
+        const char c = m_input[m_pos];
+        if (c == '{') {
+            ++m_pos;
+            out.kind = Json::Kind::Object;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                auto& member = out.members.emplace_back();
+                if (!string(member.first) || !consume(':') || !value(member.second)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            ++m_pos;
+            out.kind = Json::Kind::Array;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                if (!value(out.items.emplace_back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            out.kind = Json::Kind::String;
+            return string(out.text);
+        }
+        if (m_input.substr(m_pos, 4) == "true" || m_input.substr(m_pos, 4) == "null") {
+            out.kind = c == 't' ? Json::Kind::Bool : Json::Kind::Null;
+            m_pos += 4;
+            return true;
+        }
+        if (m_input.substr(m_pos, 5) == "false") {
+            out.kind = Json::Kind::Bool;
+            m_pos += 5;
+            return true;
+        }
+        out.kind = Json::Kind::Number;
+        const std::size_t start = m_pos;
+        while (m_pos < m_input.size() && (std::isdigit(static_cast<unsigned char>(m_input[m_pos])) != 0
+                                             || std::string_view("+-.eE").find(m_input[m_pos]) != std::string_view::npos)) {
+            ++m_pos;
+        }
+        out.number = std::stod(std::string(m_input.substr(start, m_pos - start)));
+        return m_pos > start;
+    }
+
+    std::string_view m_input;
+    std::size_t m_pos {0};
+};
+
+using RuntimeTable = std::unordered_map<std::string, notation::smufl::Box>;
+
+// Reads `text` the way a runtime loader would: parse, then index bounding boxes by name.
+bool loadAtRuntime(const std::string& text, RuntimeTable& table) {
+    Json root;
+    if (!Parser(text).parse(root)) {
+        return false;
+    }
+    const Json* boxes = root.find("glyphBBoxes");
+    if (boxes == nullptr) {
+        return false;
+    }
+    table.clear();
+    table.reserve(boxes->members.size());
+    for (const auto& [name, glyph] : boxes->members) {
+        const Json* sw = glyph.find("bBoxSW");
+        const Json* ne = glyph.find("bBoxNE");
+        if (sw == nullptr || ne == nullptr || sw->items.size() != 2 || ne->items.size() != 2) {
+            return false;
+        }
+        table[name] = {.x0 = static_cast<float>(sw->items[0].number), .y0 = static_cast<float>(sw->items[1].number),
+            .x1 = static_cast<float>(ne->items[0].number), .y1 = static_cast<float>(ne->items[1].number)};
+    }
+    return true;
+}
+
+// Metadata the size of a complete font: the bundled glyphs repeated under new names.
+std::string fullSizeMetadata() {
+    std::ostringstream out;
+    out << "{\"fontName\":\"Synthetic\",\"glyphBBoxes\":{";
+    for (std::size_t i = 0; i < 3900; ++i) {
+        const auto glyph = static_cast<notation::Glyph>(i % notation::smufl::kGlyphCount);
+        const auto box = notation::glyphs::bbox(glyph);
+        out << (i == 0 ? "" : ",") << "\n    \"" << notation::smufl::kGlyphNames[i % notation::smufl::kGlyphCount] << i
+            << "\": {\"bBoxNE\": [" << box.x1 << ", " << box.y1 << "], \"bBoxSW\": [" << box.x0 << ", " << box.y0
+            << "]}";
+    }
+    out << "},\"glyphsWithAnchors\":{";
+    for (std::size_t i = 0; i < 450; ++i) {
+        out << (i == 0 ? "" : ",") << "\n    \"noteheadBlack" << i
+            << "\": {\"stemDownNW\": [0.0, -0.168], \"stemUpSE\": [1.18, 0.168]}";
+    }
+    // Alternates, ligatures and sets make up the rest of a real file.
+    out << "},\"padding\":[";
+    for (std::size_t i = 0; i < 20000; ++i) {
+        out << (i == 0 ? "" : ",") << "{\"codepoint\":\"U+E" << i % 4096 << "\",\"name\":\"alternate" << i << "\"}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+} // namespace
+
+int main() {
+    std::ifstream file(NOTASCORE_SMUFL_METADATA, std::ios::binary);
+    const std::string bundled((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const std::string full = fullSizeMetadata();
+
+    constexpr int kRuns = 50;
+    RuntimeTable table;
+    bench::Stopwatch readWatch;
+    for (int run = 0; run < kRuns; ++run) {
+        std::ifstream again(NOTASCORE_SMUFL_METADATA, std::ios::binary);
+        const std::string text((std::istreambuf_iterator<char>(again)), std::istreambuf_iterator<char>());
+        if (!loadAtRuntime(text, table)) {
+            std::printf("failed to parse %s\n", NOTASCORE_SMUFL_METADATA);
+            return 1;
+        }
+    }
+    const double bundledMs = readWatch.elapsedMs() / kRuns;
+
+    RuntimeTable fullTable;
+    bench::Stopwatch fullWatch;
+    for (int run = 0; run < 5; ++run) {
+        loadAtRuntime(full, fullTable);
+    }
+    const double fullMs = fullWatch.elapsedMs() / 5;
+
+    // Lookups: constexpr table index versus hashing the glyph name.
+    constexpr int kLookups = 1'000'000;
+    float tableSum = 0.0f;
+    bench::Stopwatch tableWatch;
+    for (int i = 0; i < kLookups; ++i) {
+        const auto glyph = static_cast<notation::Glyph>(static_cast<std::size_t>(i) % notation::smufl::kGlyphCount);
+        tableSum += notation::glyphs::width(glyph);
+    }
+    const double tableNs = tableWatch.elapsedMs() * 1e6 / kLookups;
+    float mapSum = 0.0f;
+    std::vector<std::string> names(notation::smufl::kGlyphNames.begin(), notation::smufl::kGlyphNames.end());
+    bench::Stopwatch mapWatch;
+    for (int i = 0; i < kLookups; ++i) {
+        const auto& box = table.at(names[static_cast<std::size_t>(i) % names.size()]);
+        mapSum += box.x1 - box.x0;
+    }
+    const double mapNs = mapWatch.elapsedMs() * 1e6 / kLookups;
+
+    std::printf("generated tables: %zu glyphs, %zu anchors, 0 ms at startup\n", notation::smufl::kGlyphCount,
+        notation::smufl::kAnchorCount);
+    std::printf("runtime parse, bundled subset (%zu bytes):   %8.3f ms\n", bundled.size(), bundledMs);
+    std::printf("runtime parse, full-size metadata (%zu KiB): %8.3f ms\n", full.size() / 1024, fullMs);
+    std::printf("lookup: table %.2f ns, by name %.2f ns (checksums %.0f / %.0f)\n", tableNs, mapNs,
+        static_cast<double>(tableSum), static_cast<double>(mapSum));
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/core/SymbolTable.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Interned instrument and metadata strings: interning 100k names (10k distinct),
+// then 1M "is this instrument selected" checks against a 16-entry selection,
+// by string and by symbol.
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kNames = 100'000;
+constexpr std::size_t kDistinct = 10'000;
+constexpr std::size_t kChecks = 1'000'000;
+
+} // namespace
+
+int main() {
+    bench::Rng rng(3);
+    std::vector<std::string> names(kNames);
+    for (auto& name : names) {
+        name = "Instrument family member " + std::to_string(rng.next() % kDistinct);
+    }
+
+    core::SymbolTable table;
+    std::vector<core::Symbol> symbols(kNames);
+    bench::Stopwatch interning;
+    for (std::size_t i = 0; i < kNames; ++i) {
+        symbols[i] = table.intern(names[i]);
+    }
+    bench::report("intern 100k names", interning.elapsedMs(), 20.0);
+
+    std::vector<std::string> selectedNames(names.begin(), names.begin() + 16);
+    std::vector<core::Symbol> selectedSymbols(symbols.begin(), symbols.begin() + 16);
+
+    std::size_t byString = 0;
+    bench::Stopwatch strings;
+    for (std::size_t i = 0; i < kChecks; ++i) {
+        byString += std::ranges::find(selectedNames, names[i % kNames]) != selectedNames.end() ? 1 : 0;
+    }
+    const double stringMs = strings.elapsedMs();
+    bench::report("1M selection checks by string", stringMs, 100.0);
+
+    std::size_t bySymbol = 0;
+    bench::Stopwatch ids;
+    for (std::size_t i = 0; i < kChecks; ++i) {
+        bySymbol += std::ranges::find(selectedSymbols, symbols[i % kNames]) != selectedSymbols.end() ? 1 : 0;
+    }
+    const double symbolMs = ids.elapsedMs();
+    bench::report("1M selection checks by symbol", symbolMs, 10.0);
+
+    std::size_t stringBytes = 0;
+    for (const auto& name : names) {
+        stringBytes += sizeof(std::string) + (name.size() > 15 ? name.capacity() + 1 : 0);
+    }
+    std::printf("%zu symbols, %.1f KiB table + %.1f KiB of ids vs. %.1f KiB of strings; %.1fx faster checks\n",
+        table.size(), static_cast<double>(table.memoryBytes()) / 1024.0,
+        static_cast<double>(kNames * sizeof(core::Symbol)) / 1024.0, static_cast<double>(stringBytes) / 1024.0,
+        stringMs / std::max(symbolMs, 1e-6));
+    return byString == bySymbol ? 0 : 1;
+}
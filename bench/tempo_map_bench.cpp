@@ -0,0 +1,59 @@
+#include "BenchCommon.hpp"
+
+#include "notascore/notation/TempoMap.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+// Tick <-> seconds conversion on a score with 2000 tempo changes, one in four a
+// ramp: 1M scattered single conversions (scrubbing) and 1M sorted batch
+// conversions both ways (playback, MIDI export).
+namespace {
+
+using namespace notascore;
+
+constexpr std::size_t kConversions = 1'000'000;
+constexpr notation::Tick kScoreTicks = 480LL * 4 * 8000;
+
+} // namespace
+
+int main() {
+    bench::Rng rng(11);
+    notation::TempoMap tempo(480, 120.0);
+    for (int i = 1; i < 2000; ++i) {
+        tempo.setTempo(kScoreTicks / 2000 * i, rng.range(50, 200), i % 4 == 0);
+    }
+
+    std::vector<notation::Tick> ticks(kConversions);
+    for (auto& tick : ticks) {
+        tick = static_cast<notation::Tick>(rng.next()) % kScoreTicks;
+    }
+    std::vector<double> seconds(kConversions);
+
+    bench::Stopwatch scattered;
+    double checksum = 0.0;
+    for (const auto tick : ticks) {
+        checksum += tempo.secondsAt(static_cast<double>(tick));
+    }
+    const double scatteredMs = scattered.elapsedMs();
+    bench::report("1M scattered tick->seconds", scatteredMs, 100.0);
+
+    std::ranges::sort(ticks);
+    bench::Stopwatch batch;
+    tempo.secondsAt(ticks, seconds);
+    const double batchMs = batch.elapsedMs();
+    bench::report("1M sorted tick->seconds, batch", batchMs, 30.0);
+
+    std::vector<double> back(kConversions);
+    bench::Stopwatch inverse;
+    tempo.ticksAt(seconds, back);
+    bench::report("1M sorted seconds->tick, batch", inverse.elapsedMs(), 50.0);
+
+    double worst = 0.0;
+    for (std::size_t i = 0; i < kConversions; ++i) {
+        worst = std::max(worst, std::abs(back[i] - static_cast<double>(ticks[i])));
+    }
+    std::printf("%.1f ns per scattered conversion, %.1f ns batched; worst round-trip error %.2e ticks\n",
+        scatteredMs * 1e6 / kConversions, batchMs * 1e6 / kConversions, worst);
+    return checksum > 0.0 && worst < 1e-3 ? 0 : 1;
+}
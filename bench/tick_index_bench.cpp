@@ -0,0 +1,65 @@
+#include "BenchCommon.hpp"
+
+#include <cstdio>
+
+// Overlap queries ("which notes sound in [t0, t1)") through the tick index versus
+// a linear scan, plus the cost of keeping the index current on insert.
+int main() {
+    using namespace notascore;
+
+    auto notes = bench::makeSyntheticScore(1'000'000);
+    // A few sustained pedal notes so that queries must look back across buckets.
+    for (int tick = 0; tick < notes.back().tick; tick += 1920 * 64) {
+        notes.push_back({.tick = tick, .duration = 1920 * 16, .midiPitch = 36});
+    }
+    notation::NotationEngine engine;
+    for (const auto& note : notes) {
+        engine.addNote(note);
+    }
+    const auto lastTick = engine.notes().back().tick;
+
+    constexpr int kQueries = 10'000;
+    bench::Rng rng(3);
+    std::vector<std::uint32_t> hits;
+    std::size_t found = 0;
+    bench::Stopwatch indexWatch;
+    for (int q = 0; q < kQueries; ++q) {
+        const std::int64_t t0 = rng.range(0, lastTick);
+        hits.clear();
+        engine.notesOverlapping(t0, t0 + 4 * 1920, hits);
+        found += hits.size();
+    }
+    const double indexUs = indexWatch.elapsedMs() * 1000.0 / kQueries;
+
+    constexpr int kScans = 100;
+    std::size_t scanned = 0;
+    bench::Stopwatch scanWatch;
+    for (int q = 0; q < kScans; ++q) {
+        const std::int64_t t0 = rng.range(0, lastTick);
+        const std::int64_t t1 = t0 + 4 * 1920;
+        for (const auto& note : engine.notes()) {
+            scanned += note.tick < t1 && note.tick + std::max(note.duration, 1) > t0 ? 1 : 0;
+        }
+    }
+    const double scanUs = scanWatch.elapsedMs() * 1000.0 / kScans;
+
+    std::printf("4-measure window query: index %.3f us, linear scan %.3f us (%.0fx), avg %zu hits\n", indexUs, scanUs,
+        scanUs / indexUs, found / kQueries);
+
+    // Index maintenance alone, then together with the sorted storage insert.
+    constexpr int kInserts = 10'000;
+    notation::TickIndex index;
+    index.rebuild(engine.notes(), 1920);
+    bench::Stopwatch indexInsertWatch;
+    for (int i = 0; i < kInserts * 100; ++i) {
+        index.insert({.tick = rng.range(0, lastTick), .duration = 240, .midiPitch = 60});
+    }
+    std::printf("index update: %.4f us\n", indexInsertWatch.elapsedMs() * 1000.0 / (kInserts * 100));
+
+    bench::Stopwatch insertWatch;
+    for (int i = 0; i < kInserts; ++i) {
+        engine.addNote({.tick = rng.range(0, lastTick), .duration = 240, .midiPitch = 60});
+    }
+    std::printf("random addNote (storage + index): %.3f us\n", insertWatch.elapsedMs() * 1000.0 / kInserts);
+    return scanned == 0 ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+#include "BenchCommon.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Undo history on a ~500-page score: cost of recording a step after a
+// single-note edit, memory held per step, and undo/redo including relayout,
+// versus copying the note vector for every step.
+namespace {
+
+// Resident set size in KiB (Linux only; 0 elsewhere).
+long residentKiB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main() {
+    using namespace notascore;
+
+    notation::NotationEngine engine;
+    engine.addNotes(bench::makeSyntheticScore(220'000));
+    engine.recomputeLayoutIfNeeded();
+    engine.clearUndoHistory();
+
+    constexpr int kSteps = 1000;
+    bench::Rng rng(5);
+    const int measures = static_cast<int>(engine.layout().measureCount());
+    const long rssBefore = residentKiB();
+    double commitMs = 0.0;
+    for (int i = 0; i < kSteps; ++i) {
+        const int measure = rng.range(0, measures - 2);
+        engine.addNote({.tick = measure * 1920 + rng.range(0, 15) * 120, .duration = 120, .midiPitch = rng.range(55, 84)});
+        bench::Stopwatch watch;
+        engine.commitUndoStep();
+        commitMs += watch.elapsedMs();
+    }
+    const long rssAfter = residentKiB();
+    engine.recomputeLayoutIfNeeded();
+
+    bench::Stopwatch undoWatch;
+    for (int i = 0; i < kSteps; ++i) {
+        engine.undo();
+        engine.recomputeLayoutIfNeeded();
+    }
+    const double undoMs = undoWatch.elapsedMs() / kSteps;
+    bench::Stopwatch redoWatch;
+    for (int i = 0; i < kSteps; ++i) {
+        engine.redo();
+        engine.recomputeLayoutIfNeeded();
+    }
+    const double redoMs = redoWatch.elapsedMs() / kSteps;
+
+    std::vector<std::vector<notation::NoteEvent>> copies;
+    bench::Stopwatch copyWatch;
+    for (int i = 0; i < 50; ++i) {
+        copies.emplace_back(engine.notes().begin(), engine.notes().end());
+    }
+    const double copyMs = copyWatch.elapsedMs() / 50;
+
+    std::printf("score: %zu notes, %d undo steps\n", engine.noteCount(), kSteps);
+    bench::report("record undo step (snapshot)", commitMs / kSteps, 0.05);
+    bench::report("undo + incremental relayout", undoMs, 2.0);
+    bench::report("redo + incremental relayout", redoMs, 2.0);
+    std::printf("memory per step: %.1f KiB (full copy: %.1f KiB, %.3f ms)\n",
+        static_cast<double>(rssAfter - rssBefore) / kSteps,
+        static_cast<double>(engine.noteCount() * sizeof(notation::NoteEvent)) / 1024.0, copyMs);
+    return 0;
+}
@@ -0,0 +1,184 @@
+# Generates constexpr SMuFL metric tables from a SMuFL font metadata file.
+#
+#   cmake -DINPUT=metadata.json -DOUTPUT=SmuflMetadata.hpp -P GenerateSmuflMetadata.cmake
+#
+# Emits the Glyph and Anchor enums (in file order), glyph names, bounding boxes,
+# anchors and the numeric engraving defaults, all in staff spaces.
+
+cmake_minimum_required(VERSION 3.20)
+
+if(NOT DEFINED INPUT OR NOT DEFINED OUTPUT)
+    message(FATAL_ERROR "usage: cmake -DINPUT=<metadata.json> -DOUTPUT=<header> -P ${CMAKE_CURRENT_LIST_FILE}")
+endif()
+
+file(READ "${INPUT}" json)
+
+# "noteheadBlack" -> "NoteheadBlack"
+function(smufl_identifier name out)
+    string(SUBSTRING "${name}" 0 1 head)
+    string(SUBSTRING "${name}" 1 -1 tail)
+    string(TOUPPER "${head}" head)
+    set(${out} "${head}${tail}" PARENT_SCOPE)
+endfunction()
+
+# JSON number -> float literal ("0" -> "0.0f", "1.18" -> "1.18f").
+function(smufl_float value out)
+    if(value MATCHES "[.eE]")
+        set(${out} "${value}f" PARENT_SCOPE)
+    else()
+        set(${out} "${value}.0f" PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(smufl_point glyph section anchor out)
+    string(JSON x GET "${json}" ${section} ${glyph} ${anchor} 0)
+    string(JSON y GET "${json}" ${section} ${glyph} ${anchor} 1)
+    smufl_float("${x}" x)
+    smufl_float("${y}" y)
+    set(${out} "${x}, ${y}" PARENT_SCOPE)
+endfunction()
+
+string(JSON fontName GET "${json}" fontName)
+
+# Glyphs, in file order.
+string(JSON glyphCount LENGTH "${json}" glyphBBoxes)
+math(EXPR lastGlyph "${glyphCount} - 1")
+set(glyphs)
+foreach(i RANGE ${lastGlyph})
+    string(JSON glyph MEMBER "${json}" glyphBBoxes ${i})
+    list(APPEND glyphs ${glyph})
+endforeach()
+
+# Every anchor name used by any glyph, in order of first appearance.
+set(anchors)
+string(JSON anchoredCount ERROR_VARIABLE noAnchors LENGTH "${json}" glyphsWithAnchors)
+if(noAnchors)
+    set(anchoredCount 0)
+endif()
+if(anchoredCount GREATER 0)
+    math(EXPR lastAnchored "${anchoredCount} - 1")
+    foreach(i RANGE ${lastAnchored})
+        string(JSON glyph MEMBER "${json}" glyphsWithAnchors ${i})
+        string(JSON count LENGTH "${json}" glyphsWithAnchors ${glyph})
+        math(EXPR last "${count} - 1")
+        foreach(j RANGE ${last})
+            string(JSON anchor MEMBER "${json}" glyphsWithAnchors ${glyph} ${j})
+            if(NOT anchor IN_LIST anchors)
+                list(APPEND anchors ${anchor})
+            endif()
+        endforeach()
+    endforeach()
+endif()
+list(LENGTH anchors anchorCount)
+
+set(glyphEnum "")
+set(glyphNames "")
+set(glyphBoxes "")
+set(anchorTable "")
+set(anchorMasks "")
+foreach(glyph IN LISTS glyphs)
+    smufl_identifier(${glyph} id)
+    string(APPEND glyphEnum "    ${id},\n")
+    string(APPEND glyphNames "    \"${glyph}\",\n")
+    smufl_point(${glyph} glyphBBoxes bBoxSW sw)
+    smufl_point(${glyph} glyphBBoxes bBoxNE ne)
+    string(APPEND glyphBoxes "    Box {${sw}, ${ne}}, // ${glyph}\n")
+
+    set(points "")
+    set(mask 0)
+    set(bit 1)
+    foreach(anchor IN LISTS anchors)
+        string(JSON unused ERROR_VARIABLE missing GET "${json}" glyphsWithAnchors ${glyph} ${anchor})
+        if(missing)
+            string(APPEND points "Point {0.0f, 0.0f}, ")
+        else()
+            smufl_point(${glyph} glyphsWithAnchors ${anchor} point)
+            string(APPEND points "Point {${point}}, ")
+            math(EXPR mask "${mask} | ${bit}")
+        endif()
+        math(EXPR bit "${bit} << 1")
+    endforeach()
+    string(APPEND anchorTable "    std::array<Point, kAnchorCount> {${points}}, // ${glyph}\n")
+    string(APPEND anchorMasks "    ${mask}u, // ${glyph}\n")
+endforeach()
+
+set(anchorEnum "")
+set(anchorNames "")
+foreach(anchor IN LISTS anchors)
+    smufl_identifier(${anchor} id)
+    string(APPEND anchorEnum "    ${id},\n")
+    string(APPEND anchorNames "    \"${anchor}\",\n")
+endforeach()
+
+# Numeric engraving defaults become named constants.
+set(defaults "")
+string(JSON defaultCount ERROR_VARIABLE noDefaults LENGTH "${json}" engravingDefaults)
+if(NOT noDefaults AND defaultCount GREATER 0)
+    math(EXPR lastDefault "${defaultCount} - 1")
+    foreach(i RANGE ${lastDefault})
+        string(JSON key MEMBER "${json}" engravingDefaults ${i})
+        string(JSON type TYPE "${json}" engravingDefaults ${key})
+        if(type STREQUAL "NUMBER")
+            string(JSON value GET "${json}" engravingDefaults ${key})
+            smufl_identifier(${key} id)
+            smufl_float("${value}" value)
+            string(APPEND defaults "inline constexpr float k${id} = ${value};\n")
+        endif()
+    endforeach()
+endif()
+
+file(WRITE "${OUTPUT}.tmp" "// Generated by cmake/GenerateSmuflMetadata.cmake from ${fontName} metadata. Do not edit.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace notascore::notation::smufl {
+
+struct Box {
+    float x0 {0.0f};
+    float y0 {0.0f};
+    float x1 {0.0f};
+    float y1 {0.0f};
+};
+
+struct Point {
+    float x {0.0f};
+    float y {0.0f};
+};
+
+enum class Glyph : std::uint16_t {
+${glyphEnum}};
+
+enum class Anchor : std::uint8_t {
+${anchorEnum}};
+
+inline constexpr std::size_t kGlyphCount = ${glyphCount};
+inline constexpr std::size_t kAnchorCount = ${anchorCount};
+
+inline constexpr std::array<std::string_view, kGlyphCount> kGlyphNames {
+${glyphNames}};
+
+inline constexpr std::array<std::string_view, kAnchorCount> kAnchorNames {
+${anchorNames}};
+
+// Bounding boxes (south-west and north-east corners), y up.
+inline constexpr std::array<Box, kGlyphCount> kGlyphBoxes {
+${glyphBoxes}};
+
+// kGlyphAnchors[glyph][anchor] is meaningful when bit `anchor` of kGlyphAnchorMask[glyph] is set.
+inline constexpr std::array<std::array<Point, kAnchorCount>, kGlyphCount> kGlyphAnchors {
+${anchorTable}};
+
+inline constexpr std::array<std::uint32_t, kGlyphCount> kGlyphAnchorMask {
+${anchorMasks}};
+
+${defaults}
+} // namespace notascore::notation::smufl
+")
+
+# Only touch the header when it changes, so dependents are not rebuilt needlessly.
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
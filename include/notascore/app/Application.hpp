@@ -2,7 +2,7 @@
 
 #include "notascore/audio/AudioEngine.hpp"
 #include "notascore/core/TaskScheduler.hpp"
-#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Score.hpp"
 #include "notascore/platform/NativeWindow.hpp"
 #include "notascore/render/CpuRenderer.hpp"
 #include "notascore/ui/MainWindow.hpp"
@@ -18,7 +18,7 @@ public:
 private:
     notascore::core::TaskScheduler m_scheduler;
     notascore::render::CpuRenderer m_renderer;
-    notascore::notation::NotationEngine m_notation;
+    notascore::notation::Score m_score;
     notascore::audio::AudioEngine m_audio;
     notascore::ui::PerformanceSettings m_settings;
     notascore::ui::MainWindow m_mainWindow;
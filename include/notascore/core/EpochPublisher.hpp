@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace notascore::core {
+
+// Publishes immutable versions of a T to lock-free readers (epoch-based
+// reclamation). Writers build a complete new version and swap it in
+// atomically; a reader pins the current version and keeps using it, untouched,
+// until the pin is released, however many versions are published meanwhile.
+//
+// Readers announce the epoch they entered in one of kMaxReaders slots before
+// loading the current pointer, and a version retired in epoch e is only
+// reclaimed once no slot holds an epoch <= e. Pinning never blocks on a writer;
+// it only spins if kMaxReaders pins are held at once. Retired versions are
+// reclaimed by the next publish() or by the last reader to leave, and up to
+// kRecycled of them are kept for writers to overwrite instead of allocating.
+template <typename T>
+class EpochPublisher {
+public:
+    static constexpr std::size_t kMaxReaders = 64;
+    static constexpr std::size_t kRecycled = 2;
+
+    class Pin {
+    public:
+        Pin() = default;
+        Pin(Pin&& other) noexcept
+            : m_owner(std::exchange(other.m_owner, nullptr)), m_slot(other.m_slot),
+              m_value(std::exchange(other.m_value, nullptr)) {}
+        Pin& operator=(Pin&& other) noexcept {
+            if (this != &other) {
+                release();
+                m_owner = std::exchange(other.m_owner, nullptr);
+                m_slot = other.m_slot;
+                m_value = std::exchange(other.m_value, nullptr);
+            }
+            return *this;
+        }
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        ~Pin() { release(); }
+
+        // False when nothing was published yet.
+        [[nodiscard]] explicit operator bool() const noexcept { return m_value != nullptr; }
+        [[nodiscard]] const T& operator*() const noexcept { return *m_value; }
+        [[nodiscard]] const T* operator->() const noexcept { return m_value; }
+
+        void release() noexcept {
+            if (m_owner != nullptr) {
+                std::exchange(m_owner, nullptr)->leave(m_slot);
+                m_value = nullptr;
+            }
+        }
+
+    private:
+        friend class EpochPublisher;
+        Pin(EpochPublisher* owner, std::size_t slot, const T* value) noexcept
+            : m_owner(owner), m_slot(slot), m_value(value) {}
+
+        EpochPublisher* m_owner {nullptr};
+        std::size_t m_slot {0};
+        const T* m_value {nullptr};
+    };
+
+    EpochPublisher() { m_recycled.reserve(kRecycled); }
+    EpochPublisher(const EpochPublisher&) = delete;
+    EpochPublisher& operator=(const EpochPublisher&) = delete;
+    // Every pin must have been released.
+    ~EpochPublisher() {
+        delete m_current.load();
+        for (const auto& retired : m_retired) {
+            delete retired.value;
+        }
+    }
+
+    // Reader side.
+    [[nodiscard]] Pin pin() const {
+        auto* self = const_cast<EpochPublisher*>(this);
+        for (std::size_t attempt = 0;; ++attempt) {
+            for (std::size_t i = 0; i < kMaxReaders; ++i) {
+                std::uint64_t expected = 0;
+                // Announce an epoch no later than the one the pointer is loaded in.
+                if (self->m_slots[i].epoch.compare_exchange_strong(expected, m_epoch.load())) {
+                    return Pin(self, i, m_current.load());
+                }
+            }
+            if (attempt > 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Writer side; concurrent writers are serialized.
+
+    // A reclaimed version to overwrite with the next one, or null.
+    [[nodiscard]] std::unique_ptr<T> recycle() {
+        const std::lock_guard lock(m_writerMutex);
+        if (m_recycled.empty()) {
+            return nullptr;
+        }
+        auto value = std::move(m_recycled.back());
+        m_recycled.pop_back();
+        return value;
+    }
+
+    void publish(std::unique_ptr<T> value) {
+        const std::lock_guard lock(m_writerMutex);
+        const T* old = m_current.exchange(value.release());
+        if (old != nullptr) {
+            // Readers that could still see `old` announced at most this epoch.
+            m_retired.push_back({.value = old, .epoch = m_epoch.fetch_add(1)});
+            m_retiredCount.store(m_retired.size());
+        }
+        reclaimLocked();
+    }
+
+    // Frees the retired versions no reader can see any more.
+    void reclaim() {
+        const std::lock_guard lock(m_writerMutex);
+        reclaimLocked();
+    }
+
+    [[nodiscard]] std::size_t retiredCount() const noexcept { return m_retiredCount.load(); }
+
+private:
+    struct Retired {
+        const T* value {nullptr};
+        std::uint64_t epoch {0};
+    };
+
+    // One cache line per slot, so readers on different cores do not contend.
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch {0};
+    };
+
+    void leave(std::size_t slot) noexcept {
+        m_slots[slot].epoch.store(0);
+        // The last reader out frees what it held back; never wait for a writer.
+        if (m_retiredCount.load() > 0 && m_writerMutex.try_lock()) {
+            const std::lock_guard lock(m_writerMutex, std::adopt_lock);
+            reclaimLocked();
+        }
+    }
+
+    void reclaimLocked() noexcept {
+        if (m_retired.empty()) {
+            return;
+        }
+        std::uint64_t oldestReader = std::numeric_limits<std::uint64_t>::max();
+        for (const auto& slot : m_slots) {
+            if (const std::uint64_t epoch = slot.epoch.load(); epoch != 0 && epoch < oldestReader) {
+                oldestReader = epoch;
+            }
+        }
+        std::size_t kept = 0;
+        for (const auto& retired : m_retired) {
+            if (retired.epoch < oldestReader) {
+                if (m_recycled.size() < kRecycled) {
+                    m_recycled.emplace_back(const_cast<T*>(retired.value));
+                } else {
+                    delete retired.value;
+                }
+            } else {
+                m_retired[kept++] = retired;
+            }
+        }
+        m_retired.resize(kept);
+        m_retiredCount.store(kept);
+    }
+
+    std::array<Slot, kMaxReaders> m_slots {};
+    std::atomic<const T*> m_current {nullptr};
+    // Starts at 1: a zero slot means "no reader".
+    std::atomic<std::uint64_t> m_epoch {1};
+    std::atomic<std::size_t> m_retiredCount {0};
+
+    std::mutex m_writerMutex;
+    std::vector<Retired> m_retired;
+    std::vector<std::unique_ptr<T>> m_recycled;
+};
+
+} // namespace notascore::core
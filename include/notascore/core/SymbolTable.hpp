@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace notascore::core {
+
+// An interned string: equal text gives an equal id, so comparing two symbols is
+// one integer compare. Id 0 is the empty string.
+struct Symbol {
+    std::uint32_t id {0};
+
+    [[nodiscard]] constexpr bool empty() const noexcept { return id == 0; }
+    constexpr auto operator<=>(const Symbol&) const = default;
+};
+
+// Append-only table of interned strings. Text is copied once into fixed-size
+// blocks that never move, so views stay valid for the table's lifetime. Interning
+// takes a lock; looking a symbol's text up does not, as its slot is written
+// before the id is handed out.
+class SymbolTable {
+public:
+    SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // Shared by the UI and the document model.
+    [[nodiscard]] static SymbolTable& global();
+
+    // Id of `text`, adding it on first use. Returns the empty symbol once the
+    // table is full.
+    Symbol intern(std::string_view text);
+    // Id of `text` if it was interned before; never adds.
+    [[nodiscard]] std::optional<Symbol> find(std::string_view text) const;
+    [[nodiscard]] std::string_view text(Symbol symbol) const noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+    // Text blocks, views and lookup map.
+    [[nodiscard]] std::size_t memoryBytes() const;
+
+    static constexpr std::size_t kViewsPerChunk = 1024;
+    static constexpr std::size_t kMaxChunks = 4096;
+    static constexpr std::size_t kTextBlockBytes = 16 * 1024;
+
+private:
+    using ViewChunk = std::array<std::string_view, kViewsPerChunk>;
+
+    [[nodiscard]] std::string_view store(std::string_view text);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string_view, std::uint32_t> m_ids;
+    // Fixed so that lock-free readers never see the array itself move.
+    std::array<std::unique_ptr<ViewChunk>, kMaxChunks> m_views;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    std::vector<std::unique_ptr<char[]>> m_largeBlocks;
+    std::size_t m_blockUsed {kTextBlockBytes};
+    std::size_t m_textBytes {0};
+    std::atomic<std::size_t> m_size {0};
+};
+
+// Shorthands for the global table.
+inline Symbol intern(std::string_view text) { return SymbolTable::global().intern(text); }
+[[nodiscard]] inline std::string_view text(Symbol symbol) noexcept { return SymbolTable::global().text(symbol); }
+
+} // namespace notascore::core
@@ -17,6 +17,12 @@ public:
     void schedule(std::function<void()> task);
     void waitIdle();
 
+    // Runs body(begin, end) over [0, count) in chunks of `grain`. The calling
+    // thread takes chunks too, so this is safe to call from a pool worker.
+    void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body);
+
+    [[nodiscard]] std::size_t threadCount() const noexcept { return m_workers.size(); }
+
 private:
     void workerLoop();
 
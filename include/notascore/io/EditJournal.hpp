@@ -0,0 +1,96 @@
+#pragma once
+
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace notascore::io {
+
+enum class SyncPolicy : std::uint8_t {
+    Never,
+    Interval,
+    EveryBlock
+};
+
+struct JournalOptions {
+    // Records are buffered into blocks of about this size; memory use is bounded by it.
+    std::size_t blockBytes {64 * 1024};
+    SyncPolicy sync {SyncPolicy::Interval};
+    // With SyncPolicy::Interval, the records appended since the last sync are
+    // written and fsync'ed by the first append once this much time has passed,
+    // whether or not their block is full (group commit).
+    std::chrono::milliseconds syncInterval {1000};
+};
+
+// Append-only log of engine edits for crash recovery and autosave. Records are
+// varint-encoded as deltas of index, tick, pitch and velocity against the
+// previous record, grouped into checksummed blocks; a torn trailing block is
+// ignored on replay. A bulk edit is one record holding its transform and index
+// ranges. After a full save, reset() empties the journal.
+class EditJournal {
+public:
+    using MetadataHandler = std::function<void(std::string_view key, std::string_view value)>;
+
+    EditJournal() = default;
+    ~EditJournal();
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    // Opens `path` for appending, writing the header when the file is new. An
+    // existing journal is cut after its last complete block, dropping a tail
+    // torn by a crash. False when `path` holds anything but a journal of this
+    // version (a version 1 journal, say), which is left untouched.
+    bool open(const std::filesystem::path& path, const JournalOptions& options = {});
+    void close();
+    [[nodiscard]] bool isOpen() const noexcept { return m_file != nullptr; }
+
+    // Logs every edit of `engine` from now on.
+    void attach(notascore::notation::NotationEngine& engine);
+    void append(const notascore::notation::EditRecord& record);
+    // Score metadata (title, meter, ...) replayed through the MetadataHandler.
+    void appendMetadata(std::string_view key, std::string_view value);
+
+    // Writes the buffered block; sync() also forces it to disk.
+    bool flush();
+    bool sync();
+    // Truncates the journal to its header, e.g. after the document was saved.
+    bool reset();
+
+    [[nodiscard]] std::uint64_t recordCount() const noexcept { return m_recordCount; }
+    [[nodiscard]] std::uint64_t bytesWritten() const noexcept { return m_bytesWritten; }
+    [[nodiscard]] std::uint64_t syncCount() const noexcept { return m_syncCount; }
+
+    // Applies every complete block of the journal at `path` to `engine` (which
+    // should hold the document the journal started from). Returns false when the
+    // file is missing or not a journal.
+    static bool replay(const std::filesystem::path& path, notascore::notation::NotationEngine& engine,
+        const MetadataHandler& onMetadata = {});
+
+private:
+    void encode(const notascore::notation::EditRecord& record);
+    void beginRecord(std::size_t maxBytes);
+    void syncIfDue();
+    bool writeBlock();
+
+    std::FILE* m_file {nullptr};
+    std::filesystem::path m_path;
+    JournalOptions m_options;
+    std::vector<std::uint8_t> m_block;
+    // Delta state; reset at every block so that blocks decode independently.
+    std::int64_t m_lastIndex {0};
+    std::int64_t m_lastTick {0};
+    std::int64_t m_lastPitch {0};
+    std::int64_t m_lastVelocity {0};
+    std::chrono::steady_clock::time_point m_lastSync {};
+    std::uint64_t m_recordCount {0};
+    std::uint64_t m_bytesWritten {0};
+    std::uint64_t m_syncCount {0};
+};
+
+} // namespace notascore::io
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace notascore::io {
+
+// A whole file mapped read-only. Nothing is read up front: the OS pages the file
+// in as its bytes are first touched and may drop clean pages under memory
+// pressure, so a mapping costs address space rather than memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    // False for a missing or empty file.
+    bool open(const std::filesystem::path& path);
+    void close() noexcept;
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_data != nullptr; }
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {m_data, m_size}; }
+
+    // Turns off read-ahead on page faults, so scattered reads load only the pages
+    // they touch. Without it a first fault can read megabytes.
+    void adviseRandomAccess() const noexcept;
+    // Starts reading `range` (part of bytes()) in the background, before a pass
+    // over all of it.
+    void prefetch(std::span<const std::byte> range) const noexcept;
+
+private:
+    const std::byte* m_data {nullptr};
+    std::size_t m_size {0};
+};
+
+} // namespace notascore::io
@@ -1,16 +1,273 @@
 #pragma once
 
+#include "notascore/io/MappedFile.hpp"
 #include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/PackedNote.hpp"
+#include "notascore/notation/Score.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace notascore::io {
 
+// Chunk types are four ASCII characters, stored as a little-endian integer.
+[[nodiscard]] constexpr std::uint32_t nsxChunkType(std::string_view fourcc) noexcept {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(fourcc[0]))
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(fourcc[1])) << 8
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(fourcc[2])) << 16
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(fourcc[3])) << 24;
+}
+
+namespace nsx {
+
+constexpr std::uint16_t kVersionMajor = 2;
+constexpr std::uint16_t kVersionMinor = 0;
+constexpr std::size_t kHeaderBytes = 32;
+constexpr std::size_t kChunkEntryBytes = 32;
+// Chunks start on this boundary so their columns can be viewed in place.
+constexpr std::size_t kChunkAlignment = 8;
+
+constexpr std::uint32_t kMetadata = nsxChunkType("META");
+constexpr std::uint32_t kPart = nsxChunkType("PART");
+constexpr std::uint32_t kNotes = nsxChunkType("NOTE");
+constexpr std::uint32_t kMarkings = nsxChunkType("MARK");
+constexpr std::uint32_t kLayoutHints = nsxChunkType("LAYH");
+constexpr std::uint32_t kMeters = nsxChunkType("METR");
+constexpr std::uint32_t kTempos = nsxChunkType("TMPO");
+
+// A reader that does not know a chunk's type (or its version) skips it, unless
+// the chunk carries this flag, in which case the file cannot be read without it.
+constexpr std::uint16_t kRequired = 1;
+// `part` of chunks that belong to the whole score.
+constexpr std::uint32_t kNoPart = 0xFFFFFFFF;
+
+} // namespace nsx
+
+// One entry of the chunk table.
+struct NsxChunk {
+    std::uint32_t type {0};
+    std::uint16_t version {1};
+    std::uint16_t flags {0};
+    std::uint32_t part {nsx::kNoPart};
+    std::uint16_t staff {0};
+    std::uint16_t voice {0};
+    std::uint64_t offset {0};
+    std::uint64_t bytes {0};
+};
+
+struct NsxMetadataEntry {
+    std::string key;
+    std::string value;
+
+    bool operator==(const NsxMetadataEntry&) const = default;
+};
+
+// Layout options and system/page breaks of the first voice when it was saved, so
+// a loader can find the measures of the first page before laying anything out.
+// The breaks are empty when the document was saved with a stale layout.
+struct NsxLayoutHints {
+    int ticksPerQuarter {480};
+    int measureTicks {1920};
+    std::vector<std::uint32_t> systemFirstMeasure;
+    std::vector<std::uint32_t> pageFirstSystem;
+
+    bool operator==(const NsxLayoutHints&) const = default;
+};
+
+// Everything a load returns besides the score itself.
+struct NsxContents {
+    std::vector<NsxMetadataEntry> metadata;
+    NsxLayoutHints layoutHints;
+    // Chunks of unknown types or newer versions that were skipped.
+    std::size_t skippedChunks {0};
+};
+
+// Writes an NSX v2 file: header, chunk table, then the chunks in the order they
+// were added, each padded to nsx::kChunkAlignment. The table is written before
+// the chunks, so a reader can plan its reads from the first few hundred bytes.
+class NsxWriter {
+public:
+    void addChunk(NsxChunk chunk, std::vector<std::byte> payload);
+    // Writes a temporary file next to `path`, syncs it to disk, then renames it
+    // over `path` and syncs the directory: a failed write or a crash leaves
+    // the old file or the whole new one, never a torn one. An NsxMappedDocument
+    // open on it keeps reading the old contents. On Windows, where a mapped
+    // file cannot be replaced, saving over it fails instead.
+    bool write(const std::filesystem::path& path);
+
+private:
+    std::vector<NsxChunk> m_chunks;
+    std::vector<std::vector<std::byte>> m_payloads;
+};
+
+// Reads the header and chunk table of an NSX v2 file, then chunks on demand.
+class NsxReader {
+public:
+    // False for a missing file, another format, a newer major version or a
+    // chunk table that does not fit the file.
+    bool open(const std::filesystem::path& path);
+    [[nodiscard]] std::span<const NsxChunk> chunks() const noexcept { return m_chunks; }
+    [[nodiscard]] std::uint16_t versionMinor() const noexcept { return m_versionMinor; }
+    bool readChunk(const NsxChunk& chunk, std::vector<std::byte>& out);
+
+private:
+    std::ifstream m_input;
+    std::vector<NsxChunk> m_chunks;
+    std::uint16_t m_versionMinor {0};
+};
+
+// NSX documents.
+//
+// v2 layout (all integers little-endian):
+//   header (32 bytes)   magic "NSX2", major and minor version, header size,
+//                       chunk count, chunk table offset and file size
+//   chunk table         32 bytes per chunk: type, version, flags, part, staff,
+//                       voice, offset, size
+//   META                key/value strings (title, composer, meter, ...)
+//   PART                per part: name, range, staff count, voices per staff
+//   NOTE                one per voice: note count, then columns of ticks (int64),
+//                       durations (int32), pitches and velocities (uint8), each
+//                       column 8-byte aligned
+//   MARK                one per voice: marking count, then ticks (int64), widths
+//                       (float32) and kinds (uint8)
+//   LAYH                layout hints
+//   METR                pickup and meter changes: resolution, pickup length and
+//                       meter, change count, then columns of bars (uint32),
+//                       beats and beat units (int32)
+//   TMPO                tempo changes: resolution, change count, then columns
+//                       of ticks (int64), tempos (float64) and ramps (uint8)
+//
+// A NOTE or MARK chunk repeated for a voice makes the file corrupt.
+// Unknown chunks are skipped, so later minor versions can add chunks that older
+// readers ignore. NSX1 files (a note count followed by PackedNote records) are
+// still read.
 class NsxDocument {
 public:
+    // The whole score, loaded or unloaded parts alike.
+    bool save(const std::filesystem::path& path, const notascore::notation::Score& score,
+        std::span<const NsxMetadataEntry> metadata = {}) const;
+    // Replaces the parts, meters and tempos of `score`; files without METR or
+    // TMPO chunks get one meter (4/4) and one tempo (120). Layout options take
+    // the saved tick resolution and measure length.
+    bool load(const std::filesystem::path& path, notascore::notation::Score& score, NsxContents* contents = nullptr) const;
+
+    // A single voice, as one part with one staff.
     bool save(const std::filesystem::path& path, const notascore::notation::NotationEngine& notation) const;
+    // The notes of the first voice of the first part.
+    bool load(const std::filesystem::path& path, std::vector<notascore::notation::PackedNote>& outNotes) const;
+    // Fails when a tick is negative or does not fit a NoteEvent.
     bool load(const std::filesystem::path& path, std::vector<notascore::notation::NoteEvent>& outNotes) const;
 };
 
+// The note columns of one voice, viewed in place in a mapped file. Ticks are in
+// ascending order, as saved.
+struct NsxNoteView {
+    std::span<const std::int64_t> ticks;
+    std::span<const std::int32_t> durations;
+    std::span<const std::uint8_t> pitches;
+    std::span<const std::uint8_t> velocities;
+
+    [[nodiscard]] std::size_t size() const noexcept { return ticks.size(); }
+    [[nodiscard]] bool empty() const noexcept { return ticks.empty(); }
+    [[nodiscard]] notascore::notation::PackedNote note(std::size_t index) const noexcept {
+        return {ticks[index], durations[index], pitches[index], velocities[index]};
+    }
+    // Index of the first note at or after `tick`. Touches only the pages of the
+    // tick column that the search visits. Meaningful only while ticks ascend,
+    // which events() checks for the notes it decodes.
+    [[nodiscard]] std::size_t lowerBound(std::int64_t tick) const noexcept;
+    // Notes [begin, end) as NoteEvents; false when a tick is negative, does not
+    // fit one or is below the tick before it (note begin - 1 included), so
+    // decoding a column in consecutive slices checks its whole order.
+    bool events(std::size_t begin, std::size_t end, std::vector<notascore::notation::NoteEvent>& out) const;
+};
+
+// An NSX v2 file opened without a load. The file is memory-mapped and the note
+// columns are viewed where they lie, so opening costs the chunk table and part
+// headers, and a page of notes is read from disk only when something looks at
+// it; read-ahead is off, so scattered reads stay scattered. Tick order is
+// checked as notes are decoded, not at open. A voice is copied
+// into a NotationEngine on its first edit; other voices stay mapped. Views are
+// valid until close() or the next open().
+class NsxMappedDocument {
+public:
+    // False where NsxDocument::load would fail, and also for NSX1 files,
+    // big-endian hosts and columns that are not aligned for their type, all of
+    // which the stream loader still reads.
+    bool open(const std::filesystem::path& path);
+    void close() noexcept;
+    [[nodiscard]] bool isOpen() const noexcept { return m_file.isOpen(); }
+
+    [[nodiscard]] std::span<const NsxMetadataEntry> metadata() const noexcept { return m_metadata; }
+    [[nodiscard]] const NsxLayoutHints& layoutHints() const noexcept { return m_layoutHints; }
+    // Meters and tempos as NsxDocument::load gives them to a score.
+    [[nodiscard]] const notascore::notation::MeasureIndex& measureIndex() const noexcept { return m_measureIndex; }
+    [[nodiscard]] const notascore::notation::TempoMap& tempoMap() const noexcept { return m_tempoMap; }
+    [[nodiscard]] std::size_t mappedBytes() const noexcept { return m_file.bytes().size(); }
+    [[nodiscard]] std::size_t noteCount() const noexcept { return m_noteCount; }
+    // Chunks of unknown types or newer versions that were skipped.
+    [[nodiscard]] std::size_t skippedChunks() const noexcept { return m_skippedChunks; }
+
+    [[nodiscard]] std::size_t partCount() const noexcept { return m_parts.size(); }
+    [[nodiscard]] std::string_view partName(std::size_t part) const noexcept { return m_parts[part].name; }
+    [[nodiscard]] std::string_view partRange(std::size_t part) const noexcept { return m_parts[part].range; }
+    [[nodiscard]] std::size_t staffCount(std::size_t part) const noexcept { return m_parts[part].staffFirstVoice.size() - 1; }
+    [[nodiscard]] std::size_t voiceCount(std::size_t part, std::size_t staff) const noexcept {
+        return m_parts[part].staffFirstVoice[staff + 1] - m_parts[part].staffFirstVoice[staff];
+    }
+
+    // The voice as saved, in place; empty for a voice that does not exist.
+    [[nodiscard]] NsxNoteView notes(std::size_t part, std::size_t staff, std::size_t voice) const noexcept;
+    // Decoded markings of a voice as saved.
+    bool markings(std::size_t part, std::size_t staff, std::size_t voice,
+        std::vector<notascore::notation::Marking>& out) const;
+    // Starts reading a voice from disk, ahead of a pass over all of its notes.
+    void prefetch(std::size_t part, std::size_t staff, std::size_t voice) const noexcept;
+    // The engine of an edited voice; nullptr until its first edit().
+    [[nodiscard]] const notascore::notation::NotationEngine* edited(
+        std::size_t part, std::size_t staff, std::size_t voice) const noexcept;
+    // Copy on write: the first call copies the voice's notes and markings into
+    // an engine, which later calls return. Nullptr for a voice that does not
+    // exist or whose ticks do not fit a NoteEvent.
+    notascore::notation::NotationEngine* edit(std::size_t part, std::size_t staff, std::size_t voice);
+
+    // Replaces the parts of `score` with every voice, edited or as saved, the
+    // way NsxDocument::load would.
+    bool promote(notascore::notation::Score& score) const;
+
+private:
+    struct MappedPart {
+        std::string_view name;
+        std::string_view range;
+        // Index into m_voices of each staff's first voice, plus one past the last.
+        std::vector<std::size_t> staffFirstVoice;
+    };
+    struct MappedVoice {
+        std::span<const std::byte> noteBytes;
+        NsxNoteView notes;
+        std::span<const std::byte> markings;
+        std::unique_ptr<notascore::notation::NotationEngine> edited;
+    };
+
+    // m_voices.size() for a voice that does not exist.
+    [[nodiscard]] std::size_t indexOf(std::size_t part, std::size_t staff, std::size_t voice) const noexcept;
+
+    MappedFile m_file;
+    std::vector<NsxMetadataEntry> m_metadata;
+    NsxLayoutHints m_layoutHints;
+    notascore::notation::MeasureIndex m_measureIndex;
+    notascore::notation::TempoMap m_tempoMap;
+    std::vector<MappedPart> m_parts;
+    std::vector<MappedVoice> m_voices;
+    std::size_t m_noteCount {0};
+    std::size_t m_skippedChunks {0};
+};
+
 } // namespace notascore::io
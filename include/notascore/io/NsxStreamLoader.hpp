@@ -0,0 +1,117 @@
+#pragma once
+
+#include "notascore/core/TaskScheduler.hpp"
+#include "notascore/io/NsxDocument.hpp"
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Score.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace notascore::io {
+
+struct NsxLoadProgress {
+    std::size_t loadedNotes {0};
+    std::size_t totalNotes {0};
+    // A slice did not decode. The load stopped there: notes published so far and
+    // edits made meanwhile stay in the score, the rest of the file is missing.
+    bool failed {false};
+
+    [[nodiscard]] bool done() const noexcept { return failed || loadedNotes == totalNotes; }
+};
+
+// Loads an NSX file first page first. start() maps the file, builds every part
+// and hands the notes of the first page (found from the saved layout hints) to
+// their voices before returning, so the first page can be laid out and drawn
+// at once. The rest is decoded in slices by background tasks on a
+// TaskScheduler; publishReady() and finish() append decoded slices to their
+// voices, in order, on the thread that owns the score. Tasks never touch the
+// score, so it can be laid out, drawn and edited meanwhile, but not saved.
+// Voices are found again by part id on every publish: parts removed meanwhile
+// (or a cleared score) get no more notes, and unloaded parts keep theirs packed.
+class NsxStreamLoader {
+public:
+    using ProgressCallback = std::function<void(const NsxLoadProgress&)>;
+
+    NsxStreamLoader() = default;
+    NsxStreamLoader(const NsxStreamLoader&) = delete;
+    NsxStreamLoader& operator=(const NsxStreamLoader&) = delete;
+    // Cancels and waits for the tasks; notes not yet published are dropped.
+    ~NsxStreamLoader();
+
+    // Called on the owner thread whenever notes are published.
+    void setProgressCallback(ProgressCallback callback) { m_progressCallback = std::move(callback); }
+
+    // Replaces the parts of `score`, which must outlive the load. False, leaving
+    // `score` empty, where NsxDocument::load would fail. Files that cannot be
+    // mapped in place (NSX1, big-endian hosts) or whose first page does not
+    // decode (ticks out of order) are loaded whole, and are done on return.
+    // Ticks out of order after the first page fail the load when reached.
+    bool start(const std::filesystem::path& path, notascore::notation::Score& score,
+        notascore::core::TaskScheduler& scheduler, NsxContents* contents = nullptr);
+    // Publishes every slice decoded so far, through
+    // NotationEngine::addLoadedNotes: edits made during the load keep their
+    // undo steps, and no undo removes published notes. Returns whether the load
+    // is done.
+    bool publishReady();
+    // Waits for the remaining slices and publishes them.
+    void finish();
+
+    // From start() until the last slice is published or the load fails. A save
+    // made meanwhile would miss the notes not yet published, so callers hold
+    // saves until finish().
+    [[nodiscard]] bool loading() const noexcept { return !m_progress.done(); }
+    [[nodiscard]] const NsxLoadProgress& progress() const noexcept { return m_progress; }
+    // Notes before this tick were published by start().
+    [[nodiscard]] std::int64_t firstPageEndTick() const noexcept { return m_firstPageEnd; }
+
+private:
+    // Notes [begin, end) of one voice. A task writes `notes` and `ok`, then sets
+    // `decoded` under the mutex; only then does the owner thread read them.
+    struct Slice {
+        NsxNoteView source;
+        std::size_t begin {0};
+        std::size_t end {0};
+        std::vector<notascore::notation::NoteEvent> notes;
+        bool decoded {false};
+        bool ok {false};
+    };
+    struct Voice {
+        NsxNoteView notes;
+        // Score::partId() of its part.
+        std::uint64_t part {0};
+        std::size_t staff {0};
+        std::size_t voice {0};
+        // Slices of this voice are m_slices[nextSlice, endSlice), in tick order.
+        std::size_t nextSlice {0};
+        std::size_t endSlice {0};
+    };
+
+    void decode(std::size_t slice);
+    void cancel();
+    void fail();
+    // Drops the unpublished slices of `voice`, whose part is gone.
+    void drop(Voice& voice);
+    void report();
+
+    NsxMappedDocument m_document;
+    notascore::notation::Score* m_score {nullptr};
+    std::vector<Voice> m_voices;
+    std::vector<Slice> m_slices;
+    ProgressCallback m_progressCallback;
+    NsxLoadProgress m_progress;
+    std::int64_t m_firstPageEnd {0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_decodedSignal;
+    std::size_t m_pendingTasks {0};
+    std::atomic<bool> m_cancelled {false};
+};
+
+} // namespace notascore::io
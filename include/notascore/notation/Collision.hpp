@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace notascore::notation {
+
+struct Box {
+    float x0 {0.0f};
+    float y0 {0.0f};
+    float x1 {0.0f};
+    float y1 {0.0f};
+
+    [[nodiscard]] bool intersects(const Box& other) const noexcept {
+        return x0 < other.x1 && other.x0 < x1 && y0 < other.y1 && other.y0 < y1;
+    }
+};
+
+// Uniform-grid broadphase for one system. Each box is filed once, in the cell
+// holding its top-left corner (an intrusive list in flat arrays, so reset()
+// does not allocate once warmed up); queries widen their cell range by the
+// largest box seen. Boxes outside the grid clamp to the border cells, and
+// cells are invalidated by a generation stamp rather than cleared.
+class SpatialGrid {
+public:
+    void reset(float originX, float originY, float width, float height, float cellSize);
+
+    [[nodiscard]] bool overlaps(const Box& box) const noexcept { return firstOverlap(box) != nullptr; }
+    // Some registered box intersecting `box` (deterministic for a given insert order), or nullptr.
+    [[nodiscard]] const Box* firstOverlap(const Box& box) const noexcept;
+    void insert(const Box& box);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_boxes.size(); }
+
+private:
+    [[nodiscard]] int column(float x) const noexcept;
+    [[nodiscard]] int row(float y) const noexcept;
+    [[nodiscard]] std::int32_t head(std::size_t cell) const noexcept {
+        return m_cellStamp[cell] == m_generation ? m_cellHead[cell] : -1;
+    }
+
+    float m_originX {0.0f};
+    float m_originY {0.0f};
+    float m_inverseCell {1.0f};
+    float m_maxWidth {0.0f};
+    float m_maxHeight {0.0f};
+    int m_columns {1};
+    int m_rows {1};
+    std::uint32_t m_generation {0};
+    std::vector<std::uint32_t> m_cellStamp;
+    std::vector<std::int32_t> m_cellHead;
+    std::vector<std::int32_t> m_next;
+    std::vector<Box> m_boxes;
+};
+
+} // namespace notascore::notation
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "notascore/notation/PersistentVector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace notascore::notation {
+
+struct NoteEvent;
+struct Marking;
+
+// Immutable view of the document at one point in time. Copies share structure,
+// so holding one per undo step or handing one to a background save is cheap.
+struct DocumentSnapshot {
+    PersistentVector<NoteEvent> notes;
+    PersistentVector<Marking> markings;
+};
+
+// Linear undo/redo history of document snapshots. The oldest steps are dropped
+// beyond kMaxSteps. Each step carries the stamp it was pushed with, so the
+// histories of several documents can be interleaved in the order their steps
+// were made.
+class EditHistory {
+public:
+    static constexpr std::size_t kMaxSteps = 1024;
+
+    EditHistory();
+
+    // Drops every step and starts over from `base` (a freshly loaded document).
+    void reset(DocumentSnapshot base);
+    // Records `state` as the newest step and discards the redo branch.
+    void push(DocumentSnapshot state, std::uint64_t stamp = 0);
+    // Step back or forward; returns the snapshot to restore, or null at either end.
+    [[nodiscard]] const DocumentSnapshot* undo() noexcept;
+    [[nodiscard]] const DocumentSnapshot* redo() noexcept;
+
+    [[nodiscard]] bool canUndo() const noexcept { return m_current > 0; }
+    [[nodiscard]] bool canRedo() const noexcept { return m_current + 1 < m_states.size(); }
+    // Stamps of the step undo() or redo() would take; 0 at either end.
+    [[nodiscard]] std::uint64_t undoStamp() const noexcept { return canUndo() ? m_stamps[m_current] : 0; }
+    [[nodiscard]] std::uint64_t redoStamp() const noexcept { return canRedo() ? m_stamps[m_current + 1] : 0; }
+    [[nodiscard]] const DocumentSnapshot& current() const noexcept { return m_states[m_current]; }
+    // Rewrites every step, oldest first, without moving through the history.
+    void amend(const std::function<void(DocumentSnapshot&)>& change);
+
+private:
+    std::deque<DocumentSnapshot> m_states;
+    // Parallel to m_states; the base state's is 0.
+    std::deque<std::uint64_t> m_stamps;
+    std::size_t m_current {0};
+};
+
+} // namespace notascore::notation
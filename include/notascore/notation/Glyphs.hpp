@@ -0,0 +1,56 @@
+#pragma once
+
+#include "notascore/notation/Collision.hpp"
+#include "notascore/notation/SmuflMetadata.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace notascore::notation {
+
+using smufl::Anchor;
+using smufl::Glyph;
+
+// Glyph metrics of the bundled SMuFL font. SmuflMetadata.hpp is generated at
+// build time from resources/smufl/metadata.json, so every lookup is an index into
+// a constexpr table and nothing is parsed at startup. Units are staff spaces.
+namespace glyphs {
+
+// Bounding box with y pointing up, as in SMuFL.
+[[nodiscard]] constexpr smufl::Box bbox(Glyph glyph) noexcept {
+    return smufl::kGlyphBoxes[static_cast<std::size_t>(glyph)];
+}
+
+[[nodiscard]] constexpr float width(Glyph glyph) noexcept { return bbox(glyph).x1 - bbox(glyph).x0; }
+[[nodiscard]] constexpr float height(Glyph glyph) noexcept { return bbox(glyph).y1 - bbox(glyph).y0; }
+
+[[nodiscard]] constexpr bool hasAnchor(Glyph glyph, Anchor anchor) noexcept {
+    return (smufl::kGlyphAnchorMask[static_cast<std::size_t>(glyph)] >> static_cast<unsigned>(anchor) & 1u) != 0;
+}
+
+// Anchor point relative to the glyph origin; the origin itself when the glyph
+// does not define the anchor.
+[[nodiscard]] constexpr smufl::Point anchor(Glyph glyph, Anchor anchor) noexcept {
+    return smufl::kGlyphAnchors[static_cast<std::size_t>(glyph)][static_cast<std::size_t>(anchor)];
+}
+
+// Box of `glyph` drawn with its origin at (x, y) in layout coordinates (y down).
+[[nodiscard]] constexpr Box layoutBox(Glyph glyph, float x, float y) noexcept {
+    const auto box = bbox(glyph);
+    return {.x0 = x + box.x0, .y0 = y - box.y1, .x1 = x + box.x1, .y1 = y - box.y0};
+}
+
+// Glyph by SMuFL name, e.g. "noteheadBlack".
+[[nodiscard]] constexpr std::optional<Glyph> fromName(std::string_view name) noexcept {
+    for (std::size_t i = 0; i < smufl::kGlyphCount; ++i) {
+        if (smufl::kGlyphNames[i] == name) {
+            return static_cast<Glyph>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace glyphs
+
+} // namespace notascore::notation
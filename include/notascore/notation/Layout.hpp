@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace notascore::notation {
+
+struct NoteEvent;
+struct Marking;
+class MeasureCache;
+
+// All lengths are in staff spaces (distance between two staff lines).
+struct LayoutOptions {
+    int ticksPerQuarter {480};
+    int measureTicks {1920};
+
+    float spaceUnit {1.6f};
+    float measurePadding {2.0f};
+    float emptyMeasureWidth {8.0f};
+
+    float pageWidth {120.0f};
+    float pageHeight {170.0f};
+    float marginX {8.0f};
+    float marginTop {10.0f};
+    float marginBottom {10.0f};
+    float systemHeight {12.0f};
+    float minSystemGap {6.0f};
+
+    // Greedy system breaking instead of the optimal one, which keeps per-measure
+    // breaking state between passes.
+    bool lowMemoryMode {false};
+
+    // Lay out note positions and collisions only for the systems of the viewport
+    // pages and `prefetchPages` on either side (see NotationEngine::setViewport).
+    // Measure widths, system breaks and pages are always computed in full.
+    bool lazyPages {false};
+    std::size_t prefetchPages {2};
+
+    [[nodiscard]] float lineWidth() const noexcept { return pageWidth - 2.0f * marginX; }
+};
+
+enum class LayoutItemKind : std::uint8_t {
+    Accidental,
+    Articulation,
+    Dynamic,
+    Lyric
+};
+
+// A glyph placed by the collision pass. y is relative to the system middle
+// line. owner is relative to the system, so edits elsewhere never renumber it:
+// the offset from the system's first note for accidentals, or from its first
+// marking (the first one at or after the system's start tick) otherwise.
+struct LayoutItem {
+    float x {0.0f};
+    float y {0.0f};
+    float width {0.0f};
+    float height {0.0f};
+    std::uint32_t owner {0};
+    LayoutItemKind kind {LayoutItemKind::Accidental};
+
+    bool operator==(const LayoutItem&) const = default;
+};
+
+// Flat (structure-of-arrays) layout output. Note arrays are parallel to the
+// engine's tick-sorted note storage; range tables hold N+1 offsets. noteX is
+// absolute, noteY is relative to the middle line of the note's system so that
+// moving a system never touches its notes.
+struct LayoutResult {
+    std::vector<float> noteX;
+    std::vector<float> noteY;
+    std::vector<std::uint32_t> noteMeasure;
+
+    std::vector<std::uint32_t> measureFirstNote;
+    std::vector<float> measureX;
+    std::vector<float> measureWidth;
+    std::vector<std::uint32_t> measureSystem;
+
+    std::vector<std::uint32_t> systemFirstMeasure;
+    std::vector<float> systemY;
+    std::vector<std::uint32_t> systemPage;
+
+    std::vector<std::uint32_t> pageFirstSystem;
+
+    // Collision-resolved accidentals and markings, one block per system.
+    std::vector<std::vector<LayoutItem>> systemItems;
+
+    [[nodiscard]] std::size_t measureCount() const noexcept { return measureX.size(); }
+    [[nodiscard]] std::size_t systemCount() const noexcept { return systemY.size(); }
+    [[nodiscard]] std::size_t pageCount() const noexcept { return pageFirstSystem.empty() ? 0 : pageFirstSystem.size() - 1; }
+};
+
+// Work done by the last layout pass.
+struct LayoutPassStats {
+    bool fullPass {false};
+    // Measures [firstMeasureRespaced, firstMeasureRespaced + measuresRespaced).
+    std::size_t firstMeasureRespaced {0};
+    std::size_t measuresRespaced {0};
+    std::size_t systemsJustified {0};
+    std::size_t pagesStacked {0};
+};
+
+// Natural (unjustified) spacing, kept between passes so that justification can
+// be redone without re-spacing measures.
+struct MeasureSpacing {
+    std::vector<float> naturalWidth;
+    std::vector<float> noteOffset;
+};
+
+// Optimal system breaking state, kept between passes so that an edit only
+// recomputes the measures at and after it. Entries hold M+1 values: prefix sums
+// of natural widths, the best demerits of breaking measures [0, m) into full
+// systems, and the first measure of the last of those systems.
+struct LineBreakState {
+    std::vector<double> prefixWidth;
+    std::vector<double> cost;
+    std::vector<std::uint32_t> previous;
+};
+
+namespace layout {
+
+// Pass 0: number of measures needed to hold every note.
+[[nodiscard]] std::size_t measureCountFor(std::span<const NoteEvent> notes, const LayoutOptions& options);
+
+// Pass 0: bucket tick-sorted notes of measures [first, last) (fills measureFirstNote
+// and noteMeasure; both must already be sized, with the final offset set).
+void indexMeasures(std::span<const NoteEvent> notes, const LayoutOptions& options, std::size_t first, std::size_t last,
+    LayoutResult& result);
+
+// Pass 1: rhythmic spacing and staff positions of measures [first, last). With a
+// cache, measures whose content was spaced before reuse that result.
+void spaceMeasures(std::span<const NoteEvent> notes, const LayoutOptions& options, std::size_t first, std::size_t last,
+    LayoutResult& result, MeasureSpacing& spacing, MeasureCache* cache = nullptr);
+
+// Cache key of measure `measure` (notes [begin, end)): onsets relative to the
+// barline and pitches, combined with the spacing context of `options`.
+[[nodiscard]] std::uint64_t measureContentKey(std::span<const NoteEvent> notes, const LayoutOptions& options,
+    std::size_t measure, std::size_t begin, std::size_t end) noexcept;
+
+// Pass 2: system breaking; returns S+1 measure offsets.
+[[nodiscard]] std::vector<std::uint32_t> breakSystemsGreedy(std::span<const float> naturalWidths, float lineWidth);
+
+// Incremental variant of pass 2: re-breaks from system `firstSystem` until the new
+// breaks rejoin the old ones at or after measure `stableFrom`. Updates `breaks`
+// in place and returns the range of systems whose content may have changed.
+struct RebreakResult {
+    std::size_t firstSystem {0};
+    std::size_t lastSystem {0};
+    std::ptrdiff_t systemDelta {0};
+};
+[[nodiscard]] RebreakResult rebreakSystemsGreedy(std::span<const float> naturalWidths, float lineWidth,
+    std::size_t firstSystem, std::size_t stableFrom, std::vector<std::uint32_t>& breaks);
+
+// Pass 2 (default): Knuth-Plass style breaking that minimizes the total
+// demerits of all systems. A system never holds more measures than fit in the
+// line (a lone overfull measure excepted), so the work is O(M * K) for K
+// measures per system. Entries of `state` before `fromMeasure` must be current;
+// when measures from `stableFrom` on kept their widths (and their count), the
+// pass stops as soon as the breaks after the edit settle back onto the old ones,
+// instead of running to the last measure.
+[[nodiscard]] std::vector<std::uint32_t> breakSystemsOptimal(std::span<const float> naturalWidths, float lineWidth,
+    std::size_t fromMeasure, LineBreakState& state,
+    std::size_t stableFrom = std::numeric_limits<std::size_t>::max());
+
+// Range of systems of `fresh` that differ from `old`, widened to cover the dirty
+// measures [dirtyFirst, dirtyLast). Systems past the range keep their content
+// and are only renumbered by systemDelta.
+[[nodiscard]] RebreakResult diffBreaks(std::span<const std::uint32_t> old, std::span<const std::uint32_t> fresh,
+    std::size_t dirtyFirst, std::size_t dirtyLast);
+
+// Pass 3: horizontal justification of systems [first, last).
+void justifySystems(const LayoutOptions& options, const MeasureSpacing& spacing, std::size_t first, std::size_t last,
+    LayoutResult& result);
+
+// Pass 3, measures only: measureX, measureWidth and measureSystem of systems
+// [first, last), without touching their notes.
+void justifyMeasures(const LayoutOptions& options, const MeasureSpacing& spacing, std::size_t first, std::size_t last,
+    LayoutResult& result);
+
+// Pass 3b: place accidentals and markings of systems [first, last) without
+// overlaps, using a uniform-grid broadphase per system.
+void resolveCollisions(std::span<const NoteEvent> notes, std::span<const Marking> markings, const LayoutOptions& options,
+    std::size_t first, std::size_t last, LayoutResult& result);
+
+// Pass 4: page assignment (fills systemPage/pageFirstSystem).
+void paginate(const LayoutOptions& options, LayoutResult& result);
+
+// Pass 5: vertical placement of the systems of pages [first, last).
+void stackPages(const LayoutOptions& options, std::size_t first, std::size_t last, LayoutResult& result);
+
+} // namespace layout
+
+} // namespace notascore::notation
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace notascore::notation {
+
+// LRU cache of measure spacing keyed by a hash of the measure's content (onsets
+// relative to the barline and pitches) and of the spacing context (meter and
+// spacing options). Repeated bars, ostinatos and bars copied between parts reuse
+// the natural width and note offsets computed for the first occurrence. Entries
+// also record the note count, so only a full 64-bit collision between measures
+// of equal size could return wrong spacing.
+//
+// Spacing a measure costs a few hundred nanoseconds, so the cache must be
+// cheaper still: entries live in a fixed slot array with an open-addressing
+// index and an intrusive recency list, and evicted slots keep their offset
+// buffers, so a warm cache never allocates.
+//
+// One cache may be shared by several engines (e.g. every voice of a Score) and
+// by parallel layout chunks. It is split into kShards independent LRU caches,
+// each with its own lock, picked by a Fibonacci hash of the whole key (the
+// key's own high bits are poorly mixed): lookups and inserts lock one shard,
+// so threads spacing different measures rarely wait on each other. Recency is
+// kept per shard.
+class MeasureCache {
+public:
+    static constexpr std::size_t kDefaultCapacity = 16384;
+    static constexpr unsigned kShardBits = 4;
+    static constexpr std::size_t kShards = std::size_t {1} << kShardBits;
+
+    explicit MeasureCache(std::size_t capacity = kDefaultCapacity) { setCapacity(capacity); }
+
+    // On a hit copies the cached offsets into `noteOffset` (sized to the measure's
+    // notes), sets `naturalWidth` and marks the entry most recently used.
+    bool lookup(std::uint64_t key, std::span<float> noteOffset, float& naturalWidth);
+    // Stores a freshly spaced measure, evicting the least recently used entry.
+    void insert(std::uint64_t key, std::span<const float> noteOffset, float naturalWidth);
+
+    void clear();
+    // Drops every entry; the capacity is divided among the shards.
+    void setCapacity(std::size_t capacity);
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+    [[nodiscard]] std::size_t size() const;
+
+    [[nodiscard]] std::uint64_t hits() const;
+    [[nodiscard]] std::uint64_t misses() const;
+    [[nodiscard]] double hitRate() const;
+    void resetStats();
+
+private:
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+    struct Slot {
+        std::uint64_t key {0};
+        float naturalWidth {0.0f};
+        std::uint32_t newer {kNone};
+        std::uint32_t older {kNone};
+        std::vector<float> noteOffset;
+    };
+
+    // One LRU cache. Aligned so that shards locked by different threads do not
+    // share a cache line.
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::vector<Slot> slots;
+        // Open addressing with linear probing; holds slot indices, kNone when empty.
+        std::vector<std::uint32_t> buckets;
+        std::size_t size {0};
+        std::uint32_t newest {kNone};
+        std::uint32_t oldest {kNone};
+        std::uint64_t hits {0};
+        std::uint64_t misses {0};
+
+        // The caller holds `mutex` for all of these.
+        [[nodiscard]] std::size_t bucketOf(std::uint64_t key) const noexcept;
+        // Bucket holding `key`, or kNone.
+        [[nodiscard]] std::uint32_t find(std::uint64_t key) const noexcept;
+        void eraseBucket(std::size_t bucket) noexcept;
+        void unlink(std::uint32_t slot) noexcept;
+        void pushNewest(std::uint32_t slot) noexcept;
+        void reset(std::size_t capacity);
+    };
+
+    // Keys come from a combine that mixes their high bits poorly, so the shard is
+    // taken from the top of a Fibonacci hash of the whole key.
+    [[nodiscard]] Shard& shardOf(std::uint64_t key) noexcept {
+        return m_shards[static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - kShardBits))];
+    }
+
+    std::array<Shard, kShards> m_shards;
+    std::size_t m_capacity {0};
+};
+
+} // namespace notascore::notation
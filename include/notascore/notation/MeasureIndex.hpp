@@ -0,0 +1,102 @@
+#pragma once
+
+#include "notascore/notation/Time.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace notascore::notation {
+
+// Time signature: `beats` notes of 1/`beatUnit` per bar.
+struct Meter {
+    int beats {4};
+    int beatUnit {4};
+
+    [[nodiscard]] constexpr Tick barTicks(int ticksPerQuarter) const noexcept {
+        return static_cast<Tick>(beats) * 4 * ticksPerQuarter / beatUnit;
+    }
+    bool operator==(const Meter&) const = default;
+};
+
+// Parses a meter such as "4/4", "6/8" or "12/8". The beat unit must be a power
+// of two up to 64.
+[[nodiscard]] constexpr std::optional<Meter> parseMeter(std::string_view text) noexcept {
+    const auto number = [&](int& out) {
+        out = 0;
+        std::size_t digits = 0;
+        for (; !text.empty() && text[0] >= '0' && text[0] <= '9' && digits < 3; ++digits) {
+            out = out * 10 + (text[0] - '0');
+            text.remove_prefix(1);
+        }
+        return digits > 0 && out > 0;
+    };
+    Meter meter;
+    if (!number(meter.beats) || text.empty() || text[0] != '/') {
+        return std::nullopt;
+    }
+    text.remove_prefix(1);
+    if (!number(meter.beatUnit) || !text.empty() || meter.beatUnit > 64 || (meter.beatUnit & (meter.beatUnit - 1)) != 0) {
+        return std::nullopt;
+    }
+    return meter;
+}
+
+// Bar boundaries of a score: a meter per run of bars and an optional pickup.
+// Bars are numbered from 0; with a pickup, bar 0 is the pickup and full bars
+// start at 1. Each run stores its first bar and start tick, so tick -> bar and
+// bar -> tick are a binary search over meter changes (none for a single meter)
+// and a division. Changing a meter only recomputes the start ticks of later runs.
+class MeasureIndex {
+public:
+    explicit MeasureIndex(int ticksPerQuarter = 480, Meter meter = {});
+
+    // Meter from `bar` on, replacing a change already there. Returns false,
+    // changing nothing, for a meter whose bar is not a whole number of ticks, or
+    // for the pickup bar.
+    bool setMeter(std::uint32_t bar, Meter meter);
+    // Removes the change at `bar`; the first meter cannot be removed.
+    bool removeMeter(std::uint32_t bar);
+    // Makes bar 0 a pickup of `ticks` (renumbering every later bar), or removes
+    // the pickup for 0. Returns false for a negative length.
+    bool setPickup(Tick ticks);
+
+    [[nodiscard]] int ticksPerQuarter() const noexcept { return m_ticksPerQuarter; }
+    [[nodiscard]] Tick pickupTicks() const noexcept { return m_pickup; }
+    [[nodiscard]] std::size_t meterChangeCount() const noexcept { return m_runs.size() - (m_pickup > 0 ? 1 : 0); }
+    // First bar of meter change `change`, in bar order: 0 for the first, or 1
+    // after a pickup.
+    [[nodiscard]] std::uint32_t meterChangeBar(std::size_t change) const noexcept {
+        return m_runs[change + (m_pickup > 0 ? 1 : 0)].firstBar;
+    }
+    [[nodiscard]] Meter meterAt(std::uint32_t bar) const noexcept { return m_runs[runOfBar(bar)].meter; }
+
+    // Bar containing `tick`; bar 0 for negative ticks.
+    [[nodiscard]] std::uint32_t barAt(Tick tick) const noexcept;
+    [[nodiscard]] Tick barStart(std::uint32_t bar) const noexcept;
+    [[nodiscard]] Tick barLength(std::uint32_t bar) const noexcept { return m_runs[runOfBar(bar)].barTicks; }
+
+private:
+    struct Run {
+        std::uint32_t firstBar {0};
+        Tick startTick {0};
+        Tick barTicks {0};
+        Meter meter {};
+    };
+
+    [[nodiscard]] std::size_t runOfBar(std::uint32_t bar) const noexcept;
+    // Recomputes the start ticks of runs after `run`, and the search arrays.
+    void updateAfter(std::size_t run);
+
+    int m_ticksPerQuarter;
+    Tick m_pickup {0};
+    // Sorted by first bar; the first run starts at bar 0 and is the pickup when
+    // there is one.
+    std::vector<Run> m_runs;
+    // Run starts, kept dense for searching.
+    std::vector<std::uint32_t> m_firstBars;
+    std::vector<Tick> m_startTicks;
+};
+
+} // namespace notascore::notation
@@ -1,30 +1,362 @@
 #pragma once
 
+#include "notascore/core/EpochPublisher.hpp"
+#include "notascore/notation/EditHistory.hpp"
+#include "notascore/notation/Layout.hpp"
+#include "notascore/notation/MeasureIndex.hpp"
+#include "notascore/notation/Selection.hpp"
+#include "notascore/notation/TickIndex.hpp"
+
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
+namespace notascore::core {
+class ThreadPool;
+}
+
 namespace notascore::notation {
 
+class MeasureCache;
+
 struct NoteEvent {
     int tick {0};
     int duration {0};
     int midiPitch {60};
+    int velocity {80};
+
+    bool operator==(const NoteEvent&) const = default;
+};
+
+enum class MarkingKind : std::uint8_t {
+    Articulation,
+    Dynamic,
+    Lyric
+};
+
+// Articulation, dynamic or lyric attached to the onset at `tick`.
+struct Marking {
+    int tick {0};
+    MarkingKind kind {MarkingKind::Articulation};
+    float width {1.0f};
+
+    bool operator==(const Marking&) const = default;
+};
+
+enum class EditKind : std::uint8_t {
+    InsertNote,
+    EraseNote,
+    ModifyNote,
+    AddNotes,
+    InsertMarking,
+    EraseMarking,
+    BulkEdit
+};
+
+enum class BulkEditKind : std::uint8_t {
+    // midiPitch += amount, clamped to 0..127.
+    Transpose,
+    // tick += amount; notes stop at tick 0.
+    ShiftTicks,
+    // duration *= amount / divisor, rounded, at least one tick.
+    ScaleDurations,
+    // velocity += amount, clamped to 1..127.
+    AdjustVelocity,
+    // velocity *= amount / divisor, rounded, clamped to 1..127.
+    ScaleVelocities
+};
+
+// One transform applied to every note of a selection.
+struct BulkEdit {
+    BulkEditKind kind {BulkEditKind::Transpose};
+    int amount {0};
+    int divisor {1};
+};
+
+// One storage-level edit, as reported to the edit listener and accepted by
+// applyEdit(). Indices refer to the tick-sorted storage at the time of the edit.
+// AddNotes merges `notes` in tick order (addNote() reports a one-note AddNotes);
+// BulkEdit applies `bulk` to `ranges`. Spans are only valid for the duration of
+// the callback.
+struct EditRecord {
+    EditKind kind {EditKind::InsertNote};
+    std::uint32_t index {0};
+    NoteEvent note {};
+    Marking marking {};
+    std::span<const NoteEvent> notes {};
+    BulkEdit bulk {};
+    std::span<const NoteRange> ranges {};
+};
+
+// The layout of one system as published: its slice of LayoutResult, with note
+// and measure offsets counted from the system's first note. Measure numbers in
+// noteMeasure stay absolute.
+struct PublishedSystem {
+    std::vector<float> noteX;
+    std::vector<float> noteY;
+    std::vector<std::uint32_t> noteMeasure;
+    // One offset per measure of the system, plus one past the last note.
+    std::vector<std::uint32_t> measureFirstNote;
+    std::vector<float> measureX;
+    std::vector<float> measureWidth;
+    std::vector<LayoutItem> items;
+};
+
+// A LayoutResult split into immutable per-system blocks. Consecutive versions
+// share the blocks of every system the pass between them did not lay out, so a
+// publish copies the changed systems and the system and page tables, never the
+// whole score. A reader finds note n in systems[systemOfNote(n)], at
+// n - systemFirstNote[s].
+struct PublishedLayout {
+    std::vector<std::shared_ptr<const PublishedSystem>> systems;
+    // S+1 offsets each.
+    std::vector<std::uint32_t> systemFirstNote;
+    std::vector<std::uint32_t> systemFirstMeasure;
+    std::vector<float> systemY;
+    std::vector<std::uint32_t> systemPage;
+    std::vector<std::uint32_t> pageFirstSystem;
+
+    [[nodiscard]] std::size_t noteCount() const noexcept { return systemFirstNote.empty() ? 0 : systemFirstNote.back(); }
+    [[nodiscard]] std::size_t measureCount() const noexcept {
+        return systemFirstMeasure.empty() ? 0 : systemFirstMeasure.back();
+    }
+    [[nodiscard]] std::size_t systemCount() const noexcept { return systems.size(); }
+    [[nodiscard]] std::size_t pageCount() const noexcept { return pageFirstSystem.empty() ? 0 : pageFirstSystem.size() - 1; }
+    // The system holding note `note` (< noteCount()).
+    [[nodiscard]] std::size_t systemOfNote(std::size_t note) const noexcept {
+        const auto next = std::upper_bound(systemFirstNote.begin(), systemFirstNote.end(), note);
+        return static_cast<std::size_t>(next - systemFirstNote.begin()) - 1;
+    }
+};
+
+// One immutable layout version for readers on other threads: the layout and
+// the document it was computed from. `version` equals layoutVersion() at the
+// time it was published.
+struct LayoutVersion {
+    std::uint64_t version {0};
+    DocumentSnapshot document;
+    PublishedLayout layout;
 };
 
 class NotationEngine {
 public:
-    void addNote(const NoteEvent& event);
-    void setDirty() noexcept { m_dirty = true; }
+    using EditListener = std::function<void(const EditRecord&)>;
+
+    // Collects notes and inserts them with a single addNotes() call on commit()
+    // or destruction, so a whole import marks the layout dirty once.
+    class BatchEdit {
+    public:
+        BatchEdit(NotationEngine& engine, std::size_t expectedNotes);
+        ~BatchEdit() { commit(); }
+        BatchEdit(const BatchEdit&) = delete;
+        BatchEdit& operator=(const BatchEdit&) = delete;
+
+        // False, skipping the note, for a negative tick.
+        bool add(const NoteEvent& event) {
+            if (event.tick < 0) {
+                return false;
+            }
+            m_pending.push_back(event);
+            return true;
+        }
+        void commit();
+
+    private:
+        NotationEngine& m_engine;
+        std::vector<NoteEvent> m_pending;
+    };
+
+    // Ticks start at 0: the calls that take a note or marking return false,
+    // changing nothing, when a tick is negative.
+    bool addNote(const NoteEvent& event);
+    // Bulk insert: reserves once, sorts the batch and merges it into tick order.
+    // Equal-tick notes keep the order repeated addNote() calls would give.
+    bool addNotes(std::span<const NoteEvent> events);
+    // Notes that belong to the document as it was opened, such as the rest of a
+    // file that is still loading. They are merged as addNotes() would, into the
+    // document and into every undo and redo state, so no undo takes them away;
+    // no edit is reported and no undo step is recorded. Costs a merge per
+    // distinct state.
+    bool addLoadedNotes(std::span<const NoteEvent> events);
+    // Both return false, changing nothing, when `index` is not a note.
+    bool removeNote(std::size_t index);
+    // Replaces the note at `index`; it keeps its place among equal-tick notes
+    // unless the tick changes.
+    bool modifyNote(std::size_t index, const NoteEvent& event);
+    bool addMarking(const Marking& marking);
+    // Applies `edit` to the notes in `ranges` (sorted, disjoint) as one undo step.
+    // Each transform is a flat loop over one field of a contiguous run of notes,
+    // and only the measures holding affected notes (before and after) are
+    // re-spaced. Shifts that reorder notes against unselected ones re-sort the
+    // storage and lay out in full. Returns false, changing nothing, for invalid
+    // ranges, a non-positive scale or a shift past the tick range.
+    bool applyBulkEdit(const BulkEdit& edit, std::span<const NoteRange> ranges);
+    // Walks the selection's runs in place; the runs are copied only for an edit
+    // listener, whose record holds them as a span.
+    bool applyBulkEdit(const BulkEdit& edit, const NoteSelection& selection);
+    [[nodiscard]] BatchEdit beginBatch(std::size_t expectedNotes = 0) { return BatchEdit(*this, expectedNotes); }
+    // Snapshots share structure with the live document and with each other; taking
+    // one costs O(log n) per edit since the previous one. restore() applies only
+    // the difference, so undoing a small edit keeps the incremental relayout path.
+    [[nodiscard]] DocumentSnapshot snapshot();
+    void restore(const DocumentSnapshot& target);
+    // Edits since the last commitUndoStep() form one undo step; undo() commits
+    // pending edits first.
+    void commitUndoStep();
+    // Makes the current document the oldest undo state, e.g. after loading a file.
+    void clearUndoHistory();
+    bool undo();
+    bool redo();
+    [[nodiscard]] bool canUndo() const noexcept { return m_uncommittedStamp != 0 || m_history.canUndo(); }
+    [[nodiscard]] bool canRedo() const noexcept { return m_uncommittedStamp == 0 && m_history.canRedo(); }
+    // When the step undo() or redo() would take was started, on a clock shared
+    // by every engine; 0 when there is none. Uncommitted edits are stamped by
+    // their first edit, so they need no commitUndoStep() to keep their order.
+    [[nodiscard]] std::uint64_t undoStamp() const noexcept {
+        return m_uncommittedStamp != 0 ? m_uncommittedStamp : m_history.undoStamp();
+    }
+    [[nodiscard]] std::uint64_t redoStamp() const noexcept {
+        return m_uncommittedStamp != 0 ? 0 : m_history.redoStamp();
+    }
+    // Every edit (including undo/redo) is reported to `listener` before it is
+    // applied. applyEdit() replays a reported edit exactly and does not report it.
+    void setEditListener(EditListener listener) { m_editListener = std::move(listener); }
+    void applyEdit(const EditRecord& record);
+    // Render, audio and UI threads read published versions instead of the live
+    // layout. Once enabled, every layout pass publishes a version that shares
+    // the systems it did not lay out with the one before; pinLayout() never
+    // blocks and the pinned version stays valid and unchanged until the pin is
+    // released.
+    using LayoutPin = notascore::core::EpochPublisher<LayoutVersion>::Pin;
+    void enableLayoutPublishing();
+    [[nodiscard]] LayoutPin pinLayout() const { return m_publisher ? m_publisher->pin() : LayoutPin {}; }
+    // Pages [firstPage, lastPage) are on screen. With LayoutOptions::lazyPages,
+    // note positions and collision items are laid out only for the systems of
+    // these pages and prefetchPages on either side; moving the viewport lays out
+    // what comes into range. In lowMemoryMode, systems that leave the range
+    // release their collision items.
+    void setViewport(std::size_t firstPage, std::size_t lastPage);
+    // Whether noteX and systemItems of `system` are current; always true unless
+    // pages are laid out lazily.
+    [[nodiscard]] bool isSystemLaidOut(std::size_t system) const noexcept {
+        return !m_options.lazyPages || (system < m_systemLaidOut.size() && m_systemLaidOut[system] != 0);
+    }
+    // Forces the next layout pass to lay out the whole score.
+    void setDirty() noexcept { m_layoutValid = false; }
     void recomputeLayoutIfNeeded();
 
+    void setLayoutOptions(const LayoutOptions& options);
+    // Layout passes fan out over `pool` when set; results are identical to the
+    // single-threaded run because every chunk writes a disjoint range.
+    void setThreadPool(notascore::core::ThreadPool* pool) noexcept { m_pool = pool; }
+    // Measure spacing is memoized in `cache` when set; the cache may be shared
+    // between engines and must outlive them.
+    void setMeasureCache(MeasureCache* cache) noexcept { m_measureCache = cache; }
+
+    [[nodiscard]] const LayoutOptions& layoutOptions() const noexcept { return m_options; }
+    [[nodiscard]] const LayoutResult& layout() const noexcept { return m_layout; }
+    [[nodiscard]] const LayoutPassStats& lastPassStats() const noexcept { return m_passStats; }
+
+    [[nodiscard]] bool isDirty() const noexcept { return !m_layoutValid || m_dirtyFirst < m_dirtyLast; }
     [[nodiscard]] std::uint64_t layoutVersion() const noexcept { return m_layoutVersion; }
     [[nodiscard]] std::size_t noteCount() const noexcept { return m_notes.size(); }
+    // Notes in tick order; layout note arrays are parallel to this span.
+    [[nodiscard]] std::span<const NoteEvent> notes() const noexcept { return m_notes; }
+    [[nodiscard]] std::span<const Marking> markings() const noexcept { return m_markings; }
+    // Bars of the document: meters, meter changes and pickup. The index is
+    // shared, not copied: every voice of a Score reads the score's, which
+    // Score::setMeter and Score::setPickup edit in place. Layout still spaces
+    // uniform measures of LayoutOptions::measureTicks.
+    [[nodiscard]] const MeasureIndex& measureIndex() const noexcept { return *m_measureIndex; }
+    void setMeasureIndex(std::shared_ptr<const MeasureIndex> index) noexcept { m_measureIndex = std::move(index); }
+    // Notes starting in `bar`, by binary search over the tick-sorted storage.
+    [[nodiscard]] NoteRange notesInBar(std::uint32_t bar) const noexcept;
+    // Appends indices (into notes()) of notes sounding anywhere in [t0, t1).
+    void notesOverlapping(std::int64_t t0, std::int64_t t1, std::vector<std::uint32_t>& out) const {
+        m_tickIndex.query(m_notes, t0, t1, out);
+    }
 
 private:
+    [[nodiscard]] std::size_t insertionIndex(int tick) const noexcept;
+    void insertNoteAt(std::size_t index, const NoteEvent& event);
+    void eraseNoteAt(std::size_t index);
+    void markEdited() noexcept;
+    void replaceNote(std::size_t index, const NoteEvent& event);
+    void mergeNotes(std::span<const NoteEvent> events);
+    // Ranges: a forward range of NoteRange, a span or a selection's runs().
+    template <typename Ranges>
+    bool applyBulkEditTo(const BulkEdit& edit, const Ranges& ranges);
+    template <typename Ranges>
+    void bulkEditNotes(const BulkEdit& edit, const Ranges& ranges);
+    template <typename Ranges>
+    void renumberShiftedNotes(const Ranges& ranges);
+    void insertMarkingAt(std::size_t index, const Marking& marking);
+    void eraseMarkingAt(std::size_t index);
+    void markMarkingDirty(const Marking& marking) noexcept;
+    void emit(const EditRecord& record) const {
+        if (m_editListener) {
+            m_editListener(record);
+        }
+    }
+    void markMeasuresDirty(std::size_t first, std::size_t last) noexcept;
+    void ensureMeasureCount(std::size_t count);
+    void shrinkMeasureCount();
+    void relayoutAll();
+    void publishLayout();
+    // Systems [first, last) were laid out again; their published blocks are rebuilt.
+    void unpublishSystems(std::size_t first, std::size_t last) noexcept;
+    void relayoutDirtyMeasures();
+    void spaceMeasureRange(std::size_t first, std::size_t last);
+    void justifySystemRange(std::size_t first, std::size_t last);
+    void layoutSystemRange(std::size_t first, std::size_t last);
+    // Lays out the systems of the viewport window that are not laid out yet (and
+    // evicts the rest in lowMemoryMode). Returns whether anything changed.
+    bool layoutViewport();
+    void stackPageRange(std::size_t first, std::size_t last);
+    void forRange(std::size_t first, std::size_t last, std::size_t grain,
+        const std::function<void(std::size_t, std::size_t)>& body) const;
+
     std::vector<NoteEvent> m_notes;
-    bool m_dirty {true};
+    std::vector<Marking> m_markings;
+    std::shared_ptr<const MeasureIndex> m_measureIndex {std::make_shared<const MeasureIndex>()};
     std::uint64_t m_layoutVersion {0};
+
+    SnapshotMirror<NoteEvent> m_noteMirror;
+    SnapshotMirror<Marking> m_markingMirror;
+    EditHistory m_history;
+    // Clock stamp of the first edit since the last undo step; 0 when there is none.
+    std::uint64_t m_uncommittedStamp {0};
+    EditListener m_editListener;
+
+    // Dirty tracking: measures [m_dirtyFirst, m_dirtyLast) need re-spacing. Edits
+    // beyond kMaxIncrementalEdits between passes fall back to a full pass.
+    static constexpr std::size_t kMaxIncrementalEdits = 256;
+    bool m_layoutValid {false};
+    std::size_t m_dirtyFirst {0};
+    std::size_t m_dirtyLast {0};
+    std::size_t m_pendingEdits {0};
+
+    LayoutOptions m_options;
+    TickIndex m_tickIndex {m_options.measureTicks};
+    LayoutResult m_layout;
+    MeasureSpacing m_spacing;
+    LineBreakState m_breakState;
+    LayoutPassStats m_passStats;
+    std::size_t m_viewportFirst {0};
+    std::size_t m_viewportLast {1};
+    // Per system, with lazy pages: noteX and systemItems are current.
+    std::vector<std::uint8_t> m_systemLaidOut;
+    notascore::core::ThreadPool* m_pool {nullptr};
+    MeasureCache* m_measureCache {nullptr};
+    std::unique_ptr<notascore::core::EpochPublisher<LayoutVersion>> m_publisher;
+    // Per system, while publishing: the block of the last publish, or null when
+    // the system changed since.
+    std::vector<std::shared_ptr<const PublishedSystem>> m_publishedSystems;
 };
 
 } // namespace notascore::notation
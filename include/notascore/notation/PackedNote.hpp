@@ -0,0 +1,88 @@
+#pragma once
+
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Time.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace notascore::notation {
+
+// 16-byte note record for storage and files. One 64-bit word holds a signed
+// 48-bit tick (over 2000 years of music at 960 PPQ and 120 BPM) plus pitch
+// and velocity. The rest is the duration, the voice within the staff and
+// per-note flags. Pitch and velocity are 7-bit MIDI values and are clamped when
+// packing.
+class PackedNote {
+public:
+    static constexpr Tick kMinTick = -(Tick {1} << 47);
+    static constexpr Tick kMaxTick = (Tick {1} << 47) - 1;
+
+    constexpr PackedNote() noexcept = default;
+    constexpr PackedNote(Tick tick, int duration, int pitch, int velocity, std::uint8_t voice = 0,
+        std::uint8_t flags = 0) noexcept
+        : m_duration(duration), m_voice(voice), m_flags(flags) {
+        setTick(tick);
+        setPitch(pitch);
+        setVelocity(velocity);
+    }
+
+    [[nodiscard]] static constexpr PackedNote pack(const NoteEvent& note, std::uint8_t voice = 0) noexcept {
+        return {note.tick, note.duration, note.midiPitch, note.velocity, voice};
+    }
+    // Nullopt when the tick does not fit a NoteEvent's 32 bits.
+    [[nodiscard]] constexpr std::optional<NoteEvent> unpack() const noexcept {
+        const Tick at = tick();
+        if (at < std::numeric_limits<int>::min() || at > std::numeric_limits<int>::max()) {
+            return std::nullopt;
+        }
+        return NoteEvent {.tick = static_cast<int>(at), .duration = m_duration, .midiPitch = pitch(), .velocity = velocity()};
+    }
+
+    [[nodiscard]] constexpr Tick tick() const noexcept {
+        // Sign-extends the low 48 bits.
+        return static_cast<Tick>(m_word << 16) >> 16;
+    }
+    [[nodiscard]] constexpr int duration() const noexcept { return m_duration; }
+    [[nodiscard]] constexpr int pitch() const noexcept { return static_cast<int>((m_word >> 48) & 0x7F); }
+    [[nodiscard]] constexpr int velocity() const noexcept { return static_cast<int>((m_word >> 56) & 0x7F); }
+    [[nodiscard]] constexpr std::uint8_t voice() const noexcept { return m_voice; }
+    [[nodiscard]] constexpr std::uint8_t flags() const noexcept { return m_flags; }
+    [[nodiscard]] constexpr Tick endTick() const noexcept { return tick() + m_duration; }
+
+    // Clamps to [kMinTick, kMaxTick].
+    constexpr void setTick(Tick tick) noexcept {
+        const auto bits = static_cast<std::uint64_t>(std::clamp(tick, kMinTick, kMaxTick)) & kTickMask;
+        m_word = (m_word & ~kTickMask) | bits;
+    }
+    constexpr void setDuration(int duration) noexcept { m_duration = duration; }
+    constexpr void setPitch(int pitch) noexcept { setByte(48, pitch); }
+    constexpr void setVelocity(int velocity) noexcept { setByte(56, velocity); }
+    constexpr void setVoice(std::uint8_t voice) noexcept { m_voice = voice; }
+    constexpr void setFlags(std::uint8_t flags) noexcept { m_flags = flags; }
+
+    bool operator==(const PackedNote&) const = default;
+
+private:
+    static constexpr std::uint64_t kTickMask = (std::uint64_t {1} << 48) - 1;
+
+    constexpr void setByte(int shift, int value) noexcept {
+        const auto bits = static_cast<std::uint64_t>(std::clamp(value, 0, 127)) << shift;
+        m_word = (m_word & ~(std::uint64_t {0xFF} << shift)) | bits;
+    }
+
+    // Bits 0-47 tick, 48-55 pitch, 56-63 velocity.
+    std::uint64_t m_word {0};
+    std::int32_t m_duration {0};
+    std::uint8_t m_voice {0};
+    std::uint8_t m_flags {0};
+    std::uint16_t m_reserved {0};
+};
+
+static_assert(sizeof(PackedNote) == 16);
+static_assert(std::is_trivially_copyable_v<PackedNote>);
+
+} // namespace notascore::notation
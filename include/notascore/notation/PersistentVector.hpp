@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace notascore::notation {
+
+// Immutable sequence stored as a chunked B-tree: leaves hold up to kLeafSize
+// values, inner nodes up to kBranching children with subtree sizes. Edits copy
+// only the path to the touched leaf (O(log n)) and share every other node with
+// the previous version, so keeping many versions alive costs little memory.
+// Versions are safe to read from any thread.
+template <typename T>
+class PersistentVector {
+public:
+    static constexpr std::size_t kLeafSize = 64;
+    static constexpr std::size_t kBranching = 32;
+
+    PersistentVector() = default;
+
+    // Bulk build with full leaves, O(n).
+    [[nodiscard]] static PersistentVector fromRange(std::span<const T> values) {
+        if (values.empty()) {
+            return {};
+        }
+        std::vector<NodePtr> level;
+        level.reserve((values.size() + kLeafSize - 1) / kLeafSize);
+        for (std::size_t i = 0; i < values.size(); i += kLeafSize) {
+            auto leaf = std::make_shared<Node>();
+            leaf->values.assign(values.begin() + static_cast<std::ptrdiff_t>(i),
+                values.begin() + static_cast<std::ptrdiff_t>(std::min(i + kLeafSize, values.size())));
+            leaf->size = leaf->values.size();
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            std::vector<NodePtr> parents;
+            parents.reserve((level.size() + kBranching - 1) / kBranching);
+            for (std::size_t i = 0; i < level.size(); i += kBranching) {
+                const auto end = level.begin() + static_cast<std::ptrdiff_t>(std::min(i + kBranching, level.size()));
+                parents.push_back(makeInner({level.begin() + static_cast<std::ptrdiff_t>(i), end}));
+            }
+            level = std::move(parents);
+        }
+        return PersistentVector(std::move(level.front()));
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_root ? m_root->size : 0; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] const T& operator[](std::size_t index) const {
+        const Node* node = m_root.get();
+        while (node->height > 0) {
+            for (const auto& child : node->children) {
+                if (index < child->size) {
+                    node = child.get();
+                    break;
+                }
+                index -= child->size;
+            }
+        }
+        return node->values[index];
+    }
+
+    [[nodiscard]] PersistentVector insert(std::size_t index, const T& value) const {
+        if (!m_root) {
+            auto leaf = std::make_shared<Node>();
+            leaf->values.push_back(value);
+            leaf->size = 1;
+            return PersistentVector(std::move(leaf));
+        }
+        auto [left, right] = insertInto(*m_root, index, value);
+        if (right) {
+            return PersistentVector(makeInner({std::move(left), std::move(right)}));
+        }
+        return PersistentVector(std::move(left));
+    }
+
+    [[nodiscard]] PersistentVector erase(std::size_t index) const {
+        NodePtr root = eraseFrom(*m_root, index);
+        // Collapse single-child roots so the height shrinks with the content.
+        while (root && root->height > 0 && root->children.size() == 1) {
+            root = root->children.front();
+        }
+        return PersistentVector(std::move(root));
+    }
+
+    // Appends values [first, last) to `out`, one leaf at a time.
+    void copyRange(std::size_t first, std::size_t last, std::vector<T>& out) const {
+        if (m_root && first < last) {
+            copyFrom(*m_root, first, last, out);
+        }
+    }
+
+    // Lengths of the longest common prefix and suffix of two versions, found by
+    // skipping shared subtrees. They may be underestimated when the two trees
+    // split differently around an edit, never overestimated.
+    [[nodiscard]] static std::size_t commonPrefix(const PersistentVector& a, const PersistentVector& b) {
+        return a.m_root && b.m_root ? prefixOf<false>(a.m_root.get(), b.m_root.get()) : 0;
+    }
+    [[nodiscard]] static std::size_t commonSuffix(const PersistentVector& a, const PersistentVector& b) {
+        return a.m_root && b.m_root ? prefixOf<true>(a.m_root.get(), b.m_root.get()) : 0;
+    }
+
+private:
+    struct Node {
+        std::size_t size {0};
+        std::uint32_t height {0};
+        std::vector<T> values;
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+    using NodePtr = std::shared_ptr<const Node>;
+
+    explicit PersistentVector(NodePtr root) : m_root(std::move(root)) {}
+
+    static NodePtr makeInner(std::vector<NodePtr> children) {
+        auto node = std::make_shared<Node>();
+        node->height = children.front()->height + 1;
+        for (const auto& child : children) {
+            node->size += child->size;
+        }
+        node->children = std::move(children);
+        return node;
+    }
+
+    // Index of the child holding position `index`, which becomes relative to it.
+    // A position one past the end belongs to the last child.
+    static std::size_t childAt(const Node& node, std::size_t& index) noexcept {
+        std::size_t child = 0;
+        while (child + 1 < node.children.size() && index >= node.children[child]->size) {
+            index -= node.children[child]->size;
+            ++child;
+        }
+        return child;
+    }
+
+    // Returns the copied node and, when it overflowed, its new right sibling.
+    static std::pair<NodePtr, NodePtr> insertInto(const Node& node, std::size_t index, const T& value) {
+        if (node.height == 0) {
+            auto copy = std::make_shared<Node>(node);
+            copy->values.insert(copy->values.begin() + static_cast<std::ptrdiff_t>(index), value);
+            copy->size = copy->values.size();
+            if (copy->size <= kLeafSize) {
+                return {std::move(copy), nullptr};
+            }
+            auto sibling = std::make_shared<Node>();
+            const auto half = copy->values.begin() + static_cast<std::ptrdiff_t>(copy->size / 2);
+            sibling->values.assign(half, copy->values.end());
+            sibling->size = sibling->values.size();
+            copy->values.erase(half, copy->values.end());
+            copy->size = copy->values.size();
+            return {std::move(copy), std::move(sibling)};
+        }
+
+        const std::size_t child = childAt(node, index);
+        auto [left, right] = insertInto(*node.children[child], index, value);
+        auto children = node.children;
+        children[child] = std::move(left);
+        if (right) {
+            children.insert(children.begin() + static_cast<std::ptrdiff_t>(child) + 1, std::move(right));
+        }
+        if (children.size() <= kBranching) {
+            return {makeInner(std::move(children)), nullptr};
+        }
+        const auto half = children.begin() + static_cast<std::ptrdiff_t>(children.size() / 2);
+        std::vector<NodePtr> upper(std::make_move_iterator(half), std::make_move_iterator(children.end()));
+        children.erase(half, children.end());
+        return {makeInner(std::move(children)), makeInner(std::move(upper))};
+    }
+
+    // Returns the copied node, or null when it became empty. Underfull nodes are
+    // kept; the height never exceeds what the largest version needed.
+    static NodePtr eraseFrom(const Node& node, std::size_t index) {
+        if (node.height == 0) {
+            if (node.size == 1) {
+                return nullptr;
+            }
+            auto copy = std::make_shared<Node>(node);
+            copy->values.erase(copy->values.begin() + static_cast<std::ptrdiff_t>(index));
+            copy->size = copy->values.size();
+            return copy;
+        }
+
+        const std::size_t child = childAt(node, index);
+        NodePtr replaced = eraseFrom(*node.children[child], index);
+        auto children = node.children;
+        if (replaced) {
+            children[child] = std::move(replaced);
+        } else {
+            children.erase(children.begin() + static_cast<std::ptrdiff_t>(child));
+        }
+        return children.empty() ? nullptr : makeInner(std::move(children));
+    }
+
+    static void copyFrom(const Node& node, std::size_t first, std::size_t last, std::vector<T>& out) {
+        if (node.height == 0) {
+            out.insert(out.end(), node.values.begin() + static_cast<std::ptrdiff_t>(first),
+                node.values.begin() + static_cast<std::ptrdiff_t>(std::min(last, node.size)));
+            return;
+        }
+        std::size_t offset = 0;
+        for (const auto& child : node.children) {
+            const std::size_t childEnd = offset + child->size;
+            if (childEnd > first && offset < last) {
+                copyFrom(*child, first > offset ? first - offset : 0, last - offset, out);
+            }
+            if (childEnd >= last) {
+                break;
+            }
+            offset = childEnd;
+        }
+    }
+
+    template <bool FromBack>
+    static std::size_t prefixOf(const Node* a, const Node* b) {
+        if (a == b) {
+            return a->size;
+        }
+        // Align heights by descending the taller tree along its outer edge.
+        while (a->height > b->height) {
+            a = FromBack ? a->children.back().get() : a->children.front().get();
+        }
+        while (b->height > a->height) {
+            b = FromBack ? b->children.back().get() : b->children.front().get();
+        }
+        if (a == b) {
+            return a->size;
+        }
+
+        const auto at = [](const auto& items, std::size_t i) -> decltype(auto) {
+            return FromBack ? items[items.size() - 1 - i] : items[i];
+        };
+        std::size_t matched = 0;
+        if (a->height == 0) {
+            const std::size_t count = std::min(a->size, b->size);
+            while (matched < count && at(a->values, matched) == at(b->values, matched)) {
+                ++matched;
+            }
+            return matched;
+        }
+        const std::size_t count = std::min(a->children.size(), b->children.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            const Node* childA = at(a->children, i).get();
+            const Node* childB = at(b->children, i).get();
+            if (childA != childB) {
+                return matched + prefixOf<FromBack>(childA, childB);
+            }
+            matched += childA->size;
+        }
+        return matched;
+    }
+
+    NodePtr m_root;
+};
+
+// Keeps a PersistentVector in step with a flat vector without paying for path
+// copies on every edit: edits are logged and replayed when a version is asked
+// for, or the version is rebuilt from the flat data when that is cheaper.
+template <typename T>
+class SnapshotMirror {
+public:
+    void insert(std::size_t index, const T& value) { log({.index = index, .erase = false, .value = value}); }
+    void erase(std::size_t index) { log({.index = index, .erase = true, .value = {}}); }
+    // The flat data changed wholesale (bulk import); rebuild on the next request.
+    void invalidate() noexcept {
+        m_stale = true;
+        m_log.clear();
+    }
+    // The flat data now matches `version` exactly.
+    void reset(PersistentVector<T> version) {
+        m_version = std::move(version);
+        m_stale = false;
+        m_log.clear();
+    }
+
+    [[nodiscard]] const PersistentVector<T>& version(std::span<const T> current) {
+        if (m_stale) {
+            m_version = PersistentVector<T>::fromRange(current);
+            m_stale = false;
+        }
+        for (const auto& edit : m_log) {
+            m_version = edit.erase ? m_version.erase(edit.index) : m_version.insert(edit.index, edit.value);
+        }
+        m_log.clear();
+        return m_version;
+    }
+
+private:
+    struct Edit {
+        std::size_t index {0};
+        bool erase {false};
+        T value {};
+    };
+
+    void log(const Edit& edit) {
+        if (m_stale) {
+            return;
+        }
+        // Past this many edits a bulk rebuild beats replaying path copies.
+        if (m_log.size() >= m_version.size() / 16 + 64) {
+            invalidate();
+            return;
+        }
+        m_log.push_back(edit);
+    }
+
+    PersistentVector<T> m_version;
+    std::vector<Edit> m_log;
+    bool m_stale {false};
+};
+
+} // namespace notascore::notation
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Time.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace notascore::core {
+class ThreadPool;
+}
+
+namespace notascore::notation {
+
+// One note of an imported performance (e.g. a MIDI track), in source ticks.
+struct PerformanceNote {
+    Tick onset {0};
+    Tick duration {0};
+    int midiPitch {60};
+    int velocity {80};
+};
+
+// `actual` notes in the time of `normal` over one beat starting at `tick`.
+struct Tuplet {
+    Tick tick {0};
+    Tick duration {0};
+    int actual {3};
+    int normal {2};
+
+    bool operator==(const Tuplet&) const = default;
+};
+
+struct QuantizeOptions {
+    int sourceTicksPerQuarter {480};
+    int ticksPerQuarter {480};
+    // Plain grid, in divisions of a quarter (4 = sixteenths).
+    int division {4};
+    // Tuplet grids tried per beat, in divisions of a quarter (3 = eighth-note
+    // triplets). Grids that are not whole ticks at ticksPerQuarter are skipped.
+    std::array<int, 3> tupletDivisions {3, 6, 5};
+    bool detectTuplets {true};
+    // A tuplet grid must beat the plain grid by this many ticks of total onset
+    // error per note in the beat, so slightly loose straight playing stays straight.
+    int tupletPenalty {8};
+};
+
+struct QuantizedTrack {
+    std::vector<NoteEvent> notes;
+    std::vector<Tuplet> tuplets;
+};
+
+// Snaps performance onsets and ends to a grid, beat by beat. Each beat uses the
+// plain grid or the tuplet grid that fits its onsets best; tuplet beats are
+// reported in `tuplets`. Notes keep at least one grid step of duration. Input
+// need not be sorted; output notes are in tick order. The per-note passes are
+// flat loops over structure-of-arrays data that the compiler vectorizes.
+//
+// Returns false (leaving `out` empty) when the options are invalid or a
+// quantized tick does not fit a NoteEvent.
+bool quantize(std::span<const PerformanceNote> performance, const QuantizeOptions& options, QuantizedTrack& out);
+
+// Quantizes each part independently, in parallel on `pool` when given. `out`
+// is resized to the part count. Returns false if any part failed.
+bool quantizeParts(std::span<const std::span<const PerformanceNote>> parts, const QuantizeOptions& options,
+    std::vector<QuantizedTrack>& out, core::ThreadPool* pool = nullptr);
+
+} // namespace notascore::notation
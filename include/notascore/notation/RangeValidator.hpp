@@ -0,0 +1,119 @@
+#pragma once
+
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Selection.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace notascore::notation {
+
+// Playable MIDI pitches [low, high], both inclusive.
+struct PitchRange {
+    int low {0};
+    int high {127};
+
+    [[nodiscard]] constexpr bool contains(int pitch) const noexcept { return low <= pitch && pitch <= high; }
+    bool operator==(const PitchRange&) const = default;
+};
+
+namespace detail {
+
+// MIDI pitch of a name such as "C4", "Bb3" or "F#3" (C4 = 60), consumed from
+// the front of `text`.
+[[nodiscard]] constexpr std::optional<int> parsePitchName(std::string_view& text) noexcept {
+    constexpr int kSteps[] {9, 11, 0, 2, 4, 5, 7}; // A B C D E F G
+    if (text.empty() || text[0] < 'A' || text[0] > 'G') {
+        return std::nullopt;
+    }
+    int pitch = kSteps[text[0] - 'A'];
+    text.remove_prefix(1);
+    for (; !text.empty() && (text[0] == '#' || text[0] == 'b'); text.remove_prefix(1)) {
+        pitch += text[0] == '#' ? 1 : -1;
+    }
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+        return std::nullopt;
+    }
+    int octave = 0;
+    for (; !text.empty() && text[0] >= '0' && text[0] <= '9'; text.remove_prefix(1)) {
+        octave = octave * 10 + (text[0] - '0');
+        if (octave > 9) {
+            return std::nullopt;
+        }
+    }
+    pitch += (octave + 1) * 12;
+    return pitch >= 0 && pitch <= 127 ? std::optional<int>(pitch) : std::nullopt;
+}
+
+} // namespace detail
+
+// Parses an instrument library range such as "C4-C7" or "Bb3 - A6". Unpitched
+// ranges ("Perc") and malformed or inverted ones give nullopt.
+[[nodiscard]] constexpr std::optional<PitchRange> parsePitchRange(std::string_view text) noexcept {
+    const auto skipSpaces = [&] {
+        while (!text.empty() && text[0] == ' ') {
+            text.remove_prefix(1);
+        }
+    };
+    skipSpaces();
+    const auto low = detail::parsePitchName(text);
+    skipSpaces();
+    if (!low || text.empty() || text[0] != '-') {
+        return std::nullopt;
+    }
+    text.remove_prefix(1);
+    skipSpaces();
+    const auto high = detail::parsePitchName(text);
+    skipSpaces();
+    if (!high || !text.empty() || *high < *low) {
+        return std::nullopt;
+    }
+    return PitchRange {.low = *low, .high = *high};
+}
+
+// Flags notes outside an instrument's range, per measure, kept in step with one
+// voice's layout. After a layout pass only the measures it re-spaced are checked
+// again. Checks take the min and max pitch of long runs of notes first (flat
+// loops the compiler vectorizes); only runs that leave the range are counted
+// measure by measure.
+class RangeValidator {
+public:
+    explicit RangeValidator(PitchRange range) noexcept : m_range(range) {}
+
+    [[nodiscard]] PitchRange range() const noexcept { return m_range; }
+
+    // Brings the flags up to date with `engine`'s last layout pass. Does nothing
+    // while the engine is dirty; a pass missed in between forces a full check.
+    void update(const NotationEngine& engine);
+    // Checks every measure again.
+    void invalidate() noexcept { m_valid = false; }
+
+    [[nodiscard]] std::uint64_t outOfRangeCount() const noexcept { return m_total; }
+    [[nodiscard]] std::uint32_t outOfRangeCount(std::size_t measure) const noexcept {
+        return measure < m_measureCounts.size() ? m_measureCounts[measure] : 0;
+    }
+    // Measures checked by the last update().
+    [[nodiscard]] std::size_t lastMeasuresChecked() const noexcept { return m_lastChecked; }
+
+    // Adds the out-of-range notes of measures [firstMeasure, lastMeasure) to `out`.
+    void outOfRangeNotes(const NotationEngine& engine, std::size_t firstMeasure, std::size_t lastMeasure,
+        NoteSelection& out) const;
+    // Highlight overlays for the out-of-range notes on pages [firstPage, lastPage).
+    void highlights(const NotationEngine& engine, std::size_t firstPage, std::size_t lastPage,
+        std::vector<SelectionHighlight>& out) const;
+
+private:
+    void checkMeasures(std::span<const NoteEvent> notes, const LayoutResult& layout, std::size_t first, std::size_t last);
+
+    PitchRange m_range;
+    bool m_valid {false};
+    std::uint64_t m_version {0};
+    std::vector<std::uint32_t> m_measureCounts;
+    std::uint64_t m_total {0};
+    std::size_t m_lastChecked {0};
+};
+
+} // namespace notascore::notation
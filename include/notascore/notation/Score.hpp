@@ -0,0 +1,174 @@
+#pragma once
+
+#include "notascore/core/SymbolTable.hpp"
+#include "notascore/notation/MeasureCache.hpp"
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/PackedNote.hpp"
+#include "notascore/notation/RangeValidator.hpp"
+#include "notascore/notation/TempoMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace notascore::core {
+class ThreadPool;
+}
+
+namespace notascore::notation {
+
+// One instrument of the score: its staves and, per staff, its voices. Every voice
+// is a NotationEngine with its own contiguous tick-ordered storage, undo history
+// and layout, so a part can be edited, laid out, unloaded and reloaded without
+// touching the other parts.
+class Part {
+public:
+    Part(core::Symbol name, core::Symbol range, std::size_t staffCount, const LayoutOptions& options);
+
+    // Interned; core::text() gives the strings.
+    [[nodiscard]] core::Symbol name() const noexcept { return m_name; }
+    // Written range as shown in the instrument library, e.g. "C4-C7".
+    [[nodiscard]] core::Symbol range() const noexcept { return m_range; }
+    // range() as MIDI pitches, parsed once; nullopt for unpitched instruments.
+    [[nodiscard]] const std::optional<PitchRange>& pitchRange() const noexcept { return m_pitchRange; }
+    [[nodiscard]] std::size_t staffCount() const noexcept { return m_staves.size(); }
+    [[nodiscard]] std::size_t voiceCount(std::size_t staff) const noexcept;
+    // Adds a voice to `staff` and returns its index.
+    std::size_t addVoice(std::size_t staff);
+
+    // Null when the part is unloaded or the staff/voice does not exist.
+    [[nodiscard]] NotationEngine* voice(std::size_t staff, std::size_t voice) noexcept;
+    [[nodiscard]] const NotationEngine* voice(std::size_t staff, std::size_t voice) const noexcept;
+    [[nodiscard]] std::size_t noteCount() const noexcept;
+    // Out-of-range flags of a voice, refreshed by recomputeLayoutIfNeeded(). Null
+    // when the voice does not exist, the part is unloaded or it is unpitched.
+    [[nodiscard]] const RangeValidator* rangeValidator(std::size_t staff, std::size_t voice) const noexcept;
+    // Out-of-range notes in every loaded voice.
+    [[nodiscard]] std::uint64_t outOfRangeCount() const noexcept;
+
+    // Unloading keeps only the notes and markings of every voice, packed, and frees
+    // layout, indices and undo history; load() rebuilds the voices from them.
+    [[nodiscard]] bool isLoaded() const noexcept { return m_loaded; }
+    void unload();
+    void load();
+    // What an unloaded voice keeps; empty while the part is loaded.
+    [[nodiscard]] std::span<const PackedNote> unloadedNotes(std::size_t staff, std::size_t voice) const noexcept;
+    [[nodiscard]] std::span<const Marking> unloadedMarkings(std::size_t staff, std::size_t voice) const noexcept;
+    // NotationEngine::addLoadedNotes() on a loaded voice; an unloaded one merges
+    // `events` into what it keeps. False when the voice does not exist or a tick
+    // is negative.
+    bool addLoadedNotes(std::size_t staff, std::size_t voice, std::span<const NoteEvent> events);
+
+    void setLayoutOptions(const LayoutOptions& options);
+    // Shared with every voice; Score passes its own.
+    void setMeasureIndex(std::shared_ptr<const MeasureIndex> index);
+    void setThreadPool(notascore::core::ThreadPool* pool) noexcept;
+    void setMeasureCache(MeasureCache* cache) noexcept;
+    void recomputeLayoutIfNeeded();
+    [[nodiscard]] bool isDirty() const noexcept;
+
+private:
+    // Notes and markings of one voice while the part is unloaded.
+    struct PackedVoice {
+        std::vector<PackedNote> notes;
+        std::vector<Marking> markings;
+    };
+
+    struct Staff {
+        std::vector<std::unique_ptr<NotationEngine>> voices;
+        // Parallel to `voices` for pitched parts.
+        std::vector<RangeValidator> validators;
+        std::vector<PackedVoice> packed;
+    };
+
+    [[nodiscard]] std::unique_ptr<NotationEngine> makeVoice() const;
+
+    core::Symbol m_name;
+    core::Symbol m_range;
+    std::optional<PitchRange> m_pitchRange;
+    std::vector<Staff> m_staves;
+    LayoutOptions m_options;
+    std::shared_ptr<const MeasureIndex> m_measureIndex {std::make_shared<const MeasureIndex>()};
+    notascore::core::ThreadPool* m_pool {nullptr};
+    MeasureCache* m_measureCache {nullptr};
+    bool m_loaded {true};
+};
+
+// Parts in score order. Parts are held by pointer, so references returned by
+// addPart() and part() stay valid while other parts are added or removed.
+class Score {
+public:
+    Part& addPart(core::Symbol name, core::Symbol range, std::size_t staffCount = 1);
+    // Interns `name` and `range` first.
+    Part& addPart(std::string_view name, std::string_view range, std::size_t staffCount = 1);
+    void removePart(std::size_t index);
+    void clear();
+
+    [[nodiscard]] std::size_t partCount() const noexcept { return m_parts.size(); }
+    [[nodiscard]] Part& part(std::size_t index) noexcept { return *m_parts[index]; }
+    [[nodiscard]] const Part& part(std::size_t index) const noexcept { return *m_parts[index]; }
+    // Identifies a part for as long as it is in the score; ids are never reused,
+    // so one kept across removals cannot name a different part.
+    [[nodiscard]] std::uint64_t partId(std::size_t index) const noexcept { return m_partIds[index]; }
+    // Null once the part was removed or the score cleared.
+    [[nodiscard]] Part* findPart(std::uint64_t id) noexcept;
+    // Notes of every loaded part.
+    [[nodiscard]] std::size_t noteCount() const noexcept;
+
+    void setLayoutOptions(const LayoutOptions& options);
+    [[nodiscard]] const LayoutOptions& layoutOptions() const noexcept { return m_options; }
+    // Bars of the score. There is one index, which every voice of every part
+    // reads through a pointer, so these edit it once and in place (see
+    // MeasureIndex for what each returns).
+    void setMeasureIndex(const MeasureIndex& index) { *m_measureIndex = index; }
+    bool setMeter(std::uint32_t bar, Meter meter) { return m_measureIndex->setMeter(bar, meter); }
+    bool removeMeter(std::uint32_t bar) { return m_measureIndex->removeMeter(bar); }
+    bool setPickup(Tick ticks) { return m_measureIndex->setPickup(ticks); }
+    [[nodiscard]] const MeasureIndex& measureIndex() const noexcept { return *m_measureIndex; }
+    // Per-part work fans out over `pool` when set, one part per task.
+    void setThreadPool(notascore::core::ThreadPool* pool) noexcept;
+    // Spacing memoized across all parts; identical bars in different parts hit
+    // the same entries. Smaller in low-memory mode.
+    [[nodiscard]] MeasureCache& measureCache() noexcept { return m_measureCache; }
+    // Shared by every part; playback and export convert ticks through it.
+    [[nodiscard]] TempoMap& tempoMap() noexcept { return m_tempoMap; }
+    [[nodiscard]] const TempoMap& tempoMap() const noexcept { return m_tempoMap; }
+
+    // Score-wide undo. Every voice keeps its own history; undo() steps back the
+    // voice whose last step is the newest, and redo() steps forward the voice
+    // whose undone step is the oldest, so edits made in different parts undo
+    // and redo in the order they were made. A voice's uncommitted edits are one
+    // step, ordered by the first of them, so callers need not commit after
+    // every edit. A new edit drops the redo steps of its own voice only.
+    // Unloaded parts are skipped.
+    bool undo();
+    bool redo();
+    [[nodiscard]] bool canUndo() const noexcept { return historyVoice(false) != nullptr; }
+    [[nodiscard]] bool canRedo() const noexcept { return historyVoice(true) != nullptr; }
+
+    // Runs `body` on every loaded part; parts are independent, so this is
+    // parallel when a pool is set.
+    void forEachPart(const std::function<void(Part&)>& body);
+    void recomputeLayoutIfNeeded();
+
+private:
+    // The voice undo() (or redo()) would step; null when there is none.
+    [[nodiscard]] NotationEngine* historyVoice(bool redo) const noexcept;
+
+    MeasureCache m_measureCache;
+    TempoMap m_tempoMap;
+    std::vector<std::unique_ptr<Part>> m_parts;
+    // Parallel to m_parts.
+    std::vector<std::uint64_t> m_partIds;
+    std::uint64_t m_nextPartId {1};
+    LayoutOptions m_options;
+    std::shared_ptr<MeasureIndex> m_measureIndex {std::make_shared<MeasureIndex>()};
+    notascore::core::ThreadPool* m_pool {nullptr};
+};
+
+} // namespace notascore::notation
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "notascore/notation/Collision.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+namespace notascore::notation {
+
+struct LayoutResult;
+
+// Notes [first, last) of the tick-sorted storage.
+struct NoteRange {
+    std::uint32_t first {0};
+    std::uint32_t last {0};
+
+    bool operator==(const NoteRange&) const = default;
+};
+
+// Set of note indices stored as compressed bitsets (roaring-style). Indices are
+// split into chunks of 2^16; each chunk is a sorted array of offsets (sparse),
+// an 8 KiB bitmap (dense) or a list of runs (contiguous), whichever is
+// smallest. Select-all on a million-note score is 16 runs, and a filter that
+// matches every other note is a bitmap per chunk; nothing is stored per note.
+// Union and intersection work chunk by chunk, on whole words for bitmaps;
+// iteration yields maximal runs, so bulk edits and rendering handle a
+// contiguous span at a time.
+class NoteSelection {
+public:
+    static constexpr std::uint32_t kEnd = std::numeric_limits<std::uint32_t>::max();
+
+    void add(std::uint32_t index);
+    // Adds [first, last).
+    void addRange(std::uint32_t first, std::uint32_t last);
+    void remove(std::uint32_t index);
+    void clear() noexcept { m_chunks.clear(); }
+
+    [[nodiscard]] bool contains(std::uint32_t index) const noexcept;
+    [[nodiscard]] std::uint64_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept { return m_chunks.empty(); }
+    [[nodiscard]] std::size_t memoryBytes() const noexcept;
+
+    NoteSelection& operator|=(const NoteSelection& other);
+    NoteSelection& operator&=(const NoteSelection& other);
+    [[nodiscard]] friend NoteSelection operator|(NoteSelection a, const NoteSelection& b) { return a |= b; }
+    [[nodiscard]] friend NoteSelection operator&(NoteSelection a, const NoteSelection& b) { return a &= b; }
+    [[nodiscard]] bool operator==(const NoteSelection& other) const;
+
+    // Calls body(first, last) for every maximal run of selected indices, in
+    // order, clipped to [from, to). Chunks outside the window are skipped.
+    template <typename Body>
+    void forEachRange(Body&& body, std::uint32_t from = 0, std::uint32_t to = kEnd) const;
+    // Calls body(index) for every selected index, in order.
+    template <typename Body>
+    void forEachIndex(Body&& body) const {
+        forEachRange([&](std::uint32_t first, std::uint32_t last) {
+            for (std::uint32_t i = first; i < last; ++i) {
+                body(i);
+            }
+        });
+    }
+    [[nodiscard]] std::vector<NoteRange> ranges() const;
+
+private:
+    static constexpr std::uint32_t kChunkBits = 16;
+    static constexpr std::uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr std::size_t kBitmapWords = kChunkSize / 64;
+    // Past this many offsets an array is larger than a bitmap.
+    static constexpr std::size_t kMaxArray = 4096;
+
+    enum class Kind : std::uint8_t {
+        Array,
+        Bitmap,
+        Runs
+    };
+
+    struct Chunk {
+        std::uint32_t key {0};
+        Kind kind {Kind::Array};
+        std::uint32_t count {0};
+        // Array: sorted offsets. Runs: (first, last) offset pairs, inclusive.
+        std::vector<std::uint16_t> values {};
+        // Bitmap: kBitmapWords words.
+        std::vector<std::uint64_t> words {};
+    };
+
+    // First bit at or after `bit` that is set (or clear), or kChunkSize. Whole
+    // words are skipped at a time.
+    [[nodiscard]] static std::uint32_t nextBit(const std::vector<std::uint64_t>& words, std::uint32_t bit, bool set) noexcept {
+        std::size_t w = bit / 64;
+        std::uint64_t word = (set ? words[w] : ~words[w]) & (~std::uint64_t {0} << (bit % 64));
+        while (word == 0) {
+            if (++w == kBitmapWords) {
+                return kChunkSize;
+            }
+            word = set ? words[w] : ~words[w];
+        }
+        return static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+    }
+
+    [[nodiscard]] const Chunk* find(std::uint32_t key) const noexcept;
+    Chunk& findOrInsert(std::uint32_t key);
+    void eraseEmpty();
+
+    static void toBitmap(Chunk& chunk);
+    // Converts a bitmap chunk to whichever representation is smallest.
+    static void compact(Chunk& chunk);
+    static void unite(Chunk& chunk, const Chunk& other);
+    static void intersect(Chunk& chunk, const Chunk& other);
+
+    // Sorted by key; never holds an empty chunk.
+    std::vector<Chunk> m_chunks;
+
+public:
+    // Forward iterator over the runs of a selection. Runs that continue into the
+    // next chunk are joined, so each one is read ahead before the current is done.
+    class RangeIterator {
+    public:
+        using value_type = NoteRange;
+        using difference_type = std::ptrdiff_t;
+        using reference = const NoteRange&;
+        using pointer = const NoteRange*;
+        using iterator_category = std::forward_iterator_tag;
+
+        RangeIterator() = default;
+
+        [[nodiscard]] const NoteRange& operator*() const noexcept { return m_range; }
+        [[nodiscard]] const NoteRange* operator->() const noexcept { return &m_range; }
+        RangeIterator& operator++() noexcept {
+            m_range = m_next;
+            if (m_range.first == m_range.last) {
+                return *this;
+            }
+            readNext();
+            while (m_next.last > m_next.first && m_next.first == m_range.last) {
+                m_range.last = m_next.last;
+                readNext();
+            }
+            return *this;
+        }
+        RangeIterator operator++(int) noexcept {
+            RangeIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        // Runs are disjoint and never empty, so the run alone tells positions apart;
+        // the end is the empty run.
+        [[nodiscard]] bool operator==(const RangeIterator& other) const noexcept { return m_range == other.m_range; }
+
+    private:
+        friend class NoteSelection;
+
+        explicit RangeIterator(const std::vector<Chunk>& chunks) noexcept : m_chunks(&chunks) {
+            readNext();
+            ++*this;
+        }
+        // The next run of a single chunk, or an empty one past the last chunk.
+        void readNext() noexcept;
+
+        const std::vector<Chunk>* m_chunks {nullptr};
+        std::size_t m_chunk {0};
+        // Array: next offset. Runs: next pair. Bitmap: next bit.
+        std::uint32_t m_position {0};
+        NoteRange m_range {};
+        NoteRange m_next {};
+    };
+
+    // The maximal runs of selected indices, in order, read from the chunks in
+    // place: the same runs as forEachRange(), for callers that need an iterator.
+    // A std::ranges::subrange of RangeIterator, defined once the class is complete.
+    [[nodiscard]] auto runs() const noexcept;
+};
+
+inline auto NoteSelection::runs() const noexcept {
+    return std::ranges::subrange(RangeIterator(m_chunks), RangeIterator());
+}
+
+template <typename Body>
+void NoteSelection::forEachRange(Body&& body, std::uint32_t from, std::uint32_t to) const {
+    // Runs that continue into the next chunk are joined before being reported.
+    std::uint64_t pendingFirst = 0;
+    std::uint64_t pendingLast = 0;
+    const auto emit = [&](std::uint64_t first, std::uint64_t last) {
+        first = std::max<std::uint64_t>(first, from);
+        last = std::min<std::uint64_t>(last, to);
+        if (first >= last) {
+            return;
+        }
+        if (pendingLast == first && pendingLast > pendingFirst) {
+            pendingLast = last;
+            return;
+        }
+        if (pendingLast > pendingFirst) {
+            body(static_cast<std::uint32_t>(pendingFirst), static_cast<std::uint32_t>(pendingLast));
+        }
+        pendingFirst = first;
+        pendingLast = last;
+    };
+    for (const auto& chunk : m_chunks) {
+        const std::uint64_t base = static_cast<std::uint64_t>(chunk.key) << kChunkBits;
+        if (base + kChunkSize <= from) {
+            continue;
+        }
+        if (base >= to) {
+            break;
+        }
+        switch (chunk.kind) {
+        case Kind::Array:
+            for (std::size_t i = 0; i < chunk.values.size();) {
+                std::size_t j = i + 1;
+                while (j < chunk.values.size() && chunk.values[j] == chunk.values[j - 1] + 1) {
+                    ++j;
+                }
+                emit(base + chunk.values[i], base + chunk.values[j - 1] + 1);
+                i = j;
+            }
+            break;
+        case Kind::Runs:
+            for (std::size_t i = 0; i < chunk.values.size(); i += 2) {
+                emit(base + chunk.values[i], base + chunk.values[i + 1] + 1);
+            }
+            break;
+        case Kind::Bitmap:
+            for (std::uint32_t bit = nextBit(chunk.words, 0, true); bit < kChunkSize;) {
+                const std::uint32_t stop = nextBit(chunk.words, bit, false);
+                emit(base + bit, base + stop);
+                bit = stop < kChunkSize ? nextBit(chunk.words, stop, true) : kChunkSize;
+            }
+            break;
+        }
+    }
+    if (pendingLast > pendingFirst) {
+        body(static_cast<std::uint32_t>(pendingFirst), static_cast<std::uint32_t>(pendingLast));
+    }
+}
+
+// Highlight of a run of selected notes within one system, in page coordinates
+// (staff spaces, y down).
+struct SelectionHighlight {
+    std::uint32_t page {0};
+    Box box {};
+};
+
+// Appends one highlight per run of selected notes per system on pages
+// [firstPage, lastPage). Only the selection's runs within those pages are
+// visited, so drawing the visible pages of a huge selection costs no more than
+// drawing those pages.
+void selectionHighlights(const NoteSelection& selection, const LayoutResult& layout, std::size_t firstPage,
+    std::size_t lastPage, std::vector<SelectionHighlight>& out);
+
+} // namespace notascore::notation
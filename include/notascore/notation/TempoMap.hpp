@@ -0,0 +1,70 @@
+#pragma once
+
+#include "notascore/notation/Time.hpp"
+
+#include <span>
+#include <vector>
+
+namespace notascore::notation {
+
+// Tempo from `tick` on, in quarter notes per minute. A ramp changes the tempo
+// linearly in ticks until the next change, ending at that change's tempo.
+struct TempoChange {
+    Tick tick {0};
+    double bpm {120.0};
+    bool rampToNext {false};
+
+    bool operator==(const TempoChange&) const = default;
+};
+
+// Tick <-> seconds conversion under tempo changes and ramps. Every segment
+// stores the time at which it starts (a prefix sum rebuilt on each change), so a
+// conversion is a binary search plus a closed form within one segment: linear
+// for a constant tempo, logarithmic (and exponential for the inverse) for a ramp.
+// Batch conversions of sorted input step through segments instead of searching.
+class TempoMap {
+public:
+    explicit TempoMap(int ticksPerQuarter = 480, double bpm = 120.0);
+
+    // Adds or replaces the change at `tick`. Returns false, changing nothing, for a
+    // negative tick or a tempo that is not positive and finite.
+    bool setTempo(Tick tick, double bpm, bool rampToNext = false);
+    // Removes the change at `tick` (the one at tick 0 cannot be removed).
+    bool removeTempo(Tick tick);
+
+    [[nodiscard]] int ticksPerQuarter() const noexcept { return m_ticksPerQuarter; }
+    [[nodiscard]] std::span<const TempoChange> changes() const noexcept { return m_changes; }
+    [[nodiscard]] double bpmAt(double tick) const noexcept;
+
+    [[nodiscard]] double secondsAt(double tick) const noexcept;
+    [[nodiscard]] double ticksAt(double seconds) const noexcept;
+    // Convert every element; `out` must be at least as long as the input. Fastest
+    // for ascending input (playback, export), correct for any order.
+    void secondsAt(std::span<const Tick> ticks, std::span<double> out) const noexcept;
+    void ticksAt(std::span<const double> seconds, std::span<double> out) const noexcept;
+
+private:
+    // Segment i spans changes [i, i + 1); the last one is open-ended.
+    struct Segment {
+        double tick {0.0};
+        double seconds {0.0};
+        double bpm {120.0};
+        // Tempo change per tick across the segment (0 when constant).
+        double slope {0.0};
+    };
+
+    void rebuild();
+    [[nodiscard]] std::size_t segmentAtTick(double tick) const noexcept;
+    [[nodiscard]] std::size_t segmentAtSeconds(double seconds) const noexcept;
+    [[nodiscard]] double secondsIn(const Segment& segment, double tick) const noexcept;
+    [[nodiscard]] double ticksIn(const Segment& segment, double seconds) const noexcept;
+
+    int m_ticksPerQuarter;
+    std::vector<TempoChange> m_changes;
+    std::vector<Segment> m_segments;
+    // Segment starts, kept dense for searching.
+    std::vector<double> m_startTicks;
+    std::vector<double> m_startSeconds;
+};
+
+} // namespace notascore::notation
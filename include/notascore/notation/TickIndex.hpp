@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace notascore::notation {
+
+struct NoteEvent;
+
+// Overlap index over tick-sorted notes. Notes are bucketed by onset into spans
+// of `bucketTicks` (one measure by default); a max-segment tree over the latest
+// end tick of each bucket finds the few earlier buckets still sounding at t0.
+// Queries cost O(log n + k) plus the size of buckets holding long notes;
+// inserts cost O(log buckets).
+class TickIndex {
+public:
+    explicit TickIndex(std::int64_t bucketTicks = 1920);
+
+    void rebuild(std::span<const NoteEvent> notes, std::int64_t bucketTicks);
+    // Call after `note` has been inserted into the sorted storage.
+    void insert(const NoteEvent& note);
+    // Call after `note` has been removed from the sorted storage `notes`; rescans
+    // its bucket only when the note defined the bucket's latest end.
+    void erase(std::span<const NoteEvent> notes, const NoteEvent& note);
+
+    // Appends, in storage order, indices of notes overlapping [t0, t1). Zero-length
+    // notes occupy one tick.
+    void query(std::span<const NoteEvent> notes, std::int64_t t0, std::int64_t t1, std::vector<std::uint32_t>& out) const;
+
+    [[nodiscard]] std::int64_t bucketTicks() const noexcept { return m_bucketTicks; }
+    // Latest end tick of any note, or 0 when empty.
+    [[nodiscard]] std::int64_t maxEnd() const noexcept { return std::max<std::int64_t>(m_maxEnd[1], 0); }
+
+private:
+    void ensureBuckets(std::size_t count);
+    void raise(std::size_t bucket, std::int64_t end) noexcept;
+    void collectSounding(std::span<const NoteEvent> notes, std::size_t node, std::size_t nodeFirst, std::size_t nodeLast,
+        std::size_t lastBucket, std::int64_t t0, std::vector<std::uint32_t>& out) const;
+
+    std::int64_t m_bucketTicks;
+    std::size_t m_leaves {1};
+    // Implicit binary tree: node i has children 2i and 2i+1, leaves start at m_leaves.
+    std::vector<std::int64_t> m_maxEnd;
+};
+
+} // namespace notascore::notation
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <numeric>
+
+namespace notascore::notation {
+
+// Absolute position in ticks. 64-bit, so long scores at high PPQ (e.g. hours of
+// music at 960 PPQ and beyond) cannot overflow.
+using Tick = std::int64_t;
+
+// Exact musical time as a fraction of a whole note: 1/4 is a quarter, 1/12 an
+// eighth-note triplet. Always reduced, with a positive denominator. Tuplet values
+// stay exact even where they fall between ticks at a given PPQ (a septuplet
+// sixteenth is 1/28, which 480 PPQ cannot represent).
+class RationalTime {
+public:
+    constexpr RationalTime() noexcept = default;
+    constexpr RationalTime(std::int64_t numerator, std::int64_t denominator = 1) noexcept
+        : m_numerator(numerator), m_denominator(denominator) {
+        if (m_denominator < 0) {
+            m_numerator = -m_numerator;
+            m_denominator = -m_denominator;
+        }
+        if (const std::int64_t divisor = std::gcd(m_numerator, m_denominator); divisor > 1) {
+            m_numerator /= divisor;
+            m_denominator /= divisor;
+        }
+    }
+
+    [[nodiscard]] static constexpr RationalTime fromTicks(Tick ticks, int ticksPerQuarter) noexcept {
+        return {ticks, 4 * static_cast<std::int64_t>(ticksPerQuarter)};
+    }
+
+    [[nodiscard]] constexpr std::int64_t numerator() const noexcept { return m_numerator; }
+    [[nodiscard]] constexpr std::int64_t denominator() const noexcept { return m_denominator; }
+
+    // True when the time is a whole number of ticks at `ticksPerQuarter`.
+    [[nodiscard]] constexpr bool isExactAt(int ticksPerQuarter) const noexcept {
+        return 4 * static_cast<std::int64_t>(ticksPerQuarter) % m_denominator == 0;
+    }
+    // Nearest tick at `ticksPerQuarter`; exact when isExactAt().
+    [[nodiscard]] constexpr Tick toTicks(int ticksPerQuarter) const noexcept {
+        const std::int64_t whole = 4 * static_cast<std::int64_t>(ticksPerQuarter);
+        if (whole % m_denominator == 0) {
+            return m_numerator * (whole / m_denominator);
+        }
+        const std::int64_t scaled = m_numerator * whole;
+        const std::int64_t half = m_denominator / 2;
+        return scaled >= 0 ? (scaled + half) / m_denominator : -((-scaled + half) / m_denominator);
+    }
+
+    friend constexpr RationalTime operator+(RationalTime a, RationalTime b) noexcept {
+        const std::int64_t divisor = std::gcd(a.m_denominator, b.m_denominator);
+        return {a.m_numerator * (b.m_denominator / divisor) + b.m_numerator * (a.m_denominator / divisor),
+            a.m_denominator / divisor * b.m_denominator};
+    }
+    friend constexpr RationalTime operator-(RationalTime a, RationalTime b) noexcept {
+        return a + RationalTime(-b.m_numerator, b.m_denominator);
+    }
+    friend constexpr RationalTime operator*(RationalTime a, std::int64_t factor) noexcept {
+        const std::int64_t divisor = std::gcd(factor, a.m_denominator);
+        return {a.m_numerator * (factor / divisor), a.m_denominator / divisor};
+    }
+    friend constexpr RationalTime operator/(RationalTime a, std::int64_t divisor) noexcept {
+        const std::int64_t common = std::gcd(a.m_numerator, divisor);
+        return {a.m_numerator / common, a.m_denominator * (divisor / common)};
+    }
+
+    friend constexpr bool operator==(RationalTime, RationalTime) noexcept = default;
+    friend constexpr std::strong_ordering operator<=>(RationalTime a, RationalTime b) noexcept {
+        const std::int64_t divisor = std::gcd(a.m_denominator, b.m_denominator);
+        return a.m_numerator * (b.m_denominator / divisor) <=> b.m_numerator * (a.m_denominator / divisor);
+    }
+
+private:
+    std::int64_t m_numerator {0};
+    std::int64_t m_denominator {1};
+};
+
+} // namespace notascore::notation
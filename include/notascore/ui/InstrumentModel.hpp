@@ -24,10 +24,10 @@ public:
             return {};
         const auto& def = m_library[static_cast<std::size_t>(index.row())];
         if (role == Qt::DisplayRole) {
-            return QString::fromStdString(def.name);
+            return QString::fromUtf8(notascore::core::text(def.name));
         }
         if (role == Qt::UserRole) {
-            return QString::fromStdString(def.range);
+            return QString::fromUtf8(notascore::core::text(def.range));
         }
         return {};
     }
@@ -1,10 +1,18 @@
 #pragma once
 
+#include "notascore/core/SymbolTable.hpp"
 #include "notascore/ui/PerformanceSettings.hpp"
 
+#include <initializer_list>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace notascore::notation {
+class NotationEngine;
+class Score;
+}
+
 namespace notascore::ui {
 
 struct UiAction {
@@ -28,10 +36,13 @@ enum class WizardStep {
     ScoreSettings
 };
 
+// Library entry; the strings are interned, so entries are cheap to copy and
+// compare by symbol.
 struct InstrumentDef {
-    std::string group;
-    std::string name;
-    std::string range;
+    notascore::core::Symbol group;
+    notascore::core::Symbol name;
+    notascore::core::Symbol range;
+    std::size_t staffCount {1};
 };
 
 class MainWindow {
@@ -41,6 +52,16 @@ public:
     void resize(int width, int height) noexcept;
     void onClick(int x, int y);
 
+    // A single voice for Edit > Undo/Redo to act on when no score is set.
+    void setDocument(notascore::notation::NotationEngine* document) noexcept { m_document = document; }
+    // The score the wizard fills: one part per selected instrument. Once set,
+    // Edit > Undo/Redo step the score's history, whichever voice was edited.
+    void setScore(notascore::notation::Score* score) noexcept { m_score = score; }
+    void undo();
+    void redo();
+    [[nodiscard]] bool canUndo() const noexcept;
+    [[nodiscard]] bool canRedo() const noexcept;
+
     [[nodiscard]] int width() const noexcept { return m_width; }
     [[nodiscard]] int height() const noexcept { return m_height; }
     [[nodiscard]] const std::vector<UiAction>& actions() const noexcept { return m_actions; }
@@ -53,9 +74,9 @@ public:
     [[nodiscard]] bool livePreviewEnabled() const noexcept { return m_livePreviewEnabled; }
     [[nodiscard]] int bpm() const noexcept { return m_bpm; }
     [[nodiscard]] const std::string& title() const noexcept { return m_title; }
-    [[nodiscard]] const std::string& composer() const noexcept { return m_composer; }
-    [[nodiscard]] const std::string& meter() const noexcept { return m_meter; }
-    [[nodiscard]] const std::string& keySignature() const noexcept { return m_keySignature; }
+    [[nodiscard]] std::string_view composer() const noexcept { return notascore::core::text(m_composer); }
+    [[nodiscard]] std::string_view meter() const noexcept { return notascore::core::text(m_meter); }
+    [[nodiscard]] std::string_view keySignature() const noexcept { return notascore::core::text(m_keySignature); }
 
     [[nodiscard]] const std::vector<std::string>& recentProjects() const noexcept { return m_recentProjects; }
     [[nodiscard]] const std::vector<InstrumentDef>& instrumentLibrary() const noexcept { return m_instrumentLibrary; }
@@ -82,11 +103,16 @@ public:
 private:
     void rebuildActions();
     void openNewScoreWizard();
+    void createScore();
+    // Rewrites the status in place, reusing its buffer.
+    void setStatus(std::initializer_list<std::string_view> parts);
 
     int m_width;
     int m_height;
     PerformanceSettings m_settings;
     std::vector<UiAction> m_actions;
+    notascore::notation::NotationEngine* m_document {nullptr};
+    notascore::notation::Score* m_score {nullptr};
 
     bool m_wizardOpen {false};
     WizardStep m_wizardStep {WizardStep::Instruments};
@@ -96,9 +122,9 @@ private:
     int m_scoreCount {0};
     int m_bpm {120};
     std::string m_title {"Untitled Score"};
-    std::string m_composer {"Composer"};
-    std::string m_meter {"4/4"};
-    std::string m_keySignature {"C Major"};
+    notascore::core::Symbol m_composer {notascore::core::intern("Composer")};
+    notascore::core::Symbol m_meter {notascore::core::intern("4/4")};
+    notascore::core::Symbol m_keySignature {notascore::core::intern("C Major")};
     std::string m_statusText {"Ready"};
 
     std::vector<std::string> m_recentProjects;
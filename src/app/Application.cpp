@@ -11,13 +11,21 @@ Application::Application()
       m_nativeWindow(m_mainWindow) {
     m_audio.configureBuffer(m_settings.audioBufferFrames);
     m_audio.setPlaybackLite(m_settings.lowMemoryMode);
+
+    auto layoutOptions = m_score.layoutOptions();
+    layoutOptions.lowMemoryMode = m_settings.lowMemoryMode;
+    m_score.setLayoutOptions(layoutOptions);
+    m_mainWindow.setScore(&m_score);
+    m_score.addPart("Piano", "A0-C8", 2);
 }
 
 int Application::run() {
-    m_notation.addNote({.tick = 0, .duration = 480, .midiPitch = 60});
-    m_notation.addNote({.tick = 480, .duration = 480, .midiPitch = 64});
+    if (auto* voice = m_score.part(0).voice(0, 0)) {
+        voice->addNote({.tick = 0, .duration = 480, .midiPitch = 60});
+        voice->addNote({.tick = 480, .duration = 480, .midiPitch = 64});
+    }
 
-    m_scheduler.submit(notascore::core::TaskPriority::Interactive, [this] { m_notation.recomputeLayoutIfNeeded(); });
+    m_scheduler.submit(notascore::core::TaskPriority::Interactive, [this] { m_score.recomputeLayoutIfNeeded(); });
     m_scheduler.flush();
 
     return m_nativeWindow.run();
@@ -0,0 +1,80 @@
+#include "notascore/core/SymbolTable.hpp"
+
+#include <cstring>
+
+namespace notascore::core {
+
+SymbolTable::SymbolTable() {
+    m_views[0] = std::make_unique<ViewChunk>();
+    m_ids.emplace(std::string_view {}, 0);
+    m_size.store(1, std::memory_order_release);
+}
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+std::string_view SymbolTable::store(std::string_view text) {
+    if (text.size() > kTextBlockBytes / 4) {
+        // Long strings get a block of their own instead of wasting a shared one.
+        const auto& block = m_largeBlocks.emplace_back(std::make_unique<char[]>(text.size()));
+        std::memcpy(block.get(), text.data(), text.size());
+        m_textBytes += text.size();
+        return {block.get(), text.size()};
+    }
+    if (m_blockUsed + text.size() > kTextBlockBytes) {
+        m_blocks.push_back(std::make_unique<char[]>(kTextBlockBytes));
+        m_blockUsed = 0;
+        m_textBytes += kTextBlockBytes;
+    }
+    char* destination = m_blocks.back().get() + m_blockUsed;
+    std::memcpy(destination, text.data(), text.size());
+    m_blockUsed += text.size();
+    return {destination, text.size()};
+}
+
+Symbol SymbolTable::intern(std::string_view text) {
+    const std::scoped_lock lock(m_mutex);
+    if (const auto it = m_ids.find(text); it != m_ids.end()) {
+        return {it->second};
+    }
+    const std::size_t id = m_size.load(std::memory_order_relaxed);
+    if (id >= kViewsPerChunk * kMaxChunks) {
+        return {};
+    }
+    auto& chunk = m_views[id / kViewsPerChunk];
+    if (!chunk) {
+        chunk = std::make_unique<ViewChunk>();
+    }
+    const auto stored = store(text);
+    (*chunk)[id % kViewsPerChunk] = stored;
+    m_ids.emplace(stored, static_cast<std::uint32_t>(id));
+    m_size.store(id + 1, std::memory_order_release);
+    return {static_cast<std::uint32_t>(id)};
+}
+
+std::optional<Symbol> SymbolTable::find(std::string_view text) const {
+    const std::scoped_lock lock(m_mutex);
+    if (const auto it = m_ids.find(text); it != m_ids.end()) {
+        return Symbol {it->second};
+    }
+    return std::nullopt;
+}
+
+std::string_view SymbolTable::text(Symbol symbol) const noexcept {
+    if (symbol.id >= size()) {
+        return {};
+    }
+    return (*m_views[symbol.id / kViewsPerChunk])[symbol.id % kViewsPerChunk];
+}
+
+std::size_t SymbolTable::memoryBytes() const {
+    const std::scoped_lock lock(m_mutex);
+    const std::size_t chunks = (m_size.load(std::memory_order_relaxed) + kViewsPerChunk - 1) / kViewsPerChunk;
+    const std::size_t mapBytes = m_ids.bucket_count() * sizeof(void*)
+        + m_ids.size() * (sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void*));
+    return m_textBytes + chunks * sizeof(ViewChunk) + mapBytes;
+}
+
+} // namespace notascore::core
@@ -1,5 +1,9 @@
 #include "notascore/core/ThreadPool.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 namespace notascore::core {
 
 ThreadPool::ThreadPool(std::size_t threadCount) {
@@ -35,6 +39,44 @@ void ThreadPool::waitIdle() {
     m_idle.wait(lock, [this] { return m_tasks.empty() && m_activeTasks == 0; });
 }
 
+void ThreadPool::parallelFor(
+    std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1 || m_workers.empty()) {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+
+    struct State {
+        std::atomic<std::size_t> next {0};
+        std::atomic<std::size_t> done {0};
+    };
+    // Helpers that start after all chunks are claimed touch only the shared state,
+    // never `body`, so the caller may return as soon as every chunk is done.
+    auto state = std::make_shared<State>();
+    auto run = [state, chunks, count, grain, &body] {
+        for (std::size_t chunk = state->next.fetch_add(1); chunk < chunks; chunk = state->next.fetch_add(1)) {
+            body(chunk * grain, std::min(count, (chunk + 1) * grain));
+            if (state->done.fetch_add(1) + 1 == chunks) {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    const std::size_t helpers = std::min(m_workers.size(), chunks - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        schedule(run);
+    }
+    run();
+
+    for (std::size_t done = state->done.load(); done != chunks; done = state->done.load()) {
+        state->done.wait(done);
+    }
+}
+
 void ThreadPool::workerLoop() {
     while (true) {
         std::function<void()> task;
@@ -0,0 +1,563 @@
+#include "notascore/io/EditJournal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace notascore::io {
+
+namespace {
+
+using notascore::notation::BulkEdit;
+using notascore::notation::BulkEditKind;
+using notascore::notation::EditKind;
+using notascore::notation::EditRecord;
+using notascore::notation::Marking;
+using notascore::notation::MarkingKind;
+using notascore::notation::NoteEvent;
+using notascore::notation::NoteRange;
+
+constexpr std::array<std::uint8_t, 4> kMagic {'N', 'S', 'X', 'J'};
+// Version 2 added note velocities and bulk edits.
+constexpr std::uint32_t kVersion = 2;
+constexpr std::size_t kHeaderBytes = 8;
+constexpr std::size_t kBlockHeaderBytes = 8;
+// Sanity bound when reading a block size from a possibly torn file.
+constexpr std::size_t kMaxBlockBytes = std::size_t {1} << 26;
+constexpr std::uint8_t kMetadataRecord = 0x0F;
+// Bulk inserts are split so that one record never outgrows a block by much.
+constexpr std::size_t kNotesPerRecord = 4096;
+// Largest encoding of one note: four 10-byte varints.
+constexpr std::size_t kMaxNoteBytes = 40;
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Zigzag keeps small negative deltas short.
+void putSigned(std::vector<std::uint8_t>& out, std::int64_t value) {
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void putU32(std::uint8_t* out, std::uint32_t value) noexcept {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t* in) noexcept {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+// FNV-1a; enough to reject a torn or garbled block.
+std::uint32_t checksum(const std::uint8_t* data, std::size_t size) noexcept {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool syncToDisk(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+bool readHeader(std::FILE* file) {
+    std::array<std::uint8_t, kHeaderBytes> header {};
+    return std::fread(header.data(), 1, header.size(), file) == header.size()
+        && std::equal(kMagic.begin(), kMagic.end(), header.begin()) && getU32(header.data() + 4) == kVersion;
+}
+
+// The next complete block; false at the end of the file or at a short or
+// corrupt block, which ends the journal.
+bool readBlock(std::FILE* file, std::vector<std::uint8_t>& block) {
+    std::array<std::uint8_t, kBlockHeaderBytes> blockHeader {};
+    if (std::fread(blockHeader.data(), 1, blockHeader.size(), file) != blockHeader.size()) {
+        return false;
+    }
+    const std::size_t size = getU32(blockHeader.data());
+    if (size > kMaxBlockBytes) {
+        return false;
+    }
+    block.resize(size);
+    return std::fread(block.data(), 1, block.size(), file) == block.size()
+        && checksum(block.data(), block.size()) == getU32(blockHeader.data() + 4);
+}
+
+class Reader {
+public:
+    Reader(const std::uint8_t* data, std::size_t size) : m_at(data), m_end(data + size) {}
+
+    [[nodiscard]] bool done() const noexcept { return m_at == m_end; }
+
+    bool byte(std::uint8_t& value) noexcept {
+        if (m_at == m_end) {
+            return false;
+        }
+        value = *m_at++;
+        return true;
+    }
+
+    bool varint(std::uint64_t& value) noexcept {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t next = 0;
+            if (!byte(next)) {
+                return false;
+            }
+            value |= static_cast<std::uint64_t>(next & 0x7F) << shift;
+            if ((next & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool signedDelta(std::int64_t& last) noexcept {
+        std::uint64_t raw = 0;
+        if (!varint(raw)) {
+            return false;
+        }
+        last += static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+        return true;
+    }
+
+    bool bytes(std::size_t count, std::string_view& out) noexcept {
+        if (static_cast<std::size_t>(m_end - m_at) < count) {
+            return false;
+        }
+        out = {reinterpret_cast<const char*>(m_at), count};
+        m_at += count;
+        return true;
+    }
+
+private:
+    const std::uint8_t* m_at;
+    const std::uint8_t* m_end;
+};
+
+struct DeltaState {
+    std::int64_t index {0};
+    std::int64_t tick {0};
+    std::int64_t pitch {0};
+    std::int64_t velocity {0};
+};
+
+bool readNote(Reader& reader, DeltaState& state, NoteEvent& note) {
+    std::int64_t duration = 0;
+    // The engine only ever records ticks in [0, INT_MAX]; anything else is garbage.
+    if (!reader.signedDelta(state.tick) || !reader.signedDelta(duration) || !reader.signedDelta(state.pitch)
+        || !reader.signedDelta(state.velocity) || state.tick < 0 || state.tick > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    note = {.tick = static_cast<int>(state.tick),
+        .duration = static_cast<int>(duration),
+        .midiPitch = static_cast<int>(state.pitch),
+        .velocity = static_cast<int>(state.velocity)};
+    return true;
+}
+
+// Consecutive tick-ordered inserts are merged in one pass: merging two batches
+// one after the other gives the same order as merging them together.
+void flushPending(notascore::notation::NotationEngine& engine, std::vector<NoteEvent>& pending) {
+    if (!pending.empty()) {
+        engine.applyEdit({.kind = EditKind::AddNotes, .notes = pending});
+        pending.clear();
+    }
+}
+
+// Decodes and applies one block; returns false at the first malformed record.
+bool replayBlock(Reader reader, notascore::notation::NotationEngine& engine,
+    const EditJournal::MetadataHandler& onMetadata, std::vector<NoteEvent>& pending) {
+    DeltaState state;
+    std::vector<NoteRange> ranges;
+    while (!reader.done()) {
+        std::uint8_t kind = 0;
+        reader.byte(kind);
+        EditRecord record;
+        record.kind = static_cast<EditKind>(kind);
+        bool ok = true;
+        switch (kind) {
+        case static_cast<std::uint8_t>(EditKind::InsertNote):
+        case static_cast<std::uint8_t>(EditKind::ModifyNote):
+            ok = reader.signedDelta(state.index) && readNote(reader, state, record.note);
+            break;
+        case static_cast<std::uint8_t>(EditKind::EraseNote):
+        case static_cast<std::uint8_t>(EditKind::EraseMarking):
+            ok = reader.signedDelta(state.index);
+            break;
+        case static_cast<std::uint8_t>(EditKind::AddNotes): {
+            std::uint64_t count = 0;
+            ok = reader.varint(count) && count <= kNotesPerRecord;
+            for (std::uint64_t i = 0; ok && i < count; ++i) {
+                ok = readNote(reader, state, pending.emplace_back());
+            }
+            if (!ok) {
+                return false;
+            }
+            continue;
+        }
+        case static_cast<std::uint8_t>(EditKind::InsertMarking): {
+            std::uint8_t markingKind = 0;
+            std::string_view width;
+            ok = reader.signedDelta(state.index) && reader.signedDelta(state.tick) && reader.byte(markingKind)
+                && reader.bytes(4, width) && state.tick >= 0 && state.tick <= std::numeric_limits<int>::max();
+            if (ok) {
+                record.marking = {.tick = static_cast<int>(state.tick),
+                    .kind = static_cast<MarkingKind>(markingKind),
+                    .width = std::bit_cast<float>(getU32(reinterpret_cast<const std::uint8_t*>(width.data())))};
+            }
+            break;
+        }
+        case static_cast<std::uint8_t>(EditKind::BulkEdit): {
+            std::uint8_t bulkKind = 0;
+            std::int64_t amount = 0;
+            std::int64_t divisor = 0;
+            std::uint64_t count = 0;
+            // Ranges are checked against the document as it stands before this record.
+            flushPending(engine, pending);
+            ok = reader.byte(bulkKind) && bulkKind <= static_cast<std::uint8_t>(BulkEditKind::ScaleVelocities)
+                && reader.signedDelta(amount) && reader.signedDelta(divisor) && reader.varint(count);
+            ranges.clear();
+            std::uint64_t last = 0;
+            for (std::uint64_t i = 0; ok && i < count; ++i) {
+                std::uint64_t gap = 0;
+                std::uint64_t size = 0;
+                ok = reader.varint(gap) && reader.varint(size) && last + gap + size <= engine.noteCount();
+                if (ok) {
+                    ranges.push_back({.first = static_cast<std::uint32_t>(last + gap),
+                        .last = static_cast<std::uint32_t>(last + gap + size)});
+                    last += gap + size;
+                }
+            }
+            record.bulk = {.kind = static_cast<BulkEditKind>(bulkKind),
+                .amount = static_cast<int>(amount),
+                .divisor = static_cast<int>(divisor)};
+            record.ranges = ranges;
+            break;
+        }
+        case kMetadataRecord: {
+            std::uint64_t keySize = 0;
+            std::uint64_t valueSize = 0;
+            std::string_view key;
+            std::string_view value;
+            ok = reader.varint(keySize) && reader.bytes(static_cast<std::size_t>(keySize), key)
+                && reader.varint(valueSize) && reader.bytes(static_cast<std::size_t>(valueSize), value);
+            if (!ok) {
+                return false;
+            }
+            if (onMetadata) {
+                onMetadata(key, value);
+            }
+            continue;
+        }
+        default:
+            ok = false;
+            break;
+        }
+        flushPending(engine, pending);
+        // A journal that does not belong to this document must not index past it.
+        const auto notes = static_cast<std::int64_t>(engine.noteCount());
+        const auto markings = static_cast<std::int64_t>(engine.markings().size());
+        const bool inRange = record.kind == EditKind::InsertNote ? state.index <= notes
+            : record.kind == EditKind::EraseNote || record.kind == EditKind::ModifyNote ? state.index < notes
+            : record.kind == EditKind::InsertMarking ? state.index <= markings
+            : record.kind == EditKind::EraseMarking ? state.index < markings
+                                                     : true;
+        if (!ok || state.index < 0 || !inRange) {
+            return false;
+        }
+        record.index = static_cast<std::uint32_t>(state.index);
+        engine.applyEdit(record);
+    }
+    return true;
+}
+
+} // namespace
+
+EditJournal::~EditJournal() {
+    close();
+}
+
+bool EditJournal::open(const std::filesystem::path& path, const JournalOptions& options) {
+    close();
+    m_path = path;
+    m_options = options;
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(path, error);
+    const bool existing = !error && size >= kHeaderBytes;
+    if (existing) {
+        // Blocks appended after a torn one would never be replayed, so the
+        // journal is cut after its last complete block.
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        const bool journal = readHeader(file);
+        std::uintmax_t end = kHeaderBytes;
+        while (journal && readBlock(file, m_block)) {
+            end += kBlockHeaderBytes + m_block.size();
+        }
+        std::fclose(file);
+        m_block.clear();
+        if (!journal) {
+            return false;
+        }
+        if (end < size) {
+            std::filesystem::resize_file(path, end, error);
+            if (error) {
+                return false;
+            }
+        }
+    }
+    m_file = std::fopen(path.string().c_str(), existing ? "ab" : "wb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    if (!existing) {
+        std::array<std::uint8_t, kHeaderBytes> header {};
+        std::copy(kMagic.begin(), kMagic.end(), header.begin());
+        putU32(header.data() + 4, kVersion);
+        // Flushed at once, so that a crash before the first block still leaves a journal.
+        if (std::fwrite(header.data(), 1, header.size(), m_file) != header.size() || std::fflush(m_file) != 0) {
+            close();
+            return false;
+        }
+        m_bytesWritten += header.size();
+    }
+    m_block.reserve(m_options.blockBytes + kBlockHeaderBytes);
+    m_lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+void EditJournal::close() {
+    if (m_file == nullptr) {
+        return;
+    }
+    flush();
+    if (m_options.sync != SyncPolicy::Never) {
+        syncToDisk(m_file);
+    }
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void EditJournal::attach(notascore::notation::NotationEngine& engine) {
+    engine.setEditListener([this](const EditRecord& record) { append(record); });
+}
+
+void EditJournal::beginRecord(std::size_t maxBytes) {
+    if (!m_block.empty() && m_block.size() + maxBytes > m_options.blockBytes) {
+        writeBlock();
+    }
+    if (m_block.empty()) {
+        m_block.resize(kBlockHeaderBytes);
+        m_lastIndex = m_lastTick = m_lastPitch = m_lastVelocity = 0;
+    }
+    ++m_recordCount;
+}
+
+void EditJournal::append(const EditRecord& record) {
+    if (m_file == nullptr) {
+        return;
+    }
+    encode(record);
+    syncIfDue();
+}
+
+void EditJournal::encode(const EditRecord& record) {
+    const auto putNote = [this](const NoteEvent& note) {
+        putSigned(m_block, note.tick - m_lastTick);
+        putSigned(m_block, note.duration);
+        putSigned(m_block, note.midiPitch - m_lastPitch);
+        putSigned(m_block, note.velocity - m_lastVelocity);
+        m_lastTick = note.tick;
+        m_lastPitch = note.midiPitch;
+        m_lastVelocity = note.velocity;
+    };
+    const auto putIndex = [this](std::uint32_t index) {
+        putSigned(m_block, static_cast<std::int64_t>(index) - m_lastIndex);
+        m_lastIndex = index;
+    };
+
+    if (record.kind == EditKind::AddNotes) {
+        for (std::size_t first = 0; first < record.notes.size(); first += kNotesPerRecord) {
+            const std::size_t count = std::min(kNotesPerRecord, record.notes.size() - first);
+            beginRecord(1 + 10 + count * kMaxNoteBytes);
+            m_block.push_back(static_cast<std::uint8_t>(EditKind::AddNotes));
+            putVarint(m_block, count);
+            for (std::size_t i = first; i < first + count; ++i) {
+                putNote(record.notes[i]);
+            }
+        }
+        return;
+    }
+
+    if (record.kind == EditKind::BulkEdit) {
+        // One record however many notes it touches; ranges are gap/size pairs.
+        beginRecord(2 + 30 + record.ranges.size() * 20);
+        m_block.push_back(static_cast<std::uint8_t>(EditKind::BulkEdit));
+        m_block.push_back(static_cast<std::uint8_t>(record.bulk.kind));
+        putSigned(m_block, record.bulk.amount);
+        putSigned(m_block, record.bulk.divisor);
+        putVarint(m_block, record.ranges.size());
+        std::uint32_t last = 0;
+        for (const auto& range : record.ranges) {
+            putVarint(m_block, range.first - last);
+            putVarint(m_block, range.last - range.first);
+            last = range.last;
+        }
+        return;
+    }
+
+    beginRecord(1 + 10 + kMaxNoteBytes);
+    m_block.push_back(static_cast<std::uint8_t>(record.kind));
+    switch (record.kind) {
+    case EditKind::InsertNote:
+    case EditKind::ModifyNote:
+        putIndex(record.index);
+        putNote(record.note);
+        break;
+    case EditKind::EraseNote:
+    case EditKind::EraseMarking:
+        putIndex(record.index);
+        break;
+    case EditKind::InsertMarking: {
+        putIndex(record.index);
+        putSigned(m_block, record.marking.tick - m_lastTick);
+        m_lastTick = record.marking.tick;
+        m_block.push_back(static_cast<std::uint8_t>(record.marking.kind));
+        std::array<std::uint8_t, 4> width {};
+        putU32(width.data(), std::bit_cast<std::uint32_t>(record.marking.width));
+        m_block.insert(m_block.end(), width.begin(), width.end());
+        break;
+    }
+    case EditKind::AddNotes:
+    case EditKind::BulkEdit:
+        break;
+    }
+}
+
+void EditJournal::appendMetadata(std::string_view key, std::string_view value) {
+    if (m_file == nullptr) {
+        return;
+    }
+    beginRecord(1 + 20 + key.size() + value.size());
+    m_block.push_back(kMetadataRecord);
+    putVarint(m_block, key.size());
+    m_block.insert(m_block.end(), key.begin(), key.end());
+    putVarint(m_block, value.size());
+    m_block.insert(m_block.end(), value.begin(), value.end());
+    syncIfDue();
+}
+
+void EditJournal::syncIfDue() {
+    // A block that has not filled by the end of the interval is written as is;
+    // writeBlock() then finds the sync due.
+    if (m_options.sync == SyncPolicy::Interval && !m_block.empty()
+        && std::chrono::steady_clock::now() - m_lastSync >= m_options.syncInterval) {
+        writeBlock();
+    }
+}
+
+bool EditJournal::writeBlock() {
+    const std::size_t payload = m_block.size() - kBlockHeaderBytes;
+    putU32(m_block.data(), static_cast<std::uint32_t>(payload));
+    putU32(m_block.data() + 4, checksum(m_block.data() + kBlockHeaderBytes, payload));
+    const bool written = std::fwrite(m_block.data(), 1, m_block.size(), m_file) == m_block.size();
+    m_bytesWritten += m_block.size();
+    m_block.clear();
+    if (!written) {
+        return false;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const bool due = m_options.sync == SyncPolicy::EveryBlock
+        || (m_options.sync == SyncPolicy::Interval && now - m_lastSync >= m_options.syncInterval);
+    if (!due) {
+        return true;
+    }
+    m_lastSync = now;
+    ++m_syncCount;
+    return syncToDisk(m_file);
+}
+
+bool EditJournal::flush() {
+    if (m_file == nullptr) {
+        return false;
+    }
+    if (m_block.empty()) {
+        return true;
+    }
+    return writeBlock() && std::fflush(m_file) == 0;
+}
+
+bool EditJournal::sync() {
+    if (!flush()) {
+        return false;
+    }
+    m_lastSync = std::chrono::steady_clock::now();
+    ++m_syncCount;
+    return syncToDisk(m_file);
+}
+
+bool EditJournal::reset() {
+    if (m_file == nullptr) {
+        return false;
+    }
+    m_block.clear();
+    std::fclose(m_file);
+    m_file = nullptr;
+    std::error_code error;
+    std::filesystem::remove(m_path, error);
+    return open(m_path, m_options);
+}
+
+bool EditJournal::replay(const std::filesystem::path& path, notascore::notation::NotationEngine& engine,
+    const MetadataHandler& onMetadata) {
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    if (!readHeader(file)) {
+        std::fclose(file);
+        return false;
+    }
+
+    // One block in memory at a time.
+    std::vector<std::uint8_t> block;
+    std::vector<NoteEvent> pending;
+    while (readBlock(file, block)) {
+        if (!replayBlock(Reader(block.data(), block.size()), engine, onMetadata, pending)) {
+            break;
+        }
+    }
+    flushPending(engine, pending);
+    std::fclose(file);
+    return true;
+}
+
+} // namespace notascore::io
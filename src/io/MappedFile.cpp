@@ -0,0 +1,124 @@
+#include "notascore/io/MappedFile.hpp"
+
+#include <cstdint>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace notascore::io {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size {};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    // The view keeps the mapping and the file open.
+    const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (view == nullptr) {
+        return false;
+    }
+    m_data = static_cast<const std::byte*>(view);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// Windows already reads mapped files in small clusters on a fault.
+void MappedFile::adviseRandomAccess() const noexcept {}
+
+void MappedFile::prefetch(std::span<const std::byte>) const noexcept {}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status {};
+    void* view = MAP_FAILED;
+    if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+        view = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping keeps the file open.
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const std::byte*>(view);
+    m_size = static_cast<std::size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data != nullptr) {
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::adviseRandomAccess() const noexcept {
+    if (m_data != nullptr) {
+        ::madvise(const_cast<std::byte*>(m_data), m_size, MADV_RANDOM);
+    }
+}
+
+void MappedFile::prefetch(std::span<const std::byte> range) const noexcept {
+    if (range.empty()) {
+        return;
+    }
+    // madvise wants a page-aligned start.
+    const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto start = reinterpret_cast<std::uintptr_t>(range.data()) & ~(page - 1);
+    const auto end = reinterpret_cast<std::uintptr_t>(range.data() + range.size());
+    ::madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+}
+
+#endif
+
+} // namespace notascore::io
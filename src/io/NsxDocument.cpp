@@ -1,38 +1,1149 @@
 #include "notascore/io/NsxDocument.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <system_error>
+#include <tuple>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace notascore::io {
 
-bool NsxDocument::save(const std::filesystem::path& path, const notascore::notation::NotationEngine& notation) const {
-    std::ofstream output(path, std::ios::binary);
-    if (!output) {
+namespace {
+
+using notascore::notation::Marking;
+using notascore::notation::MarkingKind;
+using notascore::notation::MeasureIndex;
+using notascore::notation::Meter;
+using notascore::notation::NotationEngine;
+using notascore::notation::NoteEvent;
+using notascore::notation::PackedNote;
+using notascore::notation::TempoMap;
+
+constexpr std::uint32_t kMagicV2 = nsxChunkType("NSX2");
+// NSX1 wrote its magic as a native integer.
+constexpr std::uint32_t kMagicV1 = 0x4E535831;
+
+// Flushes stdio's buffer and waits until the file's data is on disk.
+bool syncToDisk(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename inside `directory` durable. Windows journals renames itself
+// and cannot open a directory as a file, so there is nothing to do there.
+bool syncDirectory(const std::filesystem::path& directory) {
+#if defined(_WIN32)
+    (void)directory;
+    return true;
+#else
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
         return false;
     }
+    const bool synced = ::fsync(fd) == 0;
+    return ::close(fd) == 0 && synced;
+#endif
+}
 
-    const std::uint32_t magic = 0x4E535831; // NSX1
-    const std::uint64_t noteCount = notation.noteCount();
-    output.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
-    output.write(reinterpret_cast<const char*>(&noteCount), sizeof(noteCount));
-    return output.good();
+constexpr std::size_t align(std::size_t offset) noexcept {
+    return (offset + nsx::kChunkAlignment - 1) / nsx::kChunkAlignment * nsx::kChunkAlignment;
 }
 
-bool NsxDocument::load(const std::filesystem::path& path, std::vector<notascore::notation::NoteEvent>& outNotes) const {
-    std::ifstream input(path, std::ios::binary);
-    if (!input) {
+// Fixed-width little-endian values; floats travel as their bit pattern.
+template <typename T>
+void storeLe(std::byte* out, T value) noexcept {
+    using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t,
+        std::conditional_t<sizeof(T) == 4, std::uint32_t, std::conditional_t<sizeof(T) == 2, std::uint16_t, std::uint8_t>>>;
+    auto bits = std::bit_cast<Bits>(value);
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, &bits, sizeof(bits));
+    } else {
+        for (std::size_t i = 0; i < sizeof(bits); ++i) {
+            out[i] = static_cast<std::byte>(bits >> (8 * i));
+        }
+    }
+}
+
+template <typename T>
+T loadLe(const std::byte* in) noexcept {
+    using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t,
+        std::conditional_t<sizeof(T) == 4, std::uint32_t, std::conditional_t<sizeof(T) == 2, std::uint16_t, std::uint8_t>>>;
+    Bits bits = 0;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&bits, in, sizeof(bits));
+    } else {
+        for (std::size_t i = 0; i < sizeof(bits); ++i) {
+            bits = static_cast<Bits>(bits | static_cast<Bits>(std::to_integer<Bits>(in[i]) << (8 * i)));
+        }
+    }
+    return std::bit_cast<T>(bits);
+}
+
+class ChunkBuilder {
+public:
+    template <typename T>
+    void put(T value) {
+        const std::size_t at = m_bytes.size();
+        m_bytes.resize(at + sizeof(T));
+        storeLe(m_bytes.data() + at, value);
+    }
+
+    void putText(std::string_view text) {
+        const auto* data = reinterpret_cast<const std::byte*>(text.data());
+        m_bytes.insert(m_bytes.end(), data, data + text.size());
+    }
+
+    // A column of `count` values of T produced by `value(i)`, padded to the
+    // chunk alignment.
+    template <typename T, typename Value>
+    void putColumn(std::size_t count, Value value) {
+        const std::size_t at = m_bytes.size();
+        m_bytes.resize(align(at + count * sizeof(T)));
+        std::byte* out = m_bytes.data() + at;
+        for (std::size_t i = 0; i < count; ++i) {
+            storeLe<T>(out + i * sizeof(T), value(i));
+        }
+    }
+
+    [[nodiscard]] std::vector<std::byte> take() { return std::move(m_bytes); }
+
+private:
+    std::vector<std::byte> m_bytes;
+};
+
+// Bounds-checked cursor over one chunk.
+class ChunkParser {
+public:
+    explicit ChunkParser(std::span<const std::byte> bytes) : m_bytes(bytes) {}
+
+    template <typename T>
+    bool get(T& value) noexcept {
+        if (m_bytes.size() - m_at < sizeof(T)) {
+            return false;
+        }
+        value = loadLe<T>(m_bytes.data() + m_at);
+        m_at += sizeof(T);
+        return true;
+    }
+
+    bool text(std::size_t size, std::string& out) {
+        if (m_bytes.size() - m_at < size) {
+            return false;
+        }
+        out.assign(reinterpret_cast<const char*>(m_bytes.data() + m_at), size);
+        m_at += size;
+        return true;
+    }
+
+    bool text(std::size_t size, std::string_view& out) noexcept {
+        if (m_bytes.size() - m_at < size) {
+            return false;
+        }
+        out = {reinterpret_cast<const char*>(m_bytes.data() + m_at), size};
+        m_at += size;
+        return true;
+    }
+
+    // Start of a column of `count` values of T; nullptr when it does not fit.
+    template <typename T>
+    const std::byte* column(std::uint64_t count) noexcept {
+        if (count > (m_bytes.size() - m_at) / sizeof(T)) {
+            return nullptr;
+        }
+        const std::byte* start = m_bytes.data() + m_at;
+        m_at = std::min(m_bytes.size(), align(m_at + static_cast<std::size_t>(count) * sizeof(T)));
+        return start;
+    }
+
+private:
+    std::span<const std::byte> m_bytes;
+    std::size_t m_at {0};
+};
+
+struct NoteColumns {
+    std::size_t count {0};
+    const std::byte* ticks {nullptr};
+    const std::byte* durations {nullptr};
+    const std::byte* pitches {nullptr};
+    const std::byte* velocities {nullptr};
+
+    [[nodiscard]] std::int64_t tick(std::size_t i) const noexcept { return loadLe<std::int64_t>(ticks + 8 * i); }
+    [[nodiscard]] std::int32_t duration(std::size_t i) const noexcept { return loadLe<std::int32_t>(durations + 4 * i); }
+    [[nodiscard]] int pitch(std::size_t i) const noexcept { return std::to_integer<int>(pitches[i]); }
+    [[nodiscard]] int velocity(std::size_t i) const noexcept { return std::to_integer<int>(velocities[i]); }
+};
+
+template <typename Tick, typename Duration, typename Pitch, typename Velocity>
+std::vector<std::byte> encodeNotes(std::size_t count, Tick tick, Duration duration, Pitch pitch, Velocity velocity) {
+    ChunkBuilder chunk;
+    chunk.put<std::uint64_t>(count);
+    chunk.putColumn<std::int64_t>(count, tick);
+    chunk.putColumn<std::int32_t>(count, duration);
+    chunk.putColumn<std::uint8_t>(count, [&](std::size_t i) { return static_cast<std::uint8_t>(std::clamp(pitch(i), 0, 127)); });
+    chunk.putColumn<std::uint8_t>(count, [&](std::size_t i) { return static_cast<std::uint8_t>(std::clamp(velocity(i), 0, 127)); });
+    return chunk.take();
+}
+
+std::vector<std::byte> encodeNotes(std::span<const NoteEvent> notes) {
+    return encodeNotes(
+        notes.size(), [&](std::size_t i) { return static_cast<std::int64_t>(notes[i].tick); },
+        [&](std::size_t i) { return static_cast<std::int32_t>(notes[i].duration); },
+        [&](std::size_t i) { return notes[i].midiPitch; }, [&](std::size_t i) { return notes[i].velocity; });
+}
+
+std::vector<std::byte> encodeNotes(std::span<const PackedNote> notes) {
+    return encodeNotes(
+        notes.size(), [&](std::size_t i) { return notes[i].tick(); },
+        [&](std::size_t i) { return static_cast<std::int32_t>(notes[i].duration()); },
+        [&](std::size_t i) { return notes[i].pitch(); }, [&](std::size_t i) { return notes[i].velocity(); });
+}
+
+bool decodeNotes(std::span<const std::byte> bytes, NoteColumns& out) {
+    ChunkParser parser(bytes);
+    std::uint64_t count = 0;
+    if (!parser.get(count)) {
+        return false;
+    }
+    out.count = static_cast<std::size_t>(count);
+    out.ticks = parser.column<std::int64_t>(count);
+    out.durations = parser.column<std::int32_t>(count);
+    out.pitches = parser.column<std::uint8_t>(count);
+    out.velocities = parser.column<std::uint8_t>(count);
+    return out.ticks != nullptr && out.durations != nullptr && out.pitches != nullptr && out.velocities != nullptr;
+}
+
+bool decodeNotes(std::span<const std::byte> bytes, std::vector<NoteEvent>& out) {
+    NoteColumns columns;
+    if (!decodeNotes(bytes, columns)) {
+        return false;
+    }
+    out.resize(columns.count);
+    for (std::size_t i = 0; i < columns.count; ++i) {
+        const std::int64_t tick = columns.tick(i);
+        if (tick < 0 || tick > std::numeric_limits<int>::max()) {
+            return false;
+        }
+        out[i] = {.tick = static_cast<int>(tick), .duration = columns.duration(i), .midiPitch = columns.pitch(i),
+            .velocity = columns.velocity(i)};
+    }
+    return true;
+}
+
+std::vector<std::byte> encodeMarkings(std::span<const Marking> markings) {
+    ChunkBuilder chunk;
+    chunk.put<std::uint64_t>(markings.size());
+    chunk.putColumn<std::int64_t>(markings.size(), [&](std::size_t i) { return static_cast<std::int64_t>(markings[i].tick); });
+    chunk.putColumn<float>(markings.size(), [&](std::size_t i) { return markings[i].width; });
+    chunk.putColumn<std::uint8_t>(markings.size(), [&](std::size_t i) { return static_cast<std::uint8_t>(markings[i].kind); });
+    return chunk.take();
+}
+
+bool decodeMarkings(std::span<const std::byte> bytes, std::vector<Marking>& out) {
+    ChunkParser parser(bytes);
+    std::uint64_t count = 0;
+    if (!parser.get(count)) {
+        return false;
+    }
+    const std::byte* ticks = parser.column<std::int64_t>(count);
+    const std::byte* widths = parser.column<float>(count);
+    const std::byte* kinds = parser.column<std::uint8_t>(count);
+    if (ticks == nullptr || widths == nullptr || kinds == nullptr) {
+        return false;
+    }
+    out.resize(static_cast<std::size_t>(count));
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        const auto tick = loadLe<std::int64_t>(ticks + 8 * i);
+        const auto kind = std::to_integer<std::uint8_t>(kinds[i]);
+        if (tick < 0 || tick > std::numeric_limits<int>::max()
+            || kind > static_cast<std::uint8_t>(MarkingKind::Lyric)) {
+            return false;
+        }
+        out[i] = {.tick = static_cast<int>(tick), .kind = static_cast<MarkingKind>(kind), .width = loadLe<float>(widths + 4 * i)};
+    }
+    return true;
+}
+
+std::vector<std::byte> encodePart(std::string_view name, std::string_view range, std::span<const std::uint32_t> voiceCounts) {
+    ChunkBuilder chunk;
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(voiceCounts.size()));
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(name.size()));
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(range.size()));
+    for (const auto count : voiceCounts) {
+        chunk.put<std::uint32_t>(count);
+    }
+    chunk.putText(name);
+    chunk.putText(range);
+    return chunk.take();
+}
+
+// Name and range point into the chunk bytes.
+struct PartHeader {
+    std::string_view name;
+    std::string_view range;
+    std::vector<std::uint32_t> voiceCounts;
+};
+
+bool decodePart(std::span<const std::byte> bytes, PartHeader& out) {
+    ChunkParser parser(bytes);
+    std::uint32_t staves = 0;
+    std::uint32_t nameBytes = 0;
+    std::uint32_t rangeBytes = 0;
+    if (!parser.get(staves) || !parser.get(nameBytes) || !parser.get(rangeBytes) || staves == 0
+        || staves > bytes.size() / sizeof(std::uint32_t)) {
+        return false;
+    }
+    out.voiceCounts.resize(staves);
+    for (auto& count : out.voiceCounts) {
+        if (!parser.get(count) || count == 0 || count > 0xFFFF) {
+            return false;
+        }
+    }
+    return parser.text(nameBytes, out.name) && parser.text(rangeBytes, out.range);
+}
+
+std::vector<std::byte> encodeMetadata(std::span<const NsxMetadataEntry> metadata) {
+    ChunkBuilder chunk;
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(metadata.size()));
+    for (const auto& entry : metadata) {
+        chunk.put<std::uint32_t>(static_cast<std::uint32_t>(entry.key.size()));
+        chunk.put<std::uint32_t>(static_cast<std::uint32_t>(entry.value.size()));
+        chunk.putText(entry.key);
+        chunk.putText(entry.value);
+    }
+    return chunk.take();
+}
+
+bool decodeMetadata(std::span<const std::byte> bytes, std::vector<NsxMetadataEntry>& out) {
+    ChunkParser parser(bytes);
+    std::uint32_t count = 0;
+    if (!parser.get(count)) {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint32_t keyBytes = 0;
+        std::uint32_t valueBytes = 0;
+        NsxMetadataEntry entry;
+        if (!parser.get(keyBytes) || !parser.get(valueBytes) || !parser.text(keyBytes, entry.key)
+            || !parser.text(valueBytes, entry.value)) {
+            return false;
+        }
+        out.push_back(std::move(entry));
+    }
+    return true;
+}
+
+std::vector<std::byte> encodeLayoutHints(const NotationEngine* first, const notascore::notation::LayoutOptions& options) {
+    ChunkBuilder chunk;
+    chunk.put<std::int32_t>(options.ticksPerQuarter);
+    chunk.put<std::int32_t>(options.measureTicks);
+    // Breaks of a stale layout would mislead the loader.
+    if (first == nullptr || first->isDirty()) {
+        chunk.put<std::uint32_t>(0);
+        chunk.put<std::uint32_t>(0);
+        return chunk.take();
+    }
+    const auto& systems = first->layout().systemFirstMeasure;
+    const auto& pages = first->layout().pageFirstSystem;
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(systems.size()));
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(pages.size()));
+    chunk.putColumn<std::uint32_t>(systems.size(), [&](std::size_t i) { return systems[i]; });
+    chunk.putColumn<std::uint32_t>(pages.size(), [&](std::size_t i) { return pages[i]; });
+    return chunk.take();
+}
+
+bool decodeLayoutHints(std::span<const std::byte> bytes, NsxLayoutHints& out) {
+    ChunkParser parser(bytes);
+    std::int32_t ticksPerQuarter = 0;
+    std::int32_t measureTicks = 0;
+    std::uint32_t systems = 0;
+    std::uint32_t pages = 0;
+    if (!parser.get(ticksPerQuarter) || !parser.get(measureTicks) || !parser.get(systems) || !parser.get(pages)
+        || ticksPerQuarter <= 0 || measureTicks <= 0) {
+        return false;
+    }
+    const std::byte* systemColumn = parser.column<std::uint32_t>(systems);
+    const std::byte* pageColumn = parser.column<std::uint32_t>(pages);
+    if (systemColumn == nullptr || pageColumn == nullptr) {
         return false;
     }
+    out.ticksPerQuarter = ticksPerQuarter;
+    out.measureTicks = measureTicks;
+    out.systemFirstMeasure.resize(systems);
+    out.pageFirstSystem.resize(pages);
+    for (std::size_t i = 0; i < systems; ++i) {
+        out.systemFirstMeasure[i] = loadLe<std::uint32_t>(systemColumn + 4 * i);
+    }
+    for (std::size_t i = 0; i < pages; ++i) {
+        out.pageFirstSystem[i] = loadLe<std::uint32_t>(pageColumn + 4 * i);
+    }
+    return true;
+}
+
+std::vector<std::byte> encodeMeters(const MeasureIndex& index) {
+    ChunkBuilder chunk;
+    const std::size_t changes = index.meterChangeCount();
+    const Meter pickupMeter = index.meterAt(0);
+    chunk.put<std::int32_t>(index.ticksPerQuarter());
+    chunk.put<std::int64_t>(index.pickupTicks());
+    chunk.put<std::int32_t>(pickupMeter.beats);
+    chunk.put<std::int32_t>(pickupMeter.beatUnit);
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(changes));
+    chunk.putColumn<std::uint32_t>(changes, [&](std::size_t i) { return index.meterChangeBar(i); });
+    chunk.putColumn<std::int32_t>(changes, [&](std::size_t i) { return index.meterAt(index.meterChangeBar(i)).beats; });
+    chunk.putColumn<std::int32_t>(changes, [&](std::size_t i) { return index.meterAt(index.meterChangeBar(i)).beatUnit; });
+    return chunk.take();
+}
 
+// Rebuilt through MeasureIndex's own setters, so a meter or pickup it would
+// refuse fails the decode.
+bool decodeMeters(std::span<const std::byte> bytes, MeasureIndex& out) {
+    ChunkParser parser(bytes);
+    std::int32_t ticksPerQuarter = 0;
+    std::int64_t pickup = 0;
+    Meter pickupMeter;
+    std::uint32_t changes = 0;
+    if (!parser.get(ticksPerQuarter) || !parser.get(pickup) || !parser.get(pickupMeter.beats)
+        || !parser.get(pickupMeter.beatUnit) || !parser.get(changes) || ticksPerQuarter <= 0 || changes == 0) {
+        return false;
+    }
+    const std::byte* bars = parser.column<std::uint32_t>(changes);
+    const std::byte* beats = parser.column<std::int32_t>(changes);
+    const std::byte* beatUnits = parser.column<std::int32_t>(changes);
+    if (bars == nullptr || beats == nullptr || beatUnits == nullptr) {
+        return false;
+    }
+    const auto meter = [&](std::size_t i) {
+        return Meter {.beats = loadLe<std::int32_t>(beats + 4 * i), .beatUnit = loadLe<std::int32_t>(beatUnits + 4 * i)};
+    };
+    // The first run holds the pickup's meter when there is one; the full bars
+    // after it are set below like any other change.
+    const Meter first = pickup > 0 ? pickupMeter : meter(0);
+    MeasureIndex index(ticksPerQuarter, first);
+    if (index.meterAt(0) != first || !index.setPickup(pickup)) {
+        return false;
+    }
+    std::uint32_t nextBar = pickup > 0 ? 1 : 0;
+    for (std::size_t i = 0; i < changes; ++i) {
+        const auto bar = loadLe<std::uint32_t>(bars + 4 * i);
+        if ((i == 0 ? bar != nextBar : bar < nextBar) || !index.setMeter(bar, meter(i))) {
+            return false;
+        }
+        nextBar = bar + 1;
+    }
+    out = index;
+    return true;
+}
+
+std::vector<std::byte> encodeTempos(const TempoMap& tempos) {
+    ChunkBuilder chunk;
+    const auto changes = tempos.changes();
+    chunk.put<std::int32_t>(tempos.ticksPerQuarter());
+    chunk.put<std::uint32_t>(static_cast<std::uint32_t>(changes.size()));
+    chunk.putColumn<std::int64_t>(changes.size(), [&](std::size_t i) { return static_cast<std::int64_t>(changes[i].tick); });
+    chunk.putColumn<double>(changes.size(), [&](std::size_t i) { return changes[i].bpm; });
+    chunk.putColumn<std::uint8_t>(changes.size(), [&](std::size_t i) { return static_cast<std::uint8_t>(changes[i].rampToNext); });
+    return chunk.take();
+}
+
+bool decodeTempos(std::span<const std::byte> bytes, TempoMap& out) {
+    ChunkParser parser(bytes);
+    std::int32_t ticksPerQuarter = 0;
+    std::uint32_t changes = 0;
+    if (!parser.get(ticksPerQuarter) || !parser.get(changes) || ticksPerQuarter <= 0 || changes == 0) {
+        return false;
+    }
+    const std::byte* ticks = parser.column<std::int64_t>(changes);
+    const std::byte* bpms = parser.column<double>(changes);
+    const std::byte* ramps = parser.column<std::uint8_t>(changes);
+    if (ticks == nullptr || bpms == nullptr || ramps == nullptr) {
+        return false;
+    }
+    TempoMap map(ticksPerQuarter);
+    std::int64_t previous = -1;
+    for (std::size_t i = 0; i < changes; ++i) {
+        const auto tick = loadLe<std::int64_t>(ticks + 8 * i);
+        const auto ramp = std::to_integer<std::uint8_t>(ramps[i]);
+        if ((i == 0 ? tick != 0 : tick <= previous) || ramp > 1
+            || !map.setTempo(tick, loadLe<double>(bpms + 8 * i), ramp != 0)) {
+            return false;
+        }
+        previous = tick;
+    }
+    out = map;
+    return true;
+}
+
+std::uint32_t readMagic(const std::filesystem::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    std::byte magic[4] {};
+    input.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    return input ? loadLe<std::uint32_t>(magic) : 0;
+}
+
+// NSX1: magic, note count, then PackedNote records in native byte order.
+bool loadV1(const std::filesystem::path& path, std::vector<PackedNote>& outNotes) {
+    std::ifstream input(path, std::ios::binary);
     std::uint32_t magic = 0;
     std::uint64_t count = 0;
     input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
     input.read(reinterpret_cast<char*>(&count), sizeof(count));
-    if (!input || magic != 0x4E535831) {
+    if (!input || magic != kMagicV1) {
         return false;
     }
+    // Checked against the file size so a corrupt count cannot force a huge allocation.
+    std::error_code error;
+    const auto fileBytes = std::filesystem::file_size(path, error);
+    const auto headerBytes = sizeof(magic) + sizeof(count);
+    if (error || fileBytes < headerBytes || (fileBytes - headerBytes) / sizeof(PackedNote) < count) {
+        return false;
+    }
+    outNotes.resize(static_cast<std::size_t>(count));
+    input.read(reinterpret_cast<char*>(outNotes.data()), static_cast<std::streamsize>(count * sizeof(PackedNote)));
+    return static_cast<bool>(input);
+}
 
+// Whether this reader understands `chunk`; unknown chunks are skipped unless required.
+bool known(const NsxChunk& chunk) noexcept {
+    const bool type = chunk.type == nsx::kMetadata || chunk.type == nsx::kPart || chunk.type == nsx::kNotes
+        || chunk.type == nsx::kMarkings || chunk.type == nsx::kLayoutHints || chunk.type == nsx::kMeters
+        || chunk.type == nsx::kTempos;
+    return type && chunk.version == 1;
+}
+
+// A voice has at most one NOTE and one MARK chunk. Readers that merged repeats
+// and readers that kept one would return different scores, so every reader
+// refuses them as corrupt.
+bool repeatsVoiceChunk(std::span<const NsxChunk> chunks) {
+    std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint16_t, std::uint16_t>> voices;
+    for (const auto& chunk : chunks) {
+        if (known(chunk) && (chunk.type == nsx::kNotes || chunk.type == nsx::kMarkings)) {
+            voices.emplace_back(chunk.type, chunk.part, chunk.staff, chunk.voice);
+        }
+    }
+    std::ranges::sort(voices);
+    return std::ranges::adjacent_find(voices) != voices.end();
+}
+
+struct HeaderFields {
+    std::uint16_t versionMinor {0};
+    std::uint32_t count {0};
+    std::uint64_t tableOffset {0};
+};
+
+// False for another format, a newer major version, a chunk table that does not
+// fit, or a recorded size other than `actualBytes`, which means a truncated or
+// appended-to file.
+bool parseHeader(const std::byte* header, std::uint64_t actualBytes, HeaderFields& out) noexcept {
+    if (loadLe<std::uint32_t>(header) != kMagicV2 || loadLe<std::uint16_t>(header + 4) != nsx::kVersionMajor) {
+        return false;
+    }
+    out = {.versionMinor = loadLe<std::uint16_t>(header + 6),
+        .count = loadLe<std::uint32_t>(header + 12),
+        .tableOffset = loadLe<std::uint64_t>(header + 16)};
+    const auto fileBytes = loadLe<std::uint64_t>(header + 24);
+    return actualBytes == fileBytes && out.tableOffset >= nsx::kHeaderBytes && out.tableOffset <= fileBytes
+        && (fileBytes - out.tableOffset) / nsx::kChunkEntryBytes >= out.count;
+}
+
+bool parseTable(const std::byte* table, std::uint32_t count, std::uint64_t fileBytes, std::vector<NsxChunk>& out) {
+    out.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::byte* entry = table + i * nsx::kChunkEntryBytes;
+        auto& chunk = out[i];
+        chunk = {.type = loadLe<std::uint32_t>(entry),
+            .version = loadLe<std::uint16_t>(entry + 4),
+            .flags = loadLe<std::uint16_t>(entry + 6),
+            .part = loadLe<std::uint32_t>(entry + 8),
+            .staff = loadLe<std::uint16_t>(entry + 12),
+            .voice = loadLe<std::uint16_t>(entry + 14),
+            .offset = loadLe<std::uint64_t>(entry + 16),
+            .bytes = loadLe<std::uint64_t>(entry + 24)};
+        if (chunk.offset > fileBytes || chunk.bytes > fileBytes - chunk.offset) {
+            out.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// A voice's notes and markings into an empty engine, with an empty history.
+// Fails when a tick does not fit a NoteEvent.
+bool copyVoice(const NsxNoteView& notes, std::span<const std::byte> markingBytes, NotationEngine& out) {
+    std::vector<NoteEvent> events;
+    std::vector<Marking> markings;
+    if (!notes.events(0, notes.size(), events) || (!markingBytes.empty() && !decodeMarkings(markingBytes, markings))) {
+        return false;
+    }
+    out.addNotes(events);
+    for (const auto& marking : markings) {
+        out.addMarking(marking);
+    }
+    out.clearUndoHistory();
+    return true;
+}
+
+// Typed view of a column inside a mapped chunk; empty when the column is not
+// aligned for T, which only a foreign writer produces.
+template <typename T>
+bool viewColumn(const std::byte* column, std::size_t count, std::span<const T>& out) noexcept {
+    if (reinterpret_cast<std::uintptr_t>(column) % alignof(T) != 0) {
+        return false;
+    }
+    out = {reinterpret_cast<const T*>(column), count};
+    return true;
+}
+
+} // namespace
+
+void NsxWriter::addChunk(NsxChunk chunk, std::vector<std::byte> payload) {
+    chunk.bytes = payload.size();
+    m_chunks.push_back(chunk);
+    m_payloads.push_back(std::move(payload));
+}
+
+bool NsxWriter::write(const std::filesystem::path& path) {
+    std::size_t cursor = align(nsx::kHeaderBytes + m_chunks.size() * nsx::kChunkEntryBytes);
+    for (auto& chunk : m_chunks) {
+        chunk.offset = cursor;
+        cursor = align(cursor + static_cast<std::size_t>(chunk.bytes));
+    }
+    const std::uint64_t fileBytes = m_chunks.empty() ? cursor : m_chunks.back().offset + m_chunks.back().bytes;
+
+    std::vector<std::byte> head(align(nsx::kHeaderBytes + m_chunks.size() * nsx::kChunkEntryBytes));
+    storeLe(head.data(), kMagicV2);
+    storeLe(head.data() + 4, nsx::kVersionMajor);
+    storeLe(head.data() + 6, nsx::kVersionMinor);
+    storeLe(head.data() + 8, static_cast<std::uint16_t>(nsx::kHeaderBytes));
+    storeLe(head.data() + 12, static_cast<std::uint32_t>(m_chunks.size()));
+    storeLe(head.data() + 16, static_cast<std::uint64_t>(nsx::kHeaderBytes));
+    storeLe(head.data() + 24, fileBytes);
+    for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+        std::byte* entry = head.data() + nsx::kHeaderBytes + i * nsx::kChunkEntryBytes;
+        const auto& chunk = m_chunks[i];
+        storeLe(entry, chunk.type);
+        storeLe(entry + 4, chunk.version);
+        storeLe(entry + 6, chunk.flags);
+        storeLe(entry + 8, chunk.part);
+        storeLe(entry + 12, chunk.staff);
+        storeLe(entry + 14, chunk.voice);
+        storeLe(entry + 16, chunk.offset);
+        storeLe(entry + 24, chunk.bytes);
+    }
+
+    // Written beside the target, synced and renamed over it, so the old file
+    // stays whole until the new one is on disk, even across a crash, and
+    // mappings of it never see a truncation.
+    auto temporary = path;
+    temporary += ".saving";
+    std::FILE* output = std::fopen(temporary.string().c_str(), "wb");
+    if (output == nullptr) {
+        return false;
+    }
+    bool written = std::fwrite(head.data(), 1, head.size(), output) == head.size();
+    static constexpr std::byte kPadding[nsx::kChunkAlignment] {};
+    for (std::size_t i = 0; written && i < m_chunks.size(); ++i) {
+        const auto& payload = m_payloads[i];
+        written = std::fwrite(payload.data(), 1, payload.size(), output) == payload.size();
+        if (written && i + 1 < m_chunks.size()) {
+            const std::size_t padding = align(payload.size()) - payload.size();
+            written = std::fwrite(kPadding, 1, padding, output) == padding;
+        }
+    }
+    written = written && syncToDisk(output);
+    written = std::fclose(output) == 0 && written;
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporary, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    // The rename itself is durable once the directory is.
+    return syncDirectory(path.parent_path());
+}
+
+bool NsxReader::open(const std::filesystem::path& path) {
+    m_chunks.clear();
+    m_input = std::ifstream(path, std::ios::binary);
+    std::byte header[nsx::kHeaderBytes] {};
+    std::error_code error;
+    const auto actualBytes = std::filesystem::file_size(path, error);
+    HeaderFields fields;
+    if (!m_input.read(reinterpret_cast<char*>(header), sizeof(header)) || error || !parseHeader(header, actualBytes, fields)) {
+        return false;
+    }
+    m_versionMinor = fields.versionMinor;
+
+    std::vector<std::byte> table(fields.count * nsx::kChunkEntryBytes);
+    m_input.seekg(static_cast<std::streamoff>(fields.tableOffset));
+    if (!m_input.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size()))) {
+        return false;
+    }
+    return parseTable(table.data(), fields.count, actualBytes, m_chunks);
+}
+
+bool NsxReader::readChunk(const NsxChunk& chunk, std::vector<std::byte>& out) {
+    out.resize(static_cast<std::size_t>(chunk.bytes));
+    m_input.clear();
+    m_input.seekg(static_cast<std::streamoff>(chunk.offset));
+    return static_cast<bool>(m_input.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size())));
+}
+
+bool NsxDocument::save(const std::filesystem::path& path, const notascore::notation::Score& score,
+    std::span<const NsxMetadataEntry> metadata) const {
+    NsxWriter writer;
+    writer.addChunk({.type = nsx::kMetadata}, encodeMetadata(metadata));
+    const NotationEngine* first = score.partCount() > 0 ? score.part(0).voice(0, 0) : nullptr;
+    writer.addChunk({.type = nsx::kLayoutHints}, encodeLayoutHints(first, score.layoutOptions()));
+    writer.addChunk({.type = nsx::kMeters}, encodeMeters(score.measureIndex()));
+    writer.addChunk({.type = nsx::kTempos}, encodeTempos(score.tempoMap()));
+    for (std::size_t p = 0; p < score.partCount(); ++p) {
+        const auto& part = score.part(p);
+        std::vector<std::uint32_t> voiceCounts(part.staffCount());
+        for (std::size_t s = 0; s < voiceCounts.size(); ++s) {
+            voiceCounts[s] = static_cast<std::uint32_t>(part.voiceCount(s));
+        }
+        const auto index = static_cast<std::uint32_t>(p);
+        writer.addChunk({.type = nsx::kPart, .flags = nsx::kRequired, .part = index},
+            encodePart(notascore::core::text(part.name()), notascore::core::text(part.range()), voiceCounts));
+        for (std::size_t s = 0; s < voiceCounts.size(); ++s) {
+            for (std::size_t v = 0; v < voiceCounts[s]; ++v) {
+                NsxChunk chunk {.type = nsx::kNotes, .flags = nsx::kRequired, .part = index,
+                    .staff = static_cast<std::uint16_t>(s), .voice = static_cast<std::uint16_t>(v)};
+                // Unloaded parts are saved from their packed notes without reloading them.
+                const auto* engine = part.voice(s, v);
+                writer.addChunk(chunk, engine != nullptr ? encodeNotes(engine->notes()) : encodeNotes(part.unloadedNotes(s, v)));
+                const auto markings = engine != nullptr ? engine->markings() : part.unloadedMarkings(s, v);
+                if (!markings.empty()) {
+                    chunk.type = nsx::kMarkings;
+                    writer.addChunk(chunk, encodeMarkings(markings));
+                }
+            }
+        }
+    }
+    return writer.write(path);
+}
+
+bool NsxDocument::load(const std::filesystem::path& path, notascore::notation::Score& score, NsxContents* contents) const {
+    NsxContents local;
+    NsxContents& out = contents != nullptr ? *contents : local;
+    out = {};
+    score.clear();
+
+    if (readMagic(path) == kMagicV1) {
+        std::vector<NoteEvent> notes;
+        if (!load(path, notes)) {
+            return false;
+        }
+        const int ticksPerQuarter = score.layoutOptions().ticksPerQuarter;
+        score.setMeasureIndex(MeasureIndex(ticksPerQuarter));
+        score.tempoMap() = TempoMap(ticksPerQuarter);
+        auto* voice = score.addPart(std::string_view {}, std::string_view {}).voice(0, 0);
+        voice->addNotes(notes);
+        voice->clearUndoHistory();
+        return true;
+    }
+
+    NsxReader reader;
+    if (!reader.open(path) || repeatsVoiceChunk(reader.chunks())) {
+        return false;
+    }
+    const auto fail = [&] {
+        score.clear();
+        return false;
+    };
+
+    // Score-wide chunks and parts first, so that voices exist whatever the chunk order.
+    std::vector<std::byte> bytes;
+    std::optional<MeasureIndex> measures;
+    std::optional<TempoMap> tempos;
+    for (const auto& chunk : reader.chunks()) {
+        if (!known(chunk)) {
+            if ((chunk.flags & nsx::kRequired) != 0) {
+                return fail();
+            }
+            ++out.skippedChunks;
+            continue;
+        }
+        if (chunk.type == nsx::kNotes || chunk.type == nsx::kMarkings) {
+            continue;
+        }
+        if (!reader.readChunk(chunk, bytes)) {
+            return fail();
+        }
+        if (chunk.type == nsx::kMetadata) {
+            if (!decodeMetadata(bytes, out.metadata)) {
+                return fail();
+            }
+        } else if (chunk.type == nsx::kLayoutHints) {
+            if (!decodeLayoutHints(bytes, out.layoutHints)) {
+                return fail();
+            }
+            auto options = score.layoutOptions();
+            options.ticksPerQuarter = out.layoutHints.ticksPerQuarter;
+            options.measureTicks = out.layoutHints.measureTicks;
+            score.setLayoutOptions(options);
+        } else if (chunk.type == nsx::kMeters) {
+            if (!decodeMeters(bytes, measures.emplace())) {
+                return fail();
+            }
+        } else if (chunk.type == nsx::kTempos) {
+            if (!decodeTempos(bytes, tempos.emplace())) {
+                return fail();
+            }
+        } else {
+            PartHeader header;
+            if (chunk.part != score.partCount() || !decodePart(bytes, header)) {
+                return fail();
+            }
+            auto& part = score.addPart(header.name, header.range, header.voiceCounts.size());
+            for (std::size_t s = 0; s < header.voiceCounts.size(); ++s) {
+                for (std::uint32_t v = 1; v < header.voiceCounts[s]; ++v) {
+                    part.addVoice(s);
+                }
+            }
+        }
+    }
+
+    score.setMeasureIndex(measures.value_or(MeasureIndex(out.layoutHints.ticksPerQuarter)));
+    score.tempoMap() = tempos.value_or(TempoMap(out.layoutHints.ticksPerQuarter));
+
+    std::vector<NoteEvent> notes;
+    std::vector<Marking> markings;
+    for (const auto& chunk : reader.chunks()) {
+        if (!known(chunk) || (chunk.type != nsx::kNotes && chunk.type != nsx::kMarkings)) {
+            continue;
+        }
+        NotationEngine* voice = chunk.part < score.partCount() ? score.part(chunk.part).voice(chunk.staff, chunk.voice) : nullptr;
+        if (voice == nullptr || !reader.readChunk(chunk, bytes)) {
+            return fail();
+        }
+        if (chunk.type == nsx::kNotes) {
+            if (!decodeNotes(bytes, notes)) {
+                return fail();
+            }
+            voice->addNotes(notes);
+        } else {
+            if (!decodeMarkings(bytes, markings)) {
+                return fail();
+            }
+            for (const auto& marking : markings) {
+                voice->addMarking(marking);
+            }
+        }
+        // An opened file starts with an empty history.
+        voice->clearUndoHistory();
+    }
+    return true;
+}
+
+bool NsxDocument::save(const std::filesystem::path& path, const NotationEngine& notation) const {
+    NsxWriter writer;
+    writer.addChunk({.type = nsx::kLayoutHints}, encodeLayoutHints(&notation, notation.layoutOptions()));
+    const std::uint32_t voices[] {1};
+    writer.addChunk({.type = nsx::kPart, .flags = nsx::kRequired, .part = 0}, encodePart({}, {}, voices));
+    writer.addChunk({.type = nsx::kNotes, .flags = nsx::kRequired, .part = 0}, encodeNotes(notation.notes()));
+    if (!notation.markings().empty()) {
+        writer.addChunk({.type = nsx::kMarkings, .flags = nsx::kRequired, .part = 0}, encodeMarkings(notation.markings()));
+    }
+    return writer.write(path);
+}
+
+bool NsxDocument::load(const std::filesystem::path& path, std::vector<PackedNote>& outNotes) const {
     outNotes.clear();
-    outNotes.resize(static_cast<std::size_t>(count));
+    if (readMagic(path) == kMagicV1) {
+        return loadV1(path, outNotes);
+    }
+    NsxReader reader;
+    if (!reader.open(path) || repeatsVoiceChunk(reader.chunks())) {
+        return false;
+    }
+    const auto chunks = reader.chunks();
+    const auto first = std::ranges::find_if(chunks, [](const NsxChunk& chunk) {
+        return chunk.type == nsx::kNotes && chunk.part == 0 && chunk.staff == 0 && chunk.voice == 0;
+    });
+    if (first == chunks.end()) {
+        return true;
+    }
+    std::vector<std::byte> bytes;
+    NoteColumns columns;
+    if (!known(*first) || !reader.readChunk(*first, bytes) || !decodeNotes(bytes, columns)) {
+        return false;
+    }
+    outNotes.resize(columns.count);
+    for (std::size_t i = 0; i < columns.count; ++i) {
+        outNotes[i] = {columns.tick(i), columns.duration(i), columns.pitch(i), columns.velocity(i)};
+    }
+    return true;
+}
+
+bool NsxDocument::load(const std::filesystem::path& path, std::vector<NoteEvent>& outNotes) const {
+    std::vector<PackedNote> packed;
+    if (!load(path, packed)) {
+        return false;
+    }
+    outNotes.clear();
+    outNotes.reserve(packed.size());
+    for (const auto& note : packed) {
+        const auto event = note.unpack();
+        if (!event || event->tick < 0) {
+            return false;
+        }
+        outNotes.push_back(*event);
+    }
+    return true;
+}
+
+std::size_t NsxNoteView::lowerBound(std::int64_t tick) const noexcept {
+    return static_cast<std::size_t>(std::ranges::lower_bound(ticks, tick) - ticks.begin());
+}
+
+bool NsxNoteView::events(std::size_t begin, std::size_t end, std::vector<NoteEvent>& out) const {
+    out.resize(end - begin);
+    std::int64_t previous = begin == 0 ? 0 : ticks[begin - 1];
+    for (std::size_t i = begin; i < end; ++i) {
+        const std::int64_t tick = ticks[i];
+        if (tick < previous || tick > std::numeric_limits<int>::max()) {
+            return false;
+        }
+        previous = tick;
+        out[i - begin] = {.tick = static_cast<int>(tick), .duration = durations[i], .midiPitch = pitches[i],
+            .velocity = velocities[i]};
+    }
+    return true;
+}
+
+bool NsxMappedDocument::open(const std::filesystem::path& path) {
+    close();
+    // Columns are little-endian on disk and are viewed as native integers.
+    if constexpr (std::endian::native != std::endian::little) {
+        return false;
+    }
+    const auto fail = [&] {
+        close();
+        return false;
+    };
+    HeaderFields fields;
+    std::vector<NsxChunk> chunks;
+    if (!m_file.open(path)) {
+        return false;
+    }
+    m_file.adviseRandomAccess();
+    const auto file = m_file.bytes();
+    if (file.size() < nsx::kHeaderBytes || !parseHeader(file.data(), file.size(), fields)
+        || !parseTable(file.data() + fields.tableOffset, fields.count, file.size(), chunks)
+        || repeatsVoiceChunk(chunks)) {
+        return fail();
+    }
+    const auto payload = [&](const NsxChunk& chunk) {
+        return file.subspan(static_cast<std::size_t>(chunk.offset), static_cast<std::size_t>(chunk.bytes));
+    };
+
+    // Same two passes as NsxDocument::load, except that notes stay where they are.
+    bool hasMeters = false;
+    bool hasTempos = false;
+    for (const auto& chunk : chunks) {
+        if (!known(chunk)) {
+            if ((chunk.flags & nsx::kRequired) != 0) {
+                return fail();
+            }
+            ++m_skippedChunks;
+            continue;
+        }
+        if (chunk.type == nsx::kMetadata) {
+            if (!decodeMetadata(payload(chunk), m_metadata)) {
+                return fail();
+            }
+        } else if (chunk.type == nsx::kLayoutHints) {
+            if (!decodeLayoutHints(payload(chunk), m_layoutHints)) {
+                return fail();
+            }
+        } else if (chunk.type == nsx::kMeters) {
+            if (!decodeMeters(payload(chunk), m_measureIndex)) {
+                return fail();
+            }
+            hasMeters = true;
+        } else if (chunk.type == nsx::kTempos) {
+            if (!decodeTempos(payload(chunk), m_tempoMap)) {
+                return fail();
+            }
+            hasTempos = true;
+        } else if (chunk.type == nsx::kPart) {
+            PartHeader header;
+            if (chunk.part != m_parts.size() || !decodePart(payload(chunk), header)) {
+                return fail();
+            }
+            MappedPart part {.name = header.name, .range = header.range, .staffFirstVoice = {m_voices.size()}};
+            for (const auto count : header.voiceCounts) {
+                part.staffFirstVoice.push_back(part.staffFirstVoice.back() + count);
+            }
+            m_voices.resize(part.staffFirstVoice.back());
+            m_parts.push_back(std::move(part));
+        }
+    }
+
+    if (!hasMeters) {
+        m_measureIndex = MeasureIndex(m_layoutHints.ticksPerQuarter);
+    }
+    if (!hasTempos) {
+        m_tempoMap = TempoMap(m_layoutHints.ticksPerQuarter);
+    }
+
+    std::vector<Marking> markings;
+    for (const auto& chunk : chunks) {
+        if (!known(chunk) || (chunk.type != nsx::kNotes && chunk.type != nsx::kMarkings)) {
+            continue;
+        }
+        const std::size_t index = indexOf(chunk.part, chunk.staff, chunk.voice);
+        if (index == m_voices.size()) {
+            return fail();
+        }
+        auto& voice = m_voices[index];
+        if (chunk.type == nsx::kMarkings) {
+            // Checked now so that a later edit cannot fail on them.
+            if (!decodeMarkings(payload(chunk), markings)) {
+                return fail();
+            }
+            voice.markings = payload(chunk);
+            continue;
+        }
+        NoteColumns columns;
+        if (!decodeNotes(payload(chunk), columns) || !viewColumn(columns.ticks, columns.count, voice.notes.ticks)
+            || !viewColumn(columns.durations, columns.count, voice.notes.durations)
+            || !viewColumn(columns.pitches, columns.count, voice.notes.pitches)
+            || !viewColumn(columns.velocities, columns.count, voice.notes.velocities)) {
+            return fail();
+        }
+        // A voice only takes ticks in [0, INT_MAX]. Only the ends are checked
+        // here, touching two pages; the order in between is checked by
+        // events() as notes are decoded.
+        const auto ticks = voice.notes.ticks;
+        if (!ticks.empty() && (ticks.front() < 0 || ticks.back() > std::numeric_limits<int>::max())) {
+            return fail();
+        }
+        voice.noteBytes = payload(chunk);
+        m_noteCount += columns.count;
+    }
+    return true;
+}
+
+void NsxMappedDocument::close() noexcept {
+    m_voices.clear();
+    m_parts.clear();
+    m_metadata.clear();
+    m_layoutHints = {};
+    m_measureIndex = MeasureIndex();
+    m_tempoMap = TempoMap();
+    m_noteCount = 0;
+    m_skippedChunks = 0;
+    m_file.close();
+}
+
+std::size_t NsxMappedDocument::indexOf(std::size_t part, std::size_t staff, std::size_t voice) const noexcept {
+    if (part >= m_parts.size() || staff >= staffCount(part) || voice >= voiceCount(part, staff)) {
+        return m_voices.size();
+    }
+    return m_parts[part].staffFirstVoice[staff] + voice;
+}
+
+NsxNoteView NsxMappedDocument::notes(std::size_t part, std::size_t staff, std::size_t voice) const noexcept {
+    const std::size_t index = indexOf(part, staff, voice);
+    return index < m_voices.size() ? m_voices[index].notes : NsxNoteView {};
+}
+
+bool NsxMappedDocument::markings(std::size_t part, std::size_t staff, std::size_t voice, std::vector<Marking>& out) const {
+    out.clear();
+    const std::size_t index = indexOf(part, staff, voice);
+    return index < m_voices.size() && (m_voices[index].markings.empty() || decodeMarkings(m_voices[index].markings, out));
+}
+
+void NsxMappedDocument::prefetch(std::size_t part, std::size_t staff, std::size_t voice) const noexcept {
+    const std::size_t index = indexOf(part, staff, voice);
+    if (index < m_voices.size()) {
+        m_file.prefetch(m_voices[index].noteBytes);
+    }
+}
+
+const NotationEngine* NsxMappedDocument::edited(std::size_t part, std::size_t staff, std::size_t voice) const noexcept {
+    const std::size_t index = indexOf(part, staff, voice);
+    return index < m_voices.size() ? m_voices[index].edited.get() : nullptr;
+}
+
+NotationEngine* NsxMappedDocument::edit(std::size_t part, std::size_t staff, std::size_t voice) {
+    const std::size_t index = indexOf(part, staff, voice);
+    if (index == m_voices.size()) {
+        return nullptr;
+    }
+    auto& mapped = m_voices[index];
+    if (mapped.edited == nullptr) {
+        auto engine = std::make_unique<NotationEngine>();
+        auto options = engine->layoutOptions();
+        options.ticksPerQuarter = m_layoutHints.ticksPerQuarter;
+        options.measureTicks = m_layoutHints.measureTicks;
+        engine->setLayoutOptions(options);
+        m_file.prefetch(mapped.noteBytes);
+        if (!copyVoice(mapped.notes, mapped.markings, *engine)) {
+            return nullptr;
+        }
+        mapped.edited = std::move(engine);
+    }
+    return mapped.edited.get();
+}
+
+bool NsxMappedDocument::promote(notascore::notation::Score& score) const {
+    score.clear();
+    auto options = score.layoutOptions();
+    options.ticksPerQuarter = m_layoutHints.ticksPerQuarter;
+    options.measureTicks = m_layoutHints.measureTicks;
+    score.setLayoutOptions(options);
+    score.setMeasureIndex(m_measureIndex);
+    score.tempoMap() = m_tempoMap;
+    for (const auto& voice : m_voices) {
+        if (voice.edited == nullptr) {
+            m_file.prefetch(voice.noteBytes);
+        }
+    }
+    for (std::size_t p = 0; p < m_parts.size(); ++p) {
+        auto& part = score.addPart(m_parts[p].name, m_parts[p].range, staffCount(p));
+        for (std::size_t s = 0; s < staffCount(p); ++s) {
+            for (std::size_t v = 1; v < voiceCount(p, s); ++v) {
+                part.addVoice(s);
+            }
+            for (std::size_t v = 0; v < voiceCount(p, s); ++v) {
+                const auto& mapped = m_voices[m_parts[p].staffFirstVoice[s] + v];
+                auto* target = part.voice(s, v);
+                if (mapped.edited == nullptr) {
+                    if (!copyVoice(mapped.notes, mapped.markings, *target)) {
+                        score.clear();
+                        return false;
+                    }
+                    continue;
+                }
+                target->addNotes(mapped.edited->notes());
+                for (const auto& marking : mapped.edited->markings()) {
+                    target->addMarking(marking);
+                }
+                target->clearUndoHistory();
+            }
+        }
+    }
     return true;
 }
 
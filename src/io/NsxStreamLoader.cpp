@@ -0,0 +1,223 @@
+#include "notascore/io/NsxStreamLoader.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace notascore::io {
+
+namespace {
+
+using notascore::notation::Marking;
+using notascore::notation::NoteEvent;
+
+// Large enough that a task outweighs its scheduling, small enough that progress
+// moves steadily and one publish never stalls a frame.
+constexpr std::size_t kSliceNotes = std::size_t {1} << 16;
+// Measures published first when the file has no page breaks saved.
+constexpr std::int64_t kFallbackMeasures = 32;
+
+std::int64_t firstPageEnd(const NsxLayoutHints& hints) {
+    const auto& pages = hints.pageFirstSystem;
+    const auto& systems = hints.systemFirstMeasure;
+    if (pages.size() == 1 && !systems.empty()) {
+        return std::numeric_limits<std::int64_t>::max();
+    }
+    const std::int64_t measures = pages.size() > 1 && pages[1] < systems.size() ? systems[pages[1]] : kFallbackMeasures;
+    return measures * hints.measureTicks;
+}
+
+} // namespace
+
+NsxStreamLoader::~NsxStreamLoader() {
+    cancel();
+}
+
+void NsxStreamLoader::cancel() {
+    m_cancelled = true;
+    std::unique_lock lock(m_mutex);
+    m_decodedSignal.wait(lock, [&] { return m_pendingTasks == 0; });
+}
+
+bool NsxStreamLoader::start(const std::filesystem::path& path, notascore::notation::Score& score,
+    notascore::core::TaskScheduler& scheduler, NsxContents* contents) {
+    cancel();
+    m_cancelled = false;
+    m_voices.clear();
+    m_slices.clear();
+    m_progress = {};
+    m_score = &score;
+    NsxContents local;
+    NsxContents& out = contents != nullptr ? *contents : local;
+
+    const auto loadWhole = [&] {
+        const bool loaded = NsxDocument {}.load(path, score, &out);
+        m_firstPageEnd = std::numeric_limits<std::int64_t>::max();
+        m_progress = {.loadedNotes = score.noteCount(), .totalNotes = score.noteCount()};
+        if (loaded) {
+            report();
+        }
+        return loaded;
+    };
+    if (!m_document.open(path)) {
+        return loadWhole();
+    }
+    const auto metadata = m_document.metadata();
+    out = {.metadata = {metadata.begin(), metadata.end()}, .layoutHints = m_document.layoutHints(),
+        .skippedChunks = m_document.skippedChunks()};
+    m_firstPageEnd = firstPageEnd(m_document.layoutHints());
+
+    score.clear();
+    auto options = score.layoutOptions();
+    options.ticksPerQuarter = m_document.layoutHints().ticksPerQuarter;
+    options.measureTicks = m_document.layoutHints().measureTicks;
+    score.setLayoutOptions(options);
+    score.setMeasureIndex(m_document.measureIndex());
+    score.tempoMap() = m_document.tempoMap();
+
+    // Parts and the first page of every voice, right away.
+    std::vector<NoteEvent> notes;
+    std::vector<Marking> markings;
+    for (std::size_t p = 0; p < m_document.partCount(); ++p) {
+        auto& part = score.addPart(m_document.partName(p), m_document.partRange(p), m_document.staffCount(p));
+        for (std::size_t s = 0; s < m_document.staffCount(p); ++s) {
+            for (std::size_t v = 1; v < m_document.voiceCount(p, s); ++v) {
+                part.addVoice(s);
+            }
+            for (std::size_t v = 0; v < m_document.voiceCount(p, s); ++v) {
+                Voice voice {.notes = m_document.notes(p, s, v), .part = score.partId(p), .staff = s, .voice = v,
+                    .nextSlice = m_slices.size()};
+                const std::size_t firstPage = voice.notes.lowerBound(m_firstPageEnd);
+                if (!voice.notes.events(0, firstPage, notes) || !m_document.markings(p, s, v, markings)) {
+                    // A full load sorts ticks out of order, and refuses what
+                    // it cannot read.
+                    m_voices.clear();
+                    m_slices.clear();
+                    m_document.close();
+                    return loadWhole();
+                }
+                auto* engine = part.voice(s, v);
+                engine->addNotes(notes);
+                for (const auto& marking : markings) {
+                    engine->addMarking(marking);
+                }
+                engine->clearUndoHistory();
+                m_progress.loadedNotes += firstPage;
+                for (std::size_t begin = firstPage; begin < voice.notes.size(); begin += kSliceNotes) {
+                    auto& slice = m_slices.emplace_back();
+                    slice.source = voice.notes;
+                    slice.begin = begin;
+                    slice.end = std::min(begin + kSliceNotes, voice.notes.size());
+                }
+                voice.endSlice = m_slices.size();
+                m_voices.push_back(voice);
+            }
+        }
+    }
+    m_progress.totalNotes = m_document.noteCount();
+
+    // The rest is read ahead from disk while the first page is drawn.
+    for (std::size_t p = 0; p < m_document.partCount(); ++p) {
+        for (std::size_t s = 0; s < m_document.staffCount(p); ++s) {
+            for (std::size_t v = 0; v < m_document.voiceCount(p, s); ++v) {
+                m_document.prefetch(p, s, v);
+            }
+        }
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_pendingTasks = m_slices.size();
+    }
+    for (std::size_t i = 0; i < m_slices.size(); ++i) {
+        scheduler.submit(notascore::core::TaskPriority::Background, [this, i] { decode(i); });
+    }
+    report();
+    if (m_slices.empty()) {
+        m_document.close();
+    }
+    return true;
+}
+
+void NsxStreamLoader::decode(std::size_t index) {
+    auto& slice = m_slices[index];
+    if (!m_cancelled) {
+        slice.ok = slice.source.events(slice.begin, slice.end, slice.notes);
+    }
+    std::lock_guard lock(m_mutex);
+    slice.decoded = true;
+    --m_pendingTasks;
+    m_decodedSignal.notify_all();
+}
+
+bool NsxStreamLoader::publishReady() {
+    if (m_progress.done()) {
+        return true;
+    }
+    bool progressed = false;
+    for (auto& voice : m_voices) {
+        auto* part = m_score->findPart(voice.part);
+        if (part == nullptr) {
+            progressed = progressed || voice.nextSlice < voice.endSlice;
+            drop(voice);
+            continue;
+        }
+        while (voice.nextSlice < voice.endSlice) {
+            auto& slice = m_slices[voice.nextSlice];
+            {
+                std::lock_guard lock(m_mutex);
+                if (!slice.decoded) {
+                    break;
+                }
+            }
+            if (!slice.ok) {
+                fail();
+                return true;
+            }
+            // Slices of a voice are published in order, so each one appends, and
+            // outside the undo history: edits made meanwhile stay undoable.
+            part->addLoadedNotes(voice.staff, voice.voice, slice.notes);
+            m_progress.loadedNotes += slice.notes.size();
+            slice.notes = {};
+            ++voice.nextSlice;
+            progressed = true;
+        }
+    }
+    if (progressed) {
+        report();
+    }
+    if (m_progress.done()) {
+        // Tasks of dropped slices may still run; none reads the views after this.
+        cancel();
+        m_document.close();
+    }
+    return m_progress.done();
+}
+
+void NsxStreamLoader::finish() {
+    {
+        std::unique_lock lock(m_mutex);
+        m_decodedSignal.wait(lock, [&] { return m_pendingTasks == 0; });
+    }
+    publishReady();
+}
+
+void NsxStreamLoader::drop(Voice& voice) {
+    for (; voice.nextSlice < voice.endSlice; ++voice.nextSlice) {
+        const auto& slice = m_slices[voice.nextSlice];
+        m_progress.totalNotes -= slice.end - slice.begin;
+    }
+}
+
+void NsxStreamLoader::fail() {
+    cancel();
+    m_document.close();
+    m_progress.failed = true;
+    report();
+}
+
+void NsxStreamLoader::report() {
+    if (m_progressCallback) {
+        m_progressCallback(m_progress);
+    }
+}
+
+} // namespace notascore::io
@@ -0,0 +1,66 @@
+#include "notascore/notation/Collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace notascore::notation {
+
+void SpatialGrid::reset(float originX, float originY, float width, float height, float cellSize) {
+    m_originX = originX;
+    m_originY = originY;
+    m_inverseCell = 1.0f / cellSize;
+    m_maxWidth = 0.0f;
+    m_maxHeight = 0.0f;
+    m_columns = std::max(1, static_cast<int>(std::ceil(width * m_inverseCell)));
+    m_rows = std::max(1, static_cast<int>(std::ceil(height * m_inverseCell)));
+    const auto cells = static_cast<std::size_t>(m_columns) * static_cast<std::size_t>(m_rows);
+    if (m_cellHead.size() != cells || ++m_generation == 0) {
+        m_cellHead.assign(cells, -1);
+        m_cellStamp.assign(cells, 0);
+        m_generation = 1;
+    }
+    m_next.clear();
+    m_boxes.clear();
+}
+
+// Clamping before truncation makes the int conversion a floor.
+int SpatialGrid::column(float x) const noexcept {
+    return static_cast<int>(std::clamp((x - m_originX) * m_inverseCell, 0.0f, static_cast<float>(m_columns - 1)));
+}
+
+int SpatialGrid::row(float y) const noexcept {
+    return static_cast<int>(std::clamp((y - m_originY) * m_inverseCell, 0.0f, static_cast<float>(m_rows - 1)));
+}
+
+const Box* SpatialGrid::firstOverlap(const Box& box) const noexcept {
+    // A box filed at its top-left corner can only reach `box` from cells up to
+    // one maximum extent above and to the left.
+    const int x0 = column(box.x0 - m_maxWidth);
+    const int x1 = column(box.x1);
+    const int y0 = row(box.y0 - m_maxHeight);
+    const int y1 = row(box.y1);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (auto entry = head(static_cast<std::size_t>(cy * m_columns + cx)); entry >= 0;
+                 entry = m_next[static_cast<std::size_t>(entry)]) {
+                const auto& other = m_boxes[static_cast<std::size_t>(entry)];
+                if (other.intersects(box)) {
+                    return &other;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void SpatialGrid::insert(const Box& box) {
+    const auto cell = static_cast<std::size_t>(row(box.y0) * m_columns + column(box.x0));
+    m_maxWidth = std::max(m_maxWidth, box.x1 - box.x0);
+    m_maxHeight = std::max(m_maxHeight, box.y1 - box.y0);
+    m_next.push_back(head(cell));
+    m_boxes.push_back(box);
+    m_cellHead[cell] = static_cast<std::int32_t>(m_boxes.size() - 1);
+    m_cellStamp[cell] = m_generation;
+}
+
+} // namespace notascore::notation
@@ -0,0 +1,50 @@
+#include "notascore/notation/EditHistory.hpp"
+
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <utility>
+
+namespace notascore::notation {
+
+EditHistory::EditHistory() : m_states(1), m_stamps(1, 0) {}
+
+void EditHistory::reset(DocumentSnapshot base) {
+    m_states.clear();
+    m_states.push_back(std::move(base));
+    m_stamps.assign(1, 0);
+    m_current = 0;
+}
+
+void EditHistory::push(DocumentSnapshot state, std::uint64_t stamp) {
+    m_states.erase(m_states.begin() + static_cast<std::ptrdiff_t>(m_current) + 1, m_states.end());
+    m_stamps.erase(m_stamps.begin() + static_cast<std::ptrdiff_t>(m_current) + 1, m_stamps.end());
+    m_states.push_back(std::move(state));
+    m_stamps.push_back(stamp);
+    if (m_states.size() > kMaxSteps) {
+        m_states.pop_front();
+        m_stamps.pop_front();
+    }
+    m_current = m_states.size() - 1;
+}
+
+void EditHistory::amend(const std::function<void(DocumentSnapshot&)>& change) {
+    for (auto& state : m_states) {
+        change(state);
+    }
+}
+
+const DocumentSnapshot* EditHistory::undo() noexcept {
+    if (!canUndo()) {
+        return nullptr;
+    }
+    return &m_states[--m_current];
+}
+
+const DocumentSnapshot* EditHistory::redo() noexcept {
+    if (!canRedo()) {
+        return nullptr;
+    }
+    return &m_states[++m_current];
+}
+
+} // namespace notascore::notation
@@ -0,0 +1,528 @@
+#include "notascore/notation/Layout.hpp"
+
+#include "notascore/notation/Collision.hpp"
+#include "notascore/notation/Glyphs.hpp"
+#include "notascore/notation/MeasureCache.hpp"
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+namespace notascore::notation::layout {
+
+namespace {
+
+// Diatonic step of each pitch class when spelled with sharps (C major).
+constexpr std::array<int, 12> kDiatonicStep {0, 0, 1, 1, 2, 3, 3, 4, 4, 5, 5, 6};
+// B4, the middle line of a treble staff.
+constexpr int kMiddleLineStep = 5 * 7 + 6;
+
+float staffOffset(int midiPitch) noexcept {
+    midiPitch = std::clamp(midiPitch, 0, 127);
+    const int octave = midiPitch / 12;
+    const int step = octave * 7 + kDiatonicStep[static_cast<std::size_t>(midiPitch % 12)];
+    return static_cast<float>(kMiddleLineStep - step) * 0.5f;
+}
+
+bool needsAccidental(int midiPitch) noexcept {
+    const int pitchClass = std::clamp(midiPitch, 0, 127) % 12;
+    return pitchClass == 1 || pitchClass == 3 || pitchClass == 6 || pitchClass == 8 || pitchClass == 10;
+}
+
+// Logarithmic duration spacing: doubling a duration adds a constant amount.
+float durationSpace(std::int64_t ticks, const LayoutOptions& options) noexcept {
+    const auto quarters = static_cast<float>(ticks) / static_cast<float>(options.ticksPerQuarter);
+    return options.spaceUnit * (1.0f + std::log2(1.0f + quarters));
+}
+
+std::uint64_t hashCombine(std::uint64_t hash, std::uint64_t value) noexcept {
+    return hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+}
+
+// Pitches are spelled with sharps (see kDiatonicStep), so accidentals take a sharp's width.
+constexpr float kAccidentalWidth = glyphs::width(Glyph::AccidentalSharp);
+constexpr float kAccidentalGap = 0.2f;
+constexpr float kCollisionCell = 2.0f;
+constexpr int kMaxPlacementSteps = 32;
+
+enum class Direction {
+    Left,
+    Up,
+    Down
+};
+
+struct Placement {
+    Box box;
+    Direction direction;
+};
+
+// Slides `placement` along its direction, jumping just past each obstacle,
+// until it no longer overlaps anything already in the grid; then claims the space.
+Box place(SpatialGrid& grid, Placement placement) {
+    constexpr float kPadding = 0.1f;
+    Box box = placement.box;
+    const Box* obstacle = grid.firstOverlap(box);
+    for (int step = 0; step < kMaxPlacementSteps && obstacle != nullptr; ++step) {
+        float dx = 0.0f;
+        float dy = 0.0f;
+        switch (placement.direction) {
+        case Direction::Left:
+            dx = obstacle->x0 - kPadding - box.x1;
+            break;
+        case Direction::Up:
+            dy = obstacle->y0 - kPadding - box.y1;
+            break;
+        case Direction::Down:
+            dy = obstacle->y1 + kPadding - box.y0;
+            break;
+        }
+        box = {.x0 = box.x0 + dx, .y0 = box.y0 + dy, .x1 = box.x1 + dx, .y1 = box.y1 + dy};
+        obstacle = grid.firstOverlap(box);
+    }
+    grid.insert(box);
+    return box;
+}
+
+// TeX-style demerits of a system with the given natural width. Justification
+// stretches measures in proportion to their natural width, so badness grows with
+// the cube of the stretch ratio; the line penalty favours fewer systems. The
+// final system stays ragged and only pays the line penalty.
+constexpr double kLinePenalty = 10.0;
+constexpr double kMaxBadness = 10000.0;
+
+double systemDemerits(double natural, double lineWidth, bool lastSystem) noexcept {
+    double badness = 0.0;
+    if (natural > lineWidth || natural <= 0.0) {
+        badness = kMaxBadness;
+    } else if (!lastSystem) {
+        const double ratio = (lineWidth - natural) / natural;
+        badness = std::min(100.0 * ratio * ratio * ratio, kMaxBadness);
+    }
+    const double demerits = kLinePenalty + badness;
+    return demerits * demerits;
+}
+
+} // namespace
+
+std::size_t measureCountFor(std::span<const NoteEvent> notes, const LayoutOptions& options) {
+    const std::int64_t measureTicks = options.measureTicks;
+    std::int64_t lastTick = 0;
+    for (const auto& note : notes) {
+        lastTick = std::max(lastTick, static_cast<std::int64_t>(note.tick) + std::max(note.duration, 1));
+    }
+    return static_cast<std::size_t>(std::max<std::int64_t>(1, (lastTick + measureTicks - 1) / measureTicks));
+}
+
+void indexMeasures(std::span<const NoteEvent> notes, const LayoutOptions& options, std::size_t first, std::size_t last,
+    LayoutResult& result) {
+    const std::int64_t measureTicks = options.measureTicks;
+    const auto firstNoteAt = [&](std::size_t measure, std::size_t from) {
+        const auto tick = static_cast<std::int64_t>(measure) * measureTicks;
+        return static_cast<std::size_t>(std::lower_bound(notes.begin() + static_cast<std::ptrdiff_t>(from), notes.end(), tick,
+            [](const NoteEvent& note, std::int64_t value) { return note.tick < value; }) - notes.begin());
+    };
+
+    std::size_t begin = firstNoteAt(first, 0);
+    for (std::size_t m = first; m < last; ++m) {
+        const std::size_t end = firstNoteAt(m + 1, begin);
+        result.measureFirstNote[m] = static_cast<std::uint32_t>(begin);
+        std::fill(result.noteMeasure.begin() + static_cast<std::ptrdiff_t>(begin),
+            result.noteMeasure.begin() + static_cast<std::ptrdiff_t>(end), static_cast<std::uint32_t>(m));
+        begin = end;
+    }
+}
+
+std::uint64_t measureContentKey(std::span<const NoteEvent> notes, const LayoutOptions& options, std::size_t measure,
+    std::size_t begin, std::size_t end) noexcept {
+    std::uint64_t hash = hashCombine(static_cast<std::uint64_t>(options.measureTicks),
+        static_cast<std::uint64_t>(options.ticksPerQuarter));
+    hash = hashCombine(hash, std::bit_cast<std::uint32_t>(options.spaceUnit));
+    hash = hashCombine(hash, std::bit_cast<std::uint32_t>(options.measurePadding));
+    const auto barline = static_cast<std::int64_t>(measure) * options.measureTicks;
+    for (std::size_t n = begin; n < end; ++n) {
+        const auto onset = static_cast<std::uint64_t>(notes[n].tick - barline);
+        hash = hashCombine(hash, (onset << 8) | static_cast<std::uint64_t>(std::clamp(notes[n].midiPitch, 0, 127)));
+    }
+    return hash;
+}
+
+void spaceMeasures(std::span<const NoteEvent> notes, const LayoutOptions& options, std::size_t first, std::size_t last,
+    LayoutResult& result, MeasureSpacing& spacing, MeasureCache* cache) {
+    const std::int64_t measureTicks = options.measureTicks;
+    for (std::size_t m = first; m < last; ++m) {
+        const std::size_t begin = result.measureFirstNote[m];
+        const std::size_t end = result.measureFirstNote[m + 1];
+        if (begin == end) {
+            spacing.naturalWidth[m] = options.emptyMeasureWidth;
+            continue;
+        }
+
+        const std::span<float> offsets(spacing.noteOffset.data() + begin, end - begin);
+        std::uint64_t key = 0;
+        if (cache != nullptr) {
+            key = measureContentKey(notes, options, m, begin, end);
+            if (cache->lookup(key, offsets, spacing.naturalWidth[m])) {
+                for (std::size_t n = begin; n < end; ++n) {
+                    result.noteY[n] = staffOffset(notes[n].midiPitch);
+                }
+                continue;
+            }
+        }
+
+        const auto measureEnd = static_cast<std::int64_t>(m + 1) * measureTicks;
+        float x = options.measurePadding;
+        std::size_t i = begin;
+        while (i < end) {
+            const std::int64_t onset = notes[i].tick;
+            std::size_t next = i;
+            int accidentals = 0;
+            while (next < end && notes[next].tick == onset) {
+                accidentals += needsAccidental(notes[next].midiPitch) ? 1 : 0;
+                ++next;
+            }
+            // Leave room for up to three accidental columns before the onset.
+            x += static_cast<float>(std::min(accidentals, 3)) * (kAccidentalWidth + kAccidentalGap);
+            for (std::size_t n = i; n < next; ++n) {
+                spacing.noteOffset[n] = x;
+                result.noteY[n] = staffOffset(notes[n].midiPitch);
+            }
+            const std::int64_t nextOnset = next < end ? static_cast<std::int64_t>(notes[next].tick) : measureEnd;
+            x += durationSpace(nextOnset - onset, options);
+            i = next;
+        }
+        spacing.naturalWidth[m] = x + options.measurePadding * 0.5f;
+        if (cache != nullptr) {
+            cache->insert(key, offsets, spacing.naturalWidth[m]);
+        }
+    }
+}
+
+std::vector<std::uint32_t> breakSystemsGreedy(std::span<const float> naturalWidths, float lineWidth) {
+    std::vector<std::uint32_t> breaks {0};
+    float used = 0.0f;
+    for (std::size_t m = 0; m < naturalWidths.size(); ++m) {
+        if (used > 0.0f && used + naturalWidths[m] > lineWidth) {
+            breaks.push_back(static_cast<std::uint32_t>(m));
+            used = 0.0f;
+        }
+        used += naturalWidths[m];
+    }
+    breaks.push_back(static_cast<std::uint32_t>(naturalWidths.size()));
+    return breaks;
+}
+
+RebreakResult rebreakSystemsGreedy(std::span<const float> naturalWidths, float lineWidth,
+    std::size_t firstSystem, std::size_t stableFrom, std::vector<std::uint32_t>& breaks) {
+    const std::size_t oldSystemCount = breaks.size() - 1;
+    std::vector<std::uint32_t> fresh;
+    float used = 0.0f;
+    for (std::size_t m = breaks[firstSystem]; m < naturalWidths.size(); ++m) {
+        if (used > 0.0f && used + naturalWidths[m] > lineWidth) {
+            if (m >= stableFrom) {
+                // Only interior entries are real system starts; the last one is the old end.
+                const auto interiorEnd = breaks.end() - 1;
+                const auto match = std::lower_bound(breaks.begin() + static_cast<std::ptrdiff_t>(firstSystem) + 1,
+                    interiorEnd, static_cast<std::uint32_t>(m));
+                if (match != interiorEnd && *match == m) {
+                    const auto rejoined = static_cast<std::size_t>(match - breaks.begin());
+                    breaks.erase(breaks.begin() + static_cast<std::ptrdiff_t>(firstSystem) + 1, match);
+                    breaks.insert(breaks.begin() + static_cast<std::ptrdiff_t>(firstSystem) + 1, fresh.begin(), fresh.end());
+                    const auto delta = static_cast<std::ptrdiff_t>(fresh.size() + firstSystem + 1)
+                        - static_cast<std::ptrdiff_t>(rejoined);
+                    return {.firstSystem = firstSystem, .lastSystem = firstSystem + fresh.size() + 1, .systemDelta = delta};
+                }
+            }
+            fresh.push_back(static_cast<std::uint32_t>(m));
+            used = 0.0f;
+        }
+        used += naturalWidths[m];
+    }
+
+    breaks.resize(firstSystem + 1);
+    breaks.insert(breaks.end(), fresh.begin(), fresh.end());
+    breaks.push_back(static_cast<std::uint32_t>(naturalWidths.size()));
+    const std::size_t systemCount = breaks.size() - 1;
+    return {.firstSystem = firstSystem,
+        .lastSystem = systemCount,
+        .systemDelta = static_cast<std::ptrdiff_t>(systemCount) - static_cast<std::ptrdiff_t>(oldSystemCount)};
+}
+
+std::vector<std::uint32_t> breakSystemsOptimal(std::span<const float> naturalWidths, float lineWidth,
+    std::size_t fromMeasure, LineBreakState& state, std::size_t stableFrom) {
+    const std::size_t count = naturalWidths.size();
+    const std::size_t from = state.cost.empty() ? 0 : std::min({fromMeasure, count, state.cost.size() - 1});
+    // Entries past `stableFrom` can only be reused when the measure count did not change.
+    if (state.cost.size() != count + 1) {
+        stableFrom = count;
+    }
+    auto& prefix = state.prefixWidth;
+    auto& cost = state.cost;
+    auto& previous = state.previous;
+    prefix.resize(count + 1);
+    cost.resize(count + 1);
+    previous.resize(count + 1);
+    prefix[0] = cost[0] = 0.0;
+    previous[0] = 0;
+    for (std::size_t m = from; m < count; ++m) {
+        prefix[m + 1] = prefix[m] + static_cast<double>(naturalWidths[m]);
+    }
+
+    // Candidate starts of a system ending before measure `end`: every start whose
+    // measures still fit, and always the previous measure on its own.
+    const double width = lineWidth;
+    const auto bestStart = [&](std::size_t end, bool lastSystem, double& best) {
+        const auto fits = std::lower_bound(prefix.begin(), prefix.begin() + static_cast<std::ptrdiff_t>(end - 1),
+            prefix[end] - width);
+        std::size_t start = end - 1;
+        best = cost[start] + systemDemerits(prefix[end] - prefix[start], width, lastSystem);
+        for (auto i = static_cast<std::size_t>(fits - prefix.begin()); i + 1 < end; ++i) {
+            const double demerits = cost[i] + systemDemerits(prefix[end] - prefix[i], width, lastSystem);
+            if (demerits < best) {
+                best = demerits;
+                start = i;
+            }
+        }
+        return start;
+    };
+
+    // cost[m] never depends on the final system, so appending measures leaves it valid.
+    // Past `stableFrom`, systems keep their demerits, so once every candidate start
+    // of the next system has moved by the same amount, later systems pick the same
+    // starts as before and their costs only move by that amount too.
+    constexpr std::size_t kNoRun = std::numeric_limits<std::size_t>::max();
+    std::size_t runStart = kNoRun;
+    double shift = 0.0;
+    for (std::size_t end = std::max<std::size_t>(from, 1); end <= count; ++end) {
+        const double oldCost = cost[end];
+        previous[end] = static_cast<std::uint32_t>(bestStart(end, false, cost[end]));
+        if (end < stableFrom || end == count) {
+            continue;
+        }
+        const double delta = cost[end] - oldCost;
+        if (runStart == kNoRun || std::abs(delta - shift) > 1e-12 * std::max(1.0, std::abs(cost[end]))) {
+            runStart = end;
+            shift = delta;
+        }
+        const auto nextFits = std::lower_bound(prefix.begin(), prefix.begin() + static_cast<std::ptrdiff_t>(end),
+            prefix[end + 1] - width);
+        if (runStart <= static_cast<std::size_t>(nextFits - prefix.begin())) {
+            for (std::size_t m = end + 1; m <= count; ++m) {
+                cost[m] += shift;
+            }
+            break;
+        }
+    }
+
+    std::vector<std::uint32_t> breaks {static_cast<std::uint32_t>(count)};
+    if (count == 0) {
+        breaks.push_back(0);
+        return breaks;
+    }
+    double total = 0.0;
+    for (std::size_t m = bestStart(count, true, total); m > 0; m = previous[m]) {
+        breaks.push_back(static_cast<std::uint32_t>(m));
+    }
+    breaks.push_back(0);
+    std::reverse(breaks.begin(), breaks.end());
+    return breaks;
+}
+
+RebreakResult diffBreaks(std::span<const std::uint32_t> old, std::span<const std::uint32_t> fresh,
+    std::size_t dirtyFirst, std::size_t dirtyLast) {
+    const std::size_t common = std::min(old.size(), fresh.size());
+    std::size_t prefix = 0;
+    while (prefix < common && old[prefix] == fresh[prefix]) {
+        ++prefix;
+    }
+    std::size_t suffix = 0;
+    while (suffix < common - prefix && old[old.size() - 1 - suffix] == fresh[fresh.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    // A system is unchanged when both of its bounds lie in the common prefix or
+    // suffix; identical breaks leave only the dirty systems.
+    const std::size_t systemCount = fresh.size() - 1;
+    const bool identical = prefix == old.size() && old.size() == fresh.size();
+    std::size_t first = identical ? systemCount : (prefix > 0 ? prefix - 1 : 0);
+    std::size_t last = identical ? 0 : std::min(systemCount, systemCount + 1 - suffix);
+    if (dirtyFirst < dirtyLast) {
+        const auto systemOf = [&](std::size_t measure) {
+            const auto it = std::upper_bound(fresh.begin(), fresh.end() - 1, static_cast<std::uint32_t>(measure));
+            return static_cast<std::size_t>(it - fresh.begin()) - 1;
+        };
+        first = std::min(first, systemOf(dirtyFirst));
+        last = std::max(last, std::min(systemCount, systemOf(dirtyLast - 1) + 1));
+    }
+    last = std::max(first, last);
+    return {.firstSystem = first,
+        .lastSystem = last,
+        .systemDelta = static_cast<std::ptrdiff_t>(fresh.size()) - static_cast<std::ptrdiff_t>(old.size())};
+}
+
+namespace {
+
+template <bool kNotes>
+void justify(const LayoutOptions& options, const MeasureSpacing& spacing, std::size_t first, std::size_t last,
+    LayoutResult& result) {
+    const std::size_t systemCount = result.systemFirstMeasure.size() - 1;
+    for (std::size_t s = first; s < last; ++s) {
+        const std::size_t mBegin = result.systemFirstMeasure[s];
+        const std::size_t mEnd = result.systemFirstMeasure[s + 1];
+
+        float natural = 0.0f;
+        for (std::size_t m = mBegin; m < mEnd; ++m) {
+            natural += spacing.naturalWidth[m];
+        }
+        // The final system stays ragged unless it is already nearly full.
+        const bool lastSystem = s + 1 == systemCount;
+        const float lineWidth = options.lineWidth();
+        const float stretch = natural <= 0.0f || (lastSystem && natural < lineWidth * 0.75f) ? 1.0f : lineWidth / natural;
+
+        float x = options.marginX;
+        for (std::size_t m = mBegin; m < mEnd; ++m) {
+            const float width = spacing.naturalWidth[m] * stretch;
+            result.measureX[m] = x;
+            result.measureWidth[m] = width;
+            result.measureSystem[m] = static_cast<std::uint32_t>(s);
+            if constexpr (kNotes) {
+                for (std::size_t n = result.measureFirstNote[m]; n < result.measureFirstNote[m + 1]; ++n) {
+                    result.noteX[n] = x + spacing.noteOffset[n] * stretch;
+                }
+            }
+            x += width;
+        }
+    }
+}
+
+} // namespace
+
+void justifySystems(const LayoutOptions& options, const MeasureSpacing& spacing, std::size_t first, std::size_t last,
+    LayoutResult& result) {
+    justify<true>(options, spacing, first, last, result);
+}
+
+void justifyMeasures(const LayoutOptions& options, const MeasureSpacing& spacing, std::size_t first, std::size_t last,
+    LayoutResult& result) {
+    justify<false>(options, spacing, first, last, result);
+}
+
+void resolveCollisions(std::span<const NoteEvent> notes, std::span<const Marking> markings, const LayoutOptions& options,
+    std::size_t first, std::size_t last, LayoutResult& result) {
+    const std::int64_t measureTicks = options.measureTicks;
+    SpatialGrid grid;
+    for (std::size_t s = first; s < last; ++s) {
+        auto& items = result.systemItems[s];
+        items.clear();
+        grid.reset(options.marginX - 16.0f, -1.5f * options.systemHeight, options.lineWidth() + 32.0f,
+            3.0f * options.systemHeight, kCollisionCell);
+
+        const std::size_t mBegin = result.systemFirstMeasure[s];
+        const std::size_t mEnd = result.systemFirstMeasure[s + 1];
+        const std::size_t nBegin = result.measureFirstNote[mBegin];
+        const std::size_t nEnd = result.measureFirstNote[mEnd];
+
+        // Noteheads are fixed obstacles.
+        for (std::size_t n = nBegin; n < nEnd; ++n) {
+            const float x = result.noteX[n];
+            const float y = result.noteY[n];
+            grid.insert(glyphs::layoutBox(Glyph::NoteheadBlack, x, y));
+        }
+
+        // Accidentals stack leftwards, in storage order.
+        for (std::size_t n = nBegin; n < nEnd; ++n) {
+            if (!needsAccidental(notes[n].midiPitch)) {
+                continue;
+            }
+            const float x1 = result.noteX[n] - kAccidentalGap;
+            const float y = result.noteY[n];
+            const auto box = place(grid,
+                {.box = glyphs::layoutBox(Glyph::AccidentalSharp, x1 - kAccidentalWidth, y), .direction = Direction::Left});
+            items.push_back({.x = box.x0, .y = box.y0, .width = box.x1 - box.x0, .height = box.y1 - box.y0,
+                .owner = static_cast<std::uint32_t>(n - nBegin), .kind = LayoutItemKind::Accidental});
+        }
+
+        // Markings move away from the staff: articulations up, dynamics and lyrics down.
+        const auto startTick = static_cast<std::int64_t>(mBegin) * measureTicks;
+        const auto endTick = static_cast<std::int64_t>(mEnd) * measureTicks;
+        const auto byTick = [](const Marking& marking, std::int64_t tick) { return marking.tick < tick; };
+        const auto kBegin = static_cast<std::size_t>(std::lower_bound(markings.begin(), markings.end(), startTick, byTick) - markings.begin());
+        const auto kEnd = static_cast<std::size_t>(std::lower_bound(markings.begin(), markings.end(), endTick, byTick) - markings.begin());
+        for (std::size_t k = kBegin; k < kEnd; ++k) {
+            const auto& marking = markings[k];
+            const auto onset = std::lower_bound(notes.begin() + static_cast<std::ptrdiff_t>(nBegin),
+                notes.begin() + static_cast<std::ptrdiff_t>(nEnd), static_cast<std::int64_t>(marking.tick),
+                [](const NoteEvent& note, std::int64_t tick) { return note.tick < tick; });
+            const auto onsetIndex = static_cast<std::size_t>(onset - notes.begin());
+            float x = 0.0f;
+            if (onsetIndex < nEnd && onset->tick == marking.tick) {
+                x = result.noteX[onsetIndex];
+            } else {
+                const auto measure = static_cast<std::size_t>(marking.tick / measureTicks);
+                const auto fraction = static_cast<float>(marking.tick - static_cast<std::int64_t>(measure) * measureTicks)
+                    / static_cast<float>(measureTicks);
+                x = result.measureX[measure] + fraction * result.measureWidth[measure];
+            }
+
+            Placement placement {};
+            LayoutItemKind kind = LayoutItemKind::Articulation;
+            switch (marking.kind) {
+            case MarkingKind::Articulation:
+                placement = {.box = {.x0 = x, .y0 = -3.5f, .x1 = x + marking.width, .y1 = -2.5f}, .direction = Direction::Up};
+                break;
+            case MarkingKind::Dynamic:
+                kind = LayoutItemKind::Dynamic;
+                placement = {.box = {.x0 = x, .y0 = 3.0f, .x1 = x + marking.width, .y1 = 4.6f}, .direction = Direction::Down};
+                break;
+            case MarkingKind::Lyric:
+                kind = LayoutItemKind::Lyric;
+                placement = {.box = {.x0 = x, .y0 = 5.5f, .x1 = x + marking.width, .y1 = 6.9f}, .direction = Direction::Down};
+                break;
+            }
+            const auto box = place(grid, placement);
+            items.push_back({.x = box.x0, .y = box.y0, .width = box.x1 - box.x0, .height = box.y1 - box.y0,
+                .owner = static_cast<std::uint32_t>(k - kBegin), .kind = kind});
+        }
+    }
+}
+
+void paginate(const LayoutOptions& options, LayoutResult& result) {
+    const std::size_t systemCount = result.systemFirstMeasure.size() - 1;
+    const float usable = options.pageHeight - options.marginTop - options.marginBottom;
+    const auto perPage = static_cast<std::size_t>(
+        std::max(1.0f, std::floor((usable + options.minSystemGap) / (options.systemHeight + options.minSystemGap))));
+
+    result.systemPage.resize(systemCount);
+    result.pageFirstSystem.clear();
+    for (std::size_t s = 0; s < systemCount; ++s) {
+        if (s % perPage == 0) {
+            result.pageFirstSystem.push_back(static_cast<std::uint32_t>(s));
+        }
+        result.systemPage[s] = static_cast<std::uint32_t>(s / perPage);
+    }
+    result.pageFirstSystem.push_back(static_cast<std::uint32_t>(systemCount));
+}
+
+void stackPages(const LayoutOptions& options, std::size_t first, std::size_t last, LayoutResult& result) {
+    const std::size_t pageCount = result.pageCount();
+    const float usable = options.pageHeight - options.marginTop - options.marginBottom;
+    for (std::size_t p = first; p < last; ++p) {
+        const std::size_t sBegin = result.pageFirstSystem[p];
+        const std::size_t sEnd = result.pageFirstSystem[p + 1];
+        const auto count = static_cast<float>(sEnd - sBegin);
+
+        // Full pages spread their systems over the whole page; the last page keeps minimum gaps.
+        float gap = options.minSystemGap;
+        if (p + 1 < pageCount && sEnd - sBegin > 1) {
+            gap = (usable - count * options.systemHeight) / (count - 1.0f);
+        }
+
+        const float pageTop = static_cast<float>(p) * options.pageHeight;
+        for (std::size_t s = sBegin; s < sEnd; ++s) {
+            result.systemY[s] = pageTop + options.marginTop + static_cast<float>(s - sBegin) * (options.systemHeight + gap);
+        }
+    }
+}
+
+} // namespace notascore::notation::layout
@@ -0,0 +1,182 @@
+#include "notascore/notation/MeasureCache.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace notascore::notation {
+
+std::size_t MeasureCache::Shard::bucketOf(std::uint64_t key) const noexcept {
+    // Keys are already hashes; fold the high bits in for small tables.
+    return static_cast<std::size_t>(key ^ (key >> 32)) & (buckets.size() - 1);
+}
+
+std::uint32_t MeasureCache::Shard::find(std::uint64_t key) const noexcept {
+    if (buckets.empty()) {
+        return kNone;
+    }
+    const std::size_t mask = buckets.size() - 1;
+    for (std::size_t bucket = bucketOf(key);; bucket = (bucket + 1) & mask) {
+        const std::uint32_t slot = buckets[bucket];
+        if (slot == kNone) {
+            return kNone;
+        }
+        if (slots[slot].key == key) {
+            return static_cast<std::uint32_t>(bucket);
+        }
+    }
+}
+
+// Backward-shift deletion keeps probe chains unbroken without tombstones.
+void MeasureCache::Shard::eraseBucket(std::size_t bucket) noexcept {
+    const std::size_t mask = buckets.size() - 1;
+    std::size_t hole = bucket;
+    for (std::size_t next = (hole + 1) & mask; buckets[next] != kNone; next = (next + 1) & mask) {
+        const std::size_t home = bucketOf(slots[buckets[next]].key);
+        // Move the entry into the hole unless its home lies cyclically in (hole, next].
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            buckets[hole] = buckets[next];
+            hole = next;
+        }
+    }
+    buckets[hole] = kNone;
+}
+
+void MeasureCache::Shard::unlink(std::uint32_t slot) noexcept {
+    Slot& entry = slots[slot];
+    (entry.newer == kNone ? newest : slots[entry.newer].older) = entry.older;
+    (entry.older == kNone ? oldest : slots[entry.older].newer) = entry.newer;
+    entry.newer = entry.older = kNone;
+}
+
+void MeasureCache::Shard::pushNewest(std::uint32_t slot) noexcept {
+    Slot& entry = slots[slot];
+    entry.newer = kNone;
+    entry.older = newest;
+    (newest == kNone ? oldest : slots[newest].newer) = slot;
+    newest = slot;
+}
+
+void MeasureCache::Shard::reset(std::size_t capacity) {
+    slots.clear();
+    slots.resize(capacity);
+    // At most half full, so probe chains stay short.
+    buckets.assign(capacity == 0 ? 0 : std::bit_ceil(capacity * 2), kNone);
+    size = 0;
+    newest = oldest = kNone;
+}
+
+bool MeasureCache::lookup(std::uint64_t key, std::span<float> noteOffset, float& naturalWidth) {
+    Shard& shard = shardOf(key);
+    const std::lock_guard lock(shard.mutex);
+    const std::uint32_t bucket = shard.find(key);
+    if (bucket == kNone || shard.slots[shard.buckets[bucket]].noteOffset.size() != noteOffset.size()) {
+        ++shard.misses;
+        return false;
+    }
+    const std::uint32_t slot = shard.buckets[bucket];
+    if (slot != shard.newest) {
+        shard.unlink(slot);
+        shard.pushNewest(slot);
+    }
+    const Slot& entry = shard.slots[slot];
+    std::copy(entry.noteOffset.begin(), entry.noteOffset.end(), noteOffset.begin());
+    naturalWidth = entry.naturalWidth;
+    ++shard.hits;
+    return true;
+}
+
+void MeasureCache::insert(std::uint64_t key, std::span<const float> noteOffset, float naturalWidth) {
+    Shard& shard = shardOf(key);
+    const std::lock_guard lock(shard.mutex);
+    if (shard.slots.empty()) {
+        return;
+    }
+    std::uint32_t slot = kNone;
+    if (const std::uint32_t bucket = shard.find(key); bucket != kNone) {
+        // Another chunk spaced the same content concurrently, or the note counts differed.
+        slot = shard.buckets[bucket];
+        shard.unlink(slot);
+    } else {
+        if (shard.size < shard.slots.size()) {
+            slot = static_cast<std::uint32_t>(shard.size++);
+        } else {
+            slot = shard.oldest;
+            shard.eraseBucket(shard.find(shard.slots[slot].key));
+            shard.unlink(slot);
+        }
+        const std::size_t mask = shard.buckets.size() - 1;
+        std::size_t free = shard.bucketOf(key);
+        while (shard.buckets[free] != kNone) {
+            free = (free + 1) & mask;
+        }
+        shard.buckets[free] = slot;
+    }
+    Slot& entry = shard.slots[slot];
+    entry.key = key;
+    entry.naturalWidth = naturalWidth;
+    entry.noteOffset.assign(noteOffset.begin(), noteOffset.end());
+    shard.pushNewest(slot);
+}
+
+void MeasureCache::clear() {
+    for (auto& shard : m_shards) {
+        const std::lock_guard lock(shard.mutex);
+        std::fill(shard.buckets.begin(), shard.buckets.end(), kNone);
+        for (auto& entry : shard.slots) {
+            entry.newer = entry.older = kNone;
+        }
+        shard.size = 0;
+        shard.newest = shard.oldest = kNone;
+    }
+}
+
+void MeasureCache::setCapacity(std::size_t capacity) {
+    for (std::size_t s = 0; s < kShards; ++s) {
+        const std::lock_guard lock(m_shards[s].mutex);
+        m_shards[s].reset(capacity / kShards + (s < capacity % kShards ? 1 : 0));
+    }
+    m_capacity = capacity;
+}
+
+std::size_t MeasureCache::size() const {
+    std::size_t total = 0;
+    for (const auto& shard : m_shards) {
+        const std::lock_guard lock(shard.mutex);
+        total += shard.size;
+    }
+    return total;
+}
+
+std::uint64_t MeasureCache::hits() const {
+    std::uint64_t total = 0;
+    for (const auto& shard : m_shards) {
+        const std::lock_guard lock(shard.mutex);
+        total += shard.hits;
+    }
+    return total;
+}
+
+std::uint64_t MeasureCache::misses() const {
+    std::uint64_t total = 0;
+    for (const auto& shard : m_shards) {
+        const std::lock_guard lock(shard.mutex);
+        total += shard.misses;
+    }
+    return total;
+}
+
+double MeasureCache::hitRate() const {
+    const std::uint64_t hitCount = hits();
+    const std::uint64_t lookups = hitCount + misses();
+    return lookups == 0 ? 0.0 : static_cast<double>(hitCount) / static_cast<double>(lookups);
+}
+
+void MeasureCache::resetStats() {
+    for (auto& shard : m_shards) {
+        const std::lock_guard lock(shard.mutex);
+        shard.hits = 0;
+        shard.misses = 0;
+    }
+}
+
+} // namespace notascore::notation
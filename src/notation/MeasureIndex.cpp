@@ -0,0 +1,119 @@
+#include "notascore/notation/MeasureIndex.hpp"
+
+#include <algorithm>
+
+namespace notascore::notation {
+
+namespace {
+
+// Bars must be a whole, positive number of ticks.
+bool fitsTicks(Meter meter, int ticksPerQuarter) noexcept {
+    return meter.beats > 0 && meter.beatUnit > 0
+        && static_cast<Tick>(meter.beats) * 4 * ticksPerQuarter % meter.beatUnit == 0;
+}
+
+// Index of the last element not greater than `value` (0 if none), branch-free.
+template <typename T>
+std::size_t lastNotAbove(const std::vector<T>& starts, T value) noexcept {
+    const T* base = starts.data();
+    for (std::size_t length = starts.size(); length > 1;) {
+        const std::size_t half = length / 2;
+        base = base[half] <= value ? base + half : base;
+        length -= half;
+    }
+    return static_cast<std::size_t>(base - starts.data());
+}
+
+} // namespace
+
+MeasureIndex::MeasureIndex(int ticksPerQuarter, Meter meter) : m_ticksPerQuarter(std::max(ticksPerQuarter, 1)) {
+    if (!fitsTicks(meter, m_ticksPerQuarter)) {
+        meter = {.beats = 4, .beatUnit = 4};
+    }
+    m_runs.push_back({.barTicks = meter.barTicks(m_ticksPerQuarter), .meter = meter});
+    updateAfter(0);
+}
+
+std::size_t MeasureIndex::runOfBar(std::uint32_t bar) const noexcept {
+    return lastNotAbove(m_firstBars, bar);
+}
+
+void MeasureIndex::updateAfter(std::size_t run) {
+    for (std::size_t r = run + 1; r < m_runs.size(); ++r) {
+        const auto& previous = m_runs[r - 1];
+        m_runs[r].startTick = previous.startTick + static_cast<Tick>(m_runs[r].firstBar - previous.firstBar) * previous.barTicks;
+    }
+    m_firstBars.resize(m_runs.size());
+    m_startTicks.resize(m_runs.size());
+    for (std::size_t r = 0; r < m_runs.size(); ++r) {
+        m_firstBars[r] = m_runs[r].firstBar;
+        m_startTicks[r] = m_runs[r].startTick;
+    }
+}
+
+bool MeasureIndex::setMeter(std::uint32_t bar, Meter meter) {
+    if (!fitsTicks(meter, m_ticksPerQuarter) || (m_pickup > 0 && bar == 0)) {
+        return false;
+    }
+    std::size_t run = runOfBar(bar);
+    if (m_runs[run].firstBar != bar) {
+        const auto& previous = m_runs[run];
+        const Run inserted {.firstBar = bar,
+            .startTick = previous.startTick + static_cast<Tick>(bar - previous.firstBar) * previous.barTicks};
+        m_runs.insert(m_runs.begin() + static_cast<std::ptrdiff_t>(++run), inserted);
+    }
+    m_runs[run].meter = meter;
+    m_runs[run].barTicks = meter.barTicks(m_ticksPerQuarter);
+    updateAfter(run);
+    return true;
+}
+
+bool MeasureIndex::removeMeter(std::uint32_t bar) {
+    const std::size_t run = runOfBar(bar);
+    const std::size_t first = m_pickup > 0 ? 1 : 0;
+    if (run <= first || m_runs[run].firstBar != bar) {
+        return false;
+    }
+    m_runs.erase(m_runs.begin() + static_cast<std::ptrdiff_t>(run));
+    updateAfter(run - 1);
+    return true;
+}
+
+bool MeasureIndex::setPickup(Tick ticks) {
+    if (ticks < 0) {
+        return false;
+    }
+    if ((ticks > 0) != (m_pickup > 0)) {
+        // Adding or removing the pickup renumbers every full bar.
+        for (auto& run : m_runs) {
+            run.firstBar = ticks > 0 ? run.firstBar + 1 : run.firstBar - 1;
+        }
+        if (ticks > 0) {
+            m_runs.insert(m_runs.begin(), {.firstBar = 0, .meter = m_runs.front().meter});
+        } else {
+            m_runs.erase(m_runs.begin());
+        }
+    }
+    m_pickup = ticks;
+    if (ticks > 0) {
+        m_runs.front().barTicks = ticks;
+    }
+    m_runs.front().startTick = 0;
+    updateAfter(0);
+    return true;
+}
+
+std::uint32_t MeasureIndex::barAt(Tick tick) const noexcept {
+    if (tick <= 0) {
+        return 0;
+    }
+    const auto& run = m_runs[lastNotAbove(m_startTicks, tick)];
+    return run.firstBar + static_cast<std::uint32_t>((tick - run.startTick) / run.barTicks);
+}
+
+Tick MeasureIndex::barStart(std::uint32_t bar) const noexcept {
+    const auto& run = m_runs[runOfBar(bar)];
+    return run.startTick + static_cast<Tick>(bar - run.firstBar) * run.barTicks;
+}
+
+} // namespace notascore::notation
@@ -1,20 +1,994 @@
 #include "notascore/notation/NotationEngine.hpp"
 
+#include "notascore/core/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
 namespace notascore::notation {
 
-void NotationEngine::addNote(const NoteEvent& event) {
-    m_notes.push_back(event);
-    m_dirty = true;
+namespace {
+
+// Chunk sizes for the parallel passes: large enough to amortise task overhead.
+constexpr std::size_t kMeasureGrain = 512;
+constexpr std::size_t kSystemGrain = 128;
+constexpr std::size_t kPageGrain = 32;
+
+// Undo steps of every engine are stamped from one clock, so a Score can take
+// the steps of its voices in the order they were made.
+std::atomic<std::uint64_t> undoClock {0};
+
+template <typename T>
+void insertAt(std::vector<T>& values, std::size_t index, T value) {
+    values.insert(values.begin() + static_cast<std::ptrdiff_t>(index), value);
+}
+
+template <typename T>
+void eraseAt(std::vector<T>& values, std::size_t index) {
+    values.erase(values.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+// Values [first, oldLast) of the live data become `replacement`; everything
+// else is unchanged.
+template <typename T>
+struct ChangedRange {
+    std::size_t first {0};
+    std::size_t oldLast {0};
+    std::vector<T> replacement;
+};
+
+// Shared subtrees bound the difference cheaply; the bounds are then tightened
+// value by value, since leaf splits make the tree diff coarser than the edit.
+template <typename T>
+ChangedRange<T> changedRange(std::span<const T> live, const PersistentVector<T>& from, const PersistentVector<T>& to) {
+    const std::size_t prefix = PersistentVector<T>::commonPrefix(from, to);
+    const std::size_t suffix =
+        std::min(PersistentVector<T>::commonSuffix(from, to), std::min(from.size(), to.size()) - prefix);
+    ChangedRange<T> range {.first = prefix, .oldLast = from.size() - suffix, .replacement = {}};
+    to.copyRange(prefix, to.size() - suffix, range.replacement);
+
+    std::size_t head = 0;
+    while (range.first < range.oldLast && head < range.replacement.size() && live[range.first] == range.replacement[head]) {
+        ++range.first;
+        ++head;
+    }
+    std::size_t tail = range.replacement.size();
+    while (range.oldLast > range.first && tail > head && live[range.oldLast - 1] == range.replacement[tail - 1]) {
+        --range.oldLast;
+        --tail;
+    }
+    range.replacement.erase(range.replacement.begin() + static_cast<std::ptrdiff_t>(tail), range.replacement.end());
+    range.replacement.erase(range.replacement.begin(), range.replacement.begin() + static_cast<std::ptrdiff_t>(head));
+    return range;
+}
+
+// Note-parallel arrays keep headroom so incremental inserts do not reallocate.
+template <typename T>
+void resizeWithHeadroom(std::vector<T>& values, std::size_t size) {
+    if (values.capacity() < size) {
+        values.reserve(size + size / 8);
+    }
+    values.resize(size);
+}
+
+// Bulk-edit kernels: one flat loop per field over a contiguous run of notes,
+// without per-note dispatch, so the compiler vectorizes them.
+void transformNotes(std::span<NoteEvent> notes, const BulkEdit& edit) noexcept {
+    const double factor = static_cast<double>(edit.amount) / static_cast<double>(std::max(edit.divisor, 1));
+    switch (edit.kind) {
+    case BulkEditKind::Transpose: {
+        const int semitones = std::clamp(edit.amount, -127, 127);
+        for (auto& note : notes) {
+            note.midiPitch = std::clamp(note.midiPitch + semitones, 0, 127);
+        }
+        break;
+    }
+    case BulkEditKind::ShiftTicks:
+        for (auto& note : notes) {
+            note.tick = std::max(note.tick + edit.amount, 0);
+        }
+        break;
+    case BulkEditKind::ScaleDurations: {
+        constexpr double kLongest = std::numeric_limits<int>::max() / 2;
+        for (auto& note : notes) {
+            note.duration = std::max(static_cast<int>(std::min(note.duration * factor + 0.5, kLongest)), 1);
+        }
+        break;
+    }
+    case BulkEditKind::AdjustVelocity: {
+        const int delta = std::clamp(edit.amount, -127, 127);
+        for (auto& note : notes) {
+            note.velocity = std::clamp(note.velocity + delta, 1, 127);
+        }
+        break;
+    }
+    case BulkEditKind::ScaleVelocities:
+        for (auto& note : notes) {
+            note.velocity = static_cast<int>(std::clamp(note.velocity * factor + 0.5, 1.0, 127.0));
+        }
+        break;
+    }
+}
+
+} // namespace
+
+bool NotationEngine::addNote(const NoteEvent& event) {
+    if (event.tick < 0) {
+        return false;
+    }
+    // A one-note AddNotes: replaying it merges by tick exactly like this call.
+    emit({.kind = EditKind::AddNotes, .notes = std::span(&event, 1)});
+    insertNoteAt(insertionIndex(event.tick), event);
+    markEdited();
+    return true;
+}
+
+bool NotationEngine::removeNote(std::size_t index) {
+    if (index >= m_notes.size()) {
+        return false;
+    }
+    emit({.kind = EditKind::EraseNote, .index = static_cast<std::uint32_t>(index)});
+    eraseNoteAt(index);
+    markEdited();
+    return true;
+}
+
+bool NotationEngine::modifyNote(std::size_t index, const NoteEvent& event) {
+    if (index >= m_notes.size() || event.tick < 0) {
+        return false;
+    }
+    emit({.kind = EditKind::ModifyNote, .index = static_cast<std::uint32_t>(index), .note = event});
+    replaceNote(index, event);
+    markEdited();
+    return true;
+}
+
+std::size_t NotationEngine::insertionIndex(int tick) const noexcept {
+    // Keep storage tick-sorted; appending in order (the common import case) stays O(1).
+    const auto position = std::upper_bound(m_notes.begin(), m_notes.end(), tick,
+        [](int value, const NoteEvent& note) { return value < note.tick; });
+    return static_cast<std::size_t>(position - m_notes.begin());
+}
+
+void NotationEngine::insertNoteAt(std::size_t index, const NoteEvent& event) {
+    m_notes.insert(m_notes.begin() + static_cast<std::ptrdiff_t>(index), event);
+    m_tickIndex.insert(event);
+    m_noteMirror.insert(index, event);
+
+    if (!m_layoutValid || ++m_pendingEdits > kMaxIncrementalEdits) {
+        m_layoutValid = false;
+        return;
+    }
+
+    // Patch the layout arrays in place so that only the touched measure is re-spaced.
+    const std::int64_t measureTicks = m_options.measureTicks;
+    const auto measure = static_cast<std::size_t>(event.tick / measureTicks);
+    const auto end = static_cast<std::int64_t>(event.tick) + std::max(event.duration, 1);
+    ensureMeasureCount(static_cast<std::size_t>((end + measureTicks - 1) / measureTicks));
+
+    insertAt(m_layout.noteMeasure, index, static_cast<std::uint32_t>(measure));
+    insertAt(m_layout.noteX, index, 0.0f);
+    insertAt(m_layout.noteY, index, 0.0f);
+    insertAt(m_spacing.noteOffset, index, 0.0f);
+    for (std::size_t m = measure + 1; m < m_layout.measureFirstNote.size(); ++m) {
+        ++m_layout.measureFirstNote[m];
+    }
+    markMeasuresDirty(measure, measure + 1);
+}
+
+void NotationEngine::eraseNoteAt(std::size_t index) {
+    const NoteEvent removed = m_notes[index];
+    m_notes.erase(m_notes.begin() + static_cast<std::ptrdiff_t>(index));
+    m_tickIndex.erase(m_notes, removed);
+    m_noteMirror.erase(index);
+
+    if (!m_layoutValid || ++m_pendingEdits > kMaxIncrementalEdits) {
+        m_layoutValid = false;
+        return;
+    }
+
+    const std::size_t measure = m_layout.noteMeasure[index];
+    eraseAt(m_layout.noteMeasure, index);
+    eraseAt(m_layout.noteX, index);
+    eraseAt(m_layout.noteY, index);
+    eraseAt(m_spacing.noteOffset, index);
+    for (std::size_t m = measure + 1; m < m_layout.measureFirstNote.size(); ++m) {
+        --m_layout.measureFirstNote[m];
+    }
+    markMeasuresDirty(measure, measure + 1);
+    shrinkMeasureCount();
+}
+
+void NotationEngine::replaceNote(std::size_t index, const NoteEvent& event) {
+    const bool sameTick = m_notes[index].tick == event.tick;
+    eraseNoteAt(index);
+    insertNoteAt(sameTick ? index : insertionIndex(event.tick), event);
+}
+
+bool NotationEngine::addNotes(std::span<const NoteEvent> events) {
+    if (std::ranges::any_of(events, [](const NoteEvent& event) { return event.tick < 0; })) {
+        return false;
+    }
+    if (events.empty()) {
+        return true;
+    }
+    emit({.kind = EditKind::AddNotes, .notes = events});
+    mergeNotes(events);
+    markEdited();
+    return true;
+}
+
+bool NotationEngine::addLoadedNotes(std::span<const NoteEvent> events) {
+    if (std::ranges::any_of(events, [](const NoteEvent& event) { return event.tick < 0; })) {
+        return false;
+    }
+    if (events.empty()) {
+        return true;
+    }
+    mergeNotes(events);
+
+    // The same stable sort and merge as mergeNotes(), per state. Consecutive
+    // states often share their notes (a marking edit, say), and then share the
+    // merged result too.
+    const auto byTick = [](const NoteEvent& a, const NoteEvent& b) { return a.tick < b.tick; };
+    std::vector<NoteEvent> batch(events.begin(), events.end());
+    std::ranges::stable_sort(batch, byTick);
+    using Notes = PersistentVector<NoteEvent>;
+    Notes previous;
+    Notes previousMerged;
+    bool merged = false;
+    std::vector<NoteEvent> notes;
+    m_history.amend([&](DocumentSnapshot& state) {
+        if (merged && state.notes.size() == previous.size() && Notes::commonPrefix(state.notes, previous) == previous.size()) {
+            state.notes = previousMerged;
+            return;
+        }
+        previous = state.notes;
+        notes.clear();
+        notes.reserve(state.notes.size() + batch.size());
+        state.notes.copyRange(0, state.notes.size(), notes);
+        const auto middle = static_cast<std::ptrdiff_t>(notes.size());
+        notes.insert(notes.end(), batch.begin(), batch.end());
+        std::inplace_merge(notes.begin(), notes.begin() + middle, notes.end(), byTick);
+        state.notes = Notes::fromRange(notes);
+        previousMerged = state.notes;
+        merged = true;
+    });
+    if (m_uncommittedStamp == 0) {
+        // The document is the current state again.
+        m_noteMirror.reset(m_history.current().notes);
+    }
+    return true;
+}
+
+void NotationEngine::mergeNotes(std::span<const NoteEvent> events) {
+    // Small batches (pastes, step entry) keep the incremental relayout path.
+    if (m_layoutValid && events.size() + m_pendingEdits <= kMaxIncrementalEdits) {
+        for (const auto& event : events) {
+            insertNoteAt(insertionIndex(event.tick), event);
+        }
+        return;
+    }
+
+    const auto byTick = [](const NoteEvent& a, const NoteEvent& b) { return a.tick < b.tick; };
+    const std::size_t oldCount = m_notes.size();
+    m_notes.reserve(oldCount + events.size());
+    m_notes.insert(m_notes.end(), events.begin(), events.end());
+
+    // Stable sort + stable merge keep equal-tick notes in insertion order, exactly
+    // as repeated addNote calls would.
+    const auto batchBegin = m_notes.begin() + static_cast<std::ptrdiff_t>(oldCount);
+    if (!std::is_sorted(batchBegin, m_notes.end(), byTick)) {
+        std::stable_sort(batchBegin, m_notes.end(), byTick);
+    }
+    if (oldCount > 0 && batchBegin->tick < m_notes[oldCount - 1].tick) {
+        std::inplace_merge(m_notes.begin(), batchBegin, m_notes.end(), byTick);
+    }
+
+    if (events.size() > oldCount) {
+        m_tickIndex.rebuild(m_notes, m_options.measureTicks);
+    } else {
+        for (const auto& event : events) {
+            m_tickIndex.insert(event);
+        }
+    }
+    m_noteMirror.invalidate();
+    m_layoutValid = false;
+}
+
+bool NotationEngine::applyBulkEdit(const BulkEdit& edit, std::span<const NoteRange> ranges) {
+    return applyBulkEditTo(edit, ranges);
+}
+
+bool NotationEngine::applyBulkEdit(const BulkEdit& edit, const NoteSelection& selection) {
+    return applyBulkEditTo(edit, selection.runs());
+}
+
+template <typename Ranges>
+bool NotationEngine::applyBulkEditTo(const BulkEdit& edit, const Ranges& ranges) {
+    std::uint32_t previousLast = 0;
+    std::size_t count = 0;
+    std::int64_t latestTick = 0;
+    for (const auto& range : ranges) {
+        if (range.first < previousLast || range.last < range.first || range.last > m_notes.size()) {
+            return false;
+        }
+        if (range.last > range.first) {
+            latestTick = m_notes[range.last - 1].tick;
+        }
+        previousLast = range.last;
+        count += range.last - range.first;
+    }
+    const bool scales = edit.kind == BulkEditKind::ScaleDurations || edit.kind == BulkEditKind::ScaleVelocities;
+    if ((scales && (edit.amount <= 0 || edit.divisor <= 0))
+        || (edit.kind == BulkEditKind::ShiftTicks && latestTick + edit.amount > std::numeric_limits<int>::max())) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    commitUndoStep();
+    if constexpr (std::is_convertible_v<const Ranges&, std::span<const NoteRange>>) {
+        emit({.kind = EditKind::BulkEdit, .bulk = edit, .ranges = ranges});
+    } else if (m_editListener) {
+        const std::vector<NoteRange> recorded(ranges.begin(), ranges.end());
+        emit({.kind = EditKind::BulkEdit, .bulk = edit, .ranges = recorded});
+    }
+    bulkEditNotes(edit, ranges);
+    markEdited();
+    commitUndoStep();
+    return true;
+}
+
+template <typename Ranges>
+void NotationEngine::bulkEditNotes(const BulkEdit& edit, const Ranges& ranges) {
+    std::size_t count = 0;
+    for (const auto& range : ranges) {
+        count += range.last - range.first;
+    }
+    if (count == 0) {
+        return;
+    }
+    const bool shifts = edit.kind == BulkEditKind::ShiftTicks;
+    const bool changesEnds = shifts || edit.kind == BulkEditKind::ScaleDurations;
+    // Few notes: patch the tick index and snapshot mirror note by note.
+    const bool few = count <= kMaxIncrementalEdits;
+
+    std::vector<NoteEvent> before;
+    if (few && changesEnds) {
+        before.reserve(count);
+        for (const auto& range : ranges) {
+            before.insert(before.end(), m_notes.begin() + range.first, m_notes.begin() + range.last);
+        }
+    }
+    if (m_layoutValid && ++m_pendingEdits > kMaxIncrementalEdits) {
+        m_layoutValid = false;
+    }
+    if (m_layoutValid) {
+        for (const auto& range : ranges) {
+            if (range.last > range.first) {
+                markMeasuresDirty(m_layout.noteMeasure[range.first], m_layout.noteMeasure[range.last - 1] + 1u);
+            }
+        }
+    }
+
+    for (const auto& range : ranges) {
+        transformNotes({m_notes.data() + range.first, range.last - range.first}, edit);
+    }
+
+    const auto byTick = [](const NoteEvent& a, const NoteEvent& b) { return a.tick < b.tick; };
+    const bool inOrder = !shifts || std::ranges::all_of(ranges, [&](const NoteRange& range) {
+        return range.first == range.last
+            || ((range.first == 0 || m_notes[range.first - 1].tick <= m_notes[range.first].tick)
+                && (range.last == m_notes.size() || m_notes[range.last - 1].tick <= m_notes[range.last].tick));
+    });
+    if (!inOrder) {
+        // Shifted past unselected notes: re-sort, keeping equal ticks in storage order.
+        std::stable_sort(m_notes.begin(), m_notes.end(), byTick);
+        m_tickIndex.rebuild(m_notes, m_options.measureTicks);
+        m_noteMirror.invalidate();
+        m_layoutValid = false;
+        return;
+    }
+
+    if (few) {
+        for (const auto& range : ranges) {
+            for (std::size_t i = range.first; i < range.last; ++i) {
+                m_noteMirror.erase(i);
+                m_noteMirror.insert(i, m_notes[i]);
+            }
+        }
+    } else {
+        m_noteMirror.invalidate();
+    }
+    if (changesEnds) {
+        if (few) {
+            for (const auto& note : before) {
+                m_tickIndex.erase(m_notes, note);
+            }
+            for (const auto& range : ranges) {
+                for (std::size_t i = range.first; i < range.last; ++i) {
+                    m_tickIndex.insert(m_notes[i]);
+                }
+            }
+        } else {
+            m_tickIndex.rebuild(m_notes, m_options.measureTicks);
+        }
+    }
+    if (!m_layoutValid || !changesEnds) {
+        return;
+    }
+
+    const std::int64_t measureTicks = m_options.measureTicks;
+    ensureMeasureCount(static_cast<std::size_t>((m_tickIndex.maxEnd() + measureTicks - 1) / measureTicks));
+    if (shifts) {
+        renumberShiftedNotes(ranges);
+    }
+    shrinkMeasureCount();
+}
+
+template <typename Ranges>
+void NotationEngine::renumberShiftedNotes(const Ranges& ranges) {
+    // Old and new onset measures of the shifted notes bound every measure whose
+    // first-note offset can change.
+    const std::int64_t measureTicks = m_options.measureTicks;
+    auto& noteMeasure = m_layout.noteMeasure;
+    std::size_t low = std::numeric_limits<std::size_t>::max();
+    std::size_t high = 0;
+    for (const auto& range : ranges) {
+        for (std::size_t i = range.first; i < range.last; ++i) {
+            const auto measure = static_cast<std::uint32_t>(m_notes[i].tick / measureTicks);
+            low = std::min<std::size_t>({low, noteMeasure[i], measure});
+            high = std::max<std::size_t>({high, noteMeasure[i], measure});
+            noteMeasure[i] = measure;
+        }
+    }
+    auto& firstNote = m_layout.measureFirstNote;
+    const std::size_t end = firstNote[high + 1];
+    std::size_t n = firstNote[low];
+    for (std::size_t m = low + 1; m <= high; ++m) {
+        while (n < end && noteMeasure[n] < m) {
+            ++n;
+        }
+        firstNote[m] = static_cast<std::uint32_t>(n);
+    }
+    markMeasuresDirty(low, high + 1);
+}
+
+bool NotationEngine::addMarking(const Marking& marking) {
+    if (marking.tick < 0) {
+        return false;
+    }
+    const auto position = std::upper_bound(m_markings.begin(), m_markings.end(), marking.tick,
+        [](int tick, const Marking& existing) { return tick < existing.tick; });
+    const auto index = static_cast<std::size_t>(position - m_markings.begin());
+    emit({.kind = EditKind::InsertMarking, .index = static_cast<std::uint32_t>(index), .marking = marking});
+    insertMarkingAt(index, marking);
+    markEdited();
+    return true;
+}
+
+void NotationEngine::insertMarkingAt(std::size_t index, const Marking& marking) {
+    m_markingMirror.insert(index, marking);
+    m_markings.insert(m_markings.begin() + static_cast<std::ptrdiff_t>(index), marking);
+    markMarkingDirty(marking);
+}
+
+void NotationEngine::eraseMarkingAt(std::size_t index) {
+    m_markingMirror.erase(index);
+    markMarkingDirty(m_markings[index]);
+    m_markings.erase(m_markings.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+void NotationEngine::markMarkingDirty(const Marking& marking) noexcept {
+    const auto measure = static_cast<std::size_t>(marking.tick / m_options.measureTicks);
+    if (m_layoutValid && measure < m_layout.measureCount()) {
+        markMeasuresDirty(measure, measure + 1);
+    }
+}
+
+void NotationEngine::applyEdit(const EditRecord& record) {
+    switch (record.kind) {
+    case EditKind::InsertNote:
+        insertNoteAt(record.index, record.note);
+        break;
+    case EditKind::EraseNote:
+        eraseNoteAt(record.index);
+        break;
+    case EditKind::ModifyNote:
+        replaceNote(record.index, record.note);
+        break;
+    case EditKind::AddNotes:
+        mergeNotes(record.notes);
+        break;
+    case EditKind::InsertMarking:
+        insertMarkingAt(record.index, record.marking);
+        break;
+    case EditKind::EraseMarking:
+        eraseMarkingAt(record.index);
+        break;
+    case EditKind::BulkEdit:
+        bulkEditNotes(record.bulk, record.ranges);
+        break;
+    }
+    markEdited();
+}
+
+DocumentSnapshot NotationEngine::snapshot() {
+    return {.notes = m_noteMirror.version(m_notes), .markings = m_markingMirror.version(m_markings)};
+}
+
+void NotationEngine::restore(const DocumentSnapshot& target) {
+    const DocumentSnapshot current = snapshot();
+
+    // Replace only what differs; small differences stay on the incremental path.
+    const auto notes = changedRange<NoteEvent>(m_notes, current.notes, target.notes);
+    for (std::size_t i = notes.oldLast; i > notes.first; --i) {
+        emit({.kind = EditKind::EraseNote, .index = static_cast<std::uint32_t>(i - 1)});
+    }
+    for (std::size_t i = 0; i < notes.replacement.size(); ++i) {
+        emit({.kind = EditKind::InsertNote, .index = static_cast<std::uint32_t>(notes.first + i), .note = notes.replacement[i]});
+    }
+    const std::size_t noteEdits = (notes.oldLast - notes.first) + notes.replacement.size();
+    if (m_layoutValid && m_pendingEdits + noteEdits <= kMaxIncrementalEdits) {
+        for (std::size_t i = notes.oldLast; i > notes.first; --i) {
+            eraseNoteAt(i - 1);
+        }
+        for (std::size_t i = 0; i < notes.replacement.size(); ++i) {
+            insertNoteAt(notes.first + i, notes.replacement[i]);
+        }
+    } else {
+        const auto first = m_notes.begin() + static_cast<std::ptrdiff_t>(notes.first);
+        m_notes.erase(first, m_notes.begin() + static_cast<std::ptrdiff_t>(notes.oldLast));
+        m_notes.insert(m_notes.begin() + static_cast<std::ptrdiff_t>(notes.first), notes.replacement.begin(),
+            notes.replacement.end());
+        m_tickIndex.rebuild(m_notes, m_options.measureTicks);
+        m_layoutValid = false;
+    }
+
+    const auto markings = changedRange<Marking>(m_markings, current.markings, target.markings);
+    for (std::size_t i = markings.oldLast; i > markings.first; --i) {
+        emit({.kind = EditKind::EraseMarking, .index = static_cast<std::uint32_t>(i - 1)});
+        markMarkingDirty(m_markings[i - 1]);
+    }
+    for (std::size_t i = 0; i < markings.replacement.size(); ++i) {
+        emit({.kind = EditKind::InsertMarking,
+            .index = static_cast<std::uint32_t>(markings.first + i),
+            .marking = markings.replacement[i]});
+        markMarkingDirty(markings.replacement[i]);
+    }
+    const auto firstMarking = m_markings.begin() + static_cast<std::ptrdiff_t>(markings.first);
+    m_markings.erase(firstMarking, m_markings.begin() + static_cast<std::ptrdiff_t>(markings.oldLast));
+    m_markings.insert(m_markings.begin() + static_cast<std::ptrdiff_t>(markings.first), markings.replacement.begin(),
+        markings.replacement.end());
+
+    m_noteMirror.reset(target.notes);
+    m_markingMirror.reset(target.markings);
+    markEdited();
+}
+
+void NotationEngine::markEdited() noexcept {
+    if (m_uncommittedStamp == 0) {
+        m_uncommittedStamp = ++undoClock;
+    }
+}
+
+void NotationEngine::commitUndoStep() {
+    if (m_uncommittedStamp != 0) {
+        m_history.push(snapshot(), m_uncommittedStamp);
+        m_uncommittedStamp = 0;
+    }
+}
+
+void NotationEngine::clearUndoHistory() {
+    m_history.reset(snapshot());
+    m_uncommittedStamp = 0;
+}
+
+bool NotationEngine::undo() {
+    commitUndoStep();
+    const DocumentSnapshot* state = m_history.undo();
+    if (state == nullptr) {
+        return false;
+    }
+    restore(*state);
+    m_uncommittedStamp = 0;
+    return true;
+}
+
+bool NotationEngine::redo() {
+    const DocumentSnapshot* state = m_uncommittedStamp != 0 ? nullptr : m_history.redo();
+    if (state == nullptr) {
+        return false;
+    }
+    restore(*state);
+    m_uncommittedStamp = 0;
+    return true;
+}
+
+NotationEngine::BatchEdit::BatchEdit(NotationEngine& engine, std::size_t expectedNotes)
+    : m_engine(engine) {
+    m_pending.reserve(expectedNotes);
+}
+
+void NotationEngine::BatchEdit::commit() {
+    m_engine.addNotes(m_pending);
+    m_pending.clear();
+}
+
+void NotationEngine::setLayoutOptions(const LayoutOptions& options) {
+    if (options.measureTicks != m_options.measureTicks) {
+        m_tickIndex.rebuild(m_notes, options.measureTicks);
+    }
+    m_options = options;
+    m_layoutValid = false;
+}
+
+void NotationEngine::shrinkMeasureCount() {
+    const std::size_t current = m_layout.measureCount();
+    const std::int64_t measureTicks = m_options.measureTicks;
+    const auto count = static_cast<std::size_t>(
+        std::max<std::int64_t>(1, (m_tickIndex.maxEnd() + measureTicks - 1) / measureTicks));
+    if (count >= current) {
+        return;
+    }
+    // The greedy re-breaker cannot drop trailing systems; lay out from scratch.
+    if (m_options.lowMemoryMode) {
+        m_layoutValid = false;
+        return;
+    }
+    // Trailing measures are empty by construction, so only the tables shrink.
+    m_layout.measureFirstNote.resize(count + 1);
+    m_layout.measureX.resize(count);
+    m_layout.measureWidth.resize(count);
+    m_layout.measureSystem.resize(count);
+    m_spacing.naturalWidth.resize(count);
+    m_dirtyFirst = std::min(m_dirtyFirst, count - 1);
+    m_dirtyLast = std::min(m_dirtyLast, count);
+    markMeasuresDirty(count - 1, count);
+}
+
+void NotationEngine::markMeasuresDirty(std::size_t first, std::size_t last) noexcept {
+    if (m_dirtyFirst >= m_dirtyLast) {
+        m_dirtyFirst = first;
+        m_dirtyLast = last;
+        return;
+    }
+    m_dirtyFirst = std::min(m_dirtyFirst, first);
+    m_dirtyLast = std::max(m_dirtyLast, last);
+}
+
+void NotationEngine::ensureMeasureCount(std::size_t count) {
+    const std::size_t current = m_layout.measureCount();
+    if (count <= current) {
+        return;
+    }
+    // New trailing measures are empty; the note being inserted is counted by the caller.
+    m_layout.measureFirstNote.resize(count + 1, m_layout.measureFirstNote.back());
+    m_layout.measureX.resize(count);
+    m_layout.measureWidth.resize(count);
+    m_layout.measureSystem.resize(count, std::numeric_limits<std::uint32_t>::max());
+    m_spacing.naturalWidth.resize(count);
+    markMeasuresDirty(current, count);
 }
 
 void NotationEngine::recomputeLayoutIfNeeded() {
-    if (!m_dirty) {
+    if (!isDirty()) {
         return;
     }
 
-    // Placeholder for TeX-style spacing + collision passes.
-    m_dirty = false;
+    if (m_layoutValid) {
+        relayoutDirtyMeasures();
+    } else {
+        relayoutAll();
+    }
+
+    layoutViewport();
+
+    m_layoutValid = true;
+    m_dirtyFirst = m_dirtyLast = 0;
+    m_pendingEdits = 0;
     ++m_layoutVersion;
+    if (m_publisher) {
+        publishLayout();
+    }
+}
+
+NoteRange NotationEngine::notesInBar(std::uint32_t bar) const noexcept {
+    const auto byTick = [](const NoteEvent& note, Tick tick) { return note.tick < tick; };
+    const Tick start = m_measureIndex->barStart(bar);
+    const auto first = std::lower_bound(m_notes.begin(), m_notes.end(), start, byTick);
+    // A bar holds few notes: gallop from its first note instead of searching the rest of the score.
+    const Tick end = start + m_measureIndex->barLength(bar);
+    std::ptrdiff_t step = 1;
+    auto bound = first;
+    while (m_notes.end() - bound > step && bound[step].tick < end) {
+        bound += step;
+        step *= 2;
+    }
+    const auto last = std::lower_bound(bound, bound + std::min(step + 1, m_notes.end() - bound), end, byTick);
+    return {.first = static_cast<std::uint32_t>(first - m_notes.begin()),
+        .last = static_cast<std::uint32_t>(last - m_notes.begin())};
+}
+
+void NotationEngine::setViewport(std::size_t firstPage, std::size_t lastPage) {
+    m_viewportFirst = firstPage;
+    m_viewportLast = std::max(lastPage, firstPage + 1);
+    // A pending pass lays out the new window itself.
+    if (!isDirty() && layoutViewport() && m_publisher) {
+        publishLayout();
+    }
+}
+
+bool NotationEngine::layoutViewport() {
+    if (!m_options.lazyPages) {
+        return false;
+    }
+    const std::size_t pageCount = m_layout.pageCount();
+    const std::size_t prefetch = m_options.prefetchPages;
+    const std::size_t firstPage = std::min(m_viewportFirst - std::min(m_viewportFirst, prefetch), pageCount);
+    const std::size_t lastPage = std::min(std::min(m_viewportLast, pageCount) + std::min(prefetch, pageCount), pageCount);
+    const std::size_t firstSystem = m_layout.pageFirstSystem[firstPage];
+    const std::size_t lastSystem = m_layout.pageFirstSystem[lastPage];
+
+    bool changed = false;
+    if (m_options.lowMemoryMode) {
+        for (std::size_t s = 0; s < m_systemLaidOut.size(); ++s) {
+            if (m_systemLaidOut[s] != 0 && (s < firstSystem || s >= lastSystem)) {
+                m_systemLaidOut[s] = 0;
+                m_layout.systemItems[s].clear();
+                m_layout.systemItems[s].shrink_to_fit();
+                unpublishSystems(s, s + 1);
+                changed = true;
+            }
+        }
+    }
+    for (std::size_t s = firstSystem; s < lastSystem;) {
+        if (m_systemLaidOut[s] != 0) {
+            ++s;
+            continue;
+        }
+        std::size_t end = s + 1;
+        while (end < lastSystem && m_systemLaidOut[end] == 0) {
+            ++end;
+        }
+        layoutSystemRange(s, end);
+        std::fill(m_systemLaidOut.begin() + static_cast<std::ptrdiff_t>(s),
+            m_systemLaidOut.begin() + static_cast<std::ptrdiff_t>(end), std::uint8_t {1});
+        changed = true;
+        s = end;
+    }
+    return changed;
+}
+
+void NotationEngine::enableLayoutPublishing() {
+    if (m_publisher) {
+        return;
+    }
+    m_publisher = std::make_unique<notascore::core::EpochPublisher<LayoutVersion>>();
+    m_publishedSystems.assign(m_layout.systemCount(), nullptr);
+    if (!isDirty()) {
+        publishLayout();
+    }
+}
+
+void NotationEngine::unpublishSystems(std::size_t first, std::size_t last) noexcept {
+    if (m_publisher) {
+        std::fill(m_publishedSystems.begin() + static_cast<std::ptrdiff_t>(first),
+            m_publishedSystems.begin() + static_cast<std::ptrdiff_t>(last), nullptr);
+    }
+}
+
+void NotationEngine::publishLayout() {
+    const auto& firstMeasure = m_layout.systemFirstMeasure;
+    const auto& firstNote = m_layout.measureFirstNote;
+    for (std::size_t s = 0; s < m_publishedSystems.size(); ++s) {
+        if (m_publishedSystems[s]) {
+            continue;
+        }
+        const std::size_t measureBegin = firstMeasure[s];
+        const std::size_t measureEnd = firstMeasure[s + 1];
+        const auto noteBegin = static_cast<std::ptrdiff_t>(firstNote[measureBegin]);
+        const auto noteEnd = static_cast<std::ptrdiff_t>(firstNote[measureEnd]);
+        auto system = std::make_shared<PublishedSystem>();
+        system->noteX.assign(m_layout.noteX.begin() + noteBegin, m_layout.noteX.begin() + noteEnd);
+        system->noteY.assign(m_layout.noteY.begin() + noteBegin, m_layout.noteY.begin() + noteEnd);
+        system->noteMeasure.assign(m_layout.noteMeasure.begin() + noteBegin, m_layout.noteMeasure.begin() + noteEnd);
+        system->measureFirstNote.reserve(measureEnd - measureBegin + 1);
+        for (std::size_t m = measureBegin; m <= measureEnd; ++m) {
+            system->measureFirstNote.push_back(firstNote[m] - firstNote[measureBegin]);
+        }
+        const auto measures = static_cast<std::ptrdiff_t>(measureBegin);
+        const auto measuresEnd = static_cast<std::ptrdiff_t>(measureEnd);
+        system->measureX.assign(m_layout.measureX.begin() + measures, m_layout.measureX.begin() + measuresEnd);
+        system->measureWidth.assign(m_layout.measureWidth.begin() + measures, m_layout.measureWidth.begin() + measuresEnd);
+        system->items = m_layout.systemItems[s];
+        m_publishedSystems[s] = std::move(system);
+    }
+
+    auto next = m_publisher->recycle();
+    if (!next) {
+        next = std::make_unique<LayoutVersion>();
+    }
+    // Copy-assignment reuses the recycled version's buffers.
+    next->version = m_layoutVersion;
+    next->document = snapshot();
+    auto& published = next->layout;
+    published.systems = m_publishedSystems;
+    published.systemFirstMeasure = firstMeasure;
+    published.systemFirstNote.resize(firstMeasure.size());
+    for (std::size_t s = 0; s < firstMeasure.size(); ++s) {
+        published.systemFirstNote[s] = firstNote[firstMeasure[s]];
+    }
+    published.systemY = m_layout.systemY;
+    published.systemPage = m_layout.systemPage;
+    published.pageFirstSystem = m_layout.pageFirstSystem;
+    m_publisher->publish(std::move(next));
+}
+
+void NotationEngine::relayoutAll() {
+    const std::size_t measureCount = layout::measureCountFor(m_notes, m_options);
+    resizeWithHeadroom(m_layout.noteMeasure, m_notes.size());
+    m_layout.measureFirstNote.resize(measureCount + 1);
+    m_layout.measureFirstNote[measureCount] = static_cast<std::uint32_t>(m_notes.size());
+    forRange(0, measureCount, kMeasureGrain, [this](std::size_t begin, std::size_t end) {
+        layout::indexMeasures(m_notes, m_options, begin, end, m_layout);
+    });
+
+    m_spacing.naturalWidth.resize(measureCount);
+    resizeWithHeadroom(m_spacing.noteOffset, m_notes.size());
+    resizeWithHeadroom(m_layout.noteY, m_notes.size());
+    spaceMeasureRange(0, measureCount);
+
+    if (m_options.lowMemoryMode) {
+        m_breakState = {};
+        m_layout.systemFirstMeasure = layout::breakSystemsGreedy(m_spacing.naturalWidth, m_options.lineWidth());
+    } else {
+        m_layout.systemFirstMeasure =
+            layout::breakSystemsOptimal(m_spacing.naturalWidth, m_options.lineWidth(), 0, m_breakState);
+    }
+    const std::size_t systemCount = m_layout.systemFirstMeasure.size() - 1;
+
+    resizeWithHeadroom(m_layout.noteX, m_notes.size());
+    m_layout.measureX.resize(measureCount);
+    m_layout.measureWidth.resize(measureCount);
+    m_layout.measureSystem.resize(measureCount);
+    m_layout.systemItems.resize(systemCount);
+    if (m_publisher) {
+        m_publishedSystems.assign(systemCount, nullptr);
+    }
+    if (m_options.lazyPages) {
+        m_systemLaidOut.assign(systemCount, 0);
+    } else {
+        m_systemLaidOut.clear();
+    }
+    justifySystemRange(0, systemCount);
+
+    m_layout.systemY.resize(systemCount);
+    layout::paginate(m_options, m_layout);
+    stackPageRange(0, m_layout.pageCount());
+
+    m_passStats = {.fullPass = true,
+        .measuresRespaced = measureCount,
+        .systemsJustified = systemCount,
+        .pagesStacked = m_layout.pageCount()};
+}
+
+void NotationEngine::relayoutDirtyMeasures() {
+    spaceMeasureRange(m_dirtyFirst, m_dirtyLast);
+
+    auto& breaks = m_layout.systemFirstMeasure;
+    layout::RebreakResult rebreak;
+    if (m_options.lowMemoryMode) {
+        // Re-break from the system holding the first dirty measure; measures appended
+        // past the old end start in the old last system.
+        const std::size_t oldSystemCount = breaks.size() - 1;
+        const std::size_t firstSystem =
+            m_dirtyFirst < breaks.back() ? m_layout.measureSystem[m_dirtyFirst] : oldSystemCount - 1;
+        rebreak = layout::rebreakSystemsGreedy(m_spacing.naturalWidth, m_options.lineWidth(), firstSystem, m_dirtyLast, breaks);
+    } else {
+        // The optimum can move breaks anywhere after the edit; only systems whose
+        // bounds actually changed are redone.
+        auto fresh = layout::breakSystemsOptimal(
+            m_spacing.naturalWidth, m_options.lineWidth(), m_dirtyFirst, m_breakState, m_dirtyLast);
+        rebreak = layout::diffBreaks(breaks, fresh, m_dirtyFirst, m_dirtyLast);
+        breaks = std::move(fresh);
+    }
+    const std::size_t systemCount = breaks.size() - 1;
+
+    // Later systems only need renumbering when the number of systems changed.
+    if (rebreak.systemDelta != 0) {
+        for (std::size_t s = rebreak.lastSystem; s < systemCount; ++s) {
+            for (std::size_t m = breaks[s]; m < breaks[s + 1]; ++m) {
+                m_layout.measureSystem[m] = static_cast<std::uint32_t>(s);
+            }
+        }
+        m_layout.systemY.resize(systemCount);
+        auto& items = m_layout.systemItems;
+        const auto oldEnd = static_cast<std::ptrdiff_t>(rebreak.lastSystem) - rebreak.systemDelta;
+        if (rebreak.systemDelta > 0) {
+            items.insert(items.begin() + oldEnd, static_cast<std::size_t>(rebreak.systemDelta), {});
+        } else {
+            items.erase(items.begin() + static_cast<std::ptrdiff_t>(rebreak.lastSystem), items.begin() + oldEnd);
+        }
+        if (m_publisher) {
+            auto& published = m_publishedSystems;
+            if (rebreak.systemDelta > 0) {
+                published.insert(published.begin() + oldEnd, static_cast<std::size_t>(rebreak.systemDelta), nullptr);
+            } else {
+                published.erase(published.begin() + static_cast<std::ptrdiff_t>(rebreak.lastSystem), published.begin() + oldEnd);
+            }
+        }
+        if (m_options.lazyPages) {
+            auto& laidOut = m_systemLaidOut;
+            if (rebreak.systemDelta > 0) {
+                laidOut.insert(laidOut.begin() + oldEnd, static_cast<std::size_t>(rebreak.systemDelta), 0);
+            } else {
+                laidOut.erase(laidOut.begin() + static_cast<std::ptrdiff_t>(rebreak.lastSystem), laidOut.begin() + oldEnd);
+            }
+        }
+    }
+    justifySystemRange(rebreak.firstSystem, rebreak.lastSystem);
+
+    // A changed system count shifts every later system, so pages restack to the end.
+    layout::paginate(m_options, m_layout);
+    const std::size_t firstPage = m_layout.systemPage[rebreak.firstSystem];
+    const std::size_t lastPage = rebreak.systemDelta != 0 ? m_layout.pageCount()
+                                                          : m_layout.systemPage[rebreak.lastSystem - 1] + std::size_t {1};
+    stackPageRange(firstPage, lastPage);
+
+    m_passStats = {.fullPass = false,
+        .firstMeasureRespaced = m_dirtyFirst,
+        .measuresRespaced = m_dirtyLast - m_dirtyFirst,
+        .systemsJustified = rebreak.lastSystem - rebreak.firstSystem,
+        .pagesStacked = lastPage - firstPage};
+}
+
+void NotationEngine::spaceMeasureRange(std::size_t first, std::size_t last) {
+    forRange(first, last, kMeasureGrain, [this](std::size_t begin, std::size_t end) {
+        layout::spaceMeasures(m_notes, m_options, begin, end, m_layout, m_spacing, m_measureCache);
+    });
+}
+
+void NotationEngine::justifySystemRange(std::size_t first, std::size_t last) {
+    unpublishSystems(first, last);
+    if (!m_options.lazyPages) {
+        layoutSystemRange(first, last);
+        return;
+    }
+    // Notes are laid out later, by layoutViewport(), if they are in view.
+    forRange(first, last, kSystemGrain, [this](std::size_t begin, std::size_t end) {
+        layout::justifyMeasures(m_options, m_spacing, begin, end, m_layout);
+    });
+    std::fill(m_systemLaidOut.begin() + static_cast<std::ptrdiff_t>(first),
+        m_systemLaidOut.begin() + static_cast<std::ptrdiff_t>(last), std::uint8_t {0});
+}
+
+void NotationEngine::layoutSystemRange(std::size_t first, std::size_t last) {
+    unpublishSystems(first, last);
+    forRange(first, last, kSystemGrain, [this](std::size_t begin, std::size_t end) {
+        layout::justifySystems(m_options, m_spacing, begin, end, m_layout);
+        layout::resolveCollisions(m_notes, m_markings, m_options, begin, end, m_layout);
+    });
+}
+
+void NotationEngine::stackPageRange(std::size_t first, std::size_t last) {
+    forRange(first, last, kPageGrain, [this](std::size_t begin, std::size_t end) {
+        layout::stackPages(m_options, begin, end, m_layout);
+    });
+}
+
+void NotationEngine::forRange(std::size_t first, std::size_t last, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& body) const {
+    if (m_pool == nullptr || last - first <= grain) {
+        body(first, last);
+        return;
+    }
+    m_pool->parallelFor(last - first, grain, [&](std::size_t begin, std::size_t end) { body(first + begin, first + end); });
 }
 
 } // namespace notascore::notation
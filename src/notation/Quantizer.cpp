@@ -0,0 +1,188 @@
+#include "notascore/notation/Quantizer.hpp"
+
+#include "notascore/core/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace notascore::notation {
+
+namespace {
+
+struct Grid {
+    int step {0};
+    int actual {0};
+    int normal {0};
+};
+
+Tick floorDiv(Tick value, Tick divisor) noexcept {
+    const Tick quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+// Nearest target tick for a source tick.
+Tick rescale(Tick tick, int from, int to) noexcept {
+    if (from == to) {
+        return tick;
+    }
+    return floorDiv(tick * to + from / 2, from);
+}
+
+// Tuplet of `division` notes per quarter: in the time of the largest power of
+// two below it (3:2, 5:4, 6:4, 7:4).
+int normalNotesFor(int division) noexcept {
+    int normal = 1;
+    while (normal * 2 < division) {
+        normal *= 2;
+    }
+    return normal;
+}
+
+} // namespace
+
+bool quantize(std::span<const PerformanceNote> performance, const QuantizeOptions& options, QuantizedTrack& out) {
+    out.notes.clear();
+    out.tuplets.clear();
+    const int tpq = options.ticksPerQuarter;
+    if (options.sourceTicksPerQuarter <= 0 || tpq <= 0 || options.division <= 0 || tpq % options.division != 0) {
+        return false;
+    }
+
+    std::vector<Grid> grids {{.step = tpq / options.division}};
+    if (options.detectTuplets) {
+        for (const int division : options.tupletDivisions) {
+            const RationalTime step(1, 4 * static_cast<std::int64_t>(std::max(division, 1)));
+            if (division > 1 && division != options.division && step.isExactAt(tpq)) {
+                grids.push_back({.step = static_cast<int>(step.toTicks(tpq)), .actual = division,
+                    .normal = normalNotesFor(division)});
+            }
+        }
+    }
+    int finestStep = tpq;
+    for (const auto& grid : grids) {
+        finestStep = std::min(finestStep, grid.step);
+    }
+    // Onsets this close before a beat snap to it on every grid, so they belong to it.
+    const Tick half = finestStep / 2;
+
+    std::vector<PerformanceNote> sorted;
+    if (!std::ranges::is_sorted(performance, {}, &PerformanceNote::onset)) {
+        sorted.assign(performance.begin(), performance.end());
+        std::ranges::stable_sort(sorted, {}, &PerformanceNote::onset);
+        performance = sorted;
+    }
+    const std::size_t count = performance.size();
+
+    // Rescale and split each onset into its beat and a small offset from the
+    // beat (-half <= local < tpq - half), so the grid passes work in floats.
+    std::vector<Tick> beat(count);
+    std::vector<Tick> end(count);
+    std::vector<float> local(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& note = performance[i];
+        const Tick onset = rescale(note.onset, options.sourceTicksPerQuarter, tpq);
+        end[i] = rescale(note.onset + std::max<Tick>(note.duration, 0), options.sourceTicksPerQuarter, tpq);
+        beat[i] = floorDiv(onset + half, tpq);
+        local[i] = static_cast<float>(onset - beat[i] * tpq);
+    }
+
+    // Onset error on every grid. local * inverse + 0.5 is never negative, so
+    // truncation rounds to nearest.
+    std::vector<float> error(count * grids.size());
+    for (std::size_t g = 0; g < grids.size(); ++g) {
+        const float step = static_cast<float>(grids[g].step);
+        const float inverse = 1.0f / step;
+        float* errors = error.data() + g * count;
+        for (std::size_t i = 0; i < count; ++i) {
+            const float snapped = static_cast<float>(static_cast<int>(local[i] * inverse + 0.5f)) * step;
+            errors[i] = std::fabs(local[i] - snapped);
+        }
+    }
+
+    // Pick each beat's grid; beats are runs of equal `beat` in onset order.
+    std::vector<float> stepOf(count);
+    std::vector<Tick> gridBeats;
+    std::vector<std::uint8_t> gridOfBeat;
+    for (std::size_t first = 0; first < count;) {
+        std::size_t last = first;
+        while (last < count && beat[last] == beat[first]) {
+            ++last;
+        }
+        std::size_t best = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        for (std::size_t g = 0; g < grids.size(); ++g) {
+            float cost = g == 0 ? 0.0f : static_cast<float>(options.tupletPenalty) * static_cast<float>(last - first);
+            for (std::size_t i = first; i < last; ++i) {
+                cost += error[g * count + i];
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = g;
+            }
+        }
+        std::fill(stepOf.begin() + static_cast<std::ptrdiff_t>(first), stepOf.begin() + static_cast<std::ptrdiff_t>(last),
+            static_cast<float>(grids[best].step));
+        if (best != 0) {
+            gridBeats.push_back(beat[first]);
+            gridOfBeat.push_back(static_cast<std::uint8_t>(best));
+            out.tuplets.push_back({.tick = beat[first] * tpq, .duration = tpq, .actual = grids[best].actual,
+                .normal = grids[best].normal});
+        }
+        first = last;
+    }
+
+    // Snap onsets to their beat's grid.
+    std::vector<int> snapped(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        snapped[i] = static_cast<int>(local[i] / stepOf[i] + 0.5f) * static_cast<int>(stepOf[i]);
+    }
+
+    // Ends snap to the grid of the beat they fall in.
+    const auto gridAt = [&](Tick beatIndex) -> const Grid& {
+        const auto it = std::ranges::lower_bound(gridBeats, beatIndex);
+        if (it == gridBeats.end() || *it != beatIndex) {
+            return grids[0];
+        }
+        return grids[gridOfBeat[static_cast<std::size_t>(it - gridBeats.begin())]];
+    };
+    out.notes.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const Tick tick = beat[i] * tpq + snapped[i];
+        const Tick endBeat = floorDiv(end[i] + half, tpq);
+        const Tick endStep = gridAt(endBeat).step;
+        const Tick endLocal = end[i] - endBeat * tpq;
+        const Tick endTick = endBeat * tpq + floorDiv(endLocal + endStep / 2, endStep) * endStep;
+        const Tick duration = std::max(endTick - tick, static_cast<Tick>(stepOf[i]));
+        if (tick < 0 || tick + duration > std::numeric_limits<int>::max()) {
+            out.notes.clear();
+            out.tuplets.clear();
+            return false;
+        }
+        out.notes.push_back({.tick = static_cast<int>(tick), .duration = static_cast<int>(duration),
+            .midiPitch = performance[i].midiPitch, .velocity = performance[i].velocity});
+    }
+    return true;
+}
+
+bool quantizeParts(std::span<const std::span<const PerformanceNote>> parts, const QuantizeOptions& options,
+    std::vector<QuantizedTrack>& out, core::ThreadPool* pool) {
+    out.resize(parts.size());
+    std::atomic<bool> ok {true};
+    const auto run = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!quantize(parts[i], options, out[i])) {
+                ok.store(false);
+            }
+        }
+    };
+    if (pool == nullptr || parts.size() < 2) {
+        run(0, parts.size());
+    } else {
+        pool->parallelFor(parts.size(), 1, run);
+    }
+    return ok.load();
+}
+
+} // namespace notascore::notation
@@ -0,0 +1,122 @@
+#include "notascore/notation/RangeValidator.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace notascore::notation {
+
+namespace {
+
+// Measures are checked in blocks of at least this many notes, so the min/max
+// pass runs over long contiguous spans rather than a few notes at a time.
+constexpr std::size_t kBlockNotes = 256;
+
+struct PitchBounds {
+    int low {std::numeric_limits<int>::max()};
+    int high {std::numeric_limits<int>::min()};
+};
+
+PitchBounds pitchBounds(std::span<const NoteEvent> notes) noexcept {
+    int low = std::numeric_limits<int>::max();
+    int high = std::numeric_limits<int>::min();
+    for (const auto& note : notes) {
+        low = std::min(low, note.midiPitch);
+        high = std::max(high, note.midiPitch);
+    }
+    return {.low = low, .high = high};
+}
+
+std::uint32_t countOutside(std::span<const NoteEvent> notes, PitchRange range) noexcept {
+    std::uint32_t count = 0;
+    for (const auto& note : notes) {
+        count += (note.midiPitch < range.low) | (note.midiPitch > range.high) ? 1u : 0u;
+    }
+    return count;
+}
+
+} // namespace
+
+void RangeValidator::checkMeasures(std::span<const NoteEvent> notes, const LayoutResult& layout, std::size_t first,
+    std::size_t last) {
+    const auto& firstNote = layout.measureFirstNote;
+    for (std::size_t begin = first; begin < last;) {
+        std::size_t end = begin + 1;
+        while (end < last && firstNote[end] - firstNote[begin] < kBlockNotes) {
+            ++end;
+        }
+        const auto block = notes.subspan(firstNote[begin], firstNote[end] - firstNote[begin]);
+        const auto bounds = pitchBounds(block);
+        const bool clean = block.empty() || (bounds.low >= m_range.low && bounds.high <= m_range.high);
+        for (std::size_t m = begin; m < end; ++m) {
+            m_total -= m_measureCounts[m];
+            m_measureCounts[m] =
+                clean ? 0 : countOutside(notes.subspan(firstNote[m], firstNote[m + 1] - firstNote[m]), m_range);
+            m_total += m_measureCounts[m];
+        }
+        begin = end;
+    }
+    m_lastChecked += last - first;
+}
+
+void RangeValidator::update(const NotationEngine& engine) {
+    if (engine.isDirty() || (m_valid && engine.layoutVersion() == m_version)) {
+        return;
+    }
+    const auto& layout = engine.layout();
+    const auto& stats = engine.lastPassStats();
+    const std::size_t measureCount = layout.measureCount();
+    const std::size_t oldCount = m_measureCounts.size();
+    m_lastChecked = 0;
+    if (!m_valid || stats.fullPass || engine.layoutVersion() != m_version + 1) {
+        m_measureCounts.assign(measureCount, 0);
+        m_total = 0;
+        checkMeasures(engine.notes(), layout, 0, measureCount);
+    } else {
+        // Measures dropped from the end take their flags with them; appended
+        // ones are checked along with the re-spaced ones.
+        for (std::size_t m = measureCount; m < oldCount; ++m) {
+            m_total -= m_measureCounts[m];
+        }
+        m_measureCounts.resize(measureCount, 0);
+        const std::size_t first = std::min(stats.firstMeasureRespaced, measureCount);
+        const std::size_t last = std::min(first + stats.measuresRespaced, measureCount);
+        checkMeasures(engine.notes(), layout, first, last);
+        if (oldCount < measureCount) {
+            checkMeasures(engine.notes(), layout, std::max(oldCount, last), measureCount);
+        }
+    }
+    m_valid = true;
+    m_version = engine.layoutVersion();
+}
+
+void RangeValidator::outOfRangeNotes(const NotationEngine& engine, std::size_t firstMeasure, std::size_t lastMeasure,
+    NoteSelection& out) const {
+    const auto notes = engine.notes();
+    const auto& firstNote = engine.layout().measureFirstNote;
+    lastMeasure = std::min(lastMeasure, m_measureCounts.size());
+    for (std::size_t m = firstMeasure; m < lastMeasure; ++m) {
+        if (m_measureCounts[m] == 0) {
+            continue;
+        }
+        for (std::uint32_t n = firstNote[m]; n < firstNote[m + 1]; ++n) {
+            if (!m_range.contains(notes[n].midiPitch)) {
+                out.add(n);
+            }
+        }
+    }
+}
+
+void RangeValidator::highlights(const NotationEngine& engine, std::size_t firstPage, std::size_t lastPage,
+    std::vector<SelectionHighlight>& out) const {
+    const auto& layout = engine.layout();
+    lastPage = std::min(lastPage, layout.pageCount());
+    if (firstPage >= lastPage || m_total == 0) {
+        return;
+    }
+    NoteSelection flagged;
+    outOfRangeNotes(engine, layout.systemFirstMeasure[layout.pageFirstSystem[firstPage]],
+        layout.systemFirstMeasure[layout.pageFirstSystem[lastPage]], flagged);
+    selectionHighlights(flagged, layout, firstPage, lastPage, out);
+}
+
+} // namespace notascore::notation
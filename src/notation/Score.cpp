@@ -0,0 +1,348 @@
+#include "notascore/notation/Score.hpp"
+
+#include "notascore/core/ThreadPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace notascore::notation {
+
+namespace {
+
+constexpr std::size_t kLowMemoryCacheCapacity = 512;
+
+} // namespace
+
+Part::Part(core::Symbol name, core::Symbol range, std::size_t staffCount, const LayoutOptions& options)
+    : m_name(name), m_range(range), m_pitchRange(parsePitchRange(core::text(range))),
+      m_staves(std::max<std::size_t>(staffCount, 1)), m_options(options) {
+    for (auto& staff : m_staves) {
+        staff.voices.push_back(makeVoice());
+        if (m_pitchRange) {
+            staff.validators.emplace_back(*m_pitchRange);
+        }
+    }
+}
+
+std::unique_ptr<NotationEngine> Part::makeVoice() const {
+    auto engine = std::make_unique<NotationEngine>();
+    engine->setLayoutOptions(m_options);
+    engine->setMeasureIndex(m_measureIndex);
+    engine->setThreadPool(m_pool);
+    engine->setMeasureCache(m_measureCache);
+    return engine;
+}
+
+std::size_t Part::voiceCount(std::size_t staff) const noexcept {
+    if (staff >= m_staves.size()) {
+        return 0;
+    }
+    return m_loaded ? m_staves[staff].voices.size() : m_staves[staff].packed.size();
+}
+
+std::size_t Part::addVoice(std::size_t staff) {
+    auto& target = m_staves.at(staff);
+    if (!m_loaded) {
+        target.packed.emplace_back();
+        return target.packed.size() - 1;
+    }
+    target.voices.push_back(makeVoice());
+    if (m_pitchRange) {
+        target.validators.emplace_back(*m_pitchRange);
+    }
+    return target.voices.size() - 1;
+}
+
+NotationEngine* Part::voice(std::size_t staff, std::size_t voice) noexcept {
+    if (!m_loaded || staff >= m_staves.size() || voice >= m_staves[staff].voices.size()) {
+        return nullptr;
+    }
+    return m_staves[staff].voices[voice].get();
+}
+
+const NotationEngine* Part::voice(std::size_t staff, std::size_t voice) const noexcept {
+    return const_cast<Part*>(this)->voice(staff, voice);
+}
+
+const RangeValidator* Part::rangeValidator(std::size_t staff, std::size_t voice) const noexcept {
+    if (staff >= m_staves.size() || voice >= m_staves[staff].validators.size()) {
+        return nullptr;
+    }
+    return &m_staves[staff].validators[voice];
+}
+
+std::uint64_t Part::outOfRangeCount() const noexcept {
+    std::uint64_t count = 0;
+    for (const auto& staff : m_staves) {
+        for (const auto& validator : staff.validators) {
+            count += validator.outOfRangeCount();
+        }
+    }
+    return count;
+}
+
+std::size_t Part::noteCount() const noexcept {
+    std::size_t count = 0;
+    for (const auto& staff : m_staves) {
+        for (const auto& engine : staff.voices) {
+            count += engine->noteCount();
+        }
+        for (const auto& packed : staff.packed) {
+            count += packed.notes.size();
+        }
+    }
+    return count;
+}
+
+void Part::unload() {
+    if (!m_loaded) {
+        return;
+    }
+    for (auto& staff : m_staves) {
+        staff.packed.resize(staff.voices.size());
+        for (std::size_t v = 0; v < staff.voices.size(); ++v) {
+            const auto& engine = *staff.voices[v];
+            auto& notes = staff.packed[v].notes;
+            notes.clear();
+            notes.reserve(engine.noteCount());
+            for (const auto& note : engine.notes()) {
+                notes.push_back(PackedNote::pack(note, static_cast<std::uint8_t>(std::min<std::size_t>(v, 255))));
+            }
+            staff.packed[v].markings.assign(engine.markings().begin(), engine.markings().end());
+        }
+        staff.voices.clear();
+        staff.voices.shrink_to_fit();
+        staff.validators.clear();
+    }
+    m_loaded = false;
+}
+
+void Part::load() {
+    if (m_loaded) {
+        return;
+    }
+    for (auto& staff : m_staves) {
+        staff.voices.reserve(staff.packed.size());
+        for (auto& packed : staff.packed) {
+            auto engine = makeVoice();
+            std::vector<NoteEvent> notes;
+            notes.reserve(packed.notes.size());
+            for (const auto& note : packed.notes) {
+                // Packed from NoteEvents, so the tick always fits.
+                notes.push_back(note.unpack().value_or(NoteEvent {}));
+            }
+            engine->addNotes(notes);
+            for (const auto& marking : packed.markings) {
+                engine->addMarking(marking);
+            }
+            // A reloaded part starts with a fresh history, as after opening a file.
+            engine->clearUndoHistory();
+            staff.voices.push_back(std::move(engine));
+            if (m_pitchRange) {
+                staff.validators.emplace_back(*m_pitchRange);
+            }
+        }
+        staff.packed.clear();
+        staff.packed.shrink_to_fit();
+    }
+    m_loaded = true;
+}
+
+std::span<const PackedNote> Part::unloadedNotes(std::size_t staff, std::size_t voice) const noexcept {
+    if (m_loaded || staff >= m_staves.size() || voice >= m_staves[staff].packed.size()) {
+        return {};
+    }
+    return m_staves[staff].packed[voice].notes;
+}
+
+std::span<const Marking> Part::unloadedMarkings(std::size_t staff, std::size_t voice) const noexcept {
+    if (m_loaded || staff >= m_staves.size() || voice >= m_staves[staff].packed.size()) {
+        return {};
+    }
+    return m_staves[staff].packed[voice].markings;
+}
+
+bool Part::addLoadedNotes(std::size_t staff, std::size_t voice, std::span<const NoteEvent> events) {
+    if (m_loaded) {
+        NotationEngine* engine = this->voice(staff, voice);
+        return engine != nullptr && engine->addLoadedNotes(events);
+    }
+    if (staff >= m_staves.size() || voice >= m_staves[staff].packed.size()
+        || std::ranges::any_of(events, [](const NoteEvent& event) { return event.tick < 0; })) {
+        return false;
+    }
+    auto& notes = m_staves[staff].packed[voice].notes;
+    const auto middle = static_cast<std::ptrdiff_t>(notes.size());
+    const auto packedVoice = static_cast<std::uint8_t>(std::min<std::size_t>(voice, 255));
+    for (const auto& event : events) {
+        notes.push_back(PackedNote::pack(event, packedVoice));
+    }
+    const auto byTick = [](const PackedNote& a, const PackedNote& b) { return a.tick() < b.tick(); };
+    std::stable_sort(notes.begin() + middle, notes.end(), byTick);
+    std::inplace_merge(notes.begin(), notes.begin() + middle, notes.end(), byTick);
+    return true;
+}
+
+void Part::setLayoutOptions(const LayoutOptions& options) {
+    m_options = options;
+    for (auto& staff : m_staves) {
+        for (auto& engine : staff.voices) {
+            engine->setLayoutOptions(options);
+        }
+    }
+}
+
+void Part::setMeasureIndex(std::shared_ptr<const MeasureIndex> index) {
+    m_measureIndex = std::move(index);
+    for (auto& staff : m_staves) {
+        for (auto& engine : staff.voices) {
+            engine->setMeasureIndex(m_measureIndex);
+        }
+    }
+}
+
+void Part::setThreadPool(notascore::core::ThreadPool* pool) noexcept {
+    m_pool = pool;
+    for (auto& staff : m_staves) {
+        for (auto& engine : staff.voices) {
+            engine->setThreadPool(pool);
+        }
+    }
+}
+
+void Part::setMeasureCache(MeasureCache* cache) noexcept {
+    m_measureCache = cache;
+    for (auto& staff : m_staves) {
+        for (auto& engine : staff.voices) {
+            engine->setMeasureCache(cache);
+        }
+    }
+}
+
+void Part::recomputeLayoutIfNeeded() {
+    for (auto& staff : m_staves) {
+        for (std::size_t v = 0; v < staff.voices.size(); ++v) {
+            staff.voices[v]->recomputeLayoutIfNeeded();
+            if (v < staff.validators.size()) {
+                staff.validators[v].update(*staff.voices[v]);
+            }
+        }
+    }
+}
+
+bool Part::isDirty() const noexcept {
+    return std::ranges::any_of(m_staves, [](const Staff& staff) {
+        return std::ranges::any_of(staff.voices, [](const auto& engine) { return engine->isDirty(); });
+    });
+}
+
+Part& Score::addPart(core::Symbol name, core::Symbol range, std::size_t staffCount) {
+    auto& part = m_parts.emplace_back(std::make_unique<Part>(name, range, staffCount, m_options));
+    m_partIds.push_back(m_nextPartId++);
+    part->setMeasureIndex(m_measureIndex);
+    part->setThreadPool(m_pool);
+    part->setMeasureCache(&m_measureCache);
+    return *part;
+}
+
+Part& Score::addPart(std::string_view name, std::string_view range, std::size_t staffCount) {
+    return addPart(core::intern(name), core::intern(range), staffCount);
+}
+
+void Score::removePart(std::size_t index) {
+    if (index < m_parts.size()) {
+        m_parts.erase(m_parts.begin() + static_cast<std::ptrdiff_t>(index));
+        m_partIds.erase(m_partIds.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+}
+
+void Score::clear() {
+    m_parts.clear();
+    m_partIds.clear();
+}
+
+Part* Score::findPart(std::uint64_t id) noexcept {
+    const auto found = std::ranges::find(m_partIds, id);
+    return found == m_partIds.end() ? nullptr : m_parts[static_cast<std::size_t>(found - m_partIds.begin())].get();
+}
+
+std::size_t Score::noteCount() const noexcept {
+    std::size_t count = 0;
+    for (const auto& part : m_parts) {
+        if (part->isLoaded()) {
+            count += part->noteCount();
+        }
+    }
+    return count;
+}
+
+void Score::setLayoutOptions(const LayoutOptions& options) {
+    const std::size_t capacity = options.lowMemoryMode ? kLowMemoryCacheCapacity : MeasureCache::kDefaultCapacity;
+    if (capacity != m_measureCache.capacity()) {
+        m_measureCache.setCapacity(capacity);
+    } else if (options.ticksPerQuarter != m_options.ticksPerQuarter || options.measureTicks != m_options.measureTicks
+        || options.spaceUnit != m_options.spaceUnit || options.measurePadding != m_options.measurePadding) {
+        // Entries are keyed by these too, so the old ones could never hit again.
+        m_measureCache.clear();
+    }
+    m_options = options;
+    for (auto& part : m_parts) {
+        part->setLayoutOptions(options);
+    }
+}
+
+void Score::setThreadPool(notascore::core::ThreadPool* pool) noexcept {
+    m_pool = pool;
+    for (auto& part : m_parts) {
+        part->setThreadPool(pool);
+    }
+}
+
+void Score::forEachPart(const std::function<void(Part&)>& body) {
+    const auto run = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (m_parts[i]->isLoaded()) {
+                body(*m_parts[i]);
+            }
+        }
+    };
+    if (m_pool == nullptr || m_parts.size() < 2) {
+        run(0, m_parts.size());
+        return;
+    }
+    m_pool->parallelFor(m_parts.size(), 1, run);
+}
+
+NotationEngine* Score::historyVoice(bool redo) const noexcept {
+    NotationEngine* chosen = nullptr;
+    std::uint64_t chosenStamp = 0;
+    for (const auto& part : m_parts) {
+        for (std::size_t s = 0; s < part->staffCount(); ++s) {
+            for (std::size_t v = 0; v < part->voiceCount(s); ++v) {
+                NotationEngine* voice = part->voice(s, v);
+                const std::uint64_t stamp = voice == nullptr ? 0 : (redo ? voice->redoStamp() : voice->undoStamp());
+                if (stamp != 0 && (chosen == nullptr || (redo ? stamp < chosenStamp : stamp > chosenStamp))) {
+                    chosen = voice;
+                    chosenStamp = stamp;
+                }
+            }
+        }
+    }
+    return chosen;
+}
+
+bool Score::undo() {
+    NotationEngine* voice = historyVoice(false);
+    return voice != nullptr && voice->undo();
+}
+
+bool Score::redo() {
+    NotationEngine* voice = historyVoice(true);
+    return voice != nullptr && voice->redo();
+}
+
+void Score::recomputeLayoutIfNeeded() {
+    forEachPart([](Part& part) { part.recomputeLayoutIfNeeded(); });
+}
+
+} // namespace notascore::notation
@@ -0,0 +1,424 @@
+#include "notascore/notation/Selection.hpp"
+
+#include "notascore/notation/Glyphs.hpp"
+#include "notascore/notation/Layout.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace notascore::notation {
+
+namespace {
+
+// Sets (or clears) bits [first, last) of a bitmap.
+void fillBits(std::vector<std::uint64_t>& words, std::uint32_t first, std::uint32_t last, bool set) noexcept {
+    while (first < last) {
+        const std::uint32_t word = first / 64;
+        const std::uint32_t end = std::min(last, (word + 1) * 64);
+        const std::uint32_t width = end - first;
+        const std::uint64_t mask = (width == 64 ? ~std::uint64_t {0} : ((std::uint64_t {1} << width) - 1)) << (first % 64);
+        words[word] = set ? words[word] | mask : words[word] & ~mask;
+        first = end;
+    }
+}
+
+std::uint32_t popcount(const std::vector<std::uint64_t>& words) noexcept {
+    std::uint32_t count = 0;
+    for (const auto word : words) {
+        count += static_cast<std::uint32_t>(std::popcount(word));
+    }
+    return count;
+}
+
+} // namespace
+
+const NoteSelection::Chunk* NoteSelection::find(std::uint32_t key) const noexcept {
+    const auto it = std::ranges::lower_bound(m_chunks, key, {}, &Chunk::key);
+    return it != m_chunks.end() && it->key == key ? &*it : nullptr;
+}
+
+NoteSelection::Chunk& NoteSelection::findOrInsert(std::uint32_t key) {
+    const auto it = std::ranges::lower_bound(m_chunks, key, {}, &Chunk::key);
+    if (it != m_chunks.end() && it->key == key) {
+        return *it;
+    }
+    return *m_chunks.insert(it, Chunk {.key = key});
+}
+
+void NoteSelection::eraseEmpty() {
+    std::erase_if(m_chunks, [](const Chunk& chunk) { return chunk.count == 0; });
+}
+
+void NoteSelection::toBitmap(Chunk& chunk) {
+    if (chunk.kind == Kind::Bitmap) {
+        return;
+    }
+    chunk.words.assign(kBitmapWords, 0);
+    if (chunk.kind == Kind::Array) {
+        for (const auto offset : chunk.values) {
+            chunk.words[offset / 64] |= std::uint64_t {1} << (offset % 64);
+        }
+    } else {
+        for (std::size_t i = 0; i < chunk.values.size(); i += 2) {
+            fillBits(chunk.words, chunk.values[i], chunk.values[i + 1] + 1u, true);
+        }
+    }
+    chunk.values.clear();
+    chunk.kind = Kind::Bitmap;
+}
+
+void NoteSelection::compact(Chunk& chunk) {
+    toBitmap(chunk);
+    chunk.count = popcount(chunk.words);
+    // A run starts at every set bit whose predecessor is clear.
+    std::size_t runs = 0;
+    std::uint64_t carry = 0;
+    for (const auto word : chunk.words) {
+        runs += static_cast<std::size_t>(std::popcount(word & ~((word << 1) | carry)));
+        carry = word >> 63;
+    }
+
+    const std::size_t arrayBytes = chunk.count * sizeof(std::uint16_t);
+    const std::size_t runBytes = runs * 2 * sizeof(std::uint16_t);
+    const std::size_t bitmapBytes = kBitmapWords * sizeof(std::uint64_t);
+    if (runBytes <= arrayBytes && runBytes < bitmapBytes) {
+        std::vector<std::uint16_t> values;
+        values.reserve(runs * 2);
+        for (std::uint32_t bit = nextBit(chunk.words, 0, true); bit < kChunkSize;) {
+            const std::uint32_t stop = nextBit(chunk.words, bit, false);
+            values.push_back(static_cast<std::uint16_t>(bit));
+            values.push_back(static_cast<std::uint16_t>(stop - 1));
+            bit = stop < kChunkSize ? nextBit(chunk.words, stop, true) : kChunkSize;
+        }
+        chunk.values = std::move(values);
+        chunk.kind = Kind::Runs;
+    } else if (chunk.count <= kMaxArray) {
+        std::vector<std::uint16_t> values;
+        values.reserve(chunk.count);
+        for (std::size_t w = 0; w < kBitmapWords; ++w) {
+            for (std::uint64_t word = chunk.words[w]; word != 0; word &= word - 1) {
+                values.push_back(static_cast<std::uint16_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(word))));
+            }
+        }
+        chunk.values = std::move(values);
+        chunk.kind = Kind::Array;
+    } else {
+        return;
+    }
+    chunk.words.clear();
+    chunk.words.shrink_to_fit();
+}
+
+void NoteSelection::add(std::uint32_t index) {
+    Chunk& chunk = findOrInsert(index >> kChunkBits);
+    const auto offset = static_cast<std::uint16_t>(index);
+    switch (chunk.kind) {
+    case Kind::Array: {
+        const auto it = std::ranges::lower_bound(chunk.values, offset);
+        if (it != chunk.values.end() && *it == offset) {
+            return;
+        }
+        chunk.values.insert(it, offset);
+        if (++chunk.count > kMaxArray) {
+            toBitmap(chunk);
+        }
+        return;
+    }
+    case Kind::Bitmap: {
+        auto& word = chunk.words[offset / 64];
+        const std::uint64_t bit = std::uint64_t {1} << (offset % 64);
+        chunk.count += (word & bit) == 0 ? 1 : 0;
+        word |= bit;
+        return;
+    }
+    case Kind::Runs:
+        if (!contains(index)) {
+            toBitmap(chunk);
+            fillBits(chunk.words, offset, offset + 1u, true);
+            compact(chunk);
+        }
+        return;
+    }
+}
+
+void NoteSelection::addRange(std::uint32_t first, std::uint32_t last) {
+    while (first < last) {
+        const std::uint32_t key = first >> kChunkBits;
+        const std::uint64_t chunkEnd = (static_cast<std::uint64_t>(key) + 1) << kChunkBits;
+        const auto end = static_cast<std::uint32_t>(std::min<std::uint64_t>(last, chunkEnd));
+        const auto from = static_cast<std::uint16_t>(first);
+        const std::uint32_t to = end - (key << kChunkBits);
+        Chunk& chunk = findOrInsert(key);
+        if (chunk.count == 0) {
+            chunk.kind = Kind::Runs;
+            chunk.values = {from, static_cast<std::uint16_t>(to - 1)};
+            chunk.count = to - from;
+        } else {
+            toBitmap(chunk);
+            fillBits(chunk.words, from, to, true);
+            compact(chunk);
+        }
+        if (end == last) {
+            return;
+        }
+        first = end;
+    }
+}
+
+void NoteSelection::remove(std::uint32_t index) {
+    if (!contains(index)) {
+        return;
+    }
+    Chunk& chunk = findOrInsert(index >> kChunkBits);
+    const auto offset = static_cast<std::uint16_t>(index);
+    if (chunk.kind == Kind::Array) {
+        chunk.values.erase(std::ranges::lower_bound(chunk.values, offset));
+        --chunk.count;
+    } else {
+        const bool wasRuns = chunk.kind == Kind::Runs;
+        toBitmap(chunk);
+        chunk.words[offset / 64] &= ~(std::uint64_t {1} << (offset % 64));
+        --chunk.count;
+        if (wasRuns || chunk.count <= kMaxArray) {
+            compact(chunk);
+        }
+    }
+    if (chunk.count == 0) {
+        eraseEmpty();
+    }
+}
+
+bool NoteSelection::contains(std::uint32_t index) const noexcept {
+    const Chunk* chunk = find(index >> kChunkBits);
+    if (chunk == nullptr) {
+        return false;
+    }
+    const auto offset = static_cast<std::uint16_t>(index);
+    switch (chunk->kind) {
+    case Kind::Array:
+        return std::ranges::binary_search(chunk->values, offset);
+    case Kind::Bitmap:
+        return (chunk->words[offset / 64] >> (offset % 64) & 1u) != 0;
+    case Kind::Runs: {
+        // Last run starting at or before `offset`.
+        std::size_t low = 0;
+        std::size_t high = chunk->values.size() / 2;
+        while (low < high) {
+            const std::size_t mid = (low + high) / 2;
+            if (chunk->values[2 * mid] <= offset) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low > 0 && offset <= chunk->values[2 * (low - 1) + 1];
+    }
+    }
+    return false;
+}
+
+std::uint64_t NoteSelection::size() const noexcept {
+    std::uint64_t total = 0;
+    for (const auto& chunk : m_chunks) {
+        total += chunk.count;
+    }
+    return total;
+}
+
+std::size_t NoteSelection::memoryBytes() const noexcept {
+    std::size_t bytes = m_chunks.capacity() * sizeof(Chunk);
+    for (const auto& chunk : m_chunks) {
+        bytes += chunk.values.capacity() * sizeof(std::uint16_t) + chunk.words.capacity() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
+
+void NoteSelection::unite(Chunk& chunk, const Chunk& other) {
+    if (chunk.kind == Kind::Array && other.kind == Kind::Array && chunk.count + other.count <= kMaxArray) {
+        std::vector<std::uint16_t> merged;
+        merged.reserve(chunk.count + other.count);
+        std::ranges::set_union(chunk.values, other.values, std::back_inserter(merged));
+        chunk.values = std::move(merged);
+        chunk.count = static_cast<std::uint32_t>(chunk.values.size());
+        return;
+    }
+    toBitmap(chunk);
+    if (other.kind == Kind::Bitmap) {
+        for (std::size_t w = 0; w < kBitmapWords; ++w) {
+            chunk.words[w] |= other.words[w];
+        }
+    } else if (other.kind == Kind::Array) {
+        for (const auto offset : other.values) {
+            chunk.words[offset / 64] |= std::uint64_t {1} << (offset % 64);
+        }
+    } else {
+        for (std::size_t i = 0; i < other.values.size(); i += 2) {
+            fillBits(chunk.words, other.values[i], other.values[i + 1] + 1u, true);
+        }
+    }
+    compact(chunk);
+}
+
+void NoteSelection::intersect(Chunk& chunk, const Chunk& other) {
+    if (chunk.kind == Kind::Array || other.kind == Kind::Array) {
+        // Filter the array side through the other chunk.
+        const Chunk& array = chunk.kind == Kind::Array ? chunk : other;
+        const Chunk& filter = chunk.kind == Kind::Array ? other : chunk;
+        NoteSelection probe;
+        probe.m_chunks.push_back(filter);
+        probe.m_chunks.back().key = 0;
+        std::vector<std::uint16_t> kept;
+        kept.reserve(array.values.size());
+        for (const auto offset : array.values) {
+            if (probe.contains(offset)) {
+                kept.push_back(offset);
+            }
+        }
+        chunk.kind = Kind::Array;
+        chunk.values = std::move(kept);
+        chunk.words.clear();
+        chunk.count = static_cast<std::uint32_t>(chunk.values.size());
+        return;
+    }
+    toBitmap(chunk);
+    if (other.kind == Kind::Bitmap) {
+        for (std::size_t w = 0; w < kBitmapWords; ++w) {
+            chunk.words[w] &= other.words[w];
+        }
+    } else {
+        std::vector<std::uint64_t> mask(kBitmapWords, 0);
+        for (std::size_t i = 0; i < other.values.size(); i += 2) {
+            fillBits(mask, other.values[i], other.values[i + 1] + 1u, true);
+        }
+        for (std::size_t w = 0; w < kBitmapWords; ++w) {
+            chunk.words[w] &= mask[w];
+        }
+    }
+    compact(chunk);
+}
+
+NoteSelection& NoteSelection::operator|=(const NoteSelection& other) {
+    std::vector<Chunk> merged;
+    merged.reserve(m_chunks.size() + other.m_chunks.size());
+    auto mine = m_chunks.begin();
+    auto theirs = other.m_chunks.begin();
+    while (mine != m_chunks.end() || theirs != other.m_chunks.end()) {
+        if (theirs == other.m_chunks.end() || (mine != m_chunks.end() && mine->key < theirs->key)) {
+            merged.push_back(std::move(*mine++));
+        } else if (mine == m_chunks.end() || theirs->key < mine->key) {
+            merged.push_back(*theirs++);
+        } else {
+            unite(*mine, *theirs++);
+            merged.push_back(std::move(*mine++));
+        }
+    }
+    m_chunks = std::move(merged);
+    return *this;
+}
+
+NoteSelection& NoteSelection::operator&=(const NoteSelection& other) {
+    auto theirs = other.m_chunks.begin();
+    for (auto& chunk : m_chunks) {
+        while (theirs != other.m_chunks.end() && theirs->key < chunk.key) {
+            ++theirs;
+        }
+        if (theirs == other.m_chunks.end() || theirs->key != chunk.key) {
+            chunk.count = 0;
+        } else {
+            intersect(chunk, *theirs);
+        }
+    }
+    eraseEmpty();
+    return *this;
+}
+
+bool NoteSelection::operator==(const NoteSelection& other) const {
+    return std::ranges::equal(runs(), other.runs());
+}
+
+static_assert(std::forward_iterator<NoteSelection::RangeIterator>);
+
+void NoteSelection::RangeIterator::readNext() noexcept {
+    const auto& chunks = *m_chunks;
+    while (m_chunk < chunks.size()) {
+        const Chunk& chunk = chunks[m_chunk];
+        const std::uint32_t base = chunk.key << kChunkBits;
+        std::size_t end = chunk.values.size();
+        switch (chunk.kind) {
+        case Kind::Array: {
+            std::size_t j = m_position + std::size_t {1};
+            while (j < end && chunk.values[j] == chunk.values[j - 1] + 1) {
+                ++j;
+            }
+            m_next = {.first = base + chunk.values[m_position], .last = base + chunk.values[j - 1] + 1u};
+            m_position = static_cast<std::uint32_t>(j);
+            break;
+        }
+        case Kind::Runs:
+            m_next = {.first = base + chunk.values[m_position], .last = base + chunk.values[m_position + 1] + 1u};
+            m_position += 2;
+            break;
+        case Kind::Bitmap: {
+            end = kChunkSize;
+            const std::uint32_t bit = nextBit(chunk.words, m_position, true);
+            if (bit == kChunkSize) {
+                ++m_chunk;
+                m_position = 0;
+                continue;
+            }
+            const std::uint32_t stop = nextBit(chunk.words, bit, false);
+            m_next = {.first = base + bit, .last = base + stop};
+            m_position = stop;
+            break;
+        }
+        }
+        if (m_position >= end) {
+            ++m_chunk;
+            m_position = 0;
+        }
+        return;
+    }
+    m_next = {};
+}
+
+std::vector<NoteRange> NoteSelection::ranges() const {
+    std::vector<NoteRange> out;
+    forEachRange([&](std::uint32_t first, std::uint32_t last) { out.push_back({.first = first, .last = last}); });
+    return out;
+}
+
+void selectionHighlights(const NoteSelection& selection, const LayoutResult& layout, std::size_t firstPage,
+    std::size_t lastPage, std::vector<SelectionHighlight>& out) {
+    lastPage = std::min(lastPage, layout.pageCount());
+    if (firstPage >= lastPage) {
+        return;
+    }
+    const auto notehead = glyphs::bbox(Glyph::NoteheadBlack);
+    const auto noteBegin = layout.measureFirstNote[layout.systemFirstMeasure[layout.pageFirstSystem[firstPage]]];
+    const auto noteEnd = layout.measureFirstNote[layout.systemFirstMeasure[layout.pageFirstSystem[lastPage]]];
+    selection.forEachRange(
+        [&](std::uint32_t first, std::uint32_t last) {
+            // Split the run at system breaks.
+            while (first < last) {
+                const std::uint32_t system = layout.measureSystem[layout.noteMeasure[first]];
+                const std::uint32_t end = std::min(last, layout.measureFirstNote[layout.systemFirstMeasure[system + 1]]);
+                const float y = layout.systemY[system];
+                Box box {.x0 = layout.noteX[first], .y0 = y + layout.noteY[first], .x1 = layout.noteX[first],
+                    .y1 = y + layout.noteY[first]};
+                for (std::uint32_t n = first; n < end; ++n) {
+                    box.x0 = std::min(box.x0, layout.noteX[n]);
+                    box.x1 = std::max(box.x1, layout.noteX[n]);
+                    box.y0 = std::min(box.y0, y + layout.noteY[n]);
+                    box.y1 = std::max(box.y1, y + layout.noteY[n]);
+                }
+                // Widen from notehead origins to their outlines (y down).
+                box = {.x0 = box.x0 + notehead.x0, .y0 = box.y0 - notehead.y1, .x1 = box.x1 + notehead.x1,
+                    .y1 = box.y1 - notehead.y0};
+                out.push_back({.page = layout.systemPage[system], .box = box});
+                first = end;
+            }
+        },
+        noteBegin, noteEnd);
+}
+
+} // namespace notascore::notation
@@ -0,0 +1,147 @@
+#include "notascore/notation/TempoMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace notascore::notation {
+
+namespace {
+
+bool validTempo(double bpm) noexcept {
+    return std::isfinite(bpm) && bpm > 0.0;
+}
+
+// Index of the segment containing `value`, given segment start values in
+// ascending order, starting from the guess `hint`. Sorted lookups mostly stay in
+// the same segment or step to the next one, so the search is rarely needed; when
+// it is, it is branch-free over a dense array of starts.
+std::size_t locate(std::span<const double> starts, std::size_t hint, double value) noexcept {
+    const std::size_t count = starts.size();
+    if (starts[hint] <= value && (hint + 1 == count || value < starts[hint + 1])) {
+        return hint;
+    }
+    if (hint + 1 < count && starts[hint + 1] <= value && (hint + 2 == count || value < starts[hint + 2])) {
+        return hint + 1;
+    }
+    const double* base = starts.data();
+    for (std::size_t length = count; length > 1;) {
+        const std::size_t half = length / 2;
+        base = base[half] <= value ? base + half : base;
+        length -= half;
+    }
+    return static_cast<std::size_t>(base - starts.data());
+}
+
+} // namespace
+
+TempoMap::TempoMap(int ticksPerQuarter, double bpm)
+    : m_ticksPerQuarter(std::max(ticksPerQuarter, 1)),
+      m_changes {{.tick = 0, .bpm = validTempo(bpm) ? bpm : 120.0}} {
+    rebuild();
+}
+
+bool TempoMap::setTempo(Tick tick, double bpm, bool rampToNext) {
+    if (tick < 0 || !validTempo(bpm)) {
+        return false;
+    }
+    const TempoChange change {.tick = tick, .bpm = bpm, .rampToNext = rampToNext};
+    const auto it = std::ranges::lower_bound(m_changes, tick, {}, &TempoChange::tick);
+    if (it != m_changes.end() && it->tick == tick) {
+        *it = change;
+    } else {
+        m_changes.insert(it, change);
+    }
+    rebuild();
+    return true;
+}
+
+bool TempoMap::removeTempo(Tick tick) {
+    const auto it = std::ranges::lower_bound(m_changes, tick, {}, &TempoChange::tick);
+    if (tick <= 0 || it == m_changes.end() || it->tick != tick) {
+        return false;
+    }
+    m_changes.erase(it);
+    rebuild();
+    return true;
+}
+
+void TempoMap::rebuild() {
+    m_segments.resize(m_changes.size());
+    m_startTicks.resize(m_changes.size());
+    m_startSeconds.resize(m_changes.size());
+    double seconds = 0.0;
+    for (std::size_t i = 0; i < m_changes.size(); ++i) {
+        const auto& change = m_changes[i];
+        auto& segment = m_segments[i];
+        segment = {.tick = static_cast<double>(change.tick), .seconds = seconds, .bpm = change.bpm};
+        m_startTicks[i] = segment.tick;
+        m_startSeconds[i] = seconds;
+        if (i + 1 < m_changes.size()) {
+            const auto& next = m_changes[i + 1];
+            if (change.rampToNext) {
+                segment.slope = (next.bpm - change.bpm) / static_cast<double>(next.tick - change.tick);
+            }
+            seconds = secondsIn(segment, static_cast<double>(next.tick));
+        }
+    }
+}
+
+double TempoMap::secondsIn(const Segment& segment, double tick) const noexcept {
+    const double secondsPerBeat = 60.0 / static_cast<double>(m_ticksPerQuarter);
+    const double elapsed = tick - segment.tick;
+    // Times before the first change continue at its starting tempo.
+    if (segment.slope == 0.0 || elapsed < 0.0) {
+        return segment.seconds + secondsPerBeat * elapsed / segment.bpm;
+    }
+    // Integral of 60 / (ppq * (bpm + slope * t)) dt.
+    return segment.seconds + secondsPerBeat / segment.slope * std::log1p(segment.slope * elapsed / segment.bpm);
+}
+
+double TempoMap::ticksIn(const Segment& segment, double seconds) const noexcept {
+    const double secondsPerBeat = 60.0 / static_cast<double>(m_ticksPerQuarter);
+    const double elapsed = seconds - segment.seconds;
+    if (segment.slope == 0.0 || elapsed < 0.0) {
+        return segment.tick + elapsed * segment.bpm / secondsPerBeat;
+    }
+    return segment.tick + segment.bpm / segment.slope * std::expm1(elapsed * segment.slope / secondsPerBeat);
+}
+
+std::size_t TempoMap::segmentAtTick(double tick) const noexcept {
+    return locate(m_startTicks, 0, tick);
+}
+
+std::size_t TempoMap::segmentAtSeconds(double seconds) const noexcept {
+    return locate(m_startSeconds, 0, seconds);
+}
+
+double TempoMap::bpmAt(double tick) const noexcept {
+    const auto& segment = m_segments[segmentAtTick(tick)];
+    return segment.bpm + segment.slope * std::max(tick - segment.tick, 0.0);
+}
+
+double TempoMap::secondsAt(double tick) const noexcept {
+    return secondsIn(m_segments[segmentAtTick(tick)], tick);
+}
+
+double TempoMap::ticksAt(double seconds) const noexcept {
+    return ticksIn(m_segments[segmentAtSeconds(seconds)], seconds);
+}
+
+void TempoMap::secondsAt(std::span<const Tick> ticks, std::span<double> out) const noexcept {
+    std::size_t segment = 0;
+    for (std::size_t i = 0; i < ticks.size(); ++i) {
+        const auto tick = static_cast<double>(ticks[i]);
+        segment = locate(m_startTicks, segment, tick);
+        out[i] = secondsIn(m_segments[segment], tick);
+    }
+}
+
+void TempoMap::ticksAt(std::span<const double> seconds, std::span<double> out) const noexcept {
+    std::size_t segment = 0;
+    for (std::size_t i = 0; i < seconds.size(); ++i) {
+        segment = locate(m_startSeconds, segment, seconds[i]);
+        out[i] = ticksIn(m_segments[segment], seconds[i]);
+    }
+}
+
+} // namespace notascore::notation
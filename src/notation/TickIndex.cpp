@@ -0,0 +1,132 @@
+#include "notascore/notation/TickIndex.hpp"
+
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace notascore::notation {
+
+namespace {
+
+constexpr std::int64_t kEmpty = std::numeric_limits<std::int64_t>::min();
+
+std::int64_t noteEnd(const NoteEvent& note) noexcept {
+    return static_cast<std::int64_t>(note.tick) + std::max(note.duration, 1);
+}
+
+std::size_t firstAtOrAfter(std::span<const NoteEvent> notes, std::int64_t tick) {
+    return static_cast<std::size_t>(std::lower_bound(notes.begin(), notes.end(), tick,
+        [](const NoteEvent& note, std::int64_t value) { return note.tick < value; }) - notes.begin());
+}
+
+} // namespace
+
+TickIndex::TickIndex(std::int64_t bucketTicks)
+    : m_bucketTicks(std::max<std::int64_t>(bucketTicks, 1)), m_maxEnd(2, kEmpty) {}
+
+void TickIndex::rebuild(std::span<const NoteEvent> notes, std::int64_t bucketTicks) {
+    m_bucketTicks = std::max<std::int64_t>(bucketTicks, 1);
+    m_leaves = 1;
+    m_maxEnd.assign(2, kEmpty);
+    if (!notes.empty()) {
+        ensureBuckets(static_cast<std::size_t>(notes.back().tick / m_bucketTicks) + 1);
+    }
+    for (const auto& note : notes) {
+        auto& leaf = m_maxEnd[m_leaves + static_cast<std::size_t>(note.tick / m_bucketTicks)];
+        leaf = std::max(leaf, noteEnd(note));
+    }
+    for (std::size_t node = m_leaves - 1; node > 0; --node) {
+        m_maxEnd[node] = std::max(m_maxEnd[2 * node], m_maxEnd[2 * node + 1]);
+    }
+}
+
+void TickIndex::insert(const NoteEvent& note) {
+    const auto bucket = static_cast<std::size_t>(note.tick / m_bucketTicks);
+    ensureBuckets(bucket + 1);
+    raise(bucket, noteEnd(note));
+}
+
+void TickIndex::erase(std::span<const NoteEvent> notes, const NoteEvent& note) {
+    const auto bucket = static_cast<std::size_t>(note.tick / m_bucketTicks);
+    std::size_t node = m_leaves + bucket;
+    if (bucket >= m_leaves || noteEnd(note) < m_maxEnd[node]) {
+        return;
+    }
+    const auto bucketStart = static_cast<std::int64_t>(bucket) * m_bucketTicks;
+    const std::size_t end = firstAtOrAfter(notes, bucketStart + m_bucketTicks);
+    std::int64_t latest = kEmpty;
+    for (std::size_t i = firstAtOrAfter(notes, bucketStart); i < end; ++i) {
+        latest = std::max(latest, noteEnd(notes[i]));
+    }
+    m_maxEnd[node] = latest;
+    for (node /= 2; node > 0; node /= 2) {
+        m_maxEnd[node] = std::max(m_maxEnd[2 * node], m_maxEnd[2 * node + 1]);
+    }
+}
+
+void TickIndex::ensureBuckets(std::size_t count) {
+    if (count <= m_leaves) {
+        return;
+    }
+    std::size_t leaves = m_leaves;
+    while (leaves < count) {
+        leaves *= 2;
+    }
+    std::vector<std::int64_t> grown(2 * leaves, kEmpty);
+    std::copy(m_maxEnd.begin() + static_cast<std::ptrdiff_t>(m_leaves), m_maxEnd.end(),
+        grown.begin() + static_cast<std::ptrdiff_t>(leaves));
+    for (std::size_t node = leaves - 1; node > 0; --node) {
+        grown[node] = std::max(grown[2 * node], grown[2 * node + 1]);
+    }
+    m_leaves = leaves;
+    m_maxEnd = std::move(grown);
+}
+
+void TickIndex::raise(std::size_t bucket, std::int64_t end) noexcept {
+    for (std::size_t node = m_leaves + bucket; node > 0 && m_maxEnd[node] < end; node /= 2) {
+        m_maxEnd[node] = end;
+    }
+}
+
+void TickIndex::query(
+    std::span<const NoteEvent> notes, std::int64_t t0, std::int64_t t1, std::vector<std::uint32_t>& out) const {
+    if (t1 <= t0 || notes.empty()) {
+        return;
+    }
+
+    // Notes starting before t0 that still sound at t0 live in buckets up to t0's.
+    if (t0 > 0) {
+        const auto lastBucket = std::min(static_cast<std::size_t>((t0 - 1) / m_bucketTicks), m_leaves - 1);
+        collectSounding(notes, 1, 0, m_leaves, lastBucket, t0, out);
+    }
+
+    // Every note starting inside [t0, t1) overlaps.
+    const std::size_t first = firstAtOrAfter(notes, t0);
+    const std::size_t last = firstAtOrAfter(notes, t1);
+    for (std::size_t i = first; i < last; ++i) {
+        out.push_back(static_cast<std::uint32_t>(i));
+    }
+}
+
+void TickIndex::collectSounding(std::span<const NoteEvent> notes, std::size_t node, std::size_t nodeFirst,
+    std::size_t nodeLast, std::size_t lastBucket, std::int64_t t0, std::vector<std::uint32_t>& out) const {
+    if (nodeFirst > lastBucket || m_maxEnd[node] <= t0) {
+        return;
+    }
+    if (node >= m_leaves) {
+        const auto bucketStart = static_cast<std::int64_t>(nodeFirst) * m_bucketTicks;
+        const std::size_t end = firstAtOrAfter(notes, std::min(bucketStart + m_bucketTicks, t0));
+        for (std::size_t i = firstAtOrAfter(notes, bucketStart); i < end; ++i) {
+            if (noteEnd(notes[i]) > t0) {
+                out.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        return;
+    }
+    const std::size_t middle = (nodeFirst + nodeLast) / 2;
+    collectSounding(notes, 2 * node, nodeFirst, middle, lastBucket, t0, out);
+    collectSounding(notes, 2 * node + 1, middle, nodeLast, lastBucket, t0, out);
+}
+
+} // namespace notascore::notation
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #if defined(_WIN32)
 
@@ -33,10 +34,10 @@ void fillRoundedRect(HDC hdc, const notascore::ui::Rect& rect, COLORREF color, i
     DeleteObject(brush);
 }
 
-void drawText(HDC hdc, int x, int y, COLORREF color, const std::string& text) {
+void drawText(HDC hdc, int x, int y, COLORREF color, std::string_view text) {
     SetBkMode(hdc, TRANSPARENT);
     SetTextColor(hdc, color);
-    TextOutA(hdc, x, y, text.c_str(), static_cast<int>(text.size()));
+    TextOutA(hdc, x, y, text.data(), static_cast<int>(text.size()));
 }
 
 void drawMainHome(HDC hdc, const notascore::ui::MainWindow& view) {
@@ -95,15 +96,15 @@ void drawWizardPanel(HDC hdc, const notascore::ui::MainWindow& view) {
         for (std::size_t i = 0; i < visible; ++i) {
             const int y = 110 + static_cast<int>(i) * 34;
             const auto& inst = view.instrumentLibrary()[i];
-            drawText(hdc, panel.x + 24, y, rgb(26, 26, 26), inst.name);
-            drawText(hdc, panel.x + 90, y, rgb(110, 110, 110), inst.range);
+            drawText(hdc, panel.x + 24, y, rgb(26, 26, 26), notascore::core::text(inst.name));
+            drawText(hdc, panel.x + 90, y, rgb(110, 110, 110), notascore::core::text(inst.range));
             fillRoundedRect(hdc, view.instrumentAddRect(i), rgb(229, 240, 255), 8);
             drawText(hdc, view.instrumentAddRect(i).x + 6, view.instrumentAddRect(i).y + 2, rgb(37, 99, 235), "+");
         }
 
         for (std::size_t i = 0; i < view.selectedInstruments().size(); ++i) {
             const int y = 110 + static_cast<int>(i) * 30;
-            drawText(hdc, panel.x + 216, y, rgb(26, 26, 26), view.selectedInstruments()[i].name);
+            drawText(hdc, panel.x + 216, y, rgb(26, 26, 26), notascore::core::text(view.selectedInstruments()[i].name));
             fillRoundedRect(hdc, view.selectedInstrumentRemoveRect(i), rgb(255, 243, 243), 6);
             drawText(hdc, view.selectedInstrumentRemoveRect(i).x + 4, view.selectedInstrumentRemoveRect(i).y - 1, rgb(180, 40, 40), "x");
         }
@@ -205,9 +206,9 @@ void drawRect(Display* d, Window w, GC gc, const notascore::ui::Rect& rect, unsi
     XFillRectangle(d, w, gc, rect.x, rect.y, static_cast<unsigned int>(rect.width), static_cast<unsigned int>(rect.height));
 }
 
-void drawText(Display* d, Window w, GC gc, int x, int y, unsigned long color, const std::string& text) {
+void drawText(Display* d, Window w, GC gc, int x, int y, unsigned long color, std::string_view text) {
     XSetForeground(d, gc, color);
-    XDrawString(d, w, gc, x, y, text.c_str(), static_cast<int>(text.size()));
+    XDrawString(d, w, gc, x, y, text.data(), static_cast<int>(text.size()));
 }
 
 void drawMainHome(Display* d, Window w, GC gc, const notascore::ui::MainWindow& view) {
@@ -262,15 +263,15 @@ void drawWizardPanel(Display* d, Window w, GC gc, const notascore::ui::MainWindo
         for (std::size_t i = 0; i < visible; ++i) {
             const int y = 110 + static_cast<int>(i) * 34;
             const auto& inst = view.instrumentLibrary()[i];
-            drawText(d, w, gc, panel.x + 24, y, rgb(26, 26, 26), inst.name);
-            drawText(d, w, gc, panel.x + 90, y, rgb(110, 110, 110), inst.range);
+            drawText(d, w, gc, panel.x + 24, y, rgb(26, 26, 26), notascore::core::text(inst.name));
+            drawText(d, w, gc, panel.x + 90, y, rgb(110, 110, 110), notascore::core::text(inst.range));
             drawRect(d, w, gc, view.instrumentAddRect(i), rgb(229, 240, 255));
             drawText(d, w, gc, view.instrumentAddRect(i).x + 6, view.instrumentAddRect(i).y + 14, rgb(37, 99, 235), "+");
         }
 
         for (std::size_t i = 0; i < view.selectedInstruments().size(); ++i) {
             const int y = 110 + static_cast<int>(i) * 30;
-            drawText(d, w, gc, panel.x + 216, y, rgb(26, 26, 26), view.selectedInstruments()[i].name);
+            drawText(d, w, gc, panel.x + 216, y, rgb(26, 26, 26), notascore::core::text(view.selectedInstruments()[i].name));
             drawRect(d, w, gc, view.selectedInstrumentRemoveRect(i), rgb(255, 243, 243));
             drawText(d, w, gc, view.selectedInstrumentRemoveRect(i).x + 4, view.selectedInstrumentRemoveRect(i).y + 12, rgb(180, 40, 40), "x");
         }
@@ -1,7 +1,11 @@
 #include "notascore/ui/MainWindow.hpp"
 
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Score.hpp"
+
 #include <algorithm>
 #include <array>
+#include <charconv>
 
 namespace notascore::ui {
 
@@ -15,15 +19,16 @@ constexpr int kCardHeight = 170;
 MainWindow::MainWindow(int width, int height, PerformanceSettings settings)
     : m_width(width), m_height(height), m_settings(settings) {
     m_recentProjects = {"String Quartet in D", "Film Cue Sketch", "Piano Etude No. 2"};
+    using core::intern;
     m_instrumentLibrary = {
-        {.group = "Madeiras", .name = "Flute", .range = "C4-C7"},
-        {.group = "Madeiras", .name = "Oboe", .range = "Bb3-A6"},
-        {.group = "Metais", .name = "Trumpet", .range = "F#3-D6"},
-        {.group = "Cordas", .name = "Violin", .range = "G3-A7"},
-        {.group = "Cordas", .name = "Cello", .range = "C2-E5"},
-        {.group = "Percussao", .name = "Snare Drum", .range = "Perc"},
-        {.group = "Teclas", .name = "Piano", .range = "A0-C8"},
-        {.group = "Personalizados", .name = "Synth Lead", .range = "C2-C7"},
+        {.group = intern("Madeiras"), .name = intern("Flute"), .range = intern("C4-C7")},
+        {.group = intern("Madeiras"), .name = intern("Oboe"), .range = intern("Bb3-A6")},
+        {.group = intern("Metais"), .name = intern("Trumpet"), .range = intern("F#3-D6")},
+        {.group = intern("Cordas"), .name = intern("Violin"), .range = intern("G3-A7")},
+        {.group = intern("Cordas"), .name = intern("Cello"), .range = intern("C2-E5")},
+        {.group = intern("Percussao"), .name = intern("Snare Drum"), .range = intern("Perc")},
+        {.group = intern("Teclas"), .name = intern("Piano"), .range = intern("A0-C8"), .staffCount = 2},
+        {.group = intern("Personalizados"), .name = intern("Synth Lead"), .range = intern("C2-C7")},
     };
 
     rebuildActions();
@@ -159,11 +164,9 @@ void MainWindow::onClick(int x, int y) {
         for (std::size_t i = 0; i < visible; ++i) {
             if (instrumentAddRect(i).contains(x, y)) {
                 const auto& candidate = m_instrumentLibrary[i];
-                const auto already = std::find_if(m_selectedInstruments.begin(), m_selectedInstruments.end(),
-                    [&](const auto& item) { return item.name == candidate.name; });
-                if (already == m_selectedInstruments.end()) {
+                if (std::ranges::find(m_selectedInstruments, candidate.name, &InstrumentDef::name) == m_selectedInstruments.end()) {
                     m_selectedInstruments.push_back(candidate);
-                    m_statusText = candidate.name + " added";
+                    setStatus({core::text(candidate.name), " added"});
                 }
                 return;
             }
@@ -173,23 +176,25 @@ void MainWindow::onClick(int x, int y) {
             if (selectedInstrumentRemoveRect(i).contains(x, y)) {
                 const auto removed = m_selectedInstruments[i].name;
                 m_selectedInstruments.erase(m_selectedInstruments.begin() + static_cast<std::ptrdiff_t>(i));
-                m_statusText = removed + " removed";
+                setStatus({core::text(removed), " removed"});
                 return;
             }
         }
     } else {
-        static constexpr std::array<const char*, 4> keyOptions {"C Major", "G Major", "D Minor", "F Major"};
-        static constexpr std::array<const char*, 4> meterOptions {"4/4", "3/4", "6/8", "5/4"};
+        using core::intern;
+        static const std::array<core::Symbol, 4> keyOptions {
+            intern("C Major"), intern("G Major"), intern("D Minor"), intern("F Major")};
+        static const std::array<core::Symbol, 4> meterOptions {intern("4/4"), intern("3/4"), intern("6/8"), intern("5/4")};
 
         if (keySignatureRect().contains(x, y)) {
             m_settingsPresetIndex = (m_settingsPresetIndex + 1) % keyOptions.size();
             m_keySignature = keyOptions[m_settingsPresetIndex];
-            m_statusText = "Key changed to " + m_keySignature;
+            setStatus({"Key changed to ", keySignature()});
             return;
         }
         if (meterRect().contains(x, y)) {
             m_meter = meterOptions[m_settingsPresetIndex % meterOptions.size()];
-            m_statusText = "Meter changed to " + m_meter;
+            setStatus({"Meter changed to ", meter()});
             return;
         }
         if (tempoRect().contains(x, y)) {
@@ -197,7 +202,9 @@ void MainWindow::onClick(int x, int y) {
             if (m_bpm > 180) {
                 m_bpm = 80;
             }
-            m_statusText = "Tempo set to " + std::to_string(m_bpm) + " BPM";
+            std::array<char, 16> digits {};
+            const auto printed = std::to_chars(digits.data(), digits.data() + digits.size(), m_bpm);
+            setStatus({"Tempo set to ", std::string_view(digits.data(), static_cast<std::size_t>(printed.ptr - digits.data())), " BPM"});
             return;
         }
         if (titleRect().contains(x, y)) {
@@ -206,7 +213,7 @@ void MainWindow::onClick(int x, int y) {
             return;
         }
         if (composerRect().contains(x, y)) {
-            m_composer = "NotaScore User";
+            m_composer = core::intern("NotaScore User");
             m_statusText = "Composer auto-filled";
             return;
         }
@@ -234,16 +241,56 @@ void MainWindow::onClick(int x, int y) {
             return;
         }
 
+        createScore();
         ++m_scoreCount;
         m_recentProjects.insert(m_recentProjects.begin(), m_title);
         if (m_recentProjects.size() > 8) {
             m_recentProjects.pop_back();
         }
         m_wizardOpen = false;
-        m_statusText = "Score created: " + m_title;
+        setStatus({"Score created: ", m_title});
+    }
+}
+
+void MainWindow::createScore() {
+    if (m_score == nullptr) {
+        return;
+    }
+    m_score->clear();
+    const int ticksPerQuarter = m_score->layoutOptions().ticksPerQuarter;
+    m_score->tempoMap() = notascore::notation::TempoMap(ticksPerQuarter, static_cast<double>(m_bpm));
+    m_score->setMeasureIndex(
+        notascore::notation::MeasureIndex(ticksPerQuarter, notascore::notation::parseMeter(meter()).value_or(notascore::notation::Meter {})));
+    for (const auto& instrument : m_selectedInstruments) {
+        m_score->addPart(instrument.name, instrument.range, instrument.staffCount);
+    }
+}
+
+void MainWindow::setStatus(std::initializer_list<std::string_view> parts) {
+    m_statusText.clear();
+    for (const auto part : parts) {
+        m_statusText.append(part);
     }
 }
 
+void MainWindow::undo() {
+    const bool undone = m_score != nullptr ? m_score->undo() : m_document != nullptr && m_document->undo();
+    m_statusText = undone ? "Undo" : "Nothing to undo";
+}
+
+void MainWindow::redo() {
+    const bool redone = m_score != nullptr ? m_score->redo() : m_document != nullptr && m_document->redo();
+    m_statusText = redone ? "Redo" : "Nothing to redo";
+}
+
+bool MainWindow::canUndo() const noexcept {
+    return m_score != nullptr ? m_score->canUndo() : m_document != nullptr && m_document->canUndo();
+}
+
+bool MainWindow::canRedo() const noexcept {
+    return m_score != nullptr ? m_score->canRedo() : m_document != nullptr && m_document->canRedo();
+}
+
 void MainWindow::rebuildActions() {
     m_actions = {
         {.label = "CPU Mode Only", .enabled = m_settings.cpuModeOnly},
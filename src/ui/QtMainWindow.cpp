@@ -15,7 +15,10 @@
 #include <QIcon>
 #include <QPixmap>
 #include <QPainter>
+#include <QMenu>
 #include <QMenuBar>
+#include <QAction>
+#include <QKeySequence>
 
 // Local helper to convert Theme::Color -> QColor
 static inline QColor toQColor(const notascore::ui::Color &c) {
@@ -73,8 +76,22 @@ QtMainWindow::QtMainWindow(notascore::ui::MainWindow& view, QWidget* parent)
     fileMenu->addAction(tr("Sair"));
 
     auto* editMenu = menu->addMenu(tr("Editar"));
-    editMenu->addAction(tr("Desfazer"));
-    editMenu->addAction(tr("Refazer"));
+    auto* undoAction = editMenu->addAction(tr("Desfazer"));
+    undoAction->setShortcut(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, [this] {
+        m_view.undo();
+        refresh();
+    });
+    auto* redoAction = editMenu->addAction(tr("Refazer"));
+    redoAction->setShortcut(QKeySequence::Redo);
+    connect(redoAction, &QAction::triggered, this, [this] {
+        m_view.redo();
+        refresh();
+    });
+    connect(editMenu, &QMenu::aboutToShow, this, [this, undoAction, redoAction] {
+        undoAction->setEnabled(m_view.canUndo());
+        redoAction->setEnabled(m_view.canRedo());
+    });
     editMenu->addSeparator();
     editMenu->addAction(tr("Preferências"));
 
@@ -197,10 +214,10 @@ QtMainWindow::QtMainWindow(notascore::ui::MainWindow& view, QWidget* parent)
         auto* instLayout = new QHBoxLayout(instWidget);
         instLayout->setContentsMargins(8, 6, 8, 6);
         
-        auto* nameLabel = new QLabel(QString::fromStdString(inst.name));
+        auto* nameLabel = new QLabel(QString::fromUtf8(notascore::core::text(inst.name)));
         nameLabel->setStyleSheet("font-size: 12px; color: #1A1A1A;");
         
-        auto* rangeLabel = new QLabel(QString::fromStdString(inst.range));
+        auto* rangeLabel = new QLabel(QString::fromUtf8(notascore::core::text(inst.range)));
         rangeLabel->setStyleSheet("font-size: 10px; color: #6E6E6E;");
         
         auto* addBtn = new ModernButton("+", ModernButton::Style::Subtle);
@@ -355,7 +372,7 @@ void QtMainWindow::refresh() {
     // Update selected instruments list
     m_selectedList->clear();
     for (const auto& inst : m_view.selectedInstruments()) {
-        m_selectedList->addItem(QString::fromStdString(inst.name));
+        m_selectedList->addItem(QString::fromUtf8(notascore::core::text(inst.name)));
     }
 
     // Update preview visibility
@@ -0,0 +1,193 @@
+#include "notascore/core/EpochPublisher.hpp"
+#include "notascore/core/SymbolTable.hpp"
+#include "notascore/notation/NotationEngine.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Concurrent readers and writers of published versions. Meant to run under
+// ThreadSanitizer (-DNOTASCORE_ENABLE_TSAN=ON) as well as in normal builds.
+namespace {
+
+using notascore::notation::NotationEngine;
+
+std::atomic<int> g_liveVersions {0};
+
+// Every element holds the version number, so a torn or reused version shows up.
+struct Payload {
+    Payload() { ++g_liveVersions; }
+    ~Payload() { --g_liveVersions; }
+    Payload(const Payload&) = delete;
+    Payload& operator=(const Payload&) = delete;
+
+    std::uint64_t version {0};
+    std::vector<std::uint64_t> values;
+};
+
+bool publisherStress() {
+    constexpr int kReaders = 4;
+    constexpr std::uint64_t kVersions = 20'000;
+    {
+        notascore::core::EpochPublisher<Payload> publisher;
+        std::atomic<bool> done {false};
+        std::atomic<bool> failed {false};
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < kReaders; ++r) {
+            readers.emplace_back([&] {
+                std::uint64_t last = 0;
+                while (!done.load()) {
+                    const auto pin = publisher.pin();
+                    if (!pin) {
+                        continue;
+                    }
+                    bool consistent = pin->version >= last && pin->values.size() == 64 + pin->version % 64;
+                    for (const auto value : pin->values) {
+                        consistent = consistent && value == pin->version;
+                    }
+                    if (!consistent) {
+                        failed.store(true);
+                    }
+                    last = pin->version;
+                }
+            });
+        }
+
+        std::thread writer([&] {
+            for (std::uint64_t v = 1; v <= kVersions; ++v) {
+                auto next = publisher.recycle();
+                if (!next) {
+                    next = std::make_unique<Payload>();
+                }
+                next->version = v;
+                next->values.assign(64 + v % 64, v);
+                publisher.publish(std::move(next));
+            }
+            done.store(true);
+        });
+
+        writer.join();
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        // With every reader gone only the current version and the recycled ones remain.
+        publisher.reclaim();
+        const int live = g_liveVersions.load();
+        if (failed.load() || publisher.retiredCount() != 0
+            || live > 1 + static_cast<int>(notascore::core::EpochPublisher<Payload>::kRecycled)) {
+            return false;
+        }
+    }
+    return g_liveVersions.load() == 0;
+}
+
+// Readers of the engine's published layouts always see a layout that matches
+// the document it was computed from, with versions never going backwards.
+bool engineStress() {
+    NotationEngine engine;
+    engine.enableLayoutPublishing();
+    std::atomic<bool> done {false};
+    std::atomic<bool> failed {false};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            std::uint64_t last = 0;
+            while (!done.load()) {
+                const auto pin = engine.pinLayout();
+                if (!pin) {
+                    continue;
+                }
+                const auto& notes = pin->document.notes;
+                const auto& layout = pin->layout;
+                bool consistent = pin->version >= last && layout.noteCount() == notes.size();
+                for (std::size_t n = 0; consistent && n < notes.size(); n += 97) {
+                    const std::size_t s = layout.systemOfNote(n);
+                    const auto& system = *layout.systems[s];
+                    const std::size_t offset = n - layout.systemFirstNote[s];
+                    consistent = system.noteX.size() == layout.systemFirstNote[s + 1] - layout.systemFirstNote[s]
+                        && system.noteMeasure[offset] == static_cast<std::uint32_t>(notes[n].tick / 1920);
+                }
+                if (!consistent) {
+                    failed.store(true);
+                }
+                last = pin->version;
+            }
+        });
+    }
+
+    std::thread writer([&] {
+        for (int i = 0; i < 3000; ++i) {
+            engine.addNote({.tick = (i * 7919) % 960'000, .duration = 240, .midiPitch = 48 + i % 36});
+            if (i % 3 == 0) {
+                engine.recomputeLayoutIfNeeded();
+            }
+            if (i % 500 == 499) {
+                engine.undo();
+                engine.recomputeLayoutIfNeeded();
+            }
+        }
+        engine.recomputeLayoutIfNeeded();
+        done.store(true);
+    });
+
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    const auto final = engine.pinLayout();
+    return !failed.load() && final && final->version == engine.layoutVersion()
+        && final->document.notes.size() == engine.noteCount();
+}
+
+// Threads interning overlapping names must agree on every id, and text looked
+// up without the lock must match what was interned.
+bool symbolStress() {
+    constexpr int kThreads = 4;
+    constexpr int kNames = 5000;
+    notascore::core::SymbolTable table;
+    std::vector<std::vector<notascore::core::Symbol>> ids(kThreads, std::vector<notascore::core::Symbol>(kNames));
+    std::atomic<bool> failed {false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kNames; ++i) {
+                // Each thread walks the names in a different order.
+                static constexpr int kStrides[kThreads] {1, 3, 7, 9};
+                const int n = (i * kStrides[t]) % kNames;
+                const std::string name = "Instrument " + std::to_string(n);
+                const auto symbol = table.intern(name);
+                ids[static_cast<std::size_t>(t)][static_cast<std::size_t>(n)] = symbol;
+                if (table.text(symbol) != name) {
+                    failed.store(true);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 1; t < kThreads; ++t) {
+        if (ids[static_cast<std::size_t>(t)] != ids[0]) {
+            return false;
+        }
+    }
+    return !failed.load() && table.size() == kNames + 1 && table.intern("").empty()
+        && table.find("Instrument 42") == ids[0][42];
+}
+
+} // namespace
+
+int main() {
+    if (!publisherStress()) {
+        return 1;
+    }
+    if (!symbolStress()) {
+        return 3;
+    }
+    return engineStress() ? 0 : 2;
+}
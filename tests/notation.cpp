@@ -0,0 +1,1216 @@
+#include "notascore/core/ThreadPool.hpp"
+#include "notascore/notation/Collision.hpp"
+#include "notascore/notation/Glyphs.hpp"
+#include "notascore/notation/MeasureCache.hpp"
+#include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/PackedNote.hpp"
+#include "notascore/notation/Quantizer.hpp"
+#include "notascore/notation/RangeValidator.hpp"
+#include "notascore/notation/Score.hpp"
+#include "notascore/notation/TempoMap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+using notascore::notation::LayoutOptions;
+using notascore::notation::LayoutResult;
+using notascore::notation::MeasureCache;
+using notascore::notation::NotationEngine;
+using notascore::notation::NoteEvent;
+
+std::vector<NoteEvent> makeScore(int measures) {
+    std::vector<NoteEvent> notes;
+    for (int m = 0; m < measures; ++m) {
+        const int base = m * 1920;
+        const int step = (m % 3 == 0) ? 240 : 480;
+        for (int tick = 0; tick < 1920; tick += step) {
+            notes.push_back({.tick = base + tick, .duration = step, .midiPitch = 60 + (m + tick / 120) % 19});
+        }
+    }
+    return notes;
+}
+
+bool sameLayout(const LayoutResult& a, const LayoutResult& b) {
+    return a.noteX == b.noteX && a.noteY == b.noteY && a.noteMeasure == b.noteMeasure
+        && a.measureFirstNote == b.measureFirstNote && a.measureX == b.measureX && a.measureWidth == b.measureWidth
+        && a.measureSystem == b.measureSystem && a.systemFirstMeasure == b.systemFirstMeasure && a.systemY == b.systemY
+        && a.systemPage == b.systemPage && a.pageFirstSystem == b.pageFirstSystem && a.systemItems == b.systemItems;
+}
+
+void addMarkings(NotationEngine& engine, int measures) {
+    using notascore::notation::MarkingKind;
+    for (int m = 0; m < measures; ++m) {
+        for (int beat = 0; beat < 4; ++beat) {
+            const int tick = m * 1920 + beat * 480;
+            engine.addMarking({.tick = tick, .kind = MarkingKind::Articulation, .width = 0.8f});
+            engine.addMarking({.tick = tick, .kind = MarkingKind::Lyric, .width = 2.5f});
+        }
+        engine.addMarking({.tick = m * 1920, .kind = MarkingKind::Dynamic, .width = 2.0f});
+        engine.addMarking({.tick = m * 1920 + 240, .kind = MarkingKind::Dynamic, .width = 2.0f});
+    }
+}
+
+// No placed glyph may overlap a notehead or another glyph of its system.
+bool collisionFree(const NotationEngine& engine) {
+    using notascore::notation::Box;
+    const auto& layout = engine.layout();
+    for (std::size_t s = 0; s < layout.systemCount(); ++s) {
+        std::vector<Box> boxes;
+        const auto nBegin = layout.measureFirstNote[layout.systemFirstMeasure[s]];
+        const auto nEnd = layout.measureFirstNote[layout.systemFirstMeasure[s + 1]];
+        for (auto n = nBegin; n < nEnd; ++n) {
+            boxes.push_back({.x0 = layout.noteX[n], .y0 = layout.noteY[n] - 0.5f, .x1 = layout.noteX[n] + 1.18f,
+                .y1 = layout.noteY[n] + 0.5f});
+        }
+        for (const auto& item : layout.systemItems[s]) {
+            const Box box {.x0 = item.x, .y0 = item.y, .x1 = item.x + item.width, .y1 = item.y + item.height};
+            for (std::size_t i = 0; i < boxes.size(); ++i) {
+                if (box.intersects(boxes[i])) {
+                    return false;
+                }
+            }
+            boxes.push_back(box);
+        }
+    }
+    return true;
+}
+
+bool overlapQueriesMatchScan(const NotationEngine& engine) {
+    const auto notes = engine.notes();
+    std::vector<std::uint32_t> hits;
+    for (std::int64_t t0 = 0; t0 < 1920 * 40; t0 += 350) {
+        for (const std::int64_t length : {1, 100, 1920, 1920 * 7}) {
+            hits.clear();
+            engine.notesOverlapping(t0, t0 + length, hits);
+            std::vector<std::uint32_t> expected;
+            for (std::uint32_t i = 0; i < notes.size(); ++i) {
+                const std::int64_t end = notes[i].tick + std::max(notes[i].duration, 1);
+                if (notes[i].tick < t0 + length && end > t0) {
+                    expected.push_back(i);
+                }
+            }
+            if (hits != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Incremental edits must reproduce a full layout of the same score exactly,
+// with or without memoized measure spacing.
+int incrementalMatchesFull(const LayoutOptions& options, MeasureCache* cache = nullptr) {
+    const auto notes = makeScore(600);
+
+    NotationEngine incremental;
+    incremental.setLayoutOptions(options);
+    incremental.setMeasureCache(cache);
+    for (const auto& note : notes) {
+        incremental.addNote(note);
+    }
+    addMarkings(incremental, 600);
+    incremental.recomputeLayoutIfNeeded();
+    if (!incremental.lastPassStats().fullPass || incremental.layout().pageCount() < 2) {
+        return 1;
+    }
+
+    // Dense edits in one measure force re-breaking; a late note appends measures.
+    const std::vector<NoteEvent> edits {
+        {.tick = 1920 * 40 + 60, .duration = 60, .midiPitch = 72},
+        {.tick = 1920 * 40 + 180, .duration = 60, .midiPitch = 74},
+        {.tick = 1920 * 40 + 300, .duration = 60, .midiPitch = 76},
+        {.tick = 1920 * 300 + 120, .duration = 120, .midiPitch = 50},
+        {.tick = 1920 * 610, .duration = 1920, .midiPitch = 67},
+    };
+    for (const auto& edit : edits) {
+        incremental.addNote(edit);
+        incremental.recomputeLayoutIfNeeded();
+        const auto& stats = incremental.lastPassStats();
+        if (stats.fullPass || stats.measuresRespaced == 0 || stats.measuresRespaced > 11) {
+            return 2;
+        }
+    }
+
+    NotationEngine full;
+    full.setLayoutOptions(options);
+    for (const auto& note : notes) {
+        full.addNote(note);
+    }
+    addMarkings(full, 600);
+    for (const auto& edit : edits) {
+        full.addNote(edit);
+    }
+    full.recomputeLayoutIfNeeded();
+
+    if (!sameLayout(incremental.layout(), full.layout()) || !collisionFree(full)) {
+        return 3;
+    }
+    return 0;
+}
+
+// Undo and redo must restore both the notes and a layout identical to laying
+// out the restored score from scratch, through the incremental path.
+bool undoRedoMatchesFull(const LayoutOptions& options) {
+    using notascore::notation::MarkingKind;
+    const auto layoutOf = [&](std::span<const NoteEvent> notes, std::span<const notascore::notation::Marking> markings) {
+        NotationEngine engine;
+        engine.setLayoutOptions(options);
+        engine.addNotes(notes);
+        for (const auto& marking : markings) {
+            engine.addMarking(marking);
+        }
+        engine.recomputeLayoutIfNeeded();
+        return engine.layout();
+    };
+
+    NotationEngine engine;
+    engine.setLayoutOptions(options);
+    engine.addNotes(makeScore(200));
+    addMarkings(engine, 200);
+    engine.recomputeLayoutIfNeeded();
+    engine.clearUndoHistory();
+
+    std::vector<std::vector<NoteEvent>> notes {{engine.notes().begin(), engine.notes().end()}};
+    std::vector<LayoutResult> layouts {engine.layout()};
+    const auto record = [&] {
+        engine.recomputeLayoutIfNeeded();
+        engine.commitUndoStep();
+        notes.emplace_back(engine.notes().begin(), engine.notes().end());
+        layouts.push_back(engine.layout());
+    };
+    // A dense measure that re-breaks systems, notes past the end, and a marking.
+    for (int i = 0; i < 6; ++i) {
+        engine.addNote({.tick = 1920 * 50 + 60 + i * 240, .duration = 60, .midiPitch = 61 + i});
+    }
+    record();
+    engine.addNote({.tick = 1920 * 203, .duration = 1920 * 2, .midiPitch = 48});
+    record();
+    engine.addMarking({.tick = 1920 * 120, .kind = MarkingKind::Dynamic, .width = 3.0f});
+    record();
+
+    const auto matches = [&](std::size_t step) {
+        const auto current = engine.notes();
+        return std::equal(current.begin(), current.end(), notes[step].begin(), notes[step].end())
+            && sameLayout(engine.layout(), layouts[step])
+            && sameLayout(engine.layout(), layoutOf(engine.notes(), engine.markings()));
+    };
+    for (std::size_t step = notes.size() - 1; step > 0; --step) {
+        if (!engine.undo()) {
+            return false;
+        }
+        engine.recomputeLayoutIfNeeded();
+        if (!matches(step - 1) || (!options.lowMemoryMode && engine.lastPassStats().fullPass)) {
+            return false;
+        }
+    }
+    if (engine.canUndo()) {
+        return false;
+    }
+    for (std::size_t step = 1; step < notes.size(); ++step) {
+        if (!engine.redo()) {
+            return false;
+        }
+        engine.recomputeLayoutIfNeeded();
+        if (!matches(step)) {
+            return false;
+        }
+    }
+    return !engine.canRedo();
+}
+
+// Random edits on a persistent vector must match a flat vector, and every older
+// version must stay intact.
+bool persistentVectorMatchesFlat() {
+    using Vector = notascore::notation::PersistentVector<int>;
+    std::vector<int> flat(5000);
+    for (std::size_t i = 0; i < flat.size(); ++i) {
+        flat[i] = static_cast<int>(i);
+    }
+    std::vector<Vector> versions {Vector::fromRange(flat)};
+    std::vector<std::vector<int>> expected {flat};
+    std::uint32_t seed = 12345;
+    for (int edit = 0; edit < 3000; ++edit) {
+        seed = seed * 1664525u + 1013904223u;
+        const std::size_t index = (seed >> 8) % (flat.size() + 1);
+        if (edit % 3 == 2 && index < flat.size()) {
+            flat.erase(flat.begin() + static_cast<std::ptrdiff_t>(index));
+            versions.push_back(versions.back().erase(index));
+        } else {
+            flat.insert(flat.begin() + static_cast<std::ptrdiff_t>(index), -edit);
+            versions.push_back(versions.back().insert(index, -edit));
+        }
+        if (edit % 500 == 0) {
+            expected.push_back(flat);
+        } else {
+            expected.emplace_back();
+        }
+    }
+    for (std::size_t v = 0; v < versions.size(); ++v) {
+        if (expected[v].empty() && v + 1 != versions.size()) {
+            continue;
+        }
+        const auto& reference = v + 1 == versions.size() ? flat : expected[v];
+        std::vector<int> copy;
+        versions[v].copyRange(0, versions[v].size(), copy);
+        if (copy != reference || versions[v][reference.size() / 2] != reference[reference.size() / 2]) {
+            return false;
+        }
+    }
+    // Shared prefixes and suffixes are found without scanning shared leaves.
+    const auto& base = versions.back();
+    const auto edited = base.insert(2500, 7);
+    return Vector::commonPrefix(base, edited) <= 2500 && Vector::commonPrefix(base, edited) >= 2500 - Vector::kLeafSize
+        && Vector::commonSuffix(base, edited) >= base.size() - 2500 - Vector::kLeafSize;
+}
+
+// Parts laid out in parallel match parts laid out alone, and unloading one part
+// leaves the others untouched and reloads it exactly.
+// Bulk edits must reproduce a full layout of the edited score while re-spacing
+// only the measures they touch, and each must undo in one step.
+bool bulkEditsMatchFull(const LayoutOptions& options) {
+    using notascore::notation::BulkEditKind;
+    using notascore::notation::NoteRange;
+    using notascore::notation::NoteSelection;
+    NotationEngine engine;
+    engine.setLayoutOptions(options);
+    engine.addNotes(makeScore(600));
+    addMarkings(engine, 600);
+    engine.recomputeLayoutIfNeeded();
+    engine.clearUndoHistory();
+
+    const auto count = static_cast<std::uint32_t>(engine.noteCount());
+    struct Step {
+        notascore::notation::BulkEdit edit;
+        std::vector<NoteRange> ranges;
+        bool incremental;
+    };
+    const std::vector<Step> steps {
+        {{.kind = BulkEditKind::Transpose, .amount = 5}, {{96, 100}, {104, 106}}, true},
+        {{.kind = BulkEditKind::AdjustVelocity, .amount = -30}, {{0, count}}, true},
+        {{.kind = BulkEditKind::ScaleDurations, .amount = 3, .divisor = 2}, {{2000, 2010}}, true},
+        // Tail shifts keep tick order, across barlines and past the old last measure.
+        // Dropping trailing measures relays out in full in low-memory mode.
+        {{.kind = BulkEditKind::ShiftTicks, .amount = 1920 * 3 + 120}, {{count - 40, count}}, true},
+        {{.kind = BulkEditKind::ShiftTicks, .amount = -120}, {{count - 200, count}}, !options.lowMemoryMode},
+        // Moving notes past their neighbours re-sorts.
+        {{.kind = BulkEditKind::ShiftTicks, .amount = 1920 * 5}, {{300, 320}}, false},
+    };
+    for (const auto& step : steps) {
+        const std::vector<NoteEvent> before(engine.notes().begin(), engine.notes().end());
+        if (!engine.applyBulkEdit(step.edit, step.ranges)) {
+            return false;
+        }
+        engine.recomputeLayoutIfNeeded();
+        if (engine.lastPassStats().fullPass == step.incremental) {
+            return false;
+        }
+        if (step.edit.kind == BulkEditKind::Transpose && engine.lastPassStats().measuresRespaced > 2) {
+            return false;
+        }
+        const std::vector<NoteEvent> after(engine.notes().begin(), engine.notes().end());
+        if (!engine.undo() || !std::ranges::equal(before, engine.notes()) || !engine.redo()
+            || !std::ranges::equal(after, engine.notes())) {
+            return false;
+        }
+        engine.recomputeLayoutIfNeeded();
+    }
+    // Invalid edits are rejected.
+    const std::vector<NoteRange> reversed {{5, 3}};
+    const std::vector<NoteRange> pastEnd {{0, count + 1}};
+    if (engine.notes()[0].velocity != 50 || engine.applyBulkEdit({.kind = BulkEditKind::ScaleDurations}, NoteSelection {})
+        || engine.applyBulkEdit({}, reversed) || engine.applyBulkEdit({}, pastEnd)) {
+        return false;
+    }
+
+    NotationEngine full;
+    full.setLayoutOptions(options);
+    full.addNotes(engine.notes());
+    addMarkings(full, 600);
+    full.recomputeLayoutIfNeeded();
+    return sameLayout(engine.layout(), full.layout());
+}
+
+// The generated glyph tables are constexpr, so they are checked at compile time.
+namespace glyphs = notascore::notation::glyphs;
+using notascore::notation::Anchor;
+using notascore::notation::Glyph;
+static_assert(glyphs::fromName("accidentalSharp") == Glyph::AccidentalSharp);
+static_assert(!glyphs::fromName("notAGlyph"));
+static_assert(glyphs::width(Glyph::NoteheadBlack) > 1.17f && glyphs::width(Glyph::NoteheadBlack) < 1.19f);
+static_assert(glyphs::hasAnchor(Glyph::NoteheadBlack, Anchor::StemUpSE));
+static_assert(!glyphs::hasAnchor(Glyph::AccidentalSharp, Anchor::StemUpSE));
+static_assert(glyphs::layoutBox(Glyph::NoteheadBlack, 10.0f, 5.0f).y0 < 5.0f);
+
+using notascore::notation::RationalTime;
+static_assert(RationalTime(1, 12) * 3 == RationalTime(1, 4));
+static_assert(RationalTime(1, 12) + RationalTime(1, 12) + RationalTime(1, 12) == RationalTime(2, 8));
+static_assert(RationalTime(1, 12) < RationalTime(1, 8) && RationalTime(-1, 4) < RationalTime(0));
+static_assert(RationalTime(1, 12).toTicks(480) == 160 && RationalTime(1, 28).toTicks(480) == 69);
+static_assert(!RationalTime(1, 28).isExactAt(480) && (RationalTime(1, 4) / 5).isExactAt(480));
+static_assert(RationalTime::fromTicks(std::int64_t {1} << 40, 960) == RationalTime(std::int64_t {1} << 32, 15));
+
+using notascore::notation::PitchRange;
+using notascore::notation::parsePitchRange;
+static_assert(parsePitchRange("C4-C7") == PitchRange {.low = 60, .high = 96});
+static_assert(parsePitchRange("Bb3 - A6") == PitchRange {.low = 58, .high = 93});
+static_assert(parsePitchRange("F#3-D6") == PitchRange {.low = 54, .high = 86});
+static_assert(parsePitchRange("A0-C8") == PitchRange {.low = 21, .high = 108});
+static_assert(!parsePitchRange("Perc") && !parsePitchRange("C7-C4") && !parsePitchRange("C4-") && !parsePitchRange("H2-C4"));
+
+using notascore::notation::Meter;
+using notascore::notation::parseMeter;
+static_assert(parseMeter("4/4") == Meter {} && parseMeter("6/8") == Meter {.beats = 6, .beatUnit = 8});
+static_assert(parseMeter("12/8")->barTicks(480) == 2880 && parseMeter("3/4")->barTicks(480) == 1440);
+static_assert(!parseMeter("4/3") && !parseMeter("0/4") && !parseMeter("4/") && !parseMeter("4/4 "));
+
+using notascore::notation::PackedNote;
+static_assert(PackedNote::pack({.tick = 960, .duration = -5, .midiPitch = 127, .velocity = 1}).unpack()
+    == NoteEvent {.tick = 960, .duration = -5, .midiPitch = 127, .velocity = 1});
+static_assert(PackedNote(-(std::int64_t {1} << 40), 480, 60, 80, 3, 0x81).tick() == -(std::int64_t {1} << 40));
+static_assert(PackedNote(std::int64_t {1} << 40, 480, 60, 80, 3, 0x81).voice() == 3
+    && PackedNote(std::int64_t {1} << 40, 480, 60, 80, 3, 0x81).flags() == 0x81);
+static_assert(PackedNote(std::int64_t {1} << 50, 0, 200, -4).tick() == PackedNote::kMaxTick
+    && PackedNote(0, 0, 200, -4).pitch() == 127 && PackedNote(0, 0, 200, -4).velocity() == 0);
+static_assert(!PackedNote(std::int64_t {1} << 40, 480, 60, 80).unpack());
+
+// Jittered sixteenths, then eighth-note triplets, then quintuplets and a held
+// note, at 960 PPQ; quantized to 480 PPQ, each beat must come back exact and
+// the tuplet beats must be found. Parallel and shuffled input must agree.
+bool quantizerFindsGridAndTuplets() {
+    using notascore::notation::PerformanceNote;
+    using notascore::notation::QuantizedTrack;
+    using notascore::notation::Tuplet;
+    const std::vector<int> onsets {0, 120, 240, 360, 480, 640, 800, 960, 1056, 1152, 1248, 1344};
+    const std::vector<int> jitter {9, -14, 6, 12, -7, 15, -11, 4, -8, 10, -5, 7};
+    std::vector<PerformanceNote> performance;
+    std::vector<NoteEvent> expected;
+    for (std::size_t i = 0; i < onsets.size(); ++i) {
+        const int next = i + 1 < onsets.size() ? onsets[i + 1] : 1440;
+        performance.push_back({.onset = 2 * (onsets[i] + jitter[i]), .duration = 2 * (next - onsets[i]) - 30,
+            .midiPitch = 60 + static_cast<int>(i)});
+        expected.push_back({.tick = onsets[i], .duration = next - onsets[i], .midiPitch = 60 + static_cast<int>(i)});
+    }
+    performance.push_back({.onset = 2 * 1440 - 20, .duration = 2 * 1920 + 25, .midiPitch = 40});
+    expected.push_back({.tick = 1440, .duration = 1920, .midiPitch = 40});
+
+    const notascore::notation::QuantizeOptions options {.sourceTicksPerQuarter = 960};
+    QuantizedTrack track;
+    if (!notascore::notation::quantize(performance, options, track) || track.notes != expected
+        || track.tuplets != std::vector<Tuplet> {{.tick = 480, .duration = 480, .actual = 3, .normal = 2},
+               {.tick = 960, .duration = 480, .actual = 5, .normal = 4}}) {
+        return false;
+    }
+
+    std::vector<PerformanceNote> shuffled(performance.rbegin(), performance.rend());
+    std::vector<std::span<const PerformanceNote>> parts(6, performance);
+    parts[3] = shuffled;
+    std::vector<QuantizedTrack> tracks;
+    notascore::core::ThreadPool pool(3);
+    if (!notascore::notation::quantizeParts(parts, options, tracks, &pool) || tracks.size() != parts.size()) {
+        return false;
+    }
+    for (const auto& part : tracks) {
+        if (part.notes.size() != expected.size() || part.tuplets != track.tuplets) {
+            return false;
+        }
+    }
+    // Ticks past the range of a NoteEvent are rejected rather than wrapped.
+    const std::vector<PerformanceNote> tooLong {{.onset = std::int64_t {1} << 40, .duration = 480}};
+    return !notascore::notation::quantize(tooLong, {}, track) && track.notes.empty();
+}
+
+bool partsAreIndependent() {
+    notascore::core::ThreadPool pool(3);
+    notascore::notation::Score score;
+    score.setThreadPool(&pool);
+    for (int p = 0; p < 4; ++p) {
+        auto& part = score.addPart("Part " + std::to_string(p), "C2-C7", p == 0 ? 2 : 1);
+        part.addVoice(0);
+        part.voice(0, 0)->addNotes(makeScore(200 + p * 50));
+        part.voice(0, 1)->addNote({.tick = 960, .duration = 1920, .midiPitch = 48});
+    }
+    score.recomputeLayoutIfNeeded();
+    if (score.measureCache().hits() == 0) {
+        return false;
+    }
+
+    for (std::size_t p = 0; p < score.partCount(); ++p) {
+        NotationEngine alone;
+        alone.addNotes(score.part(p).voice(0, 0)->notes());
+        alone.recomputeLayoutIfNeeded();
+        if (score.part(p).isDirty() || !sameLayout(alone.layout(), score.part(p).voice(0, 0)->layout())) {
+            return false;
+        }
+    }
+
+    auto& unloaded = score.part(2);
+    const std::vector<NoteEvent> before(unloaded.voice(0, 0)->notes().begin(), unloaded.voice(0, 0)->notes().end());
+    const auto layoutBefore = unloaded.voice(0, 0)->layout();
+    const std::size_t total = score.noteCount();
+    unloaded.unload();
+    score.part(1).voice(0, 0)->addNote({.tick = 0, .duration = 120, .midiPitch = 72});
+    score.recomputeLayoutIfNeeded();
+    if (unloaded.voice(0, 0) != nullptr || unloaded.voiceCount(0) != 2
+        || score.noteCount() != total + 1 - unloaded.noteCount()) {
+        return false;
+    }
+    unloaded.load();
+    score.recomputeLayoutIfNeeded();
+    const auto* reloaded = unloaded.voice(0, 0);
+    return reloaded != nullptr && std::ranges::equal(before, reloaded->notes()) && !reloaded->canUndo()
+        && sameLayout(layoutBefore, reloaded->layout()) && score.noteCount() == total + 1;
+}
+
+// Compressed selections must behave like a plain index set through every chunk
+// representation, and drive bulk edits and highlights like explicit ranges.
+bool selectionsMatchSet() {
+    using notascore::notation::NoteRange;
+    using notascore::notation::NoteSelection;
+    const auto toSet = [](const NoteSelection& selection) {
+        std::set<std::uint32_t> indices;
+        selection.forEachIndex([&](std::uint32_t index) { indices.insert(index); });
+        return indices;
+    };
+
+    // Sparse, dense and contiguous chunks, across chunk boundaries.
+    std::uint32_t state = 12345;
+    const auto next = [&] {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+    NoteSelection a;
+    NoteSelection b;
+    std::set<std::uint32_t> setA;
+    std::set<std::uint32_t> setB;
+    for (int i = 0; i < 3000; ++i) {
+        const std::uint32_t index = next() % 300000;
+        a.add(index);
+        setA.insert(index);
+    }
+    for (std::uint32_t i = 65536; i < 131072; i += 3) {
+        b.add(i);
+        setB.insert(i);
+    }
+    a.addRange(60000, 70000);
+    b.addRange(200000, 270000);
+    for (std::uint32_t i = 60000; i < 70000; ++i) {
+        setA.insert(i);
+    }
+    for (std::uint32_t i = 200000; i < 270000; ++i) {
+        setB.insert(i);
+    }
+    for (const std::uint32_t index : {60000u, 65535u, 65536u, 69999u, 66000u, 200001u, 299999u}) {
+        a.remove(index);
+        b.remove(index);
+        setA.erase(index);
+        setB.erase(index);
+    }
+    std::set<std::uint32_t> united = setA;
+    united.insert(setB.begin(), setB.end());
+    std::set<std::uint32_t> common;
+    std::ranges::set_intersection(setA, setB, std::inserter(common, common.end()));
+    if (toSet(a) != setA || toSet(b) != setB || a.size() != setA.size() || !a.contains(*setA.begin())
+        || a.contains(60000) || toSet(a | b) != united || toSet(a & b) != common || (a | b) != (b | a)) {
+        return false;
+    }
+    for (const auto& range : (a | b).ranges()) {
+        if (range.first >= range.last || united.contains(range.last) || (range.first > 0 && united.contains(range.first - 1))) {
+            return false;
+        }
+    }
+
+    // runs() reads the chunks in place and joins runs across chunks, as ranges() does.
+    const NoteSelection both = a | b;
+    if (!std::ranges::equal(both.runs(), both.ranges()) || !std::ranges::equal(a.runs(), a.ranges())
+        || !std::ranges::empty(NoteSelection {}.runs())) {
+        return false;
+    }
+
+    // Select-all costs a few runs, not a word per note.
+    NoteSelection all;
+    all.addRange(0, 1'000'000);
+    if (all.size() != 1'000'000 || all.memoryBytes() > 4096 || all.ranges() != std::vector<NoteRange> {{0, 1'000'000}}) {
+        return false;
+    }
+
+    // A bulk edit through a selection equals the same edit through its ranges.
+    NotationEngine viaSelection;
+    NotationEngine viaRanges;
+    viaSelection.addNotes(makeScore(200));
+    viaRanges.addNotes(makeScore(200));
+    NoteSelection chords;
+    for (std::uint32_t i = 0; i < viaSelection.notes().size(); i += 7) {
+        chords.add(i);
+    }
+    chords.addRange(100, 140);
+    std::vector<NoteRange> recorded;
+    viaSelection.setEditListener([&](const notascore::notation::EditRecord& record) {
+        recorded.assign(record.ranges.begin(), record.ranges.end());
+    });
+    const notascore::notation::BulkEdit up {.amount = 5};
+    if (!viaSelection.applyBulkEdit(up, chords) || !viaRanges.applyBulkEdit(up, chords.ranges())
+        || recorded != chords.ranges()) {
+        return false;
+    }
+    viaSelection.recomputeLayoutIfNeeded();
+    viaRanges.recomputeLayoutIfNeeded();
+    if (!sameLayout(viaSelection.layout(), viaRanges.layout())) {
+        return false;
+    }
+
+    // Highlights cover the selected notes of the requested pages only.
+    const auto& layout = viaSelection.layout();
+    std::vector<notascore::notation::SelectionHighlight> highlights;
+    notascore::notation::selectionHighlights(chords, layout, 0, 1, highlights);
+    const auto firstOffPage = layout.measureFirstNote[layout.systemFirstMeasure[layout.pageFirstSystem[1]]];
+    if (highlights.empty() || layout.pageCount() < 2) {
+        return false;
+    }
+    bool covered = true;
+    chords.forEachRange(
+        [&](std::uint32_t first, std::uint32_t last) {
+            for (std::uint32_t n = first; n < last; ++n) {
+                const float y = layout.systemY[layout.measureSystem[layout.noteMeasure[n]]] + layout.noteY[n];
+                covered = covered && std::ranges::any_of(highlights, [&](const auto& highlight) {
+                    return highlight.page == 0 && highlight.box.x0 <= layout.noteX[n] && layout.noteX[n] < highlight.box.x1
+                        && highlight.box.y0 < y && y < highlight.box.y1;
+                });
+            }
+        },
+        0, firstOffPage);
+    return covered && std::ranges::all_of(highlights, [](const auto& highlight) { return highlight.page == 0; });
+}
+
+// Incremental range flags must match a scan of the whole voice after every
+// kind of edit, while a one-note edit checks only the measures it re-spaced.
+bool rangeValidationMatchesScan() {
+    using notascore::notation::RangeValidator;
+    NotationEngine engine;
+    engine.addNotes(makeScore(300));
+    RangeValidator validator(*parsePitchRange("C4-E5"));
+    const auto matchesScan = [&] {
+        engine.recomputeLayoutIfNeeded();
+        validator.update(engine);
+        const auto& layout = engine.layout();
+        std::vector<std::uint32_t> counts(layout.measureCount(), 0);
+        for (std::size_t n = 0; n < engine.noteCount(); ++n) {
+            counts[layout.noteMeasure[n]] += validator.range().contains(engine.notes()[n].midiPitch) ? 0 : 1;
+        }
+        std::uint64_t total = 0;
+        for (std::size_t m = 0; m < counts.size(); ++m) {
+            total += counts[m];
+            if (validator.outOfRangeCount(m) != counts[m]) {
+                return false;
+            }
+        }
+        return validator.outOfRangeCount() == total;
+    };
+    if (!matchesScan() || validator.outOfRangeCount() == 0) {
+        return false;
+    }
+
+    auto note = engine.notes()[500];
+    note.midiPitch = 30;
+    engine.modifyNote(500, note);
+    if (!matchesScan() || validator.lastMeasuresChecked() > engine.lastPassStats().measuresRespaced
+        || validator.lastMeasuresChecked() == 0) {
+        return false;
+    }
+    engine.addNote({.tick = 1920 * 310, .duration = 480, .midiPitch = 100});
+    engine.removeNote(10);
+    if (!matchesScan() || !engine.applyBulkEdit({.amount = -12}, std::vector<notascore::notation::NoteRange> {{0, 200}})
+        || !matchesScan()) {
+        return false;
+    }
+    // Two passes without an update in between fall back to a full check.
+    engine.removeNote(engine.noteCount() - 1);
+    engine.recomputeLayoutIfNeeded();
+    engine.addNote({.tick = 0, .duration = 480, .midiPitch = 10});
+    if (!matchesScan() || validator.lastMeasuresChecked() != engine.layout().measureCount()) {
+        return false;
+    }
+
+    std::vector<notascore::notation::SelectionHighlight> highlights;
+    validator.highlights(engine, 0, 1, highlights);
+    if (highlights.empty()) {
+        return false;
+    }
+
+    notascore::notation::Score score;
+    auto& flute = score.addPart("Flute", "C4-C7");
+    auto& snare = score.addPart("Snare Drum", "Perc");
+    flute.voice(0, 0)->addNotes(makeScore(20));
+    flute.voice(0, 0)->addNote({.tick = 0, .duration = 480, .midiPitch = 50});
+    snare.voice(0, 0)->addNote({.tick = 0, .duration = 480, .midiPitch = 38});
+    score.recomputeLayoutIfNeeded();
+    return flute.pitchRange() == PitchRange {.low = 60, .high = 96} && flute.outOfRangeCount() == 1
+        && !snare.pitchRange() && snare.rangeValidator(0, 0) == nullptr;
+}
+
+// Lazy pages must match a full layout wherever they are laid out, lay out only
+// the viewport window, follow the viewport and edits, and (in low-memory mode)
+// release what leaves the window.
+bool lazyPagesMatchFull(bool lowMemoryMode) {
+    const LayoutOptions eagerOptions {.lowMemoryMode = lowMemoryMode};
+    LayoutOptions lazyOptions = eagerOptions;
+    lazyOptions.lazyPages = true;
+    lazyOptions.prefetchPages = 1;
+    NotationEngine eager;
+    NotationEngine lazy;
+    eager.setLayoutOptions(eagerOptions);
+    lazy.setLayoutOptions(lazyOptions);
+    for (auto* engine : {&eager, &lazy}) {
+        engine->addNotes(makeScore(800));
+        addMarkings(*engine, 800);
+    }
+
+    // Laid-out systems agree with the full layout; the others are exactly those
+    // outside [firstPage, lastPage) (when given).
+    const auto matches = [&](std::size_t firstPage, std::size_t lastPage) {
+        eager.recomputeLayoutIfNeeded();
+        lazy.recomputeLayoutIfNeeded();
+        const auto& a = eager.layout();
+        const auto& b = lazy.layout();
+        if (a.measureX != b.measureX || a.measureWidth != b.measureWidth || a.measureSystem != b.measureSystem
+            || a.systemY != b.systemY || a.pageFirstSystem != b.pageFirstSystem || a.noteY != b.noteY) {
+            return false;
+        }
+        for (std::size_t s = 0; s < b.systemCount(); ++s) {
+            const bool inWindow = b.systemPage[s] >= firstPage && b.systemPage[s] < lastPage;
+            if (lazy.isSystemLaidOut(s) != inWindow && lastPage != 0) {
+                return false;
+            }
+            if (!lazy.isSystemLaidOut(s)) {
+                continue;
+            }
+            const auto nBegin = b.measureFirstNote[b.systemFirstMeasure[s]];
+            const auto nEnd = b.measureFirstNote[b.systemFirstMeasure[s + 1]];
+            if (a.systemItems[s] != b.systemItems[s]
+                || !std::equal(a.noteX.begin() + nBegin, a.noteX.begin() + nEnd, b.noteX.begin() + nBegin)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!matches(0, 2)) {
+        return false;
+    }
+    const std::size_t pages = lazy.layout().pageCount();
+    if (pages < 10) {
+        return false;
+    }
+
+    // Pages 4-6 come into range; pages 0-1 stay laid out unless memory is low.
+    lazy.setViewport(5, 6);
+    const auto pageLaidOut = [&](std::size_t page) { return lazy.isSystemLaidOut(lazy.layout().pageFirstSystem[page]); };
+    if (!matches(lowMemoryMode ? 4 : 0, lowMemoryMode ? 7 : 0) || pageLaidOut(0) == lowMemoryMode || pageLaidOut(3)
+        || !pageLaidOut(4) || !pageLaidOut(6)) {
+        return false;
+    }
+
+    // Edits inside and before the window re-lay out only what is in view.
+    for (auto* engine : {&eager, &lazy}) {
+        const auto index = engine->layout().measureFirstNote[engine->layout().systemFirstMeasure[engine->layout().pageFirstSystem[5]]];
+        auto note = engine->notes()[index];
+        note.midiPitch += 1;
+        engine->modifyNote(index, note);
+        engine->addNote({.tick = 1920 * 3, .duration = 1920 * 2, .midiPitch = 61});
+    }
+    if (!matches(0, 0)) {
+        return false;
+    }
+    lazy.setViewport(0, pages);
+    eager.recomputeLayoutIfNeeded();
+    return sameLayout(eager.layout(), lazy.layout());
+}
+
+// Tick <-> seconds conversion must be exact on constant tempos, match numeric
+// integration across ramps, round-trip, and agree between scalar and batch forms.
+bool tempoMapIsExact() {
+    notascore::notation::TempoMap tempo(480, 120.0);
+    if (tempo.secondsAt(480.0) != 0.5 || tempo.ticksAt(0.5) != 480.0 || !tempo.setTempo(1920, 60.0)
+        || tempo.secondsAt(1920.0) != 2.0 || tempo.secondsAt(2400.0) != 3.0 || tempo.ticksAt(3.0) != 2400.0) {
+        return false;
+    }
+    // Four beats ramping 60 -> 120 BPM take 4 ln 2 seconds.
+    if (!tempo.setTempo(3840, 60.0, true) || !tempo.setTempo(5760, 120.0) || !tempo.setTempo(9600, 90.0, true)
+        || !tempo.setTempo(11520, 200.0)) {
+        return false;
+    }
+    const double rampStart = tempo.secondsAt(3840.0);
+    if (std::abs(tempo.secondsAt(5760.0) - rampStart - 4.0 * std::log(2.0)) > 1e-12 || tempo.bpmAt(4800.0) != 90.0) {
+        return false;
+    }
+    double integrated = 0.0;
+    constexpr int kSteps = 100'000;
+    for (int i = 0; i < kSteps; ++i) {
+        const double tick = 9600.0 + (i + 0.5) * 1920.0 / kSteps;
+        integrated += 60.0 / (480.0 * tempo.bpmAt(tick)) * 1920.0 / kSteps;
+    }
+    if (std::abs(tempo.secondsAt(11520.0) - tempo.secondsAt(9600.0) - integrated) > 1e-9) {
+        return false;
+    }
+
+    std::vector<notascore::notation::Tick> ticks;
+    for (notascore::notation::Tick tick = 0; tick < 20000; tick += 37) {
+        ticks.push_back(tick);
+    }
+    std::vector<double> seconds(ticks.size());
+    std::vector<double> back(ticks.size());
+    tempo.secondsAt(ticks, seconds);
+    tempo.ticksAt(seconds, back);
+    for (std::size_t i = 0; i < ticks.size(); ++i) {
+        const auto tick = static_cast<double>(ticks[i]);
+        if (seconds[i] != tempo.secondsAt(tick) || back[i] != tempo.ticksAt(seconds[i])
+            || std::abs(back[i] - tick) > 1e-6 || (i > 0 && seconds[i] <= seconds[i - 1])) {
+            return false;
+        }
+    }
+    std::reverse(ticks.begin(), ticks.end());
+    tempo.secondsAt(ticks, seconds);
+    if (seconds.front() != tempo.secondsAt(static_cast<double>(ticks.front())) || seconds.back() != 0.0) {
+        return false;
+    }
+
+    return !tempo.setTempo(-1, 100.0) && !tempo.setTempo(0, 0.0) && !tempo.setTempo(0, std::nan(""))
+        && !tempo.removeTempo(0) && tempo.removeTempo(1920) && tempo.changes().size() == 5;
+}
+
+// Bar lookups must match a bar-by-bar walk through meter changes and a pickup,
+// before and after edits, and notes in a bar must match a scan.
+bool measureIndexMatchesWalk() {
+    using notascore::notation::MeasureIndex;
+    using notascore::notation::Tick;
+    const auto matchesWalk = [](const MeasureIndex& index, const std::vector<std::pair<std::uint32_t, Meter>>& meters,
+                                 Tick pickup) {
+        Tick start = 0;
+        Meter meter = meters.front().second;
+        std::size_t next = 1;
+        for (std::uint32_t bar = 0; bar < 400; ++bar) {
+            const bool isPickup = pickup > 0 && bar == 0;
+            if (next < meters.size() && meters[next].first == bar) {
+                meter = meters[next++].second;
+            }
+            const Tick length = isPickup ? pickup : meter.barTicks(480);
+            if (index.barStart(bar) != start || index.barLength(bar) != length || index.barAt(start) != bar
+                || index.barAt(start + length - 1) != bar || (!isPickup && index.meterAt(bar) != meter)) {
+                return false;
+            }
+            start += length;
+        }
+        return true;
+    };
+
+    MeasureIndex index;
+    std::vector<std::pair<std::uint32_t, Meter>> meters {{0, Meter {}}};
+    if (!matchesWalk(index, meters, 0) || index.barAt(-5) != 0 || index.barStart(1000) != 1000 * 1920) {
+        return false;
+    }
+    const Meter threeFour {.beats = 3, .beatUnit = 4};
+    const Meter sixEight {.beats = 6, .beatUnit = 8};
+    const Meter fiveSixteen {.beats = 5, .beatUnit = 16};
+    index.setMeter(10, threeFour);
+    index.setMeter(50, sixEight);
+    index.setMeter(30, fiveSixteen);
+    meters = {{0, Meter {}}, {10, threeFour}, {30, fiveSixteen}, {50, sixEight}};
+    if (!matchesWalk(index, meters, 0)) {
+        return false;
+    }
+    // Edits earlier in the score shift every later bar.
+    index.setMeter(10, sixEight);
+    index.removeMeter(30);
+    meters = {{0, Meter {}}, {10, sixEight}, {50, sixEight}};
+    if (!matchesWalk(index, meters, 0)) {
+        return false;
+    }
+    // A pickup renumbers bars: the change at bar 50 moves to bar 51.
+    index.setPickup(480);
+    meters = {{0, Meter {}}, {11, sixEight}, {51, sixEight}};
+    if (!matchesWalk(index, meters, 480) || index.setMeter(0, threeFour) || index.removeMeter(0)
+        || index.meterChangeCount() != 3) {
+        return false;
+    }
+    index.setPickup(240);
+    if (!matchesWalk(index, meters, 240) || !index.setPickup(0)) {
+        return false;
+    }
+    meters = {{0, Meter {}}, {10, sixEight}, {50, sixEight}};
+    if (!matchesWalk(index, meters, 0) || index.setMeter(5, {.beats = 3, .beatUnit = 0})) {
+        return false;
+    }
+
+    // Every voice of a score reads the one index the score edits.
+    notascore::notation::Score score;
+    score.addPart("Violin", "G3-E7");
+    score.setMeasureIndex(index);
+    auto& piano = score.addPart("Piano", "A0-C8", 2);
+    NotationEngine& engine = *score.part(0).voice(0, 0);
+    engine.addNotes(makeScore(120));
+    if (!score.setPickup(960) || &engine.measureIndex() != &score.measureIndex()
+        || &piano.voice(1, 0)->measureIndex() != &score.measureIndex() || piano.voice(1, 0)->measureIndex().pickupTicks() != 960) {
+        return false;
+    }
+    for (std::uint32_t bar = 0; bar < 130; ++bar) {
+        const auto range = engine.notesInBar(bar);
+        const Tick start = engine.measureIndex().barStart(bar);
+        const Tick end = start + engine.measureIndex().barLength(bar);
+        for (std::uint32_t n = 0; n < engine.noteCount(); ++n) {
+            const bool inBar = engine.notes()[n].tick >= start && engine.notes()[n].tick < end;
+            if (inBar != (n >= range.first && n < range.last)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Negative ticks are refused at every entry point, laid out or not, and leave
+// the document untouched; shifts stop at tick 0.
+bool negativeTicksAreRefused() {
+    using notascore::notation::BulkEditKind;
+    using notascore::notation::MarkingKind;
+    using notascore::notation::NoteRange;
+    NotationEngine engine;
+    engine.addNotes(makeScore(40));
+    engine.recomputeLayoutIfNeeded();
+    const std::vector<NoteEvent> before(engine.notes().begin(), engine.notes().end());
+    const std::vector<NoteEvent> batch {{.tick = 0, .duration = 240}, {.tick = -5000, .duration = 240}};
+    if (engine.addNote({.tick = -5000, .duration = 480}) || engine.addNotes(batch) || engine.modifyNote(0, {.tick = -1})
+        || engine.addMarking({.tick = -1, .kind = MarkingKind::Dynamic})) {
+        return false;
+    }
+    {
+        auto edit = engine.beginBatch();
+        if (edit.add({.tick = -1}) || !edit.add({.tick = 0, .duration = 120})) {
+            return false;
+        }
+    }
+    const NoteRange all {.first = 0, .last = static_cast<std::uint32_t>(engine.noteCount())};
+    engine.applyBulkEdit({.kind = BulkEditKind::ShiftTicks, .amount = -1'000'000}, std::span(&all, 1));
+    engine.recomputeLayoutIfNeeded();
+    return engine.noteCount() == before.size() + 1 && engine.markings().empty()
+        && std::ranges::all_of(engine.notes(), [](const NoteEvent& note) { return note.tick == 0; });
+}
+
+// Removing or modifying a note past the last one is refused like a bad bulk
+// range: nothing changes, nothing is reported and no undo step is recorded.
+bool outOfRangeIndicesAreRefused() {
+    NotationEngine engine;
+    engine.addNotes(makeScore(40));
+    engine.clearUndoHistory();
+    const std::vector<NoteEvent> before(engine.notes().begin(), engine.notes().end());
+    std::size_t reported = 0;
+    engine.setEditListener([&](const notascore::notation::EditRecord&) { ++reported; });
+    const bool refused = !engine.removeNote(before.size()) && !engine.removeNote(std::size_t {1} << 40)
+        && !engine.modifyNote(before.size(), {.tick = 0, .duration = 240, .midiPitch = 60});
+    return refused && reported == 0 && !engine.canUndo() && std::ranges::equal(engine.notes(), before)
+        && engine.removeNote(before.size() - 1) && reported == 1;
+}
+
+} // namespace
+
+
+// Published layouts must match the live one system by system, and a version
+// must share every system the pass before it did not lay out.
+bool publishedLayoutMatchesLive(const LayoutOptions& options) {
+    using notascore::notation::PublishedLayout;
+    const auto matches = [](const PublishedLayout& published, const LayoutResult& live) {
+        if (published.systemCount() != live.systemCount() || published.systemFirstMeasure != live.systemFirstMeasure
+            || published.systemY != live.systemY || published.systemPage != live.systemPage
+            || published.pageFirstSystem != live.pageFirstSystem || published.noteCount() != live.noteX.size()) {
+            return false;
+        }
+        for (std::size_t s = 0; s < published.systemCount(); ++s) {
+            const auto& system = *published.systems[s];
+            const auto notes = static_cast<std::ptrdiff_t>(published.systemFirstNote[s]);
+            const auto measures = static_cast<std::ptrdiff_t>(published.systemFirstMeasure[s]);
+            const auto sameSlice = [](const auto& slice, const auto& all, std::ptrdiff_t first) {
+                return std::equal(slice.begin(), slice.end(), all.begin() + first, all.begin() + first + std::ssize(slice));
+            };
+            if (!sameSlice(system.noteX, live.noteX, notes) || !sameSlice(system.noteY, live.noteY, notes)
+                || !sameSlice(system.noteMeasure, live.noteMeasure, notes)
+                || !sameSlice(system.measureX, live.measureX, measures)
+                || !sameSlice(system.measureWidth, live.measureWidth, measures)
+                || system.measureX.size() != published.systemFirstMeasure[s + 1] - published.systemFirstMeasure[s]
+                || system.items != live.systemItems[s]) {
+                return false;
+            }
+            for (std::size_t m = 0; m < system.measureFirstNote.size(); ++m) {
+                if (system.measureFirstNote[m] + published.systemFirstNote[s] != live.measureFirstNote[m + static_cast<std::size_t>(measures)]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    NotationEngine engine;
+    engine.setLayoutOptions(options);
+    engine.addNotes(makeScore(200));
+    addMarkings(engine, 200);
+    engine.enableLayoutPublishing();
+    engine.recomputeLayoutIfNeeded();
+    engine.setViewport(1, 2);
+    const auto check = [&] {
+        engine.recomputeLayoutIfNeeded();
+        const auto pin = engine.pinLayout();
+        return pin && pin->version == engine.layoutVersion() && matches(pin->layout, engine.layout());
+    };
+    if (!check()) {
+        return false;
+    }
+
+    // One note late in the score: the systems before it are shared.
+    const auto before = engine.pinLayout();
+    engine.addNote({.tick = 1920 * 180 + 60, .duration = 60, .midiPitch = 70});
+    if (!check()) {
+        return false;
+    }
+    const auto after = engine.pinLayout();
+    const std::size_t edited = after->layout.systemOfNote(engine.notesInBar(180).first);
+    if (edited == 0 || after->layout.systems.front() != before->layout.systems.front()
+        || after->layout.systems[edited] == before->layout.systems[edited]) {
+        return false;
+    }
+
+    // Re-breaks, notes past the end, markings, undo and viewport moves.
+    for (int i = 0; i < 6; ++i) {
+        engine.addNote({.tick = 1920 * 50 + 60 + i * 240, .duration = 60, .midiPitch = 61 + i});
+    }
+    if (!check()) {
+        return false;
+    }
+    engine.addNote({.tick = 1920 * 203, .duration = 1920 * 2, .midiPitch = 48});
+    engine.addMarking({.tick = 1920 * 120, .kind = notascore::notation::MarkingKind::Dynamic, .width = 3.0f});
+    if (!check()) {
+        return false;
+    }
+    engine.setViewport(engine.layout().pageCount() - 1, engine.layout().pageCount());
+    engine.undo();
+    return check();
+}
+
+// Score undo steps back the voice edited last, across parts and staves, and
+// redo replays the undone steps oldest first.
+bool scoreUndoFollowsEditOrder() {
+    notascore::notation::Score score;
+    auto& piano = score.addPart("Piano", "A0-C8", 2);
+    auto& flute = score.addPart("Flute", "C4-C7");
+    NotationEngine* left = piano.voice(1, 0);
+    NotationEngine* right = piano.voice(0, 0);
+    NotationEngine* melody = flute.voice(0, 0);
+    const auto edit = [](NotationEngine* voice, int tick) {
+        voice->addNote({.tick = tick, .duration = 480, .midiPitch = 60});
+        voice->commitUndoStep();
+    };
+    edit(melody, 0);
+    edit(left, 480);
+    edit(melody, 960);
+    edit(right, 1440);
+    // Uncommitted edits are undone first.
+    left->addNote({.tick = 1920, .duration = 480, .midiPitch = 48});
+    const auto counts = [&] { return std::array {left->noteCount(), right->noteCount(), melody->noteCount()}; };
+    if (!score.canUndo() || score.canRedo()) {
+        return false;
+    }
+    using Counts = std::array<std::size_t, 3>;
+    for (const Counts expected : {Counts {1, 1, 2}, Counts {1, 0, 2}, Counts {1, 0, 1}, Counts {0, 0, 1}, Counts {0, 0, 0}}) {
+        if (!score.undo() || counts() != expected) {
+            return false;
+        }
+    }
+    if (score.undo() || score.canUndo()) {
+        return false;
+    }
+    for (const Counts expected : {Counts {0, 0, 1}, Counts {1, 0, 1}, Counts {1, 0, 2}, Counts {1, 1, 2}, Counts {2, 1, 2}}) {
+        if (!score.redo() || counts() != expected) {
+            return false;
+        }
+    }
+    if (score.redo() || score.canRedo() || !score.canUndo()) {
+        return false;
+    }
+
+    // Without explicit commits each voice's pending edits are one step, taken
+    // in the order their first edits were made.
+    notascore::notation::Score uncommitted;
+    NotationEngine* keys = uncommitted.addPart("Piano", "A0-C8", 2).voice(0, 0);
+    NotationEngine* lead = uncommitted.addPart("Flute", "C4-C7").voice(0, 0);
+    keys->addNote({.tick = 0, .duration = 480, .midiPitch = 60});
+    lead->addNote({.tick = 0, .duration = 480, .midiPitch = 72});
+    lead->addNote({.tick = 480, .duration = 480, .midiPitch = 74});
+    if (!uncommitted.undo() || keys->noteCount() != 1 || lead->noteCount() != 0) {
+        return false;
+    }
+    if (!uncommitted.undo() || keys->noteCount() != 0 || !uncommitted.redo() || keys->noteCount() != 1) {
+        return false;
+    }
+    return uncommitted.redo() && lead->noteCount() == 2 && !uncommitted.canRedo();
+}
+
+// Options that do not change how a measure is spaced keep the shared cache;
+// spacing options and the low-memory capacity drop it.
+bool scoreKeepsMeasureCache() {
+    notascore::notation::Score score;
+    score.addPart("Flute", "C4-C7").voice(0, 0)->addNotes(makeScore(400));
+    score.recomputeLayoutIfNeeded();
+    const std::size_t cached = score.measureCache().size();
+    auto options = score.layoutOptions();
+    options.pageWidth += 20.0f;
+    options.lazyPages = true;
+    score.setLayoutOptions(options);
+    if (cached == 0 || score.measureCache().size() != cached
+        || score.measureCache().capacity() != notascore::notation::MeasureCache::kDefaultCapacity) {
+        return false;
+    }
+    options.spaceUnit *= 1.5f;
+    score.setLayoutOptions(options);
+    if (score.measureCache().size() != 0) {
+        return false;
+    }
+    score.recomputeLayoutIfNeeded();
+    options.lowMemoryMode = true;
+    score.setLayoutOptions(options);
+    return score.measureCache().size() == 0
+        && score.measureCache().capacity() < notascore::notation::MeasureCache::kDefaultCapacity;
+}
+
+int main() {
+    // Optimal system breaking by default, greedy in low-memory mode.
+    for (const bool lowMemoryMode : {false, true}) {
+        if (const int failure = incrementalMatchesFull({.lowMemoryMode = lowMemoryMode}); failure != 0) {
+            return failure;
+        }
+    }
+
+    // A small cache keeps evicting; repeated bars must still hit.
+    MeasureCache cache(64);
+    if (const int failure = incrementalMatchesFull({}, &cache); failure != 0) {
+        return failure;
+    }
+    if (cache.hits() == 0 || cache.size() > 64) {
+        return 10;
+    }
+
+    // Parallel passes must reproduce the single-threaded layout exactly.
+    notascore::core::ThreadPool pool(3);
+    NotationEngine parallel;
+    parallel.setThreadPool(&pool);
+    for (const auto& note : makeScore(6000)) {
+        parallel.addNote(note);
+    }
+    NotationEngine serial;
+    for (const auto& note : parallel.notes()) {
+        serial.addNote(note);
+    }
+    addMarkings(parallel, 6000);
+    addMarkings(serial, 6000);
+    parallel.recomputeLayoutIfNeeded();
+    serial.recomputeLayoutIfNeeded();
+    if (!sameLayout(parallel.layout(), serial.layout())) {
+        return 4;
+    }
+
+    // Overlap queries must agree with a brute-force scan, including long notes
+    // started several measures earlier and notes inserted out of order.
+    NotationEngine queries;
+    for (const auto& note : makeScore(40)) {
+        queries.addNote(note);
+    }
+    queries.addNote({.tick = 1920 * 3 + 10, .duration = 1920 * 9, .midiPitch = 40});
+    queries.addNote({.tick = 100, .duration = 1920 * 20, .midiPitch = 41});
+    queries.addNote({.tick = 1920 * 12, .duration = 0, .midiPitch = 42});
+    if (!overlapQueriesMatchScan(queries)) {
+        return 5;
+    }
+
+    // A shuffled batch must land exactly where repeated addNote calls put it.
+    auto batch = makeScore(30);
+    std::reverse(batch.begin(), batch.end());
+    batch.push_back({.tick = 1920, .duration = 10, .midiPitch = 99});
+    NotationEngine oneByOne;
+    NotationEngine bulk;
+    for (const auto& note : makeScore(20)) {
+        oneByOne.addNote(note);
+        bulk.addNote(note);
+    }
+    for (const auto& note : batch) {
+        oneByOne.addNote(note);
+    }
+    {
+        auto edit = bulk.beginBatch(batch.size());
+        for (const auto& note : batch) {
+            edit.add(note);
+        }
+    }
+    const auto a = oneByOne.notes();
+    const auto b = bulk.notes();
+    const bool sameOrder = std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const NoteEvent& x, const NoteEvent& y) {
+        return x.tick == y.tick && x.duration == y.duration && x.midiPitch == y.midiPitch;
+    });
+    if (!sameOrder || !overlapQueriesMatchScan(bulk)) {
+        return 6;
+    }
+
+    for (const bool lowMemoryMode : {false, true}) {
+        if (!undoRedoMatchesFull({.lowMemoryMode = lowMemoryMode})) {
+            return 7;
+        }
+    }
+    if (!persistentVectorMatchesFlat()) {
+        return 8;
+    }
+    if (!partsAreIndependent()) {
+        return 9;
+    }
+    if (!quantizerFindsGridAndTuplets()) {
+        return 11;
+    }
+    for (const bool lowMemoryMode : {false, true}) {
+        if (!bulkEditsMatchFull({.lowMemoryMode = lowMemoryMode})) {
+            return 12;
+        }
+    }
+    if (!selectionsMatchSet()) {
+        return 13;
+    }
+    if (!rangeValidationMatchesScan()) {
+        return 14;
+    }
+    for (const bool lowMemoryMode : {false, true}) {
+        if (!lazyPagesMatchFull(lowMemoryMode)) {
+            return 15;
+        }
+    }
+    if (!tempoMapIsExact()) {
+        return 16;
+    }
+    if (!measureIndexMatchesWalk()) {
+        return 17;
+    }
+    if (!negativeTicksAreRefused()) {
+        return 18;
+    }
+    for (const LayoutOptions options : {LayoutOptions {}, LayoutOptions {.lowMemoryMode = true, .lazyPages = true}}) {
+        if (!publishedLayoutMatchesLive(options)) {
+            return 19;
+        }
+    }
+    if (!scoreUndoFollowsEditOrder()) {
+        return 20;
+    }
+    if (!scoreKeepsMeasureCache()) {
+        return 21;
+    }
+    if (!outOfRangeIndicesAreRefused()) {
+        return 22;
+    }
+    return 0;
+}
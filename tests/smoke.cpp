@@ -1,5 +1,6 @@
 #include "notascore/io/NsxDocument.hpp"
 #include "notascore/notation/NotationEngine.hpp"
+#include "notascore/notation/Score.hpp"
 #include "notascore/ui/MainWindow.hpp"
 #include "notascore/ui/PerformanceSettings.hpp"
 
@@ -9,6 +10,11 @@ int main() {
     notascore::notation::NotationEngine notation;
     notation.addNote({.tick = 0, .duration = 240, .midiPitch = 60});
     notation.recomputeLayoutIfNeeded();
+    const auto& layout = notation.layout();
+    if (layout.noteX.size() != 1 || layout.measureCount() != 1 || layout.pageCount() != 1
+        || layout.noteX[0] <= layout.measureX[0]) {
+        return 4;
+    }
 
     notascore::io::NsxDocument doc;
     const auto path = std::filesystem::path("smoke.nsx");
@@ -17,7 +23,7 @@ int main() {
     }
 
     std::vector<notascore::notation::NoteEvent> notes;
-    if (!doc.load(path, notes)) {
+    if (!doc.load(path, notes) || notes != std::vector(notation.notes().begin(), notation.notes().end())) {
         return 2;
     }
 
@@ -25,6 +31,8 @@ int main() {
         {.cpuModel = "legacy", .ramMb = 4096, .hasDedicatedGpu = false, .legacyOpenGLOnly = true});
 
     notascore::ui::MainWindow mainWindow(1280, 720, settings);
+    notascore::notation::Score score;
+    mainWindow.setScore(&score);
     const auto newScore = mainWindow.newScoreCardRect();
     mainWindow.onClick(newScore.x + 12, newScore.y + 12);
 
@@ -32,7 +40,18 @@ int main() {
     mainWindow.onClick(mainWindow.assistantNextRect().x + 6, mainWindow.assistantNextRect().y + 6);
     mainWindow.onClick(mainWindow.assistantNextRect().x + 6, mainWindow.assistantNextRect().y + 6);
 
+    // Edit > Undo reaches whichever voice of the new score was edited.
+    bool undone = false;
+    if (score.partCount() == 1) {
+        score.part(0).voice(0, score.part(0).addVoice(0))->addNote({.tick = 0, .duration = 480, .midiPitch = 72});
+        mainWindow.undo();
+        undone = score.noteCount() == 0 && mainWindow.canRedo() && !mainWindow.canUndo();
+    }
+
     std::filesystem::remove(path);
 
-    return settings.cpuModeOnly && settings.lowMemoryMode && notes.size() == 1 && mainWindow.scoreCount() == 1 ? 0 : 3;
+    return settings.cpuModeOnly && settings.lowMemoryMode && notes.size() == 1 && mainWindow.scoreCount() == 1
+            && score.partCount() == 1 && score.part(0).name() == mainWindow.instrumentLibrary()[0].name && undone
+        ? 0
+        : 3;
 }